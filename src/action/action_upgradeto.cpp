@@ -203,7 +203,7 @@ int TransformUnitIntoType(CUnit &unit, const stratagus::unit_type &newtype)
 			unit.Variable[i].Value = unit.Variable[i].Max;
 		} else {
 			unit.Variable[i].Max += newstats.Variables[i].Max - oldstats.Variables[i].Max;
-			unit.Variable[i].Increase += newstats.Variables[i].Increase - oldstats.Variables[i].Increase;
+			unit.change_variable_increase(i, newstats.Variables[i].Increase - oldstats.Variables[i].Increase);
 			unit.Variable[i].Enable = newstats.Variables[i].Enable;
 		}
 		//Wyrmgus end
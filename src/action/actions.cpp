@@ -75,6 +75,7 @@
 #include "unit/unit.h"
 #include "unit/unit_find.h"
 #include "unit/unit_manager.h"
+#include "unit/unit_target_snapshot.h"
 #include "unit/unit_type.h"
 #include "upgrade/dependency.h"
 #include "util/random.h"
@@ -425,23 +426,29 @@ static void HandleBuffsEachSecond(CUnit &unit)
 	}
 	//Wyrmgus end
 	
-	// User defined variables
-	for (unsigned int i = 0; i < UnitTypeVar.GetNumberVariable(); i++) {
-		if (i == BLOODLUST_INDEX || i == HASTE_INDEX || i == SLOW_INDEX
-			|| i == INVISIBLE_INDEX || i == UNHOLYARMOR_INDEX || i == POISON_INDEX || i == STUN_INDEX || i == BLEEDING_INDEX || i == LEADERSHIP_INDEX || i == BLESSING_INDEX || i == INSPIRE_INDEX || i == PRECISION_INDEX || i == REGENERATION_INDEX || i == BARKSKIN_INDEX || i == INFUSION_INDEX || i == TERROR_INDEX || i == WITHER_INDEX || i == DEHYDRATION_INDEX || i == HYDRATING_INDEX) {
-			continue;
-		}
-		if (i == HP_INDEX && HandleBurnAndPoison(unit)) {
-			continue;
-		}
+	// HP is handled separately, as burn, poison and regeneration affect it regardless of its increase
+	if (!unit.Variable.empty() && !HandleBurnAndPoison(unit)) {
 		//Wyrmgus start
-		if (i == HP_INDEX && unit.Variable[REGENERATION_INDEX].Value > 0) {
-			unit.Variable[i].Value += 1;
-			clamp(&unit.Variable[i].Value, 0, unit.GetModifiedVariable(i, VariableMax));
+		if (unit.Variable[REGENERATION_INDEX].Value > 0) {
+			unit.Variable[HP_INDEX].Value += 1;
+			clamp(&unit.Variable[HP_INDEX].Value, 0, unit.GetModifiedVariable(HP_INDEX, VariableMax));
 		}
 		//Wyrmgus end
-		if (unit.Variable[i].Enable && unit.Variable[i].Increase) {
-			IncreaseVariable(unit, i);
+		if (unit.Variable[HP_INDEX].Enable && unit.Variable[HP_INDEX].Increase) {
+			IncreaseVariable(unit, HP_INDEX);
+		}
+	}
+
+	// User defined variables, of which only the ones with a nonzero increase are gone through
+	// the list is accessed by index, since increasing a variable can make the unit die and have its variables replaced
+	const std::vector<int> &increasing_variables = unit.get_increasing_variables();
+	for (size_t i = 0; i < increasing_variables.size(); ++i) {
+		const int index = increasing_variables[i];
+		if (index == HP_INDEX) {
+			continue;
+		}
+		if (unit.Variable[index].Enable && unit.Variable[index].Increase) {
+			IncreaseVariable(unit, index);
 		}
 	}
 	
@@ -556,46 +563,36 @@ static void HandleUnitAction(CUnit &unit)
 	unit.Orders[0]->Execute(unit);
 }
 
-template <typename UNITP_ITERATOR>
-static void UnitActionsEachSecond(UNITP_ITERATOR begin, UNITP_ITERATOR end)
+static void UnitActionsEachSecond(CUnit &unit)
 {
-	for (UNITP_ITERATOR it = begin; it != end; ++it) {
-		CUnit &unit = **it;
-
-		if (unit.Destroyed) {
-			continue;
-		}
+	if (unit.Destroyed) {
+		return;
+	}
 
-		// OnEachSecond callback
-		if (unit.Type->OnEachSecond  && unit.IsUnusable(false) == false) {
-			unit.Type->OnEachSecond->pushPreamble();
-			unit.Type->OnEachSecond->pushInteger(UnitNumber(unit));
-			unit.Type->OnEachSecond->run();
-		}
+	// OnEachSecond callback
+	if (unit.Type->OnEachSecond  && unit.IsUnusable(false) == false) {
+		unit.Type->OnEachSecond->pushPreamble();
+		unit.Type->OnEachSecond->pushInteger(UnitNumber(unit));
+		unit.Type->OnEachSecond->run();
+	}
 
-		// 1) Blink flag.
-		if (unit.Blink) {
-			--unit.Blink;
-		}
-		// 2) Buffs...
-		HandleBuffsEachSecond(unit);
+	// 1) Blink flag.
+	if (unit.Blink) {
+		--unit.Blink;
 	}
+	// 2) Buffs...
+	HandleBuffsEachSecond(unit);
 }
 
-template <typename UNITP_ITERATOR>
-static void UnitActionsEachFiveSeconds(UNITP_ITERATOR begin, UNITP_ITERATOR end)
+static void UnitActionsEachFiveSeconds(CUnit &unit)
 {
-	for (UNITP_ITERATOR it = begin; it != end; ++it) {
-		CUnit &unit = **it;
-
-		if (unit.Destroyed) {
-			continue;
-		}
+	if (unit.Destroyed) {
+		return;
+	}
 
-		//if the unit is garrisoned within a building that provides garrison training, increase its XP
-		if (unit.Container && unit.Container->Type->BoolFlag[GARRISONTRAINING_INDEX].value) {
-			unit.ChangeExperience(1);
-		}
+	//if the unit is garrisoned within a building that provides garrison training, increase its XP
+	if (unit.Container && unit.Container->Type->BoolFlag[GARRISONTRAINING_INDEX].value) {
+		unit.ChangeExperience(1);
 	}
 }
 
@@ -632,74 +629,65 @@ static void DumpUnitInfo(CUnit &unit)
 	fflush(nullptr);
 }
 
-template <typename UNITP_ITERATOR>
-static void UnitActionsEachCycle(UNITP_ITERATOR begin, UNITP_ITERATOR end)
+static void UnitActionsEachCycle(CUnit &unit)
 {
-	for (UNITP_ITERATOR it = begin; it != end; ++it) {
-		CUnit &unit = **it;
-
-		if (unit.Destroyed) {
-			continue;
-		}
+	if (unit.Destroyed) {
+		return;
+	}
 
-		if (!ReplayRevealMap && unit.Selected && !unit.IsVisible(*CPlayer::GetThisPlayer())) {
-			UnSelectUnit(unit);
-			SelectionChanged();
-		}
+	if (!ReplayRevealMap && unit.Selected && !unit.IsVisible(*CPlayer::GetThisPlayer())) {
+		UnSelectUnit(unit);
+		SelectionChanged();
+	}
 
-		// OnEachCycle callback
-		if (unit.Type->OnEachCycle && unit.IsUnusable(false) == false) {
-			unit.Type->OnEachCycle->pushPreamble();
-			unit.Type->OnEachCycle->pushInteger(UnitNumber(unit));
-			unit.Type->OnEachCycle->run();
-		}
+	// OnEachCycle callback
+	if (unit.Type->OnEachCycle && unit.IsUnusable(false) == false) {
+		unit.Type->OnEachCycle->pushPreamble();
+		unit.Type->OnEachCycle->pushInteger(UnitNumber(unit));
+		unit.Type->OnEachCycle->run();
+	}
 
-		// Handle each cycle buffs
-		HandleBuffsEachCycle(unit);
-		// Unit could be dead after TTL kill
-		if (unit.Destroyed) {
-			continue;
-		}
+	// Handle each cycle buffs
+	HandleBuffsEachCycle(unit);
+	// Unit could be dead after TTL kill
+	if (unit.Destroyed) {
+		return;
+	}
 
-		try {
-			HandleUnitAction(unit);
-		} catch (AnimationDie_Exception &) {
-			AnimationDie_OnCatch(unit);
-		}
+	try {
+		HandleUnitAction(unit);
+	} catch (AnimationDie_Exception &) {
+		AnimationDie_OnCatch(unit);
+	}
 
-		if (EnableUnitDebug) {
-			DumpUnitInfo(unit);
-		}
-		// Calculate some hash.
-		SyncHash = (SyncHash << 5) | (SyncHash >> 27);
-		SyncHash ^= unit.Orders.empty() == false ? static_cast<int>(unit.CurrentAction()) << 18 : 0;
-		SyncHash ^= unit.Refs << 3;
+	if (EnableUnitDebug) {
+		DumpUnitInfo(unit);
 	}
+	// Calculate some hash.
+	SyncHash = (SyncHash << 5) | (SyncHash >> 27);
+	SyncHash ^= unit.Orders.empty() == false ? static_cast<int>(unit.CurrentAction()) << 18 : 0;
+	SyncHash ^= unit.Refs << 3;
 }
 
 //Wyrmgus start
-template <typename UNITP_ITERATOR>
-static void UnitActionsEachMinute(UNITP_ITERATOR begin, UNITP_ITERATOR end)
+static void UnitActionsEachMinute(CUnit &unit)
 {
-	for (UNITP_ITERATOR it = begin; it != end; ++it) {
-		CUnit &unit = **it;
-
-		if (unit.Destroyed) {
-			continue;
-		}
+	if (unit.Destroyed) {
+		return;
+	}
 
-		unit.UpdateSoldUnits();
-		
-		for (size_t i = 0; i < unit.Type->SpawnUnits.size(); ++i) {
-			stratagus::unit_type *spawned_type = unit.Type->SpawnUnits[i];
-			int spawned_type_demand = spawned_type->Stats[unit.Player->Index].Variables[DEMAND_INDEX].Value;
-			if ((GameCycle % (CYCLES_PER_MINUTE * spawned_type_demand)) == 0) { //the quantity of minutes it takes to spawn the unit depends on the unit's supply demand
-				if ((unit.Player->GetUnitTypeCount(spawned_type) * spawned_type_demand) >= (unit.Player->GetUnitTypeCount(unit.Type) * 5)) { //max limit reached
-					continue;
-				}
-				CUnit *spawned_unit = MakeUnit(*spawned_type, unit.Player);
-				DropOutOnSide(*spawned_unit, spawned_unit->Direction, &unit);
+	unit.UpdateSoldUnits();
+	
+	const unsigned long game_minute = GameCycle / CYCLES_PER_MINUTE;
+	for (size_t i = 0; i < unit.Type->SpawnUnits.size(); ++i) {
+		stratagus::unit_type *spawned_type = unit.Type->SpawnUnits[i];
+		int spawned_type_demand = spawned_type->Stats[unit.Player->Index].Variables[DEMAND_INDEX].Value;
+		if ((game_minute % spawned_type_demand) == 0) { //the quantity of minutes it takes to spawn the unit depends on the unit's supply demand
+			if ((unit.Player->GetUnitTypeCount(spawned_type) * spawned_type_demand) >= (unit.Player->GetUnitTypeCount(unit.Type) * 5)) { //max limit reached
+				continue;
 			}
+			CUnit *spawned_unit = MakeUnit(*spawned_type, unit.Player);
+			DropOutOnSide(*spawned_unit, spawned_unit->Direction, &unit);
 		}
 	}
 }
@@ -707,27 +695,30 @@ static void UnitActionsEachMinute(UNITP_ITERATOR begin, UNITP_ITERATOR end)
 
 /**
 **  Update the actions of all units each game cycle/second.
+**
+**  Units are handled in slot order, and units created during the cycle are
+**  only handled from the next cycle on. The periodic actions are spread
+**  across cycles by unit slot, so that each cycle handles an equal share of
+**  the units instead of all of them on every second, five seconds or minute.
+**
+**  The units around each unit which may look for targets are selected on the
+**  worker threads beforehand, and the units choose their targets from them.
 */
 void UnitActions()
 {
-	const bool isASecondCycle = !(GameCycle % CYCLES_PER_SECOND);
-	// Unit list may be modified during loop... so make a copy
-	std::vector<CUnit *> table(UnitManager.begin(), UnitManager.end());
+	UnitManager.StartIterationGeneration();
+
+	// Select the units around each unit which may look for targets in parallel, before any unit acts; the units then act serially, in slot order
+	stratagus::unit_target_snapshot::get()->take();
 
 	// Check for things that only happen every second
-	if (isASecondCycle) {
-		UnitActionsEachSecond(table.begin(), table.end());
-	}
-	
-	if ((GameCycle % (CYCLES_PER_SECOND * 5)) == 0) {
-		UnitActionsEachFiveSeconds(table.begin(), table.end());
-	}
+	UnitManager.for_each_unit_slot(GameCycle % CYCLES_PER_SECOND, CYCLES_PER_SECOND, UnitActionsEachSecond);
+	UnitManager.for_each_unit_slot(GameCycle % (CYCLES_PER_SECOND * 5), CYCLES_PER_SECOND * 5, UnitActionsEachFiveSeconds);
 	// Do all actions
-	UnitActionsEachCycle(table.begin(), table.end());
-	
+	UnitManager.for_each_unit_slot(0, 1, UnitActionsEachCycle);
 	//Wyrmgus start
-	if ((GameCycle % CYCLES_PER_MINUTE) == 0) {
-		UnitActionsEachMinute(table.begin(), table.end());
-	}
+	UnitManager.for_each_unit_slot(GameCycle % CYCLES_PER_MINUTE, CYCLES_PER_MINUTE, UnitActionsEachMinute);
 	//Wyrmgus end
+
+	stratagus::unit_target_snapshot::get()->clear();
 }
@@ -1415,14 +1415,14 @@ void CommandSharedVision(int player, bool state, int opponent)
 				CMapField &mf = *CMap::Map.Field(i, z);
 				CMapFieldPlayerInfo &mfp = mf.playerInfo;
 
-				if (mfp.Visible[player] && !mfp.Visible[opponent] && !CPlayer::Players[player]->is_revealed()) {
-					mfp.Visible[opponent] = 1;
+				if (mfp.IsExploredBy(player) && !mfp.IsExploredBy(opponent) && !CPlayer::Players[player]->is_revealed()) {
+					mfp.SetExploredBy(opponent);
 					if (opponent == CPlayer::GetThisPlayer()->Index) {
 						CMap::Map.MarkSeenTile(mf, z);
 					}
 				}
-				if (mfp.Visible[opponent] && !mfp.Visible[player] && !CPlayer::Players[opponent]->is_revealed()) {
-					mfp.Visible[player] = 1;
+				if (mfp.IsExploredBy(opponent) && !mfp.IsExploredBy(player) && !CPlayer::Players[opponent]->is_revealed()) {
+					mfp.SetExploredBy(player);
 					if (player == CPlayer::GetThisPlayer()->Index) {
 						CMap::Map.MarkSeenTile(mf, z);
 					}
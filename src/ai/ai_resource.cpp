@@ -48,6 +48,7 @@
 #include "unit/unit.h"
 #include "unit/unit_class.h"
 #include "unit/unit_find.h"
+#include "unit/unit_spatial_index.h"
 #include "unit/unit_type.h"
 #include "upgrade/dependency.h"
 #include "upgrade/upgrade.h"
@@ -213,6 +214,48 @@ private:
 	const stratagus::unit_type *type;
 };
 
+/**
+**  Get the mask of the players whose units can be enemies of a player's units.
+**
+**  Units of other players can be hostile regardless of diplomacy (e.g. neutral hostile units or units with hidden ownership),
+**  so this only excludes the player itself, unless it is its own enemy through its overlord.
+*/
+static uint32_t GetEnemyUnitPlayerMask(const CPlayer &player)
+{
+	uint32_t player_mask = 0;
+
+	for (int i = 0; i < PlayerMax; ++i) {
+		if (i != player.Index || player.IsEnemy(player)) {
+			player_mask |= 1u << i;
+		}
+	}
+
+	return player_mask;
+}
+
+/**
+**  Count the units in an area which fulfill a predicate, through the map layer's spatial index.
+**
+**  The units are only counted, so the order in which the index visits them does not matter.
+*/
+template <typename Pred>
+static int CountUnitsInArea(Vec2i min_pos, Vec2i max_pos, const int z, const uint32_t player_mask, const stratagus::unit_type *unit_type, Pred pred)
+{
+	CMap::Map.FixSelectionArea(min_pos, max_pos, z);
+
+	int count = 0;
+	const QRect tile_rect(QPoint(min_pos.x, min_pos.y), QPoint(max_pos.x, max_pos.y));
+	CMap::Map.MapLayers[z]->get_unit_index()->for_each_unit_in_rect(tile_rect, player_mask, unit_type, [&count, &pred](CUnit *unit, const QRect &unit_tile_rect) {
+		Q_UNUSED(unit_tile_rect)
+
+		if (pred(unit)) {
+			++count;
+		}
+	});
+
+	return count;
+}
+
 /**
 **  Enemy units in distance.
 **
@@ -227,23 +270,21 @@ int AiEnemyUnitsInDistance(const CPlayer &player,
 						   const stratagus::unit_type *type, const Vec2i &pos, unsigned range, int z)
 {
 	const Vec2i offset(range, range);
-	std::vector<CUnit *> units;
+	const uint32_t player_mask = GetEnemyUnitPlayerMask(player);
 
 	if (type == nullptr) {
 		//Wyrmgus start
 //		Select(pos - offset, pos + offset, units, IsAEnemyUnitOf(player));
-		Select(pos - offset, pos + offset, units, z, IsAEnemyUnitOf(player));
+		return CountUnitsInArea(pos - offset, pos + offset, z, player_mask, nullptr, IsAEnemyUnitOf(player));
 		//Wyrmgus end
-		return static_cast<int>(units.size());
 	} else {
 		const Vec2i typeSize(type->get_tile_size() - QSize(1, 1));
 		const IsAEnemyUnitWhichCanCounterAttackOf pred(player, *type);
 
 		//Wyrmgus start
 //		Select(pos - offset, pos + typeSize + offset, units, pred);
-		Select(pos - offset, pos + typeSize + offset, units, z, pred);
+		return CountUnitsInArea(pos - offset, pos + typeSize + offset, z, player_mask, nullptr, pred);
 		//Wyrmgus end
-		return static_cast<int>(units.size());
 	}
 }
 
@@ -2676,9 +2717,9 @@ static void AiCheckMinecartConstruction()
 					continue;
 				}
 				
-				std::vector<CUnit *> settlement_minecart_table;
-				SelectAroundUnit(*mine_unit, 8, settlement_minecart_table, MakeAndPredicate(HasSamePlayerAs(*AiPlayer->Player), HasSameTypeAs(*minecart_type)));
-				int settlement_minecart_count = settlement_minecart_table.size();
+				const Vec2i offset(8, 8);
+				const Vec2i mine_size(mine_unit->Type->get_tile_size() - QSize(1, 1));
+				int settlement_minecart_count = CountUnitsInArea(mine_unit->tilePos - offset, mine_unit->tilePos + mine_size + offset, mine_unit->MapLayer->ID, 1u << AiPlayer->Player->Index, minecart_type, NoFilter());
 				settlement_minecart_count += mine_unit->GetTotalInsideCount(AiPlayer->Player, true, false, minecart_type);
 				settlement_minecart_count += town_hall_unit->GetTotalInsideCount(AiPlayer->Player, true, false, minecart_type);
 				settlement_minecart_count += AiGetUnitTypeRequestedCount(*AiPlayer, minecart_type, 0, mine_settlement);
@@ -153,7 +153,7 @@
 	} else if (!strcmp(next + 1, "Max")) {
 		goal->Variable[index].Max = value;
 	} else if (!strcmp(next + 1, "Increase")) {
-		goal->Variable[index].Increase = value;
+		goal->set_variable_increase(index, value);
 	} else if (!strcmp(next + 1, "Enable")) {
 		goal->Variable[index].Enable = value;
 	} else if (!strcmp(next + 1, "Percent")) {
@@ -74,12 +74,183 @@
 #include "unit/unit_type.h"
 #include "upgrade/upgrade_class.h"
 #include "upgrade/upgrade_structs.h"
+#include "util/binary_stream.h"
+#include "util/exception_util.h"
 #include "util/qunique_ptr.h"
 #include "util/string_util.h"
+#include "util/thread_pool.h"
 #include "world.h"
 
+#include <QCryptographicHash>
+
 namespace stratagus {
 
+static constexpr const char *sml_data_cache_magic = "WYRMSMLC";
+static constexpr uint16_t sml_data_cache_version = 1;
+
+/**
+**	@brief	Get the key for the cached SML data of a folder
+**
+**	The key is a hash of the relative paths, sizes and modification times of the folder's data files, so that any change to the files invalidates the cache without their content having to be read.
+*/
+static QByteArray get_sml_data_cache_key(const std::filesystem::path &path, const std::vector<std::filesystem::path> &filepaths)
+{
+	QCryptographicHash hash(QCryptographicHash::Sha1);
+
+	hash.addData(QByteArray::number(sml_data_cache_version));
+	hash.addData(";", 1);
+
+	for (const std::filesystem::path &filepath : filepaths) {
+		hash.addData(QByteArray::fromStdString(std::filesystem::relative(filepath, path).generic_string()));
+		hash.addData(",", 1);
+		hash.addData(QByteArray::number(static_cast<qulonglong>(std::filesystem::file_size(filepath))));
+		hash.addData(",", 1);
+		hash.addData(QByteArray::number(static_cast<qlonglong>(std::filesystem::last_write_time(filepath).time_since_epoch().count())));
+		hash.addData(";", 1);
+	}
+
+	return hash.result();
+}
+
+static std::filesystem::path get_sml_data_cache_filepath(const std::filesystem::path &path)
+{
+	//each folder has a single cache file, which is replaced when the folder's files change
+	const QByteArray path_hash = QCryptographicHash::hash(QByteArray::fromStdString(std::filesystem::absolute(path).generic_string()), QCryptographicHash::Sha1);
+	return database::get_cache_path() / "database" / (path_hash.toHex().toStdString() + ".bin");
+}
+
+/**
+**	@brief	Load the cached SML data of a folder
+**
+**	@param	path			The folder's path
+**	@param	key				The cache key for the folder's current files
+**	@param	sml_data_list	The list to which the SML data is added if it is loaded
+**
+**	@return	True if the SML data was loaded from the cache, or false otherwise
+*/
+static bool load_cached_sml_data(const std::filesystem::path &path, const QByteArray &key, std::vector<sml_data> &sml_data_list)
+{
+	try {
+		const std::filesystem::path filepath = get_sml_data_cache_filepath(path);
+
+		if (!std::filesystem::exists(filepath)) {
+			return false;
+		}
+
+		std::ifstream ifstream(filepath, std::ios::binary);
+		if (!ifstream) {
+			return false;
+		}
+
+		const std::string file_content(std::istreambuf_iterator<char>{ifstream}, std::istreambuf_iterator<char>{});
+		binary_reader reader(file_content);
+
+		if (reader.read_bytes(std::strlen(sml_data_cache_magic)) != sml_data_cache_magic || reader.read<uint16_t>() != sml_data_cache_version) {
+			return false;
+		}
+
+		if (reader.read_bytes(key.size()) != std::string_view(key.constData(), key.size())) {
+			return false;
+		}
+
+		const uint32_t file_count = reader.read<uint32_t>();
+		std::vector<sml_data> file_sml_data_list;
+		file_sml_data_list.reserve(file_count);
+
+		for (uint32_t i = 0; i < file_count; ++i) {
+			file_sml_data_list.push_back(sml_data::from_binary(reader));
+		}
+
+		if (!reader.is_at_end()) {
+			return false;
+		}
+
+		for (sml_data &file_sml_data : file_sml_data_list) {
+			sml_data_list.push_back(std::move(file_sml_data));
+		}
+
+		return true;
+	} catch (const std::exception &exception) {
+		exception::report(exception);
+		return false;
+	}
+}
+
+static void save_cached_sml_data(const std::filesystem::path &path, const QByteArray &key, const std::vector<sml_data> &file_sml_data_list)
+{
+	const std::filesystem::path filepath = get_sml_data_cache_filepath(path);
+
+	std::string buffer;
+	binary_writer writer(buffer);
+	writer.write_bytes(sml_data_cache_magic, std::strlen(sml_data_cache_magic));
+	writer.write<uint16_t>(sml_data_cache_version);
+	writer.write_bytes(key.constData(), key.size());
+	writer.write<uint32_t>(static_cast<uint32_t>(file_sml_data_list.size()));
+
+	for (const sml_data &file_sml_data : file_sml_data_list) {
+		file_sml_data.write_binary(writer);
+	}
+
+	std::filesystem::create_directories(filepath.parent_path());
+
+	//write to a temporary file first, so that an interrupted write cannot leave a partial cache file behind
+	std::filesystem::path temp_filepath = filepath;
+	temp_filepath += ".tmp";
+
+	{
+		std::ofstream ofstream(temp_filepath, std::ios::binary);
+		if (!ofstream) {
+			throw std::runtime_error("Failed to open file: " + temp_filepath.string());
+		}
+
+		ofstream.write(buffer.data(), buffer.size());
+
+		if (!ofstream) {
+			throw std::runtime_error("Failed to write file: " + temp_filepath.string());
+		}
+	}
+
+	std::filesystem::rename(temp_filepath, filepath);
+}
+
+/**
+**	@brief	Get the index of a meta object's property from its name
+**
+**	The property indexes of each meta object are mapped by name the first time that they are needed, so that setting properties from the database does not require going through all of the meta object's properties each time.
+**
+**	@param	meta_object		The meta object
+**	@param	property_name	The property's name
+**
+**	@return	The property's index, or -1 if the meta object has no property with that name
+*/
+static int get_meta_property_index(const QMetaObject *meta_object, const std::string &property_name)
+{
+	static std::map<const QMetaObject *, std::map<std::string, int>> property_indexes_by_meta_object;
+	static std::mutex mutex;
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	auto find_iterator = property_indexes_by_meta_object.find(meta_object);
+	if (find_iterator == property_indexes_by_meta_object.end()) {
+		std::map<std::string, int> property_indexes;
+
+		const int property_count = meta_object->propertyCount();
+		for (int i = 0; i < property_count; ++i) {
+			property_indexes.emplace(meta_object->property(i).name(), i);
+		}
+
+		find_iterator = property_indexes_by_meta_object.emplace(meta_object, std::move(property_indexes)).first;
+	}
+
+	const std::map<std::string, int> &property_indexes = find_iterator->second;
+	const auto property_find_iterator = property_indexes.find(property_name);
+	if (property_find_iterator == property_indexes.end()) {
+		return -1;
+	}
+
+	return property_find_iterator->second;
+}
+
 /**
 **	@brief	Process a SML property for an instance of a QObject-derived class
 **
@@ -90,44 +261,38 @@ void database::process_sml_property_for_object(QObject *object, const sml_proper
 {
 	const QMetaObject *meta_object = object->metaObject();
 	const std::string class_name = meta_object->className();
-	const int property_count = meta_object->propertyCount();
-	for (int i = 0; i < property_count; ++i) {
-		QMetaProperty meta_property = meta_object->property(i);
-		const char *property_name = meta_property.name();
+	const int property_index = get_meta_property_index(meta_object, property.get_key());
 
-		if (property_name != property.get_key()) {
-			continue;
-		}
+	if (property_index == -1) {
+		throw std::runtime_error("Invalid " + std::string(meta_object->className()) + " property: \"" + property.get_key() + "\".");
+	}
 
-		const QVariant::Type property_type = meta_property.type();
+	QMetaProperty meta_property = meta_object->property(property_index);
+	const char *property_name = meta_property.name();
 
-		if (property_type == QVariant::Type::List || property_type == QVariant::Type::StringList) {
-			database::modify_list_property_for_object(object, property_name, property.get_operator(), property.get_value());
-			return;
-		} else if (property_type == QVariant::String) {
-			if (property.get_operator() != sml_operator::assignment) {
-				throw std::runtime_error("Only the assignment operator is available for string properties.");
-			}
+	const QVariant::Type property_type = meta_property.type();
 
-			const std::string method_name = "set_" + property.get_key();
+	if (property_type == QVariant::Type::List || property_type == QVariant::Type::StringList) {
+		database::modify_list_property_for_object(object, property_name, property.get_operator(), property.get_value());
+	} else if (property_type == QVariant::String) {
+		if (property.get_operator() != sml_operator::assignment) {
+			throw std::runtime_error("Only the assignment operator is available for string properties.");
+		}
 
-			const bool success = QMetaObject::invokeMethod(object, method_name.c_str(), Qt::ConnectionType::DirectConnection, Q_ARG(const std::string &, property.get_value()));
+		const std::string method_name = "set_" + property.get_key();
 
-			if (!success) {
-				throw std::runtime_error("Failed to set value for string property \"" + property.get_key() + "\".");
-			}
-			return;
-		} else {
-			QVariant new_property_value = database::process_sml_property_value(property, meta_property, object);
-			bool success = object->setProperty(property_name, new_property_value);
-			if (!success) {
-				throw std::runtime_error("Failed to set value for property \"" + std::string(property_name) + "\".");
-			}
-			return;
+		const bool success = QMetaObject::invokeMethod(object, method_name.c_str(), Qt::ConnectionType::DirectConnection, Q_ARG(const std::string &, property.get_value()));
+
+		if (!success) {
+			throw std::runtime_error("Failed to set value for string property \"" + property.get_key() + "\".");
+		}
+	} else {
+		QVariant new_property_value = database::process_sml_property_value(property, meta_property, object);
+		bool success = object->setProperty(property_name, new_property_value);
+		if (!success) {
+			throw std::runtime_error("Failed to set value for property \"" + std::string(property_name) + "\".");
 		}
 	}
-
-	throw std::runtime_error("Invalid " + std::string(meta_object->className()) + " property: \"" + property.get_key() + "\".");
 }
 
 QVariant database::process_sml_property_value(const sml_property &property, const QMetaProperty &meta_property, const QObject *object)
@@ -459,6 +624,8 @@ std::filesystem::path database::get_base_path(const module *module)
 
 void database::parse_folder(const std::filesystem::path &path, std::vector<sml_data> &sml_data_list)
 {
+	std::vector<std::filesystem::path> filepaths;
+
 	std::filesystem::recursive_directory_iterator dir_iterator(path);
 
 	for (const std::filesystem::directory_entry &dir_entry : dir_iterator) {
@@ -466,8 +633,35 @@ void database::parse_folder(const std::filesystem::path &path, std::vector<sml_d
 			continue;
 		}
 
-		sml_parser parser(dir_entry.path());
-		sml_data_list.push_back(parser.parse());
+		filepaths.push_back(dir_entry.path());
+	}
+
+	//sort the file paths, so that the parsed data is in a deterministic order regardless of the directory iteration order
+	std::sort(filepaths.begin(), filepaths.end());
+
+	const QByteArray cache_key = get_sml_data_cache_key(path, filepaths);
+	if (load_cached_sml_data(path, cache_key, sml_data_list)) {
+		return;
+	}
+
+	//parse each file in its own task, placing the results in the same order as the file paths
+	std::vector<sml_data> file_sml_data_list(filepaths.size());
+
+	thread_pool::get()->parallel_for(filepaths.size(), [&filepaths, &file_sml_data_list](const size_t begin, const size_t end) {
+		for (size_t i = begin; i < end; ++i) {
+			sml_parser parser(filepaths[i]);
+			file_sml_data_list[i] = parser.parse();
+		}
+	});
+
+	try {
+		save_cached_sml_data(path, cache_key, file_sml_data_list);
+	} catch (const std::exception &exception) {
+		exception::report(exception);
+	}
+
+	for (sml_data &file_sml_data : file_sml_data_list) {
+		sml_data_list.push_back(std::move(file_sml_data));
 	}
 }
 
@@ -485,10 +679,12 @@ void database::parse()
 		const std::filesystem::path &path = kv_pair.first;
 		const module *module = kv_pair.second;
 
-		//parse the files in each data type's folder
-		for (const std::unique_ptr<data_type_metadata> &metadata : this->metadata) {
-			metadata->get_parsing_function()(path, module);
-		}
+		//parse the files in each data type's folder; each data type stores its parsed data separately, so the data types can be parsed in parallel, while modules are parsed in order
+		thread_pool::get()->parallel_for(this->metadata.size(), [this, &path, module](const size_t begin, const size_t end) {
+			for (size_t i = begin; i < end; ++i) {
+				this->metadata[i]->get_parsing_function()(path, module);
+			}
+		});
 	}
 }
 
@@ -111,6 +111,11 @@ public:
 		return documents_path;
 	}
 
+	static std::filesystem::path get_cache_path()
+	{
+		return database::get_documents_path() / "cache";
+	}
+
 	static std::filesystem::path get_base_path(const module *module);
 
 	static std::filesystem::path get_graphics_path(const module *module)
@@ -33,9 +33,47 @@
 
 #include "database/sml_operator.h"
 #include "database/sml_property_visitor.h"
+#include "util/binary_stream.h"
 
 namespace stratagus {
 
+/**
+**	@brief	Read SML data written by write_binary
+**
+**	@param	reader	The binary reader
+**
+**	@return	The SML data
+*/
+sml_data sml_data::from_binary(binary_reader &reader)
+{
+	std::string tag = reader.read_string();
+	const sml_operator scope_operator = reader.read<sml_operator>();
+	sml_data data(std::move(tag), scope_operator);
+
+	const uint32_t value_count = reader.read<uint32_t>();
+	data.values.reserve(value_count);
+	for (uint32_t i = 0; i < value_count; ++i) {
+		data.add_value(reader.read_string());
+	}
+
+	const uint32_t element_count = reader.read<uint32_t>();
+	data.elements.reserve(element_count);
+	for (uint32_t i = 0; i < element_count; ++i) {
+		const bool is_property = reader.read<uint8_t>() != 0;
+
+		if (is_property) {
+			std::string key = reader.read_string();
+			const sml_operator property_operator = reader.read<sml_operator>();
+			std::string value = reader.read_string();
+			data.add_property(std::move(key), property_operator, std::move(value));
+		} else {
+			data.add_child(sml_data::from_binary(reader));
+		}
+	}
+
+	return data;
+}
+
 sml_data::sml_data(std::string &&tag)
 	: tag(std::move(tag)), scope_operator(sml_operator::assignment)
 {
@@ -51,6 +89,33 @@ void sml_data::add_property(std::string &&key, const sml_operator sml_operator,
 	this->elements.push_back(sml_property(std::move(key), sml_operator, std::move(value)));
 }
 
+/**
+**	@brief	Write the SML data in a binary form, so that it can be read back without being parsed again
+**
+**	@param	writer	The binary writer
+*/
+void sml_data::write_binary(binary_writer &writer) const
+{
+	writer.write_string(this->get_tag());
+	writer.write<sml_operator>(this->get_operator());
+
+	writer.write<uint32_t>(static_cast<uint32_t>(this->get_values().size()));
+	for (const std::string &value : this->get_values()) {
+		writer.write_string(value);
+	}
+
+	writer.write<uint32_t>(static_cast<uint32_t>(this->get_elements().size()));
+	this->for_each_element([&](const sml_property &property) {
+		writer.write<uint8_t>(1);
+		writer.write_string(property.get_key());
+		writer.write<sml_operator>(property.get_operator());
+		writer.write_string(property.get_value());
+	}, [&](const sml_data &child_data) {
+		writer.write<uint8_t>(0);
+		child_data.write_binary(writer);
+	});
+}
+
 void sml_data::print(std::ofstream &ofstream, const size_t indentation, const bool new_line) const
 {
 	if (new_line) {
@@ -38,6 +38,8 @@
 
 namespace stratagus {
 
+class binary_reader;
+class binary_writer;
 class sml_parser;
 
 //stratagus markup language data
@@ -53,6 +55,8 @@ public:
 		return point_data;
 	}
 
+	static sml_data from_binary(binary_reader &reader);
+
 	sml_data(std::string &&tag = std::string());
 
 	sml_data(std::string &&tag, const sml_operator scope_operator)
@@ -293,6 +297,8 @@ public:
 
 	void print(std::ofstream &ofstream, const size_t indentation, const bool new_line) const;
 
+	void write_binary(binary_writer &writer) const;
+
 	void print_components(std::ofstream &ofstream, const size_t indentation = 0) const
 	{
 		if (!this->get_values().empty()) {
@@ -34,6 +34,8 @@
 #include "database/sml_data.h"
 #include "database/sml_operator.h"
 
+#include <QFile>
+
 namespace stratagus {
 
 sml_parser::sml_parser(const std::filesystem::path &filepath)
@@ -47,23 +49,44 @@ sml_data sml_parser::parse()
 		throw std::runtime_error("File \"" + this->filepath.string() + "\" not found.");
 	}
 
-	std::ifstream ifstream(this->filepath);
+	QFile file(QString::fromStdString(this->filepath.string()));
 
-	if (!ifstream) {
+	if (!file.open(QIODevice::ReadOnly)) {
 		throw std::runtime_error("Failed to open file: " + this->filepath.string());
 	}
 
+	//map the file into memory, so that tokens can reference its data directly instead of being copied; if mapping fails, read the file's contents instead
+	QByteArray file_contents;
+	std::string_view file_data;
+	const qint64 file_size = file.size();
+
+	if (file_size > 0) {
+		const uchar *mapped_data = file.map(0, file_size);
+		if (mapped_data != nullptr) {
+			file_data = std::string_view(reinterpret_cast<const char *>(mapped_data), static_cast<size_t>(file_size));
+		} else {
+			file_contents = file.readAll();
+			file_data = std::string_view(file_contents.constData(), static_cast<size_t>(file_contents.size()));
+		}
+	}
+
 	sml_data file_sml_data(this->filepath.stem().string());
 
-	std::string line;
 	int line_index = 1;
 	this->current_sml_data = &file_sml_data;
 
 	try {
-		while (std::getline(ifstream, line)) {
-			this->parse_line(line);
+		size_t line_begin = 0;
+		while (line_begin < file_data.size()) {
+			size_t line_end = file_data.find('\n', line_begin);
+			if (line_end == std::string_view::npos) {
+				line_end = file_data.size();
+			}
+
+			this->parse_line(file_data.substr(line_begin, line_end - line_begin));
 			this->parse_tokens();
 			++line_index;
+			line_begin = line_end + 1;
 		}
 	} catch (std::exception &exception) {
 		throw std::runtime_error("Error parsing data file \"" + this->filepath.string() + "\", line " + std::to_string(line_index) + ": " + exception.what());
@@ -74,13 +97,38 @@ sml_data sml_parser::parse()
 	return file_sml_data;
 }
 
-void sml_parser::parse_line(const std::string &line)
+void sml_parser::parse_line(const std::string_view &line)
 {
 	bool opened_quotation_marks = false;
 	bool escaped = false;
-	std::string current_string;
 
-	for (const char c : line) {
+	//the current token references the line directly while its characters are contiguous in it, and is only copied into an owned string otherwise
+	const char *token_begin = nullptr;
+	size_t token_size = 0;
+	std::string *token_string = nullptr;
+
+	const auto get_token_string = [&]() -> std::string & {
+		if (token_string == nullptr) {
+			token_string = &this->token_strings.emplace_back(std::string_view(token_begin, token_size));
+		}
+
+		return *token_string;
+	};
+
+	const auto finish_token = [&]() {
+		if (token_string != nullptr) {
+			this->tokens.push_back(*token_string);
+			token_string = nullptr;
+		} else if (token_size > 0) {
+			this->tokens.emplace_back(token_begin, token_size);
+		}
+
+		token_size = 0;
+	};
+
+	for (size_t i = 0; i < line.size(); ++i) {
+		const char c = line[i];
+
 		if (!escaped) {
 			if (c == '\"') {
 				opened_quotation_marks = !opened_quotation_marks;
@@ -98,11 +146,7 @@ void sml_parser::parse_line(const std::string &line)
 
 			//whitespace, carriage returns and etc. separate tokens, if they occur outside of quotes
 			if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
-				if (!current_string.empty()) {
-					this->tokens.push_back(std::move(current_string));
-					current_string = std::string();
-				}
-
+				finish_token();
 				continue;
 			}
 		}
@@ -110,17 +154,25 @@ void sml_parser::parse_line(const std::string &line)
 		if (escaped) {
 			escaped = false;
 
-			if (this->parse_escaped_character(current_string, c)) {
+			if (this->parse_escaped_character(get_token_string(), c)) {
 				continue;
 			}
 		}
 
-		current_string += c;
+		if (token_string != nullptr) {
+			token_string->push_back(c);
+		} else if (token_size == 0) {
+			token_begin = &line[i];
+			token_size = 1;
+		} else if (token_begin + token_size == &line[i]) {
+			++token_size;
+		} else {
+			//a quotation mark or escape character was skipped within the token, so it can no longer reference the line directly
+			get_token_string().push_back(c);
+		}
 	}
 
-	if (!current_string.empty()) {
-		this->tokens.push_back(std::move(current_string));
-	}
+	finish_token();
 }
 
 /**
@@ -155,7 +207,7 @@ bool sml_parser::parse_escaped_character(std::string &current_string, const char
 */
 void sml_parser::parse_tokens()
 {
-	for (std::string &token : this->tokens) {
+	for (const std::string_view &token : this->tokens) {
 		if (!this->current_key.empty() && this->current_property_operator == sml_operator::none && token != "=" && token != "+=" && token != "-=" && token != "==" && token != "!=" && token != "<" && token != "<=" && token != ">" && token != ">=" && token != "{") {
 			//if the previously-given key isn't empty and no operator has been provided before or now, then the key was actually a value, part of a simple collection of values
 			this->current_sml_data->add_value(std::move(this->current_key));
@@ -178,7 +230,7 @@ void sml_parser::parse_tokens()
 
 				this->current_sml_data = this->current_sml_data->parent;
 			} else { //key
-				this->current_key = std::move(token);
+				this->current_key = std::string(token);
 			}
 
 			continue;
@@ -204,7 +256,7 @@ void sml_parser::parse_tokens()
 			} else if (token == ">=") {
 				this->current_property_operator = sml_operator::greater_than_or_equality;
 			} else {
-				throw std::runtime_error("Tried using operator \"" + token + "\" for key \"" + this->current_key + "\", but it is not a valid operator.");
+				throw std::runtime_error("Tried using operator \"" + std::string(token) + "\" for key \"" + this->current_key + "\", but it is not a valid operator.");
 			}
 
 			continue;
@@ -221,7 +273,7 @@ void sml_parser::parse_tokens()
 			new_sml_data.parent = this->current_sml_data;
 			this->current_sml_data = &new_sml_data;
 		} else {
-			this->current_sml_data->add_property(std::move(this->current_key), this->current_property_operator, std::move(token));
+			this->current_sml_data->add_property(std::move(this->current_key), this->current_property_operator, std::string(token));
 		}
 
 		this->current_key = std::string();
@@ -229,11 +281,13 @@ void sml_parser::parse_tokens()
 	}
 
 	this->tokens.clear();
+	this->token_strings.clear();
 }
 
 void sml_parser::reset()
 {
 	this->tokens.clear();
+	this->token_strings.clear();
 	this->current_sml_data = nullptr;
 	this->current_key = std::string();
 	this->current_property_operator = sml_operator::none;
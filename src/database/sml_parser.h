@@ -44,14 +44,15 @@ public:
 	sml_data parse();
 
 private:
-	void parse_line(const std::string &line);
+	void parse_line(const std::string_view &line);
 	bool parse_escaped_character(std::string &current_string, const char c);
 	void parse_tokens();
 	void reset();
 
 private:
 	std::filesystem::path filepath;
-	std::vector<std::string> tokens;
+	std::vector<std::string_view> tokens; //the tokens of the current line, referencing either the file data or token_strings
+	std::deque<std::string> token_strings; //owned strings for the tokens of the current line which are not contiguous in the file data, e.g. because they contain escaped characters
 	sml_data *current_sml_data = nullptr;
 	std::string current_key;
 	sml_operator current_property_operator;
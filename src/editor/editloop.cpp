@@ -251,7 +251,7 @@ static void EditTile(const Vec2i &pos, stratagus::terrain_type *terrain)
 	}
 	//Wyrmgus end
 
-	UI.Minimap.UpdateSeenXY(pos);
+	UI.Minimap.UpdateSeenXY(pos, UI.CurrentMapLayer->ID);
 	//Wyrmgus start
 //	UI.Minimap.UpdateXY(pos);
 	UI.Minimap.UpdateXY(pos, UI.CurrentMapLayer->ID);
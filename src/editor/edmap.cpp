@@ -168,7 +168,7 @@ void EditorChangeTile(const Vec2i &pos, int tileIndex)
 	}
 	//Wyrmgus end
 
-	UI.Minimap.UpdateSeenXY(pos);
+	UI.Minimap.UpdateSeenXY(pos, UI.CurrentMapLayer->ID);
 	UI.Minimap.UpdateXY(pos, UI.CurrentMapLayer->ID);
 
 	EditorChangeSurrounding(pos, tile);
@@ -0,0 +1,170 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+//      (c) Copyright 2020 by Andrettin
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+//
+
+#include "stratagus.h"
+
+#include "game/benchmark.h"
+
+#include "actions.h"
+#include "ai.h"
+#include "pathfinder.h"
+#include "player.h"
+#include "unit/unit_manager.h"
+#include "util/random.h"
+
+extern void StartMap(const std::string &filename, bool clean);
+extern void StartSavedGame(const std::string &filename);
+
+namespace stratagus {
+
+/**
+**	@brief	Run the benchmark
+**
+**	@param	filepath	The map or saved game to run the benchmark for
+*/
+void benchmark::run(const std::string &filepath)
+{
+	this->filepath = filepath;
+	this->saved_game = benchmark::is_saved_game_path(filepath);
+
+	//use the default seed, so that map generation is the same in each run
+	random::get()->reset_seed(true);
+	SyncHash = 0;
+
+	if (this->saved_game) {
+		StartSavedGame(filepath);
+	} else {
+		StartMap(filepath, true);
+	}
+}
+
+/**
+**	@brief	Get whether a path is that of a saved game, i.e. whether its extension is ".sav", optionally followed by a compression extension
+**
+**	@param	filepath	The path
+**
+**	@return	True if the path is that of a saved game, or false otherwise
+*/
+bool benchmark::is_saved_game_path(const std::filesystem::path &filepath)
+{
+	std::filesystem::path extension = filepath.extension();
+
+	if (extension == ".gz" || extension == ".bz2") {
+		extension = filepath.stem().extension();
+	}
+
+	return extension == ".sav";
+}
+
+/**
+**	@brief	Prepare the game which has just been set up for the benchmark
+*/
+void benchmark::start_game()
+{
+	//let the AI control the players which would otherwise be waiting for input
+	for (int i = 0; i < NumPlayers; ++i) {
+		CPlayer *player = CPlayer::Players[i];
+
+		if (player->Type != PlayerPerson) {
+			continue;
+		}
+
+		player->Type = PlayerComputer;
+		player->AiEnabled = true;
+		if (!player->Ai) {
+			AiInit(*player);
+		}
+	}
+
+	this->end_cycle = GameCycle + this->cycle_count;
+	this->cycle_durations.clear();
+	UnitManager.reset_allocation_counters();
+	this->cycle_durations.reserve(this->cycle_count);
+}
+
+bool benchmark::is_finished() const
+{
+	return GameCycle >= this->end_cycle;
+}
+
+/**
+**	@brief	Print the cycle timing percentiles, the unit allocation counts, the path cache statistics and the final sync hash to the standard output
+**
+**	The path cache statistics are counted from the start of the game, as the path cache is reset when the pathfinder is initialized.
+*/
+void benchmark::print_results() const
+{
+	std::vector<std::chrono::steady_clock::duration> sorted_durations = this->cycle_durations;
+	std::sort(sorted_durations.begin(), sorted_durations.end());
+
+	const auto to_milliseconds = [](const std::chrono::steady_clock::duration &duration) {
+		return std::chrono::duration<double, std::milli>(duration).count();
+	};
+
+	//get a percentile with the nearest-rank method
+	const auto get_percentile = [&](const size_t percentile) {
+		if (sorted_durations.empty()) {
+			return 0.;
+		}
+
+		const size_t rank = std::max<size_t>((percentile * sorted_durations.size() + 99) / 100, 1);
+		return to_milliseconds(sorted_durations[rank - 1]);
+	};
+
+	std::chrono::steady_clock::duration total_duration(0);
+	for (const std::chrono::steady_clock::duration &duration : sorted_durations) {
+		total_duration += duration;
+	}
+
+	const double total_milliseconds = to_milliseconds(total_duration);
+	const double mean_milliseconds = sorted_durations.empty() ? 0. : total_milliseconds / sorted_durations.size();
+	const AStarPathCacheStats path_cache_stats = AStarGetPathCacheStats();
+
+	printf("Benchmark: %s\n", this->filepath.c_str());
+	printf("Cycles: %lu of %lu\n", static_cast<unsigned long>(sorted_durations.size()), this->cycle_count);
+	printf("Total time: %.3f ms\n", total_milliseconds);
+	printf("Cycle time mean: %.3f ms\n", mean_milliseconds);
+	printf("Cycle time p50: %.3f ms\n", get_percentile(50));
+	printf("Cycle time p90: %.3f ms\n", get_percentile(90));
+	printf("Cycle time p99: %.3f ms\n", get_percentile(99));
+	printf("Cycle time max: %.3f ms\n", get_percentile(100));
+	printf("Unit allocations in new slots: %u\n", UnitManager.get_new_slot_allocation_count());
+	printf("Unit allocations reusing released units: %u\n", UnitManager.get_reused_allocation_count());
+	printf("Unit releases: %u\n", UnitManager.get_release_count());
+	printf("Released units awaiting reuse: %lu\n", static_cast<unsigned long>(UnitManager.get_released_unit_count()));
+	printf("Unit slot chunks: %lu\n", static_cast<unsigned long>(UnitManager.get_slot_chunk_count()));
+	printf("Path cache hits: %lu\n", path_cache_stats.Hits);
+	printf("Path cache misses: %lu\n", path_cache_stats.Misses);
+	printf("Path cache invalidations: %lu\n", path_cache_stats.Invalidations);
+	printf("Path cache flushes: %lu\n", path_cache_stats.Flushes);
+	printf("Path cache size: %lu\n", static_cast<unsigned long>(path_cache_stats.Size));
+	printf("Final game cycle: %lu\n", GameCycle);
+	printf("Sync hash: 0x%08X\n", SyncHash);
+	fflush(stdout);
+}
+
+}
@@ -0,0 +1,79 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+//      (c) Copyright 2020 by Andrettin
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+//
+
+#pragma once
+
+#include "util/singleton.h"
+
+namespace stratagus {
+
+/**
+**	@brief	Runs a game for a given quantity of cycles without drawing or waiting for real time, measuring how long each cycle takes
+**
+**	The benchmark is enabled with the -B command-line option, and runs the map or saved game given on the command line. All players are controlled by the AI and the random seed is fixed, so that runs of the same build play out the same way and report the same sync hash.
+*/
+class benchmark final : public singleton<benchmark>
+{
+public:
+	static bool is_saved_game_path(const std::filesystem::path &filepath);
+
+	bool is_enabled() const
+	{
+		return this->cycle_count > 0;
+	}
+
+	unsigned long get_cycle_count() const
+	{
+		return this->cycle_count;
+	}
+
+	void set_cycle_count(const unsigned long cycle_count)
+	{
+		this->cycle_count = cycle_count;
+	}
+
+	void run(const std::string &filepath);
+	void start_game();
+
+	bool is_finished() const;
+
+	void add_cycle_duration(const std::chrono::steady_clock::duration &duration)
+	{
+		this->cycle_durations.push_back(duration);
+	}
+
+	void print_results() const;
+
+private:
+	std::string filepath;
+	bool saved_game = false;
+	unsigned long cycle_count = 0;
+	unsigned long end_cycle = 0;
+	std::vector<std::chrono::steady_clock::duration> cycle_durations;
+};
+
+}
@@ -49,6 +49,7 @@
 #include "editor.h"
 #include "faction.h"
 #include "font.h"
+#include "game/benchmark.h"
 //Wyrmgus start
 #include "grand_strategy.h"
 //Wyrmgus end
@@ -1666,7 +1667,8 @@ void CreateGame(const std::string &filename, CMap *map, bool is_mod)
 	GameCycle = 0;
 	FastForwardCycle = 0;
 	SyncHash = 0;
-	stratagus::random::get()->reset_seed(IsNetworkGame());
+	//network games and benchmarks use the default seed, so that their random events are the same on each machine or run
+	stratagus::random::get()->reset_seed(IsNetworkGame() || stratagus::benchmark::get()->is_enabled());
 
 	if (IsNetworkGame()) { // Prepare network play
 		NetworkOnStartGame();
@@ -1876,6 +1878,7 @@ static void CleanGame_Lua()
 */
 void CleanGame()
 {
+	WaitForBackgroundSaveGame();
 	EndReplayLog();
 	CleanMessages();
 
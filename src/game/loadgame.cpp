@@ -39,6 +39,7 @@
 #include "database/database.h"
 #include "dialogue.h"
 #include "font.h"
+#include "game/save_game_file.h"
 //Wyrmgus start
 #include "grand_strategy.h"
 //Wyrmgus end
@@ -239,6 +240,49 @@ static void PlaceUnits()
 	}
 }
 
+/**
+**  Execute the sections of a save game file.
+**
+**  Legacy save games, which consist only of Lua code, are executed as a whole.
+**
+**  @param filename  File name to be loaded.
+*/
+static void LoadSaveGameFile(const std::string &filename)
+{
+	DebugPrint("Loading '%s'\n" _C_ filename.c_str());
+
+	std::string content;
+	if (!GetFileContent(filename, content)) {
+		return;
+	}
+
+	if (!stratagus::save_game_reader::is_save_game_data(content)) {
+		LuaLoadBuffer(content, filename);
+		return;
+	}
+
+	try {
+		stratagus::save_game_reader reader(content);
+		while (const std::optional<stratagus::save_game_reader::section> section = reader.read_section()) {
+			switch (section->type) {
+				case stratagus::save_game_section_type::lua_script:
+					LuaLoadBuffer(section->data, filename + ":" + section->name);
+					break;
+				case stratagus::save_game_section_type::map_tiles: {
+					stratagus::binary_reader section_reader(section->data);
+					CMap::Map.load_tile_planes(section_reader);
+					break;
+				}
+				default:
+					DebugPrint("Skipping unknown save game section \"%s\"\n" _C_ section->name.c_str());
+					break;
+			}
+		}
+	} catch (...) {
+		std::throw_with_nested(std::runtime_error("Failed to load save game \"" + filename + "\"."));
+	}
+}
+
 /**
 **  Load a game to file.
 **
@@ -270,7 +314,7 @@ void LoadGame(const std::string &filename)
 	//Wyrmgus start
 	CalculateItemsToLoad();
 	//Wyrmgus end
-	LuaLoadFile(filename);
+	LoadSaveGameFile(filename);
 	LuaGarbageCollect();
 
 	PlaceUnits();
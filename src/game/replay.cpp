@@ -124,7 +124,7 @@ public:
 		Resource(0), NumUnits(0), Difficulty(0), NoFow(false), Inside(false), RevealMap(0),
 		//Wyrmgus start
 //		MapRichness(0), GameType(0), Opponents(0), Commands(nullptr)
-		MapRichness(0), GameType(0), Opponents(0), NoRandomness(false), NoTimeOfDay(false), TechLevel(0), MaxTechLevel(0), Commands(nullptr)
+		MapRichness(0), GameType(0), Opponents(0), NoRandomness(false), NoTimeOfDay(false), TechLevel(0), MaxTechLevel(0), Version(0), Commands(nullptr)
 		//Wyrmgus end
 	{
 		memset(Engine, 0, sizeof(Engine));
@@ -161,6 +161,7 @@ public:
 	//Wyrmgus end
 	int TechLevel;
 	int MaxTechLevel;
+	int Version;   /// Version of the game logic the replay was recorded with, 0 if it predates versioning
 	int Engine[3];
 	int Network[3];
 	LogEntry *Commands;
@@ -170,6 +171,18 @@ public:
 // Constants
 //----------------------------------------------------------------------------
 
+/**
+**  Version of the game logic replays are recorded with, to be increased
+**  whenever a change makes replays recorded before it go out of sync.
+**
+**  1: long paths are routed through the cluster graph of the map layer, if the pathfinder knows unseen terrain
+**  2: cluster graph routes are cached and shared by units going to the same goal
+**  3: units choose their targets from the units around them at the start of the cycle
+**  4: units are processed in the order of their slots
+**  5: the per-player unit lists of each unit type are indexed by type slot, with units removed by swapping them with the last one
+**  6: per-second buff handling only goes through the variables with a nonzero increase
+*/
+static constexpr int ReplayVersion = 6;
 
 //----------------------------------------------------------------------------
 // Variables
@@ -246,6 +259,8 @@ static FullReplay *StartReplay()
 	replay->MaxTechLevel = GameSettings.MaxTechLevel;
 	//Wyrmgus end
 
+	replay->Version = ReplayVersion;
+
 	replay->Engine[0] = StratagusMajorVersion;
 	replay->Engine[1] = StratagusMinorVersion;
 	replay->Engine[2] = StratagusPatchLevel;
@@ -304,6 +319,10 @@ static void ApplyReplaySettings()
 	GameSettings.MaxTechLevel = CurrentReplay->MaxTechLevel;
 	//Wyrmgus end
 
+	if (CurrentReplay->Version != ReplayVersion) {
+		fprintf(stderr, "The replay was recorded with game logic version %d, while the current one is %d; it will likely go out of sync.\n", CurrentReplay->Version, ReplayVersion);
+	}
+
 	// FIXME : check engine version
 	// FIXME : FIXME: check network version
 	// FIXME : check mapid
@@ -409,6 +428,7 @@ static void SaveFullLog(CFile &file)
 	file.printf("  TechLevel = %d,\n", CurrentReplay->TechLevel);
 	file.printf("  MaxTechLevel = %d,\n", CurrentReplay->MaxTechLevel);
 	//Wyrmgus end
+	file.printf("  Version = %d,\n", CurrentReplay->Version);
 	file.printf("  Engine = { %d, %d, %d },\n",
 				CurrentReplay->Engine[0], CurrentReplay->Engine[1], CurrentReplay->Engine[2]);
 	file.printf("  Network = { %d, %d, %d }\n",
@@ -726,6 +746,8 @@ static int CclReplayLog(lua_State *l)
 		//Wyrmgus end
 		} else if (!strcmp(value, "MapRichness")) {
 			replay->MapRichness = LuaToNumber(l, -1);
+		} else if (!strcmp(value, "Version")) {
+			replay->Version = LuaToNumber(l, -1);
 		} else if (!strcmp(value, "Engine")) {
 			if (!lua_istable(l, -1) || lua_rawlen(l, -1) != 3) {
 				LuaError(l, "incorrect argument");
@@ -0,0 +1,130 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+//      (c) Copyright 2020 by Andrettin
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+//
+
+#include "stratagus.h"
+
+#include "game/save_game_file.h"
+
+#include "iolib.h"
+
+namespace stratagus {
+
+static constexpr char save_game_magic[] = {'W', 'Y', 'R', 'M', 'S', 'A', 'V', 'E'};
+static constexpr uint32_t save_game_format_version = 1;
+
+save_game_writer::save_game_writer(CFile &file) : file(file)
+{
+	std::string header;
+	binary_writer writer(header);
+	writer.write_bytes(save_game_magic, sizeof(save_game_magic));
+	writer.write<uint32_t>(save_game_format_version);
+	this->file.write(header.data(), header.size());
+}
+
+/**
+**	@brief	Write a section of Lua code
+**
+**	@param	name		The name of the section
+**	@param	function	The function which prints the Lua code to the file given to it, which is an in-memory one, so that the size of the section is known before it is written
+*/
+void save_game_writer::write_lua_section(const std::string &name, const std::function<void(CFile &)> &function)
+{
+	CFile section_file;
+	section_file.open_memory();
+	function(section_file);
+	this->write_section(save_game_section_type::lua_script, name, section_file.get_memory_buffer());
+}
+
+void save_game_writer::write_binary_section(const save_game_section_type type, const std::string &name, const std::function<void(binary_writer &)> &function)
+{
+	std::string data;
+	binary_writer writer(data);
+	function(writer);
+	this->write_section(type, name, data);
+}
+
+void save_game_writer::finish()
+{
+	this->write_section(save_game_section_type::end, std::string(), std::string());
+}
+
+void save_game_writer::write_section(const save_game_section_type type, const std::string &name, const std::string &data)
+{
+	std::string section_header;
+	binary_writer writer(section_header);
+	writer.write<save_game_section_type>(type);
+	writer.write_string(name);
+	writer.write<uint64_t>(data.size());
+
+	this->file.write(section_header.data(), section_header.size());
+	this->file.write(data.data(), data.size());
+}
+
+bool save_game_reader::is_save_game_data(const std::string_view &data)
+{
+	return data.size() >= sizeof(save_game_magic) && data.compare(0, sizeof(save_game_magic), std::string_view(save_game_magic, sizeof(save_game_magic))) == 0;
+}
+
+save_game_reader::save_game_reader(const std::string_view &data) : reader(data)
+{
+	if (!save_game_reader::is_save_game_data(data)) {
+		throw std::runtime_error("The data is not that of a save game.");
+	}
+
+	this->reader.read_bytes(sizeof(save_game_magic));
+
+	const uint32_t format_version = this->reader.read<uint32_t>();
+	if (format_version > save_game_format_version) {
+		throw std::runtime_error("The save game format version (" + std::to_string(format_version) + ") is newer than the one supported by this version of the engine (" + std::to_string(save_game_format_version) + ").");
+	}
+}
+
+/**
+**	@brief	Read the next section of the save game
+**
+**	@return	The section, or an empty optional if the end of the save game has been reached
+*/
+std::optional<save_game_reader::section> save_game_reader::read_section()
+{
+	section save_section;
+	save_section.type = this->reader.read<save_game_section_type>();
+	if (save_section.type == save_game_section_type::end) {
+		return std::nullopt;
+	}
+
+	save_section.name = this->reader.read_string();
+
+	const uint64_t size = this->reader.read<uint64_t>();
+	if (size > this->reader.get_remaining_size()) {
+		throw std::runtime_error("The save game section \"" + save_section.name + "\" has a size of " + std::to_string(size) + " byte(s), but only " + std::to_string(this->reader.get_remaining_size()) + " byte(s) remain in the save game.");
+	}
+	save_section.data = this->reader.read_bytes(static_cast<size_t>(size));
+
+	return save_section;
+}
+
+}
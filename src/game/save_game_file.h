@@ -0,0 +1,87 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+//      (c) Copyright 2020 by Andrettin
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+//
+
+#pragma once
+
+#include "util/binary_stream.h"
+
+class CFile;
+
+namespace stratagus {
+
+enum class save_game_section_type : uint16_t {
+	end = 0, //marks the end of the save game
+	lua_script = 1, //Lua code which is executed when loading
+	map_tiles = 2 //the map fields of all map layers, saved as binary tile planes
+};
+
+/**
+**	@brief	Writes a save game as a sequence of typed sections
+**
+**	The save game starts with a magic string and a format version, followed by the sections, each with its type, name and size, so that a reader can skip sections it doesn't need.
+**
+**	Only the map fields are saved in binary; units, players and the other subsystems are saved as Lua sections. Each section is built in memory before being written, and save_game_reader works on the whole decompressed save game, so neither of them streams.
+*/
+class save_game_writer final
+{
+public:
+	explicit save_game_writer(CFile &file);
+
+	void write_lua_section(const std::string &name, const std::function<void(CFile &)> &function);
+	void write_binary_section(const save_game_section_type type, const std::string &name, const std::function<void(binary_writer &)> &function);
+	void finish();
+
+private:
+	void write_section(const save_game_section_type type, const std::string &name, const std::string &data);
+
+	CFile &file;
+};
+
+/**
+**	@brief	Reads the sections of a save game written by save_game_writer, without copying their data
+*/
+class save_game_reader final
+{
+public:
+	struct section final
+	{
+		save_game_section_type type = save_game_section_type::end;
+		std::string name;
+		std::string_view data;
+	};
+
+	static bool is_save_game_data(const std::string_view &data);
+
+	explicit save_game_reader(const std::string_view &data);
+
+	std::optional<section> read_section();
+
+private:
+	binary_reader reader;
+};
+
+}
@@ -40,6 +40,7 @@
 #include "ai.h"
 #include "campaign.h"
 #include "character.h"
+#include "game/save_game_file.h"
 #include "iocompat.h"
 #include "iolib.h"
 #include "map/map.h"
@@ -47,16 +48,21 @@
 #include "parameters.h"
 #include "player.h"
 #include "replay.h"
+#include "script.h"
 #include "script/trigger.h"
 #include "spells.h"
 #include "time/calendar.h"
+#include "translate.h"
 #include "ui/ui.h"
 #include "unit/unit.h"
 #include "unit/unit_manager.h"
 #include "unit/unit_type.h"
 #include "upgrade/upgrade.h"
 #include "util/date_util.h"
+#include "util/exception_util.h"
+#include "util/profiler.h"
 #include "util/random.h"
+#include "util/thread_pool.h"
 #include "version.h"
 
 extern void StartMap(const std::string &filename, bool clean);
@@ -98,25 +104,13 @@ static std::string GetSaveDir()
 }
 
 /**
-**  Save a game to file.
-**
-**  @param filename  File name to be stored.
-**  @return  -1 if saving failed, 0 if all OK
+**  Save the header of a save game, which loads the map and sets the global game state.
 **
-**  @note  Later we want to store in a more compact binary format.
+**  @param file      Output file.
+**  @param filename  File name of the save game.
 */
-int SaveGame(const std::string &filename)
+static void SaveGameHeader(CFile &file, const std::string &filename)
 {
-	CFile file;
-	std::string fullpath(GetSaveDir());
-
-	fullpath += "/";
-	fullpath += filename;
-	if (file.open(fullpath.c_str(), CL_WRITE_GZ | CL_OPEN_WRITE) == -1) {
-		fprintf(stderr, "Can't save to '%s'\n", filename.c_str());
-		return -1;
-	}
-
 	time_t now;
 	char dateStr[64];
 
@@ -172,25 +166,244 @@ int SaveGame(const std::string &filename)
 	}
 
 	file.printf("SetGodMode(%s)\n", GodMode ? "true" : "false");
+}
+
+/**
+**  Write the current game state to a file.
+**
+**  The save game consists of sections: most of them contain the Lua code which restores a part of the game state,
+**  while the map fields are stored as binary tile planes, as they make up the bulk of the save game's size.
+**
+**  @param file      Output file, which may be an in-memory one.
+**  @param filename  File name of the save game.
+**  @return  -1 if saving failed, 0 if all OK
+*/
+static int WriteSaveGame(CFile &file, const std::string &filename)
+{
+	try {
+		stratagus::save_game_writer writer(file);
+
+		writer.write_lua_section("header", [&filename](CFile &section_file) {
+			SaveGameHeader(section_file, filename);
+		});
+		writer.write_lua_section("unit-types", SaveUnitTypes);
+		writer.write_lua_section("upgrades", SaveUpgrades);
+		writer.write_lua_section("players", SavePlayers);
+		writer.write_lua_section("map", [](CFile &section_file) {
+			CMap::Map.Save(section_file, false);
+		});
+		writer.write_binary_section(stratagus::save_game_section_type::map_tiles, "map-tiles", [](stratagus::binary_writer &binary_writer) {
+			CMap::Map.save_tile_planes(binary_writer);
+		});
+		writer.write_lua_section("units", [](CFile &section_file) {
+			UnitManager.Save(section_file);
+		});
+		writer.write_lua_section("ui", SaveUserInterface);
+		writer.write_lua_section("ai", SaveAi);
+		writer.write_lua_section("selections", SaveSelections);
+		writer.write_lua_section("groups", SaveGroups);
+		writer.write_lua_section("missiles", SaveMissiles);
+		writer.write_lua_section("replay", SaveReplayList);
+		writer.write_lua_section("settings", SaveGameSettings);
+		// FIXME: find all state information which must be saved.
+		writer.write_lua_section("lua-state", [](CFile &section_file) {
+			const std::string s = SaveGlobal(Lua);
+			if (!s.empty()) {
+				section_file.printf("-- Lua state\n\n %s\n", s.c_str());
+			}
+		});
+		writer.write_lua_section("triggers", SaveTriggers); //Triggers are saved in SaveGlobal, so load it after Global
+		writer.finish();
+	} catch (const std::exception &exception) {
+		stratagus::exception::report(exception);
+		fprintf(stderr, "Can't save to '%s'\n", filename.c_str());
+		return -1;
+	}
+
+	return 0;
+}
+
+/// Result of the save game being written in the background, if any
+static std::future<int> BackgroundSaveGameResult;
+
+/// Whether the RunSaveGame hook is being run for a background save, in which case its own SaveGame call is left to the background save
+static bool RunningBackgroundSaveGameHook = false;
+
+/**
+**  Save a game to file.
+**
+**  @param filename  File name to be stored.
+**  @return  -1 if saving failed, 0 if all OK
+*/
+int SaveGame(const std::string &filename)
+{
+	if (RunningBackgroundSaveGameHook) {
+		return 0;
+	}
+
+	//don't write to the save directory while a background save is still doing so
+	WaitForBackgroundSaveGame();
+
+	CFile file;
+	std::string fullpath(GetSaveDir());
+
+	fullpath += "/";
+	fullpath += filename;
+	if (file.open(fullpath.c_str(), CL_WRITE_GZ | CL_OPEN_WRITE) == -1) {
+		fprintf(stderr, "Can't save to '%s'\n", filename.c_str());
+		return -1;
+	}
+
+	const int result = WriteSaveGame(file, filename);
+	file.close();
+	return result;
+}
+
+/**
+**  Save a game to file without stalling the game.
+**
+**  The game state is written to memory at once, so that it is consistent,
+**  but the compression and writing to disk happen in the background while the game continues.
+**  UpdateBackgroundSaveGame reports the result when they are done.
+**
+**  Writing the game state still happens on the main thread, and so still stalls the game:
+**  most of it is produced by the subsystems' Lua serialization and by SaveGlobal, which use the Lua state,
+**  and the game state changes as soon as the game continues. The stall is recorded in the profiler
+**  as the "SaveGameInBackground::WriteSaveGame" zone.
+**
+**  The RunSaveGame hook of the game scripts is run on the main thread before the game state is written,
+**  so that the scripts can update the state to be saved as they do for a synchronous save.
+**
+**  @param filename  File name to be stored.
+**  @return  -1 if saving failed or another background save is still in progress, 0 if all OK
+*/
+int SaveGameInBackground(const std::string &filename)
+{
+	if (BackgroundSaveGameResult.valid()) {
+		fprintf(stderr, "Can't save to '%s', as a previous save is still being written\n", filename.c_str());
+		return -1;
+	}
+
+	RunningBackgroundSaveGameHook = true;
+	CclCommand("if (RunSaveGame ~= nil) then RunSaveGame(\"" + filename + "\") end;");
+	RunningBackgroundSaveGameHook = false;
+
+	CFile snapshot_file;
+	snapshot_file.open_memory();
+	{
+		const stratagus::profile_zone profile("SaveGameInBackground::WriteSaveGame");
+		if (WriteSaveGame(snapshot_file, filename) == -1) {
+			return -1;
+		}
+	}
+
+	const std::string fullpath = GetSaveDir() + "/" + filename;
+	auto snapshot = std::make_shared<const std::string>(snapshot_file.get_memory_buffer());
+	snapshot_file.close();
+
+	auto promise = std::make_shared<std::promise<int>>();
+	BackgroundSaveGameResult = promise->get_future();
+
+	try {
+		stratagus::thread_pool::get()->post([fullpath, snapshot, promise]() {
+			CFile file;
+			if (file.open(fullpath.c_str(), CL_WRITE_GZ | CL_OPEN_WRITE) == -1) {
+				fprintf(stderr, "Can't save to '%s'\n", fullpath.c_str());
+				promise->set_value(-1);
+				return;
+			}
+
+			const int written = file.write(snapshot->data(), snapshot->size());
+			file.close();
+			promise->set_value(written > 0 ? 0 : -1);
+		});
+	} catch (...) {
+		promise->set_exception(std::current_exception());
+	}
+
+	return 0;
+}
+
+/**
+**  Get the result of the background save, waiting for it to finish if necessary.
+**
+**  @return  -1 if saving failed, 0 if all OK
+*/
+static int GetBackgroundSaveGameResult()
+{
+	try {
+		return BackgroundSaveGameResult.get();
+	} catch (const std::exception &exception) {
+		stratagus::exception::report(exception);
+		return -1;
+	}
+}
+
+/**
+**  Report the result of the background save, if it has finished.
+**
+**  Called from the main loop, as the status line can only be set from the main thread.
+*/
+void UpdateBackgroundSaveGame()
+{
+	if (!BackgroundSaveGameResult.valid() || BackgroundSaveGameResult.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+		return;
+	}
+
+	if (GetBackgroundSaveGameResult() == 0) {
+		UI.StatusLine.Set(_("Game saved"));
+	} else {
+		UI.StatusLine.Set(_("Saving the game failed"));
+	}
+}
+
+/**
+**  Wait for the background save to finish, if one is in progress.
+*/
+void WaitForBackgroundSaveGame()
+{
+	if (BackgroundSaveGameResult.valid()) {
+		GetBackgroundSaveGameResult();
+	}
+}
+
+/**
+**  Convert a save game in the legacy format, which consists only of Lua code, to the sectioned one.
+**
+**  The whole legacy save game is stored in a single Lua section, so that it is loaded exactly as before;
+**  saving the game again after loading it stores its map fields as tile planes.
+**
+**  @param old_filename  File name of the legacy save game.
+**  @param new_filename  File name to store the converted save game as.
+**  @return  -1 if the conversion failed, 0 if all OK
+*/
+int ConvertSaveGame(const std::string &old_filename, const std::string &new_filename)
+{
+	const std::string save_dir = GetSaveDir();
+
+	std::string content;
+	if (!GetFileContent(save_dir + "/" + old_filename, content)) {
+		return -1;
+	}
+
+	if (stratagus::save_game_reader::is_save_game_data(content)) {
+		fprintf(stderr, "'%s' is not a legacy save game\n", old_filename.c_str());
+		return -1;
+	}
+
+	CFile file;
+	const std::string fullpath = save_dir + "/" + new_filename;
+	if (file.open(fullpath.c_str(), CL_WRITE_GZ | CL_OPEN_WRITE) == -1) {
+		fprintf(stderr, "Can't save to '%s'\n", new_filename.c_str());
+		return -1;
+	}
+
+	stratagus::save_game_writer writer(file);
+	writer.write_lua_section("legacy", [&content](CFile &section_file) {
+		section_file.write(content.data(), content.size());
+	});
+	writer.finish();
 
-	SaveUnitTypes(file);
-	SaveUpgrades(file);
-	SavePlayers(file);
-	CMap::Map.Save(file);
-	UnitManager.Save(file);
-	SaveUserInterface(file);
-	SaveAi(file);
-	SaveSelections(file);
-	SaveGroups(file);
-	SaveMissiles(file);
-	SaveReplayList(file);
-	SaveGameSettings(file);
-	// FIXME: find all state information which must be saved.
-	const std::string s = SaveGlobal(Lua);
-	if (!s.empty()) {
-		file.printf("-- Lua state\n\n %s\n", s.c_str());
-	}
-	SaveTriggers(file); //Triggers are saved in SaveGlobal, so load it after Global
 	file.close();
 	return 0;
 }
@@ -76,6 +76,10 @@ class CGraphic;
 extern void GenerateHistory();
 extern void LoadGame(const std::string &filename); /// Load saved game
 extern int SaveGame(const std::string &filename); /// Save game
+extern int SaveGameInBackground(const std::string &filename); /// Save game, writing it to disk in the background
+extern void UpdateBackgroundSaveGame(); /// Report the result of the background save game, if it has finished
+extern void WaitForBackgroundSaveGame(); /// Wait for the background save game to be written
+extern int ConvertSaveGame(const std::string &old_filename, const std::string &new_filename); /// Convert a legacy save game to the sectioned format
 extern void DeleteSaveGame(const std::string &filename); /// Delete save game
 extern bool SaveGameLoading;                 /// Save game is in progress of loading
 
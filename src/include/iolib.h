@@ -105,13 +105,17 @@ public:
 	~CFile();
 
 	int open(const char *name, long flags);
+	int open_memory();
 	int close();
 	void flush();
 	int read(void *buf, size_t len);
 	int seek(long offset, int whence);
 	long tell();
 
+	int write(const void *buf, size_t len);
 	int printf(const char *format, ...) PRINTF_VAARG_ATTRIBUTE(2, 3); // Don't forget to count this
+
+	const std::string &get_memory_buffer() const;
 private:
 	CFile(const CFile &rhs); // No implementation
 	const CFile &operator = (const CFile &rhs); // No implementation
@@ -125,7 +129,8 @@ enum {
 	CLF_TYPE_PLAIN,    /// plain text file handle
 	CLF_TYPE_GZIP,     /// gzip file handle
 	CLF_TYPE_BZIP2,    /// bzip2 file handle
-	CLF_TYPE_PHYSFS    /// physfs file handle
+	CLF_TYPE_PHYSFS,   /// physfs file handle
+	CLF_TYPE_MEMORY    /// in-memory buffer handle
 };
 
 #define CL_OPEN_READ 0x1
@@ -139,12 +139,25 @@ enum class VisitResult {
 	Cancel
 };
 
+/**
+**  Breadth-first traversal of the map terrain.
+**
+**  The visited state and the queue of positions to visit are kept in scratch buffers which are pooled per thread
+**  and per map size, so that successive traversals of the same map layer reuse them: each Init only starts a new
+**  generation instead of clearing the whole buffer, so its cost doesn't depend on the size of the map.
+*/
 class TerrainTraversal
 {
 public:
 	typedef short int dataType;
 public:
 	TerrainTraversal() : allow_diagonal(true) {}
+	~TerrainTraversal();
+	TerrainTraversal(const TerrainTraversal &other) = delete;
+	TerrainTraversal &operator =(const TerrainTraversal &other) = delete;
+
+	static void ReleaseFreeBuffers();
+
 	void SetSize(unsigned int width, unsigned int height);
 	void SetDiagonalAllowed(const bool allowed);
 	void Init();
@@ -172,19 +185,29 @@ private:
 		Vec2i from;
 	};
 
+public:
+	/// Buffers of a traversal, which are reused by later traversals of the same size
+	struct ScratchBuffer {
+		unsigned int ExtendedWidth = 0;
+		unsigned int Height = 0;
+		unsigned int Generation = 0;     /// Current traversal; values stamped with an older generation count as unvisited
+		std::vector<unsigned int> Stamps; /// Generation in which each value was set; the border has the maximum stamp, so that it always counts as set
+		std::vector<dataType> Values;
+		std::vector<PosNode> Frontier;    /// Positions to visit; as each position is queued at most once per traversal, this never needs to wrap around
+		size_t FrontierHead = 0;          /// Index of the next position to visit
+	};
+
 private:
-	std::vector<dataType> m_values;
-	std::queue<PosNode> m_queue;
-	unsigned int m_extented_width;
-	unsigned int m_height;
+	ScratchBuffer *m_buffer = nullptr;
 	bool allow_diagonal;
 };
 
 template <typename T>
 bool TerrainTraversal::Run(T &context)
 {
-	for (; m_queue.empty() == false; m_queue.pop()) {
-		const PosNode &posNode = m_queue.front();
+	for (; m_buffer->FrontierHead < m_buffer->Frontier.size(); ++m_buffer->FrontierHead) {
+		//copied, since visiting may queue positions and thus reallocate the frontier
+		const PosNode posNode = m_buffer->Frontier[m_buffer->FrontierHead];
 
 		switch (context.Visit(*this, posNode.pos, posNode.from)) {
 			case VisitResult::Finished: return true;
@@ -198,6 +221,15 @@ bool TerrainTraversal::Run(T &context)
 }
 
 
+/// Statistics of the cache of long path routes
+struct AStarPathCacheStats {
+	unsigned long Hits = 0;          /// Lookups which found a valid route
+	unsigned long Misses = 0;        /// Lookups which had to search for the route
+	unsigned long Invalidations = 0; /// Misses due to the terrain having changed since the route was cached
+	unsigned long Flushes = 0;       /// Times the cache was cleared for being full
+	size_t Size = 0;                 /// Current quantity of cached routes
+};
+
 /*----------------------------------------------------------------------------
 --  Variables
 ----------------------------------------------------------------------------*/
@@ -227,6 +259,9 @@ extern void InitPathfinder();
 /// Free the pathfinder
 extern void FreePathfinder();
 
+/// Notify the pathfinder that the passability of a tile may have changed
+extern void PathfinderTileChanged(const Vec2i &pos, int z);
+
 /// Returns the next element of the path
 extern int NextPathElement(CUnit &unit, short int *xdp, short int *ydp);
 /// Return distance to unit.
@@ -254,6 +289,9 @@ extern int GetAStarMovingUnitCrossingCost();
 extern void SetAStarUnknownTerrainCost(int cost);
 extern int GetAStarUnknownTerrainCost();
 
+/// Get the hit/miss statistics of the path route cache
+extern AStarPathCacheStats AStarGetPathCacheStats();
+
 //Wyrmgus start
 /// Find and a* path for a unit
 extern int AStarFindPath(const Vec2i &startPos, const Vec2i &goalPos, int gw, int gh,
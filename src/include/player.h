@@ -95,9 +95,17 @@ public:
 		return CPlayer::revealed_players;
 	}
 
+	static uint32_t get_revealed_player_mask()
+	{
+		return CPlayer::revealed_player_mask;
+	}
+
+	static void update_mutual_shared_vision_masks();
+
 private:
 	static CPlayer *ThisPlayer; //player on local computer
 	static inline std::vector<const CPlayer *> revealed_players;
+	static inline uint32_t revealed_player_mask = 0; //bit mask of the revealed players
 
 public:
 	CPlayer();
@@ -176,11 +184,12 @@ public:
 	int SpeedUpgrade;                /// speed factor for upgrading
 	int SpeedResearch;               /// speed factor for researching
 
-	std::map<const stratagus::unit_type *, int> UnitTypesCount;  						/// total units of unit-type
-	std::map<const stratagus::unit_type *, int> UnitTypesUnderConstructionCount;  		/// total under construction units of unit-type
-	std::map<const stratagus::unit_type *, int> UnitTypesAiActiveCount;  				/// total units of unit-type that have their AI set to active
-	std::map<const stratagus::unit_type *, std::vector<CUnit *>> UnitsByType;			/// units owned by this player for each type
-	std::map<const stratagus::unit_type *, std::vector<CUnit *>> AiActiveUnitsByType;	/// AI active units owned by this player for each type
+	//the per-type counters and unit lists are indexed by the unit type's slot, and grown as needed
+	std::vector<int> UnitTypesCount;  						/// total units of unit-type
+	std::vector<int> UnitTypesUnderConstructionCount;  		/// total under construction units of unit-type
+	std::vector<int> UnitTypesAiActiveCount;  				/// total units of unit-type that have their AI set to active
+	std::vector<std::vector<CUnit *>> UnitsByType;			/// units owned by this player for each type, in which each unit's position is its PlayerTypeSlot
+	std::vector<std::vector<CUnit *>> AiActiveUnitsByType;	/// AI active units owned by this player for each type, in which each unit's position is its PlayerAiActiveTypeSlot
 	std::vector<CUnit *> Heroes;											/// hero units owned by this player
 	std::vector<stratagus::deity *> Deities;								/// deities chosen by this player
 	std::vector<stratagus::quest *> AvailableQuests;			/// quests available to this player
@@ -412,6 +421,9 @@ public:
 	void SetUnitTypeAiActiveCount(const stratagus::unit_type *type, int quantity);
 	void ChangeUnitTypeAiActiveCount(const stratagus::unit_type *type, int quantity);
 	int GetUnitTypeAiActiveCount(const stratagus::unit_type *type) const;
+
+	const std::vector<CUnit *> &GetUnitsByType(const stratagus::unit_type *type) const;
+	const std::vector<CUnit *> &GetAiActiveUnitsByType(const stratagus::unit_type *type) const;
 	
 	void IncreaseCountsForUnit(CUnit *unit, bool type_change = false);
 	void DecreaseCountsForUnit(CUnit *unit, bool type_change = false);
@@ -460,6 +472,11 @@ public:
 	bool has_shared_vision_with(const CUnit &unit) const;
 	bool has_mutual_shared_vision_with(const CPlayer &player) const;
 	bool has_mutual_shared_vision_with(const CUnit &unit) const;
+
+	uint32_t get_mutual_shared_vision_mask() const
+	{
+		return this->mutual_shared_vision_mask;
+	}
 	bool IsTeamed(const CPlayer &player) const;
 	bool IsTeamed(const CUnit &unit) const;
 
@@ -578,6 +595,7 @@ private:
 	unsigned int Enemy = 0;     /// enemy bit field for this player
 	unsigned int Allied = 0;    /// allied bit field for this player
 	std::set<int> shared_vision; /// set of player indexes that this player has shared vision with
+	uint32_t mutual_shared_vision_mask = 0; /// bit mask of the players with which this player has mutual shared vision
 
 	friend void CleanPlayers();
 	friend void SetPlayersPalette();
@@ -80,6 +80,7 @@ public:
 	}
 
 	bool applies_to(const unit_type *unit_type) const;
+	const std::vector<unit_type *> &get_affected_unit_types() const;
 	
 	int GetUnitStock(unit_type *unit_type) const;
 	void SetUnitStock(unit_type *unit_type, int quantity);
@@ -101,6 +102,8 @@ public:
 private:
 	std::vector<unit_type *> unit_types; //which unit types are affected
 	std::vector<unit_class *> unit_classes; //which unit classes are affected
+	mutable std::vector<unit_type *> affected_unit_types; //the unit types affected directly or through their class, in slot order
+	mutable std::optional<unsigned int> affected_unit_types_revision; //the unit class revision for which the affected unit types were built
 
 public:
 	unit_type *ConvertTo = nullptr;			/// convert to this unit-type.
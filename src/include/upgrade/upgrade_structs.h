@@ -79,7 +79,7 @@ public:
 	void SetUnitStock(const stratagus::unit_type *unit_type, int quantity);
 	void ChangeUnitStock(const stratagus::unit_type *unit_type, int quantity);
 public:
-	std::vector<stratagus::unit_variable> Variables;           /// user defined variable.
+	stratagus::shared_unit_variables Variables;	/// user defined variable, shared with copies of the stats until modified (e.g. between players until an upgrade changes them for one of them)
 	int Costs[MaxCosts];            /// current costs of the unit
 	int Storing[MaxCosts];          /// storage increasing
 	int ImproveIncomes[MaxCosts];   /// Gives player an improved income
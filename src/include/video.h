@@ -556,9 +556,12 @@ extern int LoadGraphicPNG(CGraphic *g, const int scale_factor);
 /// Make an OpenGL texture
 extern void MakeTexture(CGraphic *graphic, const bool grayscale, const stratagus::time_of_day *time_of_day);
 //Wyrmgus start
-extern void MakeTextures2(const CGraphic *g, const QImage &image, GLuint texture, const int ow, const int oh, const stratagus::time_of_day *time_of_day = nullptr);
+extern void MakeTextures2(const CGraphic *g, const QImage &image, GLuint texture, const int ow, const int oh);
 //Wyrmgus end
 extern void MakePlayerColorTexture(CPlayerColorGraphic *graphic, const stratagus::player_color *player_color, const stratagus::time_of_day *time_of_day = nullptr);
+extern size_t GetTextureVariantMemorySize();
+extern void PrepareTimeOfDayTextures(const stratagus::time_of_day *time_of_day);
+extern void MakePreparedTextures();
 
 /// Regenerate Window screen if needed
 extern void ValidateOpenGLScreen();
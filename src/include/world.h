@@ -69,6 +69,7 @@ public:
 	}
 
 	std::vector<QVariantList> parse_geojson_folder(const std::string_view &folder) const;
+	QByteArray get_geojson_folder_hash(const std::string_view &folder) const;
 	terrain_geodata_map parse_terrain_geojson_folder() const;
 	std::map<const site *, std::vector<std::unique_ptr<QGeoShape>>> parse_territories_geojson_folder() const;
 
@@ -0,0 +1,273 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+//      (c) Copyright 2020 by Andrettin
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+//
+
+#include "stratagus.h"
+
+#include "map/geodata_plane.h"
+
+#include "util/binary_stream.h"
+#include "util/geoshape_util.h"
+
+#include <QFile>
+
+namespace stratagus {
+
+/**
+**	@brief	Rasterize the geoshapes of a list of entries into a plane
+**
+**	Entries are written in order, and a pixel covered by the geoshapes of more than one entry keeps the first of them.
+**
+**	@param	size			The size of the plane
+**	@param	georectangle	The georectangle covered by the plane
+**	@param	entries			The entries, each with an identifier and its geoshapes
+**
+**	@return	The plane
+*/
+geodata_plane geodata_plane::rasterize(const QSize &size, const QGeoRectangle &georectangle, const std::vector<entry_geoshapes> &entries)
+{
+	if (entries.size() > geodata_plane::max_entry_count) {
+		throw std::runtime_error("Cannot rasterize " + std::to_string(entries.size()) + " geodata entries into a plane, as the maximum is " + std::to_string(geodata_plane::max_entry_count) + ".");
+	}
+
+	geodata_plane plane(size);
+
+	QImage image(size, QImage::Format_RGBA8888);
+	image.fill(Qt::transparent);
+
+	for (const entry_geoshapes &entry : entries) {
+		plane.entry_identifiers.push_back(entry.first);
+		const size_t index = plane.entry_identifiers.size();
+
+		//encode the entry's index in the red and green components of its color, so that it can be read back from the image
+		const QColor color(static_cast<int>(index & 0xFF), static_cast<int>((index >> 8) & 0xFF), 0);
+
+		for (const std::unique_ptr<QGeoShape> &geoshape : *entry.second) {
+			geoshape::write_to_image(*geoshape, image, color, georectangle);
+		}
+	}
+
+	plane.index_buffer.resize(static_cast<size_t>(size.width()) * size.height() * 2);
+
+	for (int y = 0; y < size.height(); ++y) {
+		const uchar *line = image.constScanLine(y);
+		char *index_line = plane.index_buffer.data() + static_cast<size_t>(y) * size.width() * 2;
+
+		for (int x = 0; x < size.width(); ++x) {
+			const uchar *pixel = line + x * 4;
+			const bool written = pixel[3] != 0;
+			index_line[x * 2] = written ? static_cast<char>(pixel[0]) : 0;
+			index_line[x * 2 + 1] = written ? static_cast<char>(pixel[1]) : 0;
+		}
+	}
+
+	plane.index_data = reinterpret_cast<const uchar *>(plane.index_buffer.data());
+
+	return plane;
+}
+
+/**
+**	@brief	Load a plane from a cache file
+**
+**	The file is memory mapped, with the plane's index data being read directly from the mapping.
+**
+**	@param	filepath	The path to the cache file
+**	@param	key			The key which the plane must have been saved with, identifying the inputs it was rasterized from
+**	@param	size		The size which the plane must have
+**
+**	@return	The plane, or nothing if there is no valid cache file for the key
+*/
+std::optional<geodata_plane> geodata_plane::load(const std::filesystem::path &filepath, const QByteArray &key, const QSize &size)
+{
+	if (!std::filesystem::exists(filepath)) {
+		return std::nullopt;
+	}
+
+	auto file = std::make_unique<QFile>(QString::fromStdString(filepath.string()));
+	if (!file->open(QIODevice::ReadOnly)) {
+		return std::nullopt;
+	}
+
+	const qint64 file_size = file->size();
+	const uchar *data = file->map(0, file_size);
+	if (data == nullptr) {
+		return std::nullopt;
+	}
+
+	try {
+		binary_reader reader(std::string_view(reinterpret_cast<const char *>(data), static_cast<size_t>(file_size)));
+
+		if (reader.read_bytes(std::strlen(geodata_plane::cache_magic)) != geodata_plane::cache_magic) {
+			return std::nullopt;
+		}
+
+		if (reader.read<uint16_t>() != geodata_plane::cache_version) {
+			return std::nullopt;
+		}
+
+		if (reader.read_string() != key.toStdString()) {
+			return std::nullopt;
+		}
+
+		const uint32_t width = reader.read<uint32_t>();
+		const uint32_t height = reader.read<uint32_t>();
+		if (static_cast<int>(width) != size.width() || static_cast<int>(height) != size.height()) {
+			return std::nullopt;
+		}
+
+		geodata_plane plane(size);
+
+		const uint32_t entry_count = reader.read<uint32_t>();
+		for (uint32_t i = 0; i < entry_count; ++i) {
+			plane.entry_identifiers.push_back(reader.read_string());
+		}
+
+		if (reader.get_remaining_size() != static_cast<size_t>(width) * height * 2) {
+			return std::nullopt;
+		}
+
+		plane.index_data = data + reader.get_position();
+		plane.file = std::move(file);
+
+		return std::move(plane);
+	} catch (const std::runtime_error &) {
+		//the cache file is truncated
+		return std::nullopt;
+	}
+}
+
+geodata_plane::geodata_plane(const QSize &size) : size(size)
+{
+}
+
+geodata_plane::geodata_plane(geodata_plane &&other)
+{
+	*this = std::move(other);
+}
+
+geodata_plane::~geodata_plane()
+{
+}
+
+geodata_plane &geodata_plane::operator =(geodata_plane &&other)
+{
+	this->size = other.size;
+	this->entry_identifiers = std::move(other.entry_identifiers);
+	this->index_buffer = std::move(other.index_buffer);
+	this->file = std::move(other.file);
+
+	//the index data of a rasterized plane points to its own buffer, which has to be pointed to again after being moved
+	if (this->file != nullptr) {
+		this->index_data = other.index_data;
+	} else {
+		this->index_data = reinterpret_cast<const uchar *>(this->index_buffer.data());
+	}
+	other.index_data = nullptr;
+
+	return *this;
+}
+
+/**
+**	@brief	Write the plane's entries to an image, in their respective colors
+**
+**	Pixels which have already been written to (i.e. which are not fully transparent) are left unchanged.
+**
+**	@param	image			The image, which must have the plane's size, and which is converted to the RGBA8888 format if it has a different one
+**	@param	entry_colors	The color of each entry, in the order of the entries
+*/
+void geodata_plane::write_to_image(QImage &image, const std::vector<QColor> &entry_colors) const
+{
+	if (image.size() != this->get_size()) {
+		throw std::runtime_error("Cannot write a geodata plane to an image of a different size.");
+	}
+
+	if (image.format() != QImage::Format_RGBA8888) {
+		image = image.convertToFormat(QImage::Format_RGBA8888);
+	}
+
+	for (int y = 0; y < this->size.height(); ++y) {
+		uchar *line = image.scanLine(y);
+
+		for (int x = 0; x < this->size.width(); ++x) {
+			uchar *pixel = line + x * 4;
+
+			if (pixel[3] != 0) {
+				continue; //ignore already-written pixels
+			}
+
+			const uint16_t entry_index = this->get_entry_index(QPoint(x, y));
+			if (entry_index == 0) {
+				continue;
+			}
+
+			const QColor &color = entry_colors.at(entry_index - 1);
+			pixel[0] = static_cast<uchar>(color.red());
+			pixel[1] = static_cast<uchar>(color.green());
+			pixel[2] = static_cast<uchar>(color.blue());
+			pixel[3] = static_cast<uchar>(color.alpha());
+		}
+	}
+}
+
+/**
+**	@brief	Save the plane to a cache file
+**
+**	@param	filepath	The path to the cache file
+**	@param	key			The key identifying the inputs the plane was rasterized from
+*/
+void geodata_plane::save(const std::filesystem::path &filepath, const QByteArray &key) const
+{
+	std::string buffer;
+	binary_writer writer(buffer);
+
+	writer.write_bytes(geodata_plane::cache_magic, std::strlen(geodata_plane::cache_magic));
+	writer.write<uint16_t>(geodata_plane::cache_version);
+	writer.write_string(key.toStdString());
+	writer.write<uint32_t>(static_cast<uint32_t>(this->size.width()));
+	writer.write<uint32_t>(static_cast<uint32_t>(this->size.height()));
+
+	writer.write<uint32_t>(static_cast<uint32_t>(this->entry_identifiers.size()));
+	for (const std::string &entry_identifier : this->entry_identifiers) {
+		writer.write_string(entry_identifier);
+	}
+
+	writer.write_bytes(this->index_data, static_cast<size_t>(this->size.width()) * this->size.height() * 2);
+
+	std::filesystem::create_directories(filepath.parent_path());
+
+	std::ofstream ofstream(filepath, std::ios::binary);
+	if (!ofstream) {
+		throw std::runtime_error("Failed to open file: " + filepath.string());
+	}
+
+	ofstream.write(buffer.data(), buffer.size());
+
+	if (!ofstream) {
+		throw std::runtime_error("Failed to write file: " + filepath.string());
+	}
+}
+
+}
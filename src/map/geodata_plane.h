@@ -0,0 +1,86 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+//      (c) Copyright 2020 by Andrettin
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+//
+
+#pragma once
+
+class QFile;
+
+namespace stratagus {
+
+/**
+**	@brief	A plane of rasterized geodata, in which each pixel holds the index of the entry (e.g. a terrain type or site) whose geoshapes covered it
+**
+**	Entry indexes start at 1, with 0 meaning that the pixel is not covered by any geoshape. Planes can be saved to a cache file, and loaded from it by memory mapping the file.
+*/
+class geodata_plane final
+{
+public:
+	using entry_geoshapes = std::pair<std::string, const std::vector<std::unique_ptr<QGeoShape>> *>;
+
+	static constexpr const char *cache_magic = "WYRMGEOP";
+	static constexpr uint16_t cache_version = 1;
+	static constexpr size_t max_entry_count = UINT16_MAX; //entry indexes are stored as 16-bit integers
+
+	static geodata_plane rasterize(const QSize &size, const QGeoRectangle &georectangle, const std::vector<entry_geoshapes> &entries);
+	static std::optional<geodata_plane> load(const std::filesystem::path &filepath, const QByteArray &key, const QSize &size);
+
+	geodata_plane(geodata_plane &&other);
+	~geodata_plane();
+
+	geodata_plane &operator =(geodata_plane &&other);
+
+	void write_to_image(QImage &image, const std::vector<QColor> &entry_colors) const;
+	void save(const std::filesystem::path &filepath, const QByteArray &key) const;
+
+	const QSize &get_size() const
+	{
+		return this->size;
+	}
+
+	const std::vector<std::string> &get_entry_identifiers() const
+	{
+		return this->entry_identifiers;
+	}
+
+	uint16_t get_entry_index(const QPoint &pos) const
+	{
+		const size_t offset = (static_cast<size_t>(pos.y()) * this->size.width() + pos.x()) * 2;
+		return static_cast<uint16_t>(this->index_data[offset] | (this->index_data[offset + 1] << 8));
+	}
+
+private:
+	explicit geodata_plane(const QSize &size);
+
+private:
+	QSize size;
+	std::vector<std::string> entry_identifiers;
+	const uchar *index_data = nullptr; //the entry index of each pixel, as little-endian 16-bit integers
+	std::string index_buffer; //the buffer holding the index data, if the plane was rasterized
+	std::unique_ptr<QFile> file; //the memory mapped cache file holding the index data, if the plane was loaded
+};
+
+}
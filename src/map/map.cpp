@@ -42,6 +42,7 @@
 #include "map/terrain_feature.h"
 #include "map/terrain_type.h"
 #include "map/tileset.h"
+#include "pathfinder.h"
 #include "plane.h"
 #include "player.h"
 //Wyrmgus start
@@ -68,8 +69,10 @@
 #include "unit/unit_type_type.h"
 //Wyrmgus start
 #include "upgrade/upgrade.h"
+#include "util/binary_stream.h"
 //Wyrmgus end
 #include "util/container_util.h"
+#include "util/ordered_point_pool.h"
 #include "util/size_util.h"
 #include "util/vector_random_util.h"
 #include "util/vector_util.h"
@@ -214,13 +217,14 @@ void CMap::Reveal(bool only_person_players)
 			CMapFieldPlayerInfo &playerInfo = mf.playerInfo;
 			for (int p = 0; p < PlayerMax; ++p) {
 				if (CPlayer::Players[p]->Type == PlayerPerson || !only_person_players) {
-					playerInfo.Visible[p] = std::max<unsigned short>(1, playerInfo.Visible[p]);
+					playerInfo.SetExploredBy(p);
 				}
 			}
 			MarkSeenTile(mf, z);
 		}
 	}
 	//Wyrmgus end
+	UI.Minimap.update_all_seen();
 	//  Global seen recount. Simple and effective.
 	for (CUnitManager::Iterator it = UnitManager.begin(); it != UnitManager.end(); ++it) {
 		CUnit &unit = **it;
@@ -338,16 +342,16 @@ Vec2i CMap::GenerateUnitLocation(const stratagus::unit_type *unit_type, const st
 		}
 	}
 
-	std::vector<Vec2i> potential_positions;
-	for (int x = min_pos.x; x <= (max_pos.x - (unit_type->get_tile_width() - 1)); ++x) {
-		for (int y = min_pos.y; y <= (max_pos.y - (unit_type->get_tile_height() - 1)); ++y) {
-			potential_positions.push_back(Vec2i(x, y));
+	const QPoint potential_max_pos(max_pos.x - (unit_type->get_tile_width() - 1), max_pos.y - (unit_type->get_tile_height() - 1));
+	stratagus::ordered_point_pool potential_positions(QRect(QPoint(min_pos.x, min_pos.y), potential_max_pos));
+	for (int x = min_pos.x; x <= potential_max_pos.x(); ++x) {
+		for (int y = min_pos.y; y <= potential_max_pos.y(); ++y) {
+			potential_positions.push_back(QPoint(x, y));
 		}
 	}
 	
 	while (!potential_positions.empty()) {
-		random_pos = potential_positions[SyncRand(potential_positions.size())];
-		stratagus::vector::remove(potential_positions, random_pos);
+		random_pos = potential_positions.take(SyncRand(potential_positions.size()));
 		
 		if (!this->Info.IsPointOnMap(random_pos, z) || (this->is_point_in_a_subtemplate_area(random_pos, z) && GameCycle == 0)) {
 			continue;
@@ -1542,7 +1546,7 @@ void CMap::ClearMapLayers()
 **
 ** @param file Output file.
 */
-void CMap::Save(CFile &file) const
+void CMap::Save(CFile &file, const bool save_map_fields) const
 {
 	file.printf("\n--- -----------------------------------------\n");
 	file.printf("--- MODULE: map\n");
@@ -1586,6 +1590,12 @@ void CMap::Save(CFile &file) const
 	file.printf("  },\n");
 	//Wyrmgus end
 
+	if (!save_map_fields) {
+		//the map fields are saved separately as tile planes
+		file.printf("}})\n");
+		return;
+	}
+
 	file.printf("  \"map-fields\", {\n");
 	//Wyrmgus start
 	/*
@@ -1624,6 +1634,54 @@ void CMap::Save(CFile &file) const
 	file.printf("}})\n");
 }
 
+/**
+**	@brief	Save the fields of all map layers as binary tile planes
+**
+**	@param	writer	The binary writer to save to
+*/
+void CMap::save_tile_planes(stratagus::binary_writer &writer) const
+{
+	writer.write<uint32_t>(static_cast<uint32_t>(this->MapLayers.size()));
+
+	for (const CMapLayer *map_layer : this->MapLayers) {
+		writer.write<int32_t>(map_layer->get_width());
+		writer.write<int32_t>(map_layer->get_height());
+		CMapField::save_tile_planes(map_layer->Fields, map_layer->get_width() * map_layer->get_height(), writer);
+	}
+}
+
+/**
+**	@brief	Load the fields of all map layers from binary tile planes
+**
+**	The map layers must have already been created with the same sizes as those of the saved ones.
+**
+**	@param	reader	The binary reader to load from
+*/
+void CMap::load_tile_planes(stratagus::binary_reader &reader)
+{
+	const uint32_t map_layer_count = reader.read<uint32_t>();
+	if (map_layer_count != this->MapLayers.size()) {
+		throw std::runtime_error("The saved tile planes have " + std::to_string(map_layer_count) + " map layers, but the map has " + std::to_string(this->MapLayers.size()) + ".");
+	}
+
+	for (CMapLayer *map_layer : this->MapLayers) {
+		const int width = reader.read<int32_t>();
+		const int height = reader.read<int32_t>();
+		if (width != map_layer->get_width() || height != map_layer->get_height()) {
+			throw std::runtime_error("The saved tile planes for map layer " + std::to_string(map_layer->ID) + " have a size of " + std::to_string(width) + "x" + std::to_string(height) + ", but the map layer has a size of " + std::to_string(map_layer->get_width()) + "x" + std::to_string(map_layer->get_height()) + ".");
+		}
+
+		const int field_count = width * height;
+		CMapField::load_tile_planes(map_layer->Fields, field_count, reader);
+
+		for (int i = 0; i < field_count; ++i) {
+			if (map_layer->Field(i)->IsDestroyedForestTile()) {
+				map_layer->DestroyedForestTiles.push_back(map_layer->GetPosFromIndex(i));
+			}
+		}
+	}
+}
+
 /*----------------------------------------------------------------------------
 -- Map Tile Update Functions
 ----------------------------------------------------------------------------*/
@@ -1777,6 +1835,7 @@ void CMap::SetTileTerrain(const Vec2i &pos, stratagus::terrain_type *terrain, in
 	}
 	
 	mf.SetTerrain(terrain);
+	PathfinderTileChanged(pos, z);
 	
 	if (terrain->is_overlay()) {
 		//remove decorations if the overlay terrain has changed
@@ -1845,6 +1904,7 @@ void CMap::RemoveTileOverlayTerrain(const Vec2i &pos, int z)
 	stratagus::terrain_type *old_terrain = mf.OverlayTerrain;
 	
 	mf.RemoveOverlayTerrain();
+	PathfinderTileChanged(pos, z);
 	
 	this->CalculateTileTransitions(pos, true, z);
 	this->calculate_tile_terrain_feature(pos, z);
@@ -1912,6 +1972,7 @@ void CMap::SetOverlayTerrainDestroyed(const Vec2i &pos, bool destroyed, int z)
 			mf.Value = stratagus::resource::get_all()[WoodCost]->DefaultAmount;
 		}
 	}
+	PathfinderTileChanged(pos, z);
 	
 	if (destroyed) {
 		if (mf.OverlayTerrain->get_destroyed_tiles().size() > 0) {
@@ -2647,10 +2708,10 @@ void CMap::GenerateTerrain(const std::unique_ptr<stratagus::generated_terrain> &
 		}
 	}
 	
-	std::vector<Vec2i> potential_positions;
+	stratagus::ordered_point_pool potential_positions(QRect(QPoint(min_pos.x, min_pos.y), QPoint(max_pos.x, max_pos.y)));
 	for (int x = min_pos.x; x <= max_pos.x; ++x) {
 		for (int y = min_pos.y; y <= max_pos.y; ++y) {
-			potential_positions.push_back(Vec2i(x, y));
+			potential_positions.push_back(QPoint(x, y));
 		}
 	}
 	
@@ -2660,8 +2721,7 @@ void CMap::GenerateTerrain(const std::unique_ptr<stratagus::generated_terrain> &
 			break;
 		}
 		
-		random_pos = potential_positions[SyncRand(potential_positions.size())];
-		potential_positions.erase(std::remove(potential_positions.begin(), potential_positions.end(), random_pos), potential_positions.end());
+		random_pos = potential_positions.take(SyncRand(potential_positions.size()));
 		
 		if (!this->Info.IsPointOnMap(random_pos, z) || this->is_point_in_a_subtemplate_area(random_pos, z)) {
 			continue;
@@ -2938,7 +2998,7 @@ void CMap::generate_missing_terrain(const Vec2i &min_pos, const Vec2i &max_pos,
 		return;
 	}
 
-	std::vector<Vec2i> seeds;
+	stratagus::ordered_point_pool seeds(QRect(QPoint(0, 0), this->MapLayers[z]->get_size()));
 
 	//use tiles that have a terrain as seeds for the terrain generation
 	bool has_tile_with_missing_terrain = false;
@@ -2966,8 +3026,7 @@ void CMap::generate_missing_terrain(const Vec2i &min_pos, const Vec2i &max_pos,
 
 	//expand seeds
 	while (!seeds.empty()) {
-		Vec2i seed_pos = seeds[SyncRand(seeds.size())];
-		stratagus::vector::remove(seeds, seed_pos);
+		const Vec2i seed_pos = seeds.take(SyncRand(seeds.size()));
 
 		const CMapField *seed_tile = this->Field(seed_pos, z);
 
@@ -3212,15 +3271,19 @@ void CMap::generate_settlement_territories(const int z)
 	this->calculate_settlement_territory_border_tiles(z);
 }
 
-stratagus::point_set CMap::expand_settlement_territories(std::vector<QPoint> &&seeds, const int z, const int block_flags, const int same_flags)
+stratagus::point_set CMap::expand_settlement_territories(std::vector<QPoint> &&seed_list, const int z, const int block_flags, const int same_flags)
 {
 	//the seeds blocked by the block flags are stored, and then returned by the function
 	stratagus::point_set blocked_seeds;
 
+	stratagus::ordered_point_pool seeds(QRect(QPoint(0, 0), this->MapLayers[z]->get_size()));
+	for (const QPoint &seed_pos : seed_list) {
+		seeds.push_back(seed_pos);
+	}
+
 	//expand seeds
 	while (!seeds.empty()) {
-		const QPoint seed_pos = seeds[SyncRand(seeds.size())];
-		stratagus::vector::remove(seeds, seed_pos);
+		const QPoint seed_pos = seeds.take(SyncRand(seeds.size()));
 
 		const CMapField *seed_tile = this->Field(seed_pos, z);
 
@@ -84,6 +84,8 @@ class CUniqueItem;
 class CUnit;
 
 namespace stratagus {
+	class binary_reader;
+	class binary_writer;
 	class faction;
 	class generated_terrain;
 	class map_template;
@@ -195,7 +197,7 @@ public:
 	bool CanTileBePartOfMissingTerrainGeneration(const CMapField *tile, const stratagus::terrain_type *terrain_type, const stratagus::terrain_type *overlay_terrain_type) const;
 	void generate_missing_terrain(const Vec2i &min_pos, const Vec2i &max_pos, const int z);
 	void generate_settlement_territories(const int z);
-	stratagus::point_set expand_settlement_territories(std::vector<QPoint> &&seeds, const int z, const int block_flags = 0, const int same_flags = 0);
+	stratagus::point_set expand_settlement_territories(std::vector<QPoint> &&seed_list, const int z, const int block_flags = 0, const int same_flags = 0);
 	void calculate_settlement_territory_border_tiles(const int z);
 	void GenerateNeutralUnits(stratagus::unit_type *unit_type, int quantity, const Vec2i &min_pos, const Vec2i &max_pos, bool grouped, int z);
 	//Wyrmgus end
@@ -230,7 +232,9 @@ public:
 	void Reveal(bool only_person_players = false);
 	//Wyrmgus end
 	/// Save the map.
-	void Save(CFile &file) const;
+	void Save(CFile &file, const bool save_map_fields = true) const;
+	void save_tile_planes(stratagus::binary_writer &writer) const;
+	void load_tile_planes(stratagus::binary_reader &reader);
 
 	//
 	// Wall
@@ -378,6 +382,8 @@ extern MapMarkerFunc MapUnmarkTileDetectEthereal;
 /// Mark sight changes
 extern void MapSight(const CPlayer &player, const Vec2i &pos, int w,
 					 int h, int range, MapMarkerFunc *marker, int z);
+/// Move sight, only (un)marking the tiles whose visibility changes
+extern void MapSightDelta(const CPlayer &player, const Vec2i &old_pos, int old_range, const Vec2i &new_pos, int new_range, int w, int h, MapMarkerFunc *marker, MapMarkerFunc *unmarker, int z);
 /// Update fog of war
 extern void UpdateFogOfWarChange();
 
@@ -40,7 +40,9 @@
 #include "database/defines.h"
 #include "map/map_layer.h"
 #include "map/minimap.h"
+#include "map/sight_stencil.h"
 #include "map/tileset.h"
+#include "map/visibility_planes.h"
 #include "player.h"
 #include "ui/ui.h"
 #include "unit/unit.h"
@@ -264,21 +266,24 @@ void MapMarkTileSight(const CPlayer &player, const unsigned int index, int z)
 //	CMapField &mf = *CMap::Map.Field(index);
 	CMapField &mf = *CMap::Map.Field(index, z);
 	//Wyrmgus end
-	unsigned short *v = &(mf.playerInfo.Visible[player.Index]);
-	if (*v == 0 || *v == 1) { // Unexplored or unseen
+	unsigned short *v = &CMap::Map.MapLayers[z]->get_visibility_planes()->get_sight_count_ref(player.Index, index);
+	if (*v == 0) { // Unexplored or unseen
 		// When there is no fog only unexplored tiles are marked.
-		if (!CMap::Map.NoFogOfWar || *v == 0) {
+		if (!CMap::Map.NoFogOfWar || !mf.playerInfo.IsExploredBy(player.Index)) {
 			//Wyrmgus start
 //			UnitsOnTileMarkSeen(player, mf, 0);
 			UnitsOnTileMarkSeen(player, mf, 0, 0);
 			//Wyrmgus end
 		}
-		*v = 2;
+		*v = 1;
+		mf.playerInfo.ExploredPlayers |= 1u << player.Index;
+		mf.playerInfo.VisiblePlayers |= 1u << player.Index;
 		if (mf.playerInfo.IsTeamVisible(*CPlayer::GetThisPlayer())) {
 			//Wyrmgus start
 //			CMap::Map.MarkSeenTile(mf);
 			CMap::Map.MarkSeenTile(mf, z);
 			//Wyrmgus end
+			UI.Minimap.UpdateSeenXY(CMap::Map.MapLayers[z]->GetPosFromIndex(index), z);
 		}
 		return;
 	}
@@ -310,13 +315,12 @@ void MapUnmarkTileSight(const CPlayer &player, const unsigned int index, int z)
 //	CMapField &mf = *CMap::Map.Field(index);
 	CMapField &mf = *CMap::Map.Field(index, z);
 	//Wyrmgus end
-	unsigned short *v = &mf.playerInfo.Visible[player.Index];
+	unsigned short *v = &CMap::Map.MapLayers[z]->get_visibility_planes()->get_sight_count_ref(player.Index, index);
 	switch (*v) {
-		case 0:  // Unexplored
-		case 1:
+		case 0:  // Unexplored or unseen
 			// This happens when we unmark everything in CommandSharedVision
 			break;
-		case 2:
+		case 1:
 			// When there is NoFogOfWar units never get unmarked.
 			if (!CMap::Map.NoFogOfWar) {
 				//Wyrmgus start
@@ -330,7 +334,11 @@ void MapUnmarkTileSight(const CPlayer &player, const unsigned int index, int z)
 //				CMap::Map.MarkSeenTile(mf);
 				CMap::Map.MarkSeenTile(mf, z);
 				//Wyrmgus end
+				UI.Minimap.UpdateSeenXY(CMap::Map.MapLayers[z]->GetPosFromIndex(index), z);
 			}
+			mf.playerInfo.VisiblePlayers &= ~(1u << player.Index);
+			--*v;
+			break;
 		default:  // seen -> seen
 			--*v;
 			break;
@@ -361,12 +369,13 @@ void MapMarkTileDetectCloak(const CPlayer &player, const unsigned int index, int
 //	CMapField &mf = *CMap::Map.Field(index);
 	CMapField &mf = *CMap::Map.Field(index, z);
 	//Wyrmgus end
-	unsigned char *v = &mf.playerInfo.VisCloak[player.Index];
+	unsigned char *v = &CMap::Map.MapLayers[z]->get_visibility_planes()->get_cloak_detection_count_ref(player.Index, index);
 	if (*v == 0) {
 		//Wyrmgus start
 //		UnitsOnTileMarkSeen(player, mf, 1);
 		UnitsOnTileMarkSeen(player, mf, 1, 0);
 		//Wyrmgus end
+		mf.playerInfo.CloakDetectingPlayers |= 1u << player.Index;
 	}
 	Assert(*v != 255);
 	++*v;
@@ -398,13 +407,14 @@ void MapUnmarkTileDetectCloak(const CPlayer &player, const unsigned int index, i
 //	CMapField &mf = *CMap::Map.Field(index);
 	CMapField &mf = *CMap::Map.Field(index, z);
 	//Wyrmgus end
-	unsigned char *v = &mf.playerInfo.VisCloak[player.Index];
+	unsigned char *v = &CMap::Map.MapLayers[z]->get_visibility_planes()->get_cloak_detection_count_ref(player.Index, index);
 	Assert(*v != 0);
 	if (*v == 1) {
 		//Wyrmgus start
 //		UnitsOnTileUnmarkSeen(player, mf, 1);
 		UnitsOnTileUnmarkSeen(player, mf, 1, 0);
 		//Wyrmgus end
+		mf.playerInfo.CloakDetectingPlayers &= ~(1u << player.Index);
 	}
 	--*v;
 }
@@ -430,9 +440,10 @@ void MapUnmarkTileDetectCloak(const CPlayer &player, const Vec2i &pos, int z)
 void MapMarkTileDetectEthereal(const CPlayer &player, const unsigned int index, int z)
 {
 	CMapField &mf = *CMap::Map.Field(index, z);
-	unsigned char *v = &mf.playerInfo.VisEthereal[player.Index];
+	unsigned char *v = &CMap::Map.MapLayers[z]->get_visibility_planes()->get_ethereal_detection_count_ref(player.Index, index);
 	if (*v == 0) {
 		UnitsOnTileMarkSeen(player, mf, 0, 1);
+		mf.playerInfo.EtherealDetectingPlayers |= 1u << player.Index;
 	}
 	Assert(*v != 255);
 	++*v;
@@ -452,10 +463,11 @@ void MapMarkTileDetectEthereal(const CPlayer &player, const Vec2i &pos, int z)
 void MapUnmarkTileDetectEthereal(const CPlayer &player, const unsigned int index, int z)
 {
 	CMapField &mf = *CMap::Map.Field(index, z);
-	unsigned char *v = &mf.playerInfo.VisEthereal[player.Index];
+	unsigned char *v = &CMap::Map.MapLayers[z]->get_visibility_planes()->get_ethereal_detection_count_ref(player.Index, index);
 	Assert(*v != 0);
 	if (*v == 1) {
 		UnitsOnTileUnmarkSeen(player, mf, 0, 1);
+		mf.playerInfo.EtherealDetectingPlayers &= ~(1u << player.Index);
 	}
 	--*v;
 }
@@ -466,9 +478,58 @@ void MapUnmarkTileDetectEthereal(const CPlayer &player, const Vec2i &pos, int z)
 }
 //Wyrmgus end
 
+/**
+**  Check whether a tile within sight range can be seen from a unit's tiles,
+**  i.e. whether no air-unpassable obstacle blocks the view to it.
+**
+**  @param pos   location of the unit's top-left tile
+**  @param w     width of the unit, in square
+**  @param h     height of the unit, in square
+**  @param mpos  location of the tile to check
+**  @param z     map layer
+**
+**  @return      true if the tile is seen from at least one of the unit's tiles
+*/
+static bool CanSightReachTile(const Vec2i &pos, int w, int h, const Vec2i &mpos, int z)
+{
+	//how many tiles are seen after the obstacle; set to 1 here so that the obstacle tiles themselves don't have fog drawn over them
+	static constexpr int max_obstacle_difference = 1;
+
+	for (int x = 0; x < w; ++x) {
+		for (int y = 0; y < h; ++y) {
+			if (CheckObstaclesBetweenTiles(pos + Vec2i(x, y), mpos, MapFieldAirUnpassable, z, max_obstacle_difference)) { //the obstacle must be avoidable from at least one of the unit's tiles
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+/**
+**  Apply a marker function to a tile.
+**
+**  @param player     player to mark the sight for
+**  @param mpos       location of the tile
+**  @param row_index  index of the first tile of the row of the tile
+**  @param marker     function to mark or unmark sight
+**  @param z          map layer
+*/
+static inline void ApplySightMarker(const CPlayer &player, const Vec2i &mpos, const unsigned int row_index, MapMarkerFunc *marker, int z)
+{
+#ifdef MARKER_ON_INDEX
+	marker(player, mpos.x + row_index, z);
+#else
+	marker(player, mpos, z);
+#endif
+}
+
 /**
 **  Mark the sight of unit. (Explore and make visible.)
 **
+**  The sight circle is taken from a precomputed stencil, and applied as one
+**  horizontal span of tiles per row.
+**
 **  @param player  player to mark the sight for (not unit owner)
 **  @param pos     location to mark
 **  @param w       width to mark, in square
@@ -485,178 +546,132 @@ void MapSight(const CPlayer &player, const Vec2i &pos, int w, int h, int range,
 	if (!range) {
 		return;
 	}
-	
-	//Wyrmgus start
-	std::vector<unsigned long> obstacle_flags;
-	int max_obstacle_difference = 1; //how many tiles are seen after the obstacle; set to 1 here so that the obstacle tiles themselves don't have fog drawn over them
-	obstacle_flags.push_back(MapFieldAirUnpassable);
-	//Wyrmgus end
-	
-	// Up hemi-cyle
-	const int miny = std::max(-range, 0 - pos.y);
-	
-	for (int offsety = miny; offsety != 0; ++offsety) {
-		const int offsetx = isqrt(square(range + 1) - square(-offsety) - 1);
-		const int minx = std::max(0, pos.x - offsetx);
-		//Wyrmgus start
-//		const int maxx = std::min(CMap::Map.Info.MapWidth, pos.x + w + offsetx);
-		const int maxx = std::min(CMap::Map.Info.MapWidths[z], pos.x + w + offsetx);
-		//Wyrmgus end
-		Vec2i mpos(minx, pos.y + offsety);
-#ifdef MARKER_ON_INDEX
-		//Wyrmgus start
-//		const unsigned int index = mpos.y * CMap::Map.Info.MapWidth;
-		const unsigned int index = mpos.y * CMap::Map.Info.MapWidths[z];
-		//Wyrmgus end
-#endif
+
+	const stratagus::sight_stencil &stencil = stratagus::sight_stencil::get(range, w, h);
+	const int map_width = CMap::Map.Info.MapWidths[z];
+	const int map_height = CMap::Map.Info.MapHeights[z];
+
+	const int min_offset_y = std::max(stencil.get_min_offset_y(), 0 - pos.y);
+	const int max_offset_y = std::min(stencil.get_max_offset_y(), map_height - pos.y);
+
+	for (int offset_y = min_offset_y; offset_y < max_offset_y; ++offset_y) {
+		const stratagus::sight_stencil::span &span = stencil.get_span(offset_y);
+		const int minx = std::max(0, pos.x + span.min_offset_x);
+		const int maxx = std::min(map_width, pos.x + span.max_offset_x);
+		Vec2i mpos(minx, pos.y + offset_y);
+		const unsigned int row_index = mpos.y * map_width;
 
 		for (mpos.x = minx; mpos.x < maxx; ++mpos.x) {
 			//Wyrmgus start
-			bool obstacle_check = true;
-			for (size_t i = 0; i < obstacle_flags.size(); ++i) {
-				bool obstacle_subcheck = false;
-				for (int x = 0; x < w; ++x) {
-					for (int y = 0; y < h; ++y) {
-						if (CheckObstaclesBetweenTiles(pos + Vec2i(x, y), mpos, obstacle_flags[i], z, max_obstacle_difference)) { //the obstacle must be avoidable from at least one of the unit's tiles
-							obstacle_subcheck = true;
-							break;
-						}
-					}
-					if (obstacle_subcheck) {
-						break;
-					}
-				}
-				if (!obstacle_subcheck) {
-					obstacle_check = false;
-					break;
-				}
-			}
-			if (!obstacle_check) {
+			if (!CanSightReachTile(pos, w, h, mpos, z)) {
 				continue;
 			}
 			//Wyrmgus end
-#ifdef MARKER_ON_INDEX
-			//Wyrmgus start
-//			marker(player, mpos.x + index);
-			marker(player, mpos.x + index, z);
-			//Wyrmgus end
-#else
-			//Wyrmgus start
-//			marker(player, mpos);
-			marker(player, mpos, z);
-			//Wyrmgus end
-#endif
+			ApplySightMarker(player, mpos, row_index, marker, z);
 		}
 	}
-	for (int offsety = 0; offsety < h; ++offsety) {
-		const int minx = std::max(0, pos.x - range);
-		//Wyrmgus start
-//		const int maxx = std::min(CMap::Map.Info.MapWidth, pos.x + w + range);
-		const int maxx = std::min(CMap::Map.Info.MapWidths[z], pos.x + w + range);
-		//Wyrmgus end
-		Vec2i mpos(minx, pos.y + offsety);
-#ifdef MARKER_ON_INDEX
-		//Wyrmgus start
-//		const unsigned int index = mpos.y * CMap::Map.Info.MapWidth;
-		const unsigned int index = mpos.y * CMap::Map.Info.MapWidths[z];
-		//Wyrmgus end
-#endif
+}
 
-		for (mpos.x = minx; mpos.x < maxx; ++mpos.x) {
-			//Wyrmgus start
-			bool obstacle_check = true;
-			for (size_t i = 0; i < obstacle_flags.size(); ++i) {
-				bool obstacle_subcheck = false;
-				for (int x = 0; x < w; ++x) {
-					for (int y = 0; y < h; ++y) {
-						if (CheckObstaclesBetweenTiles(pos + Vec2i(x, y), mpos, obstacle_flags[i], z, max_obstacle_difference)) { //the obstacle must be avoidable from at least one of the unit's tiles
-							obstacle_subcheck = true;
-							break;
-						}
-					}
-					if (obstacle_subcheck) {
-						break;
-					}
-				}
-				if (!obstacle_subcheck) {
-					obstacle_check = false;
-					break;
-				}
-			}
-			if (!obstacle_check) {
-				continue;
-			}
-			//Wyrmgus end
-#ifdef MARKER_ON_INDEX
-			//Wyrmgus start
-//			marker(player, mpos.x + index);
-			marker(player, mpos.x + index, z);
-			//Wyrmgus end
-#else
-			//Wyrmgus start
-//			marker(player, mpos);
-			marker(player, mpos, z);
-			//Wyrmgus end
-#endif
-		}
+/**
+**  Move the sight of unit from one location to another.
+**
+**  Rather than unmarking the whole sight area at the old location and marking
+**  it again at the new one, only the tiles whose visibility from the unit
+**  changes are (un)marked; when the unit moves a single tile, these are the
+**  leading and trailing edges of its sight circle. The resulting counters are
+**  the same as with MapSight(unmarker) followed by MapSight(marker).
+**
+**  Tiles within both sight areas are only checked for obstacles if the unit
+**  moved, as its view of them may then have become blocked or unblocked.
+**
+**  @param player     player to mark the sight for (not unit owner)
+**  @param old_pos    previous location of the unit
+**  @param old_range  previous radius of the sight
+**  @param new_pos    new location of the unit
+**  @param new_range  new radius of the sight
+**  @param w          width to mark, in square
+**  @param h          height to mark, in square
+**  @param marker     function to mark sight
+**  @param unmarker   function to unmark sight
+**  @param z          map layer, which must be the same for both locations
+*/
+void MapSightDelta(const CPlayer &player, const Vec2i &old_pos, int old_range, const Vec2i &new_pos, int new_range, int w, int h, MapMarkerFunc *marker, MapMarkerFunc *unmarker, int z)
+{
+	if (!old_range || !new_range) {
+		// Nothing to share between the two areas.
+		MapSight(player, old_pos, w, h, old_range, unmarker, z);
+		MapSight(player, new_pos, w, h, new_range, marker, z);
+		return;
 	}
-	// bottom hemi-cycle
-	//Wyrmgus start
-//	const int maxy = std::min(range, CMap::Map.Info.MapHeight - pos.y - h);
-	const int maxy = std::min(range, CMap::Map.Info.MapHeights[z] - pos.y - h);
-	//Wyrmgus end
-	for (int offsety = 0; offsety < maxy; ++offsety) {
-		const int offsetx = isqrt(square(range + 1) - square(offsety + 1) - 1);
-		const int minx = std::max(0, pos.x - offsetx);
-		//Wyrmgus start
-//		const int maxx = std::min(CMap::Map.Info.MapWidth, pos.x + w + offsetx);
-		const int maxx = std::min(CMap::Map.Info.MapWidths[z], pos.x + w + offsetx);
-		//Wyrmgus end
-		Vec2i mpos(minx, pos.y + h + offsety);
-#ifdef MARKER_ON_INDEX
-		//Wyrmgus start
-//		const unsigned int index = mpos.y * CMap::Map.Info.MapWidth;
-		const unsigned int index = mpos.y * CMap::Map.Info.MapWidths[z];
-		//Wyrmgus end
-#endif
 
-		for (mpos.x = minx; mpos.x < maxx; ++mpos.x) {
-			//Wyrmgus start
-			bool obstacle_check = true;
-			for (size_t i = 0; i < obstacle_flags.size(); ++i) {
-				bool obstacle_subcheck = false;
-				for (int x = 0; x < w; ++x) {
-					for (int y = 0; y < h; ++y) {
-						if (CheckObstaclesBetweenTiles(pos + Vec2i(x, y), mpos, obstacle_flags[i], z, max_obstacle_difference)) { //the obstacle must be avoidable from at least one of the unit's tiles
-							obstacle_subcheck = true;
-							break;
-						}
-					}
-					if (obstacle_subcheck) {
-						break;
-					}
-				}
-				if (!obstacle_subcheck) {
-					obstacle_check = false;
-					break;
+	const stratagus::sight_stencil &old_stencil = stratagus::sight_stencil::get(old_range, w, h);
+	const stratagus::sight_stencil &new_stencil = stratagus::sight_stencil::get(new_range, w, h);
+	const int map_width = CMap::Map.Info.MapWidths[z];
+	const int map_height = CMap::Map.Info.MapHeights[z];
+
+	const int miny = std::max(0, std::min(old_pos.y + old_stencil.get_min_offset_y(), new_pos.y + new_stencil.get_min_offset_y()));
+	const int maxy = std::min(map_height, std::max(old_pos.y + old_stencil.get_max_offset_y(), new_pos.y + new_stencil.get_max_offset_y()));
+
+	for (int y = miny; y < maxy; ++y) {
+		const int old_offset_y = y - old_pos.y;
+		const int new_offset_y = y - new_pos.y;
+		const bool in_old_rows = old_offset_y >= old_stencil.get_min_offset_y() && old_offset_y < old_stencil.get_max_offset_y();
+		const bool in_new_rows = new_offset_y >= new_stencil.get_min_offset_y() && new_offset_y < new_stencil.get_max_offset_y();
+
+		// Tiles outside both spans are not (un)marked; use empty spans for rows outside a stencil.
+		int old_minx = 0;
+		int old_maxx = 0;
+		if (in_old_rows) {
+			const stratagus::sight_stencil::span &span = old_stencil.get_span(old_offset_y);
+			old_minx = std::max(0, old_pos.x + span.min_offset_x);
+			old_maxx = std::min(map_width, old_pos.x + span.max_offset_x);
+		}
+		int new_minx = 0;
+		int new_maxx = 0;
+		if (in_new_rows) {
+			const stratagus::sight_stencil::span &span = new_stencil.get_span(new_offset_y);
+			new_minx = std::max(0, new_pos.x + span.min_offset_x);
+			new_maxx = std::min(map_width, new_pos.x + span.max_offset_x);
+		}
+
+		int minx = std::min(old_minx, new_minx);
+		int maxx = std::max(old_maxx, new_maxx);
+		if (old_minx >= old_maxx) {
+			minx = new_minx;
+			maxx = new_maxx;
+		} else if (new_minx >= new_maxx) {
+			minx = old_minx;
+			maxx = old_maxx;
+		}
+
+		Vec2i mpos(minx, y);
+		const unsigned int row_index = mpos.y * map_width;
+
+		const auto apply_sight_changes = [&](const int begin_x, const int end_x) {
+			for (mpos.x = begin_x; mpos.x < end_x; ++mpos.x) {
+				const bool old_seen = mpos.x >= old_minx && mpos.x < old_maxx && CanSightReachTile(old_pos, w, h, mpos, z);
+				const bool new_seen = mpos.x >= new_minx && mpos.x < new_maxx && CanSightReachTile(new_pos, w, h, mpos, z);
+
+				if (old_seen == new_seen) {
+					continue;
 				}
+
+				ApplySightMarker(player, mpos, row_index, new_seen ? marker : unmarker, z);
 			}
-			if (!obstacle_check) {
+		};
+
+		if (old_pos == new_pos) {
+			// Obstacles are traced from the same tiles for both ranges, so tiles in both spans keep their visibility and only the rest can change.
+			const int shared_minx = std::max(old_minx, new_minx);
+			const int shared_maxx = std::min(old_maxx, new_maxx);
+			if (shared_minx < shared_maxx) {
+				apply_sight_changes(minx, shared_minx);
+				apply_sight_changes(shared_maxx, maxx);
 				continue;
 			}
-			//Wyrmgus end
-#ifdef MARKER_ON_INDEX
-			//Wyrmgus start
-//			marker(player, mpos.x + index);
-			marker(player, mpos.x + index, z);
-			//Wyrmgus end
-#else
-			//Wyrmgus start
-//			marker(player, mpos);
-			marker(player, mpos, z);
-			//Wyrmgus end
-#endif
 		}
+
+		apply_sight_changes(minx, maxx);
 	}
 }
 
@@ -40,6 +40,7 @@
 #include "map/terrain_type.h"
 #include "map/tile.h"
 #include "map/tileset.h"
+#include "map/visibility_planes.h"
 #include "sound/sound_server.h"
 #include "time/season.h"
 #include "time/season_schedule.h"
@@ -47,6 +48,8 @@
 #include "time/time_of_day_schedule.h"
 #include "unit/unit.h"
 #include "unit/unit_manager.h"
+#include "unit/unit_spatial_index.h"
+#include "video.h"
 
 #ifdef USE_OAML
 #include <oaml.h>
@@ -83,6 +86,9 @@ CMapLayer::CMapLayer(const QSize &size) : size(size)
 	} catch (const std::bad_alloc &) {
 		std::throw_with_nested(std::runtime_error("Failed to allocate map layer with a tile area of " + std::to_string(max_tile_index) + ", for " + std::to_string(max_tile_index * sizeof(CMapField)) + " bytes in total."));
 	}
+
+	this->unit_index = std::make_unique<stratagus::unit_spatial_index>(size);
+	this->visibility_planes = std::make_unique<stratagus::visibility_planes>(max_tile_index);
 }
 
 /**
@@ -278,6 +284,12 @@ void CMapLayer::DecrementRemainingTimeOfDayHours()
 	if (this->RemainingTimeOfDayHours <= 0) {
 		this->IncrementTimeOfDay();
 	}
+#if defined(USE_OPENGL) || defined(USE_GLES)
+	else if (this->RemainingTimeOfDayHours <= this->TimeOfDaySchedule->HourMultiplier && this == UI.CurrentMapLayer) {
+		//the time of day will change in the next hour, so prepare the textures for the next time of day in the background
+		PrepareTimeOfDayTextures(this->GetNextScheduledTimeOfDay()->TimeOfDay);
+	}
+#endif
 }
 
 /**
@@ -285,16 +297,26 @@ void CMapLayer::DecrementRemainingTimeOfDayHours()
 */
 void CMapLayer::IncrementTimeOfDay()
 {
-	unsigned current_time_of_day_id = this->TimeOfDay->ID;
-	current_time_of_day_id++;
-	if (current_time_of_day_id >= this->TimeOfDaySchedule->ScheduledTimesOfDay.size()) {
-		current_time_of_day_id = 0;
-	}
-	
-	this->SetTimeOfDay(this->TimeOfDaySchedule->ScheduledTimesOfDay[current_time_of_day_id]);
+	this->SetTimeOfDay(this->GetNextScheduledTimeOfDay());
 	this->RemainingTimeOfDayHours += this->TimeOfDay->GetHours(this->GetSeason());
 }
 
+/**
+**	@brief	Get the scheduled time of day which follows the current one
+**
+**	@return	The next scheduled time of day
+*/
+CScheduledTimeOfDay *CMapLayer::GetNextScheduledTimeOfDay() const
+{
+	unsigned next_time_of_day_id = this->TimeOfDay->ID;
+	next_time_of_day_id++;
+	if (next_time_of_day_id >= this->TimeOfDaySchedule->ScheduledTimesOfDay.size()) {
+		next_time_of_day_id = 0;
+	}
+
+	return this->TimeOfDaySchedule->ScheduledTimesOfDay[next_time_of_day_id];
+}
+
 /**
 **	@brief	Set the time of day corresponding to an amount of hours
 **
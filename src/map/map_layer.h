@@ -49,6 +49,8 @@ namespace stratagus {
 	class plane;
 	class season;
 	class time_of_day;
+	class unit_spatial_index;
+	class visibility_planes;
 	class world;
 }
 
@@ -128,6 +130,7 @@ public:
 private:
 	void DecrementRemainingTimeOfDayHours();
 	void IncrementTimeOfDay();
+	CScheduledTimeOfDay *GetNextScheduledTimeOfDay() const;
 public:
 	void SetTimeOfDayByHours(const unsigned long long hours);
 	void SetTimeOfDay(CScheduledTimeOfDay *time_of_day);
@@ -140,11 +143,23 @@ public:
 	void SetSeasonByHours(const unsigned long long hours);
 	void SetSeason(CScheduledSeason *season);
 	stratagus::season *GetSeason() const;
+
+	stratagus::unit_spatial_index *get_unit_index() const
+	{
+		return this->unit_index.get();
+	}
+
+	stratagus::visibility_planes *get_visibility_planes() const
+	{
+		return this->visibility_planes.get();
+	}
 	
 	int ID = -1;
 private:
 	CMapField *Fields = nullptr;				/// fields on the map layer
 	QSize size;									/// the size in tiles of the map layer
+	std::unique_ptr<stratagus::unit_spatial_index> unit_index;	/// coarse index of the units placed on the map layer, for range queries
+	std::unique_ptr<stratagus::visibility_planes> visibility_planes;	/// the per-player visibility counters of the map layer's tiles
 public:
 	CScheduledTimeOfDay *TimeOfDay = nullptr;	/// the time of day for the map layer
 	CTimeOfDaySchedule *TimeOfDaySchedule = nullptr;	/// the time of day schedule for the map layer
@@ -36,6 +36,7 @@
 #include "map/map.h"
 
 #include "map/map_layer.h"
+#include "map/visibility_planes.h"
 #include "player.h"
 #include "unit/unit.h"
 #include "unit/unit_type.h"
@@ -47,31 +48,20 @@
 static inline unsigned char
 IsTileRadarVisible(const CPlayer &pradar, const CPlayer &punit, const CMapFieldPlayerInfo &mfp)
 {
-	if (mfp.RadarJammer[punit.Index]) {
+	if (mfp.RadarJammingPlayers & (1u << punit.Index)) {
 		return 0;
 	}
 
-	int p = pradar.Index;
+	const uint32_t player_bit = 1u << pradar.Index;
 	if (pradar.IsVisionSharing()) {
-		const unsigned char *const radar = mfp.Radar;
-		const unsigned char *const jamming = mfp.RadarJammer;
-		unsigned char radarvision = 0;
 		// Check jamming first, if we are jammed, exit
-		for (int i = 0; i < PlayerMax; ++i) {
-			if (i != p) {
-				if (jamming[i] > 0 && punit.has_mutual_shared_vision_with(*CPlayer::Players[i])) {
-					// We are jammed, return nothing
-					return 0;
-				}
-				if (radar[i] > 0 && pradar.has_mutual_shared_vision_with(*CPlayer::Players[i])) {
-					radarvision |= radar[i];
-				}
-			}
+		if (mfp.RadarJammingPlayers & punit.get_mutual_shared_vision_mask() & ~player_bit) {
+			// We are jammed, return nothing
+			return 0;
 		}
-		// Can't exit until the end, as we might be jammed
-		return (radarvision | mfp.Radar[p]);
+		return (mfp.RadarPlayers & (pradar.get_mutual_shared_vision_mask() | player_bit)) != 0;
 	}
-	return mfp.Radar[p];
+	return (mfp.RadarPlayers & player_bit) != 0;
 }
 
 
@@ -107,8 +97,10 @@ bool CUnit::IsVisibleOnRadar(const CPlayer &pradar) const
 */
 void MapMarkTileRadar(const CPlayer &player, const unsigned int index, int z)
 {
-	Assert(CMap::Map.Field(index, z)->playerInfo.Radar[player.Index] != 255);
-	CMap::Map.Field(index, z)->playerInfo.Radar[player.Index]++;
+	unsigned char *v = &CMap::Map.MapLayers[z]->get_visibility_planes()->get_radar_count_ref(player.Index, index);
+	Assert(*v != 255);
+	++*v;
+	CMap::Map.Field(index, z)->playerInfo.RadarPlayers |= 1u << player.Index;
 }
 
 void MapMarkTileRadar(const CPlayer &player, int x, int y, int z)
@@ -130,10 +122,13 @@ void MapUnmarkTileRadar(const CPlayer &player, const unsigned int index, int z)
 	// Reduce radar coverage if it exists.
 	//Wyrmgus start
 //	unsigned char *v = &(CMap::Map.Field(index)->playerInfo.Radar[player.Index]);
-	unsigned char *v = &(CMap::Map.Field(index, z)->playerInfo.Radar[player.Index]);
+	unsigned char *v = &CMap::Map.MapLayers[z]->get_visibility_planes()->get_radar_count_ref(player.Index, index);
 	//Wyrmgus end
 	if (*v) {
 		--*v;
+		if (*v == 0) {
+			CMap::Map.Field(index, z)->playerInfo.RadarPlayers &= ~(1u << player.Index);
+		}
 	}
 }
 
@@ -159,8 +154,10 @@ void MapMarkTileRadarJammer(const CPlayer &player, const unsigned int index, int
 	//Wyrmgus start
 //	Assert(CMap::Map.Field(index)->playerInfo.RadarJammer[player.Index] != 255);
 //	CMap::Map.Field(index)->playerInfo.RadarJammer[player.Index]++;
-	Assert(CMap::Map.Field(index, z)->playerInfo.RadarJammer[player.Index] != 255);
-	CMap::Map.Field(index, z)->playerInfo.RadarJammer[player.Index]++;
+	unsigned char *v = &CMap::Map.MapLayers[z]->get_visibility_planes()->get_radar_jammer_count_ref(player.Index, index);
+	Assert(*v != 255);
+	++*v;
+	CMap::Map.Field(index, z)->playerInfo.RadarJammingPlayers |= 1u << player.Index;
 	//Wyrmgus end
 }
 
@@ -185,10 +182,13 @@ void MapUnmarkTileRadarJammer(const CPlayer &player, const unsigned int index, i
 	// Reduce radar coverage if it exists.
 	//Wyrmgus start
 //	unsigned char *v = &(CMap::Map.Field(index)->playerInfo.RadarJammer[player.Index]);
-	unsigned char *v = &(CMap::Map.Field(index, z)->playerInfo.RadarJammer[player.Index]);
+	unsigned char *v = &CMap::Map.MapLayers[z]->get_visibility_planes()->get_radar_jammer_count_ref(player.Index, index);
 	//Wyrmgus end
 	if (*v) {
 		--*v;
+		if (*v == 0) {
+			CMap::Map.Field(index, z)->playerInfo.RadarJammingPlayers &= ~(1u << player.Index);
+		}
 	}
 }
 
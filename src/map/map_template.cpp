@@ -32,12 +32,14 @@
 #include "campaign.h"
 #include "civilization.h"
 #include "config.h"
+#include "database/database.h"
 #include "database/defines.h"
 #include "editor.h"
 #include "faction.h"
 #include "game.h"
 #include "iocompat.h"
 #include "iolib.h"
+#include "map/geodata_plane.h"
 #include "map/historical_location.h"
 #include "map/map.h"
 #include "map/map_layer.h"
@@ -59,16 +61,20 @@
 #include "unit/unit_class.h"
 #include "unit/unit_find.h"
 #include "unit/unit_type.h"
+#include "util/exception_util.h"
 #include "util/geocoordinate_util.h"
 #include "util/georectangle_util.h"
-#include "util/geoshape_util.h"
+#include "util/ordered_point_pool.h"
 #include "util/point_util.h"
+#include "util/profiler.h"
 #include "util/size_util.h"
 #include "util/string_util.h"
 #include "util/vector_util.h"
 #include "video.h"
 #include "world.h"
 
+#include <QCryptographicHash>
+
 namespace stratagus {
 
 map_template::map_template(const std::string &identifier)
@@ -339,29 +345,25 @@ void map_template::initialize()
 	}
 
 	if (this->outputs_terrain_image()) {
-		terrain_geodata_map terrain_data;
+		//the terrain geodata is only parsed if a terrain plane is not in the cache
+		std::unique_ptr<terrain_geodata_map> terrain_data;
 
-		if (this->get_world() != nullptr) {
-			terrain_data = this->get_world()->parse_terrain_geojson_folder();
-		}
+		const geodata_plane terrain_plane = this->get_terrain_geodata_plane(false, terrain_data);
+		const geodata_plane overlay_terrain_plane = this->get_terrain_geodata_plane(true, terrain_data);
 
 		const std::string filename = this->get_identifier() + ".png";
 		const std::string overlay_filename = this->get_identifier() + "_overlay.png";
 
-		this->save_terrain_image(filename, false, terrain_data);
-		this->save_terrain_image(overlay_filename, true, terrain_data);
+		this->save_terrain_image(filename, false, terrain_plane);
+		this->save_terrain_image(overlay_filename, true, overlay_terrain_plane);
 	}
 
 	if (this->outputs_territory_image()) {
-		std::map<const site *, std::vector<std::unique_ptr<QGeoShape>>> territory_data;
-
-		if (this->get_world() != nullptr) {
-			territory_data = this->get_world()->parse_territories_geojson_folder();
-		}
+		const geodata_plane territory_plane = this->get_territory_geodata_plane();
 
 		const std::string filename = this->get_identifier() + "_territories.png";
 
-		this->save_territory_image(filename, territory_data);
+		this->save_territory_image(filename, territory_plane);
 	}
 
 	data_entry::initialize();
@@ -585,6 +587,8 @@ void map_template::Apply(const QPoint &template_start_pos, const QPoint &map_sta
 	this->current_map_start_pos = map_start_pos;
 	this->current_start_pos = template_start_pos;
 
+	const profile_zone profile("map_template::Apply: " + this->get_identifier());
+
 	const campaign *current_campaign = game::get()->get_current_campaign();
 	
 	if (z >= (int)CMap::Map.MapLayers.size()) {
@@ -1972,7 +1976,7 @@ QPoint map_template::generate_subtemplate_position(const map_template *subtempla
 		min_pos.setX(std::max<short>(min_pos.x(), other_template_pos.x() + other_template->get_applied_width() - (subtemplate->get_applied_width() / 2)));
 	}
 
-	std::vector<QPoint> potential_positions;
+	ordered_point_pool potential_positions(QRect(min_pos, max_pos));
 	for (int x = min_pos.x(); x <= max_pos.x(); ++x) {
 		for (int y = min_pos.y(); y <= max_pos.y(); ++y) {
 			potential_positions.push_back(QPoint(x, y));
@@ -1980,8 +1984,7 @@ QPoint map_template::generate_subtemplate_position(const map_template *subtempla
 	}
 
 	while (!potential_positions.empty()) {
-		const QPoint subtemplate_pos = potential_positions[SyncRand(potential_positions.size())];
-		vector::remove(potential_positions, subtemplate_pos);
+		const QPoint subtemplate_pos = potential_positions.take(SyncRand(potential_positions.size()));
 
 		//include the offsets relevant for the templates dependent on this one's position (e.g. templates that have to be to the north of this one), so that there is enough space for them to be generated there
 		const int north_offset = subtemplate->GetDependentTemplatesNorthOffset();
@@ -2090,7 +2093,190 @@ QPoint map_template::get_location_map_position(const std::unique_ptr<historical_
 	return QPoint(-1, -1);
 }
 
-void map_template::save_terrain_image(const std::string &filename, const bool overlay, const terrain_geodata_map &terrain_data) const
+/**
+**	@brief	Get the path of the cache file for a rasterized geodata plane of the map template
+**
+**	@param	plane_name	The name of the plane
+**
+**	@return	The path of the cache file
+*/
+std::filesystem::path map_template::get_geodata_cache_filepath(const std::string &plane_name) const
+{
+	return database::get_cache_path() / "geodata" / (this->get_identifier() + "_" + plane_name + ".bin");
+}
+
+/**
+**	@brief	Add the map template's properties which affect the rasterization of geodata to a cache key
+**
+**	@param	hash	The hash which is used to build the cache key
+*/
+void map_template::add_geodata_cache_key_data(QCryptographicHash &hash) const
+{
+	for (const double value : {this->get_min_longitude(), this->get_max_longitude(), this->get_min_latitude(), this->get_max_latitude()}) {
+		hash.addData(QByteArray::number(value, 'g', 17));
+	}
+
+	hash.addData(QByteArray::number(this->get_width()));
+	hash.addData(QByteArray::number(this->get_height()));
+}
+
+static bool is_terrain_geodata_overlay(const terrain_geodata_key &key)
+{
+	if (std::holds_alternative<const terrain_feature *>(key)) {
+		const terrain_feature *terrain_feature = std::get<const stratagus::terrain_feature *>(key);
+		return terrain_feature->is_trade_route() || terrain_feature->get_terrain_type()->is_overlay();
+	}
+
+	return std::get<const terrain_type *>(key)->is_overlay();
+}
+
+static std::string get_terrain_geodata_entry_identifier(const terrain_geodata_key &key)
+{
+	if (std::holds_alternative<const terrain_feature *>(key)) {
+		return std::string(terrain_feature::class_identifier) + ":" + std::get<const terrain_feature *>(key)->get_identifier();
+	}
+
+	return std::string(terrain_type::class_identifier) + ":" + std::get<const terrain_type *>(key)->get_identifier();
+}
+
+static QColor get_terrain_geodata_entry_color(const std::string &entry_identifier)
+{
+	const size_t separator_pos = entry_identifier.find(':');
+	const std::string class_identifier = entry_identifier.substr(0, separator_pos);
+	const std::string identifier = entry_identifier.substr(separator_pos + 1);
+
+	if (class_identifier == terrain_feature::class_identifier) {
+		return terrain_feature::get(identifier)->get_color();
+	}
+
+	return terrain_type::get(identifier)->get_color();
+}
+
+/**
+**	@brief	Get the key identifying the inputs from which a terrain plane of the map template is rasterized
+**
+**	Besides the GeoJSON files and the map template's georectangle and size, the key covers the order in which terrain types and features are written, since pixels covered by more than one of them keep the first one.
+**
+**	@param	overlay	Whether the plane is for overlay terrain
+**
+**	@return	The key
+*/
+QByteArray map_template::get_terrain_geodata_cache_key(const bool overlay) const
+{
+	QCryptographicHash hash(QCryptographicHash::Sha1);
+
+	hash.addData(this->get_world()->get_geojson_folder_hash(world::terrain_map_folder));
+	this->add_geodata_cache_key_data(hash);
+
+	std::vector<terrain_geodata_key> terrain_keys;
+	for (const terrain_type *terrain : terrain_type::get_all()) {
+		terrain_keys.push_back(terrain);
+	}
+	for (const terrain_feature *terrain_feature : terrain_feature::get_all()) {
+		terrain_keys.push_back(terrain_feature);
+	}
+
+	std::stable_sort(terrain_keys.begin(), terrain_keys.end(), terrain_geodata_map_compare());
+
+	for (const terrain_geodata_key &terrain_key : terrain_keys) {
+		if (is_terrain_geodata_overlay(terrain_key) != overlay) {
+			continue;
+		}
+
+		hash.addData(QByteArray::fromStdString(get_terrain_geodata_entry_identifier(terrain_key)));
+	}
+
+	return hash.result();
+}
+
+/**
+**	@brief	Get a rasterized terrain plane for the map template, from the cache if it has already been rasterized from the same inputs
+**
+**	@param	overlay			Whether to get the plane for overlay terrain
+**	@param	terrain_data	The parsed terrain geodata of the map template's world, which is parsed by this function if it is needed and has not been parsed yet
+**
+**	@return	The terrain plane
+*/
+geodata_plane map_template::get_terrain_geodata_plane(const bool overlay, std::unique_ptr<terrain_geodata_map> &terrain_data) const
+{
+	if (this->get_world() == nullptr) {
+		return geodata_plane::rasterize(this->get_size(), this->get_georectangle(), {});
+	}
+
+	const std::filesystem::path cache_filepath = this->get_geodata_cache_filepath(overlay ? "overlay_terrain" : "terrain");
+	const QByteArray cache_key = this->get_terrain_geodata_cache_key(overlay);
+
+	std::optional<geodata_plane> cached_plane = geodata_plane::load(cache_filepath, cache_key, this->get_size());
+	if (cached_plane.has_value()) {
+		return std::move(cached_plane.value());
+	}
+
+	if (terrain_data == nullptr) {
+		terrain_data = std::make_unique<terrain_geodata_map>(this->get_world()->parse_terrain_geojson_folder());
+	}
+
+	std::vector<geodata_plane::entry_geoshapes> entries;
+	for (const auto &kv_pair : *terrain_data) {
+		if (is_terrain_geodata_overlay(kv_pair.first) != overlay) {
+			continue;
+		}
+
+		entries.emplace_back(get_terrain_geodata_entry_identifier(kv_pair.first), &kv_pair.second);
+	}
+
+	geodata_plane plane = geodata_plane::rasterize(this->get_size(), this->get_georectangle(), entries);
+
+	try {
+		plane.save(cache_filepath, cache_key);
+	} catch (const std::exception &exception) {
+		exception::report(exception);
+	}
+
+	return plane;
+}
+
+/**
+**	@brief	Get a rasterized territory plane for the map template, from the cache if it has already been rasterized from the same inputs
+**
+**	@return	The territory plane
+*/
+geodata_plane map_template::get_territory_geodata_plane() const
+{
+	if (this->get_world() == nullptr) {
+		return geodata_plane::rasterize(this->get_size(), this->get_georectangle(), {});
+	}
+
+	const std::filesystem::path cache_filepath = this->get_geodata_cache_filepath("territories");
+
+	QCryptographicHash hash(QCryptographicHash::Sha1);
+	hash.addData(this->get_world()->get_geojson_folder_hash(world::territories_map_folder));
+	this->add_geodata_cache_key_data(hash);
+	const QByteArray cache_key = hash.result();
+
+	std::optional<geodata_plane> cached_plane = geodata_plane::load(cache_filepath, cache_key, this->get_size());
+	if (cached_plane.has_value()) {
+		return std::move(cached_plane.value());
+	}
+
+	const std::map<const site *, std::vector<std::unique_ptr<QGeoShape>>> territory_data = this->get_world()->parse_territories_geojson_folder();
+
+	std::vector<geodata_plane::entry_geoshapes> entries;
+	for (const auto &kv_pair : territory_data) {
+		entries.emplace_back(kv_pair.first->get_identifier(), &kv_pair.second);
+	}
+
+	geodata_plane plane = geodata_plane::rasterize(this->get_size(), this->get_georectangle(), entries);
+
+	try {
+		plane.save(cache_filepath, cache_key);
+	} catch (const std::exception &exception) {
+		exception::report(exception);
+	}
+
+	return plane;
+}
+
+void map_template::save_terrain_image(const std::string &filename, const bool overlay, const geodata_plane &terrain_plane) const
 {
 	bool use_terrain_file = true;
 	std::filesystem::path terrain_file;
@@ -2155,38 +2341,13 @@ void map_template::save_terrain_image(const std::string &filename, const bool ov
 			y += 1;
 		}
 	} else {
-		const QGeoRectangle georectangle = this->get_georectangle();
-
-		for (const auto &kv_pair : terrain_data) {
-			const terrain_type *terrain = nullptr;
-			const terrain_feature *terrain_feature = nullptr;
-
-			QColor color;
-			if (std::holds_alternative<const stratagus::terrain_feature *>(kv_pair.first)) {
-				terrain_feature = std::get<const stratagus::terrain_feature *>(kv_pair.first);
-				terrain = terrain_feature->get_terrain_type();
-				color = terrain_feature->get_color();
-			} else {
-				terrain = std::get<const terrain_type *>(kv_pair.first);
-				color = terrain->get_color();
-			}
-
-			bool terrain_overlay = false;
-			if (terrain_feature != nullptr && terrain_feature->is_trade_route()) {
-				terrain_overlay = true;
-			} else {
-				terrain_overlay = terrain->is_overlay();
-			}
-
-			if (terrain_overlay != overlay) {
-				continue;
-			}
-
-			for (const auto &geoshape : kv_pair.second) {
-				geoshape::write_to_image(*geoshape, image, color, georectangle, filename);
-			}
+		std::vector<QColor> entry_colors;
+		for (const std::string &entry_identifier : terrain_plane.get_entry_identifiers()) {
+			entry_colors.push_back(get_terrain_geodata_entry_color(entry_identifier));
 		}
 
+		terrain_plane.write_to_image(image, entry_colors);
+
 		stratagus::point_map<const stratagus::terrain_type *> terrain_map;
 
 		for (const auto &kv_pair : this->get_tile_terrains()) {
@@ -2214,7 +2375,7 @@ void map_template::save_terrain_image(const std::string &filename, const bool ov
 	image.save(QString::fromStdString(filename));
 }
 
-void map_template::save_territory_image(const std::string &filename, const std::map<const site *, std::vector<std::unique_ptr<QGeoShape>>> &territory_data) const
+void map_template::save_territory_image(const std::string &filename, const geodata_plane &territory_plane) const
 {
 	const std::filesystem::path territory_image = this->get_terrain_image();
 
@@ -2230,20 +2391,19 @@ void map_template::save_territory_image(const std::string &filename, const std::
 		image.fill(Qt::transparent);
 	}
 
-	const QGeoRectangle georectangle = this->get_georectangle();
-
-	for (const auto &kv_pair : territory_data) {
-		const site *settlement = kv_pair.first;
+	std::vector<QColor> entry_colors;
+	for (const std::string &entry_identifier : territory_plane.get_entry_identifiers()) {
+		const site *settlement = site::get(entry_identifier);
 		const QColor color = settlement->get_color();
 		if (!color.isValid()) {
 			throw std::runtime_error("Settlement \"" + settlement->get_identifier() + "\" has no valid color.");
 		}
 
-		for (const auto &geoshape : kv_pair.second) {
-			geoshape::write_to_image(*geoshape, image, color, georectangle, filename);
-		}
+		entry_colors.push_back(color);
 	}
 
+	territory_plane.write_to_image(image, entry_colors);
+
 	image.save(QString::fromStdString(filename));
 }
 
@@ -38,6 +38,7 @@
 
 class CMapField;
 class CUniqueItem;
+class QCryptographicHash;
 struct lua_State;
 
 int CclDefineMapTemplate(lua_State *l);
@@ -46,6 +47,7 @@ namespace stratagus {
 
 class character;
 class faction;
+class geodata_plane;
 class historical_location;
 class historical_unit;
 class plane;
@@ -577,8 +579,13 @@ public:
 		return QGeoRectangle(QGeoCoordinate(this->get_max_latitude(), this->get_min_longitude()), QGeoCoordinate(this->get_min_latitude(), this->get_max_longitude()));
 	}
 
-	void save_terrain_image(const std::string &filename, const bool overlay, const terrain_geodata_map &terrain_data) const;
-	void save_territory_image(const std::string &filename, const std::map<const site *, std::vector<std::unique_ptr<QGeoShape>>> &territory_data) const;
+	std::filesystem::path get_geodata_cache_filepath(const std::string &plane_name) const;
+	void add_geodata_cache_key_data(QCryptographicHash &hash) const;
+	QByteArray get_terrain_geodata_cache_key(const bool overlay) const;
+	geodata_plane get_terrain_geodata_plane(const bool overlay, std::unique_ptr<terrain_geodata_map> &terrain_data) const;
+	geodata_plane get_territory_geodata_plane() const;
+	void save_terrain_image(const std::string &filename, const bool overlay, const geodata_plane &terrain_plane) const;
+	void save_territory_image(const std::string &filename, const geodata_plane &territory_plane) const;
 	
 private:
 	std::filesystem::path terrain_file;
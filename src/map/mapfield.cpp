@@ -42,6 +42,7 @@
 #include "script.h"
 #include "unit/unit.h"
 #include "unit/unit_manager.h"
+#include "util/binary_stream.h"
 #include "util/vector_util.h"
 
 CMapField::CMapField() :
@@ -387,7 +388,7 @@ void CMapField::Save(CFile &file) const
 	}
 	//Wyrmgus end
 	for (int i = 0; i != PlayerMax; ++i) {
-		if (playerInfo.Visible[i] == 1) {
+		if (playerInfo.GetVisibilityState(i) == 1) {
 			file.printf(", \"explored\", %d", i);
 		}
 	}
@@ -514,27 +515,8 @@ void CMapField::parse(lua_State *l)
 	this->Value = LuaToNumber(l, -1, 3);
 	this->cost = LuaToNumber(l, -1, 4);
 	*/
-	std::string terrain_ident = LuaToString(l, -1, 1);
-	if (!terrain_ident.empty()) {
-		const stratagus::terrain_feature *terrain_feature = stratagus::terrain_feature::try_get(terrain_ident);
-		if (terrain_feature != nullptr) {
-			this->Terrain = terrain_feature->get_terrain_type();
-			this->terrain_feature = terrain_feature;
-		} else {
-			this->Terrain = stratagus::terrain_type::get(terrain_ident);
-		}
-	}
-	
-	std::string overlay_terrain_ident = LuaToString(l, -1, 2);
-	if (!overlay_terrain_ident.empty()) {
-		const stratagus::terrain_feature *overlay_terrain_feature = stratagus::terrain_feature::try_get(overlay_terrain_ident);
-		if (overlay_terrain_feature != nullptr) {
-			this->OverlayTerrain = overlay_terrain_feature->get_terrain_type();
-			this->terrain_feature = overlay_terrain_feature;
-		} else {
-			this->OverlayTerrain = stratagus::terrain_type::get(overlay_terrain_ident);
-		}
-	}
+	this->load_terrain_identifier(LuaToString(l, -1, 1), false);
+	this->load_terrain_identifier(LuaToString(l, -1, 2), true);
 	
 	this->SetOverlayTerrainDamaged(LuaToBoolean(l, -1, 3));
 	this->SetOverlayTerrainDestroyed(LuaToBoolean(l, -1, 4));
@@ -597,7 +579,7 @@ void CMapField::parse(lua_State *l)
 		} else if (!strcmp(value, "explored")) {
 		//Wyrmgus end
 			++j;
-			this->playerInfo.Visible[LuaToNumber(l, -1, j + 1)] = 1;
+			this->playerInfo.SetExploredBy(LuaToNumber(l, -1, j + 1));
 		} else if (!strcmp(value, "land")) {
 			this->Flags |= MapFieldLandAllowed;
 		} else if (!strcmp(value, "coast")) {
@@ -665,6 +647,284 @@ void CMapField::parse(lua_State *l)
 	}
 }
 
+/**
+**	@brief	Table of the identifiers referenced by the tile planes of a save game, so that each tile only stores a 16-bit index into it
+*/
+class tile_plane_identifier_table final
+{
+public:
+	tile_plane_identifier_table()
+	{
+		this->identifiers.push_back(std::string()); //index 0 is none
+	}
+
+	uint16_t get_index(const std::string &identifier)
+	{
+		if (identifier.empty()) {
+			return 0;
+		}
+
+		const auto find_iterator = this->indexes.find(identifier);
+		if (find_iterator != this->indexes.end()) {
+			return find_iterator->second;
+		}
+
+		if (this->identifiers.size() > UINT16_MAX) {
+			throw std::runtime_error("Too many different identifiers in the map fields to save them as tile planes.");
+		}
+
+		const uint16_t index = static_cast<uint16_t>(this->identifiers.size());
+		this->identifiers.push_back(identifier);
+		this->indexes[identifier] = index;
+		return index;
+	}
+
+	const std::vector<std::string> &get_identifiers() const
+	{
+		return this->identifiers;
+	}
+
+private:
+	std::vector<std::string> identifiers;
+	std::map<std::string, uint16_t> indexes;
+};
+
+/// The field flags stored in save games, i.e. all of them except the speed mask
+static constexpr uint32_t SavedMapFieldFlags = ~static_cast<uint32_t>(MapFieldSpeedMask);
+
+/**
+**	@brief	Save map fields as tile planes, i.e. one array per property with an entry for each field
+**
+**	This stores the same state as CMapField::Save, but in binary form, so that it can be loaded without going through Lua.
+**
+**	@param	fields		The fields to save
+**	@param	field_count	The quantity of fields
+**	@param	writer		The binary writer to save the planes to
+*/
+void CMapField::save_tile_planes(const CMapField *fields, const unsigned int field_count, stratagus::binary_writer &writer)
+{
+	tile_plane_identifier_table identifier_table;
+
+	std::string plane_data;
+	stratagus::binary_writer plane_writer(plane_data);
+
+	for (unsigned int i = 0; i < field_count; ++i) {
+		const CMapField &mf = fields[i];
+		const stratagus::terrain_feature *terrain_feature = mf.get_terrain_feature();
+		const bool overlay_feature = terrain_feature != nullptr && terrain_feature->get_terrain_type()->is_overlay();
+		plane_writer.write<uint16_t>(identifier_table.get_index((terrain_feature != nullptr && !overlay_feature) ? terrain_feature->get_identifier() : (mf.Terrain ? mf.Terrain->Ident : std::string())));
+	}
+	for (unsigned int i = 0; i < field_count; ++i) {
+		const CMapField &mf = fields[i];
+		const stratagus::terrain_feature *terrain_feature = mf.get_terrain_feature();
+		const bool overlay_feature = terrain_feature != nullptr && terrain_feature->get_terrain_type()->is_overlay();
+		plane_writer.write<uint16_t>(identifier_table.get_index(overlay_feature ? terrain_feature->get_identifier() : (mf.OverlayTerrain ? mf.OverlayTerrain->Ident : std::string())));
+	}
+	for (unsigned int i = 0; i < field_count; ++i) {
+		const CMapField &mf = fields[i];
+		plane_writer.write<uint16_t>(identifier_table.get_index(mf.playerInfo.SeenTerrain ? mf.playerInfo.SeenTerrain->Ident : std::string()));
+	}
+	for (unsigned int i = 0; i < field_count; ++i) {
+		const CMapField &mf = fields[i];
+		plane_writer.write<uint16_t>(identifier_table.get_index(mf.playerInfo.SeenOverlayTerrain ? mf.playerInfo.SeenOverlayTerrain->Ident : std::string()));
+	}
+	for (unsigned int i = 0; i < field_count; ++i) {
+		const CMapField &mf = fields[i];
+		plane_writer.write<uint16_t>(identifier_table.get_index(mf.get_settlement() != nullptr ? mf.get_settlement()->get_identifier() : std::string()));
+	}
+	for (unsigned int i = 0; i < field_count; ++i) {
+		const CMapField &mf = fields[i];
+		plane_writer.write<uint8_t>((mf.OverlayTerrainDamaged ? 1 : 0) | (mf.OverlayTerrainDestroyed ? 2 : 0));
+	}
+	for (unsigned int i = 0; i < field_count; ++i) {
+		plane_writer.write<int16_t>(fields[i].SolidTile);
+	}
+	for (unsigned int i = 0; i < field_count; ++i) {
+		plane_writer.write<int16_t>(fields[i].OverlaySolidTile);
+	}
+	for (unsigned int i = 0; i < field_count; ++i) {
+		plane_writer.write<int16_t>(fields[i].playerInfo.SeenSolidTile);
+	}
+	for (unsigned int i = 0; i < field_count; ++i) {
+		plane_writer.write<int16_t>(fields[i].playerInfo.SeenOverlaySolidTile);
+	}
+	for (unsigned int i = 0; i < field_count; ++i) {
+		plane_writer.write<int16_t>(fields[i].Value);
+	}
+	for (unsigned int i = 0; i < field_count; ++i) {
+		plane_writer.write<uint8_t>(fields[i].cost);
+	}
+	for (unsigned int i = 0; i < field_count; ++i) {
+		plane_writer.write<int32_t>(fields[i].Landmass);
+	}
+	for (unsigned int i = 0; i < field_count; ++i) {
+		plane_writer.write<uint32_t>(static_cast<uint32_t>(fields[i].Flags) & SavedMapFieldFlags);
+	}
+	for (unsigned int i = 0; i < field_count; ++i) {
+		plane_writer.write<uint32_t>(fields[i].playerInfo.ExploredPlayers);
+	}
+
+	//the transition tiles are variable-length, so they are stored as a plane of their counts, followed by all of their entries
+	const auto for_each_transition_list = [&fields, field_count](const std::function<void(const std::vector<std::pair<stratagus::terrain_type *, short>> &)> &function) {
+		for (unsigned int i = 0; i < field_count; ++i) {
+			function(fields[i].TransitionTiles);
+			function(fields[i].OverlayTransitionTiles);
+			function(fields[i].playerInfo.SeenTransitionTiles);
+			function(fields[i].playerInfo.SeenOverlayTransitionTiles);
+		}
+	};
+
+	for_each_transition_list([&plane_writer](const std::vector<std::pair<stratagus::terrain_type *, short>> &transition_tiles) {
+		if (transition_tiles.size() > UINT8_MAX) {
+			throw std::runtime_error("Too many transition tiles in a map field to save them as tile planes.");
+		}
+
+		plane_writer.write<uint8_t>(static_cast<uint8_t>(transition_tiles.size()));
+	});
+	for_each_transition_list([&plane_writer, &identifier_table](const std::vector<std::pair<stratagus::terrain_type *, short>> &transition_tiles) {
+		for (const auto &transition_tile : transition_tiles) {
+			plane_writer.write<uint16_t>(identifier_table.get_index(transition_tile.first->Ident));
+			plane_writer.write<int16_t>(transition_tile.second);
+		}
+	});
+
+	//the identifier table is written before the planes, as it is needed to read them
+	writer.write<uint32_t>(field_count);
+	writer.write<uint32_t>(static_cast<uint32_t>(identifier_table.get_identifiers().size()));
+	for (const std::string &identifier : identifier_table.get_identifiers()) {
+		writer.write_string(identifier);
+	}
+	writer.write_bytes(plane_data.data(), plane_data.size());
+}
+
+/**
+**	@brief	Load map fields from tile planes saved by save_tile_planes
+**
+**	@param	fields		The fields to load, which must have been cleared beforehand as for CMapField::parse
+**	@param	field_count	The quantity of fields
+**	@param	reader		The binary reader to load the planes from
+*/
+void CMapField::load_tile_planes(CMapField *fields, const unsigned int field_count, stratagus::binary_reader &reader)
+{
+	const uint32_t saved_field_count = reader.read<uint32_t>();
+	if (saved_field_count != field_count) {
+		throw std::runtime_error("The saved tile planes have " + std::to_string(saved_field_count) + " fields, but the map layer has " + std::to_string(field_count) + ".");
+	}
+
+	std::vector<std::string> identifiers;
+	identifiers.resize(reader.read<uint32_t>());
+	for (std::string &identifier : identifiers) {
+		identifier = reader.read_string();
+	}
+
+	const auto read_identifier = [&reader, &identifiers]() -> const std::string & {
+		const uint16_t index = reader.read<uint16_t>();
+		if (index >= identifiers.size()) {
+			throw std::runtime_error("Invalid identifier index in the saved tile planes: " + std::to_string(index) + ".");
+		}
+		return identifiers[index];
+	};
+
+	for (unsigned int i = 0; i < field_count; ++i) {
+		fields[i].load_terrain_identifier(read_identifier(), false);
+	}
+	for (unsigned int i = 0; i < field_count; ++i) {
+		fields[i].load_terrain_identifier(read_identifier(), true);
+	}
+	for (unsigned int i = 0; i < field_count; ++i) {
+		const std::string &identifier = read_identifier();
+		if (!identifier.empty()) {
+			fields[i].playerInfo.SeenTerrain = stratagus::terrain_type::get(identifier);
+		}
+	}
+	for (unsigned int i = 0; i < field_count; ++i) {
+		const std::string &identifier = read_identifier();
+		if (!identifier.empty()) {
+			fields[i].playerInfo.SeenOverlayTerrain = stratagus::terrain_type::get(identifier);
+		}
+	}
+	for (unsigned int i = 0; i < field_count; ++i) {
+		const std::string &identifier = read_identifier();
+		if (!identifier.empty()) {
+			fields[i].settlement = stratagus::site::get(identifier);
+		}
+	}
+	for (unsigned int i = 0; i < field_count; ++i) {
+		const uint8_t overlay_state = reader.read<uint8_t>();
+		fields[i].SetOverlayTerrainDamaged((overlay_state & 1) != 0);
+		fields[i].SetOverlayTerrainDestroyed((overlay_state & 2) != 0);
+	}
+	for (unsigned int i = 0; i < field_count; ++i) {
+		fields[i].SolidTile = reader.read<int16_t>();
+	}
+	for (unsigned int i = 0; i < field_count; ++i) {
+		fields[i].OverlaySolidTile = reader.read<int16_t>();
+	}
+	for (unsigned int i = 0; i < field_count; ++i) {
+		fields[i].playerInfo.SeenSolidTile = reader.read<int16_t>();
+	}
+	for (unsigned int i = 0; i < field_count; ++i) {
+		fields[i].playerInfo.SeenOverlaySolidTile = reader.read<int16_t>();
+	}
+	for (unsigned int i = 0; i < field_count; ++i) {
+		fields[i].Value = reader.read<int16_t>();
+	}
+	for (unsigned int i = 0; i < field_count; ++i) {
+		fields[i].cost = reader.read<uint8_t>();
+	}
+	for (unsigned int i = 0; i < field_count; ++i) {
+		fields[i].Landmass = reader.read<int32_t>();
+	}
+	for (unsigned int i = 0; i < field_count; ++i) {
+		fields[i].Flags |= reader.read<uint32_t>() & SavedMapFieldFlags;
+	}
+	for (unsigned int i = 0; i < field_count; ++i) {
+		fields[i].playerInfo.ExploredPlayers = reader.read<uint32_t>();
+	}
+
+	std::vector<uint8_t> transition_tile_counts;
+	transition_tile_counts.reserve(field_count * 4);
+	for (unsigned int i = 0; i < field_count * 4; ++i) {
+		transition_tile_counts.push_back(reader.read<uint8_t>());
+	}
+
+	size_t count_index = 0;
+	for (unsigned int i = 0; i < field_count; ++i) {
+		CMapField &mf = fields[i];
+		for (std::vector<std::pair<stratagus::terrain_type *, short>> *transition_tiles : { &mf.TransitionTiles, &mf.OverlayTransitionTiles, &mf.playerInfo.SeenTransitionTiles, &mf.playerInfo.SeenOverlayTransitionTiles }) {
+			const uint8_t transition_tile_count = transition_tile_counts[count_index++];
+			for (uint8_t j = 0; j < transition_tile_count; ++j) {
+				stratagus::terrain_type *terrain = stratagus::terrain_type::get(read_identifier());
+				const short tile_number = reader.read<int16_t>();
+				transition_tiles->push_back(std::pair<stratagus::terrain_type *, int>(terrain, tile_number));
+			}
+		}
+	}
+}
+
+/**
+**	@brief	Set the terrain or overlay terrain of the field from a saved identifier, which may be that of a terrain feature
+**
+**	@param	identifier	The identifier of the terrain type or terrain feature; nothing is set if it is empty
+**	@param	overlay		Whether the identifier is for the overlay terrain
+*/
+void CMapField::load_terrain_identifier(const std::string &identifier, const bool overlay)
+{
+	if (identifier.empty()) {
+		return;
+	}
+
+	stratagus::terrain_type *&terrain = overlay ? this->OverlayTerrain : this->Terrain;
+
+	const stratagus::terrain_feature *terrain_feature = stratagus::terrain_feature::try_get(identifier);
+	if (terrain_feature != nullptr) {
+		terrain = terrain_feature->get_terrain_type();
+		this->terrain_feature = terrain_feature;
+	} else {
+		terrain = stratagus::terrain_type::get(identifier);
+	}
+}
+
 /// Check if a field flags.
 bool CMapField::CheckMask(int mask) const
 {
@@ -757,60 +1017,36 @@ CPlayer *CMapField::get_realm_owner() const
 
 unsigned char CMapFieldPlayerInfo::TeamVisibilityState(const CPlayer &player) const
 {
-	if (IsVisible(player)) {
-		return 2;
-	}
-
-	unsigned char maxVision = 0;
-
-	if (IsExplored(player)) {
-		maxVision = 1;
-	}
-
-	for (int i : player.get_shared_vision()) {
-		if (player.has_mutual_shared_vision_with(*CPlayer::Players[i])) {
-			maxVision = std::max<unsigned char>(maxVision, Visible[i]);
-			if (maxVision >= 2) {
-				return 2;
-			}
-		}
-	}
-
-	for (const CPlayer *other_player : CPlayer::get_revealed_players()) {
-		const int other_player_index = other_player->Index;
-		if (Visible[other_player_index] < 2) { //don't show a revealed player's explored tiles, only the currently visible ones
-			continue;
-		}
+	const uint32_t team_mask = (1u << player.Index) | player.get_mutual_shared_vision_mask();
 
-		maxVision = std::max<unsigned char>(maxVision, Visible[other_player_index]);
-		if (maxVision >= 2) {
-			return 2;
-		}
+	//revealed players only show the tiles they currently see, not the ones they explored
+	if (VisiblePlayers & (team_mask | CPlayer::get_revealed_player_mask())) {
+		return 2;
 	}
 
-	if (maxVision == 1 && CMap::Map.NoFogOfWar) {
-		return 2;
+	if (ExploredPlayers & team_mask) {
+		return CMap::Map.NoFogOfWar ? 2 : 1;
 	}
 
-	return maxVision;
+	return 0;
 }
 
 bool CMapFieldPlayerInfo::IsExplored(const CPlayer &player) const
 {
-	return Visible[player.Index] != 0;
+	return IsExploredBy(player.Index);
 }
 
 //Wyrmgus start
 bool CMapFieldPlayerInfo::IsTeamExplored(const CPlayer &player) const
 {
-	return Visible[player.Index] != 0 || TeamVisibilityState(player) != 0;
+	return IsExploredBy(player.Index) || TeamVisibilityState(player) != 0;
 }
 //Wyrmgus end
 
 bool CMapFieldPlayerInfo::IsVisible(const CPlayer &player) const
 {
 	const bool fogOfWar = !CMap::Map.NoFogOfWar;
-	return Visible[player.Index] >= 2 || (!fogOfWar && IsExplored(player));
+	return (VisiblePlayers & (1u << player.Index)) != 0 || (!fogOfWar && IsExplored(player));
 }
 
 bool CMapFieldPlayerInfo::IsTeamVisible(const CPlayer &player) const
@@ -113,6 +113,12 @@ void minimap::Create()
 {
 	this->terrain_textures.resize(CMap::Map.MapLayers.size());
 	this->overlay_textures.resize(CMap::Map.MapLayers.size());
+	this->terrain_upload_rects.resize(CMap::Map.MapLayers.size());
+	this->overlay_upload_rects.resize(CMap::Map.MapLayers.size());
+	this->dirty_tiles.resize(CMap::Map.MapLayers.size());
+	this->dirty_tile_rects.resize(CMap::Map.MapLayers.size());
+	this->unit_dots.resize(CMap::Map.MapLayers.size());
+	this->overlay_states.resize(CMap::Map.MapLayers.size());
 	MinimapTextureWidth.resize(CMap::Map.MapLayers.size());
 	MinimapTextureHeight.resize(CMap::Map.MapLayers.size());
 
@@ -183,8 +189,13 @@ void minimap::Create()
 
 		this->UpdateTerrain(z);
 		this->update_territories(z);
+
+		this->overlay_states[z] = this->get_overlay_state();
+		this->dirty_tiles[z].resize(CMap::Map.Info.MapWidths[z] * CMap::Map.Info.MapHeights[z]);
 	}
 
+	this->update_all_seen();
+
 	NumMinimapEvents = 0;
 }
 
@@ -245,6 +256,8 @@ void minimap::UpdateTerrain(int z)
 			*(uint32_t *) &(this->terrain_texture_data[z][(mx + my * MinimapTextureWidth[z]) * 4]) = c;
 		}
 	}
+
+	this->terrain_upload_rects[z] = QRect(0, 0, MinimapTextureWidth[z], MinimapTextureHeight[z]);
 }
 
 void minimap::update_territories(const int z)
@@ -271,84 +284,67 @@ void minimap::UpdateXY(const Vec2i &pos, int z)
 		return;
 	}
 
-	int scalex = MinimapScaleX[z] * SCALE_PRECISION / MINIMAP_FAC;
-	if (scalex == 0) {
-		scalex = 1;
-	}
-	int scaley = MinimapScaleY[z] * SCALE_PRECISION / MINIMAP_FAC;
-	if (scaley == 0) {
-		scaley = 1;
-	}
-
 	const season *season = CMap::Map.MapLayers[z]->GetSeason();
 
-	const int ty = pos.y * CMap::Map.Info.MapWidths[z];
-	const int tx = pos.x;
+	const CMapField &mf = *CMap::Map.MapLayers[z]->Field(pos);
+	const terrain_type *terrain = mf.GetTopTerrain(true);
 
-	const int texture_width = this->get_texture_width(z);
-	const int texture_height = this->get_texture_height(z);
+	const QColor color = terrain ? terrain->get_minimap_color(season) : QColor(0, 0, 0);
+	const uint32_t c = Video.MapRGB(0, color.red(), color.green(), color.blue());
 
-	for (int my = YOffset[z]; my < texture_height - YOffset[z]; ++my) {
-		const int y = Minimap2MapY[z][my];
-		if (y < ty) {
-			continue;
-		}
-		if (y > ty) {
-			break;
+	const QRect texture_rect = this->get_tile_texture_rect(pos, z);
+	for (int my = texture_rect.top(); my <= texture_rect.bottom(); ++my) {
+		for (int mx = texture_rect.left(); mx <= texture_rect.right(); ++mx) {
+			*(uint32_t *) &(this->terrain_texture_data[z][(mx + my * MinimapTextureWidth[z]) * 4]) = c;
 		}
+	}
 
-		for (int mx = XOffset[z]; mx < texture_width - XOffset[z]; ++mx) {
-			const int x = Minimap2MapX[z][mx];
+	this->terrain_upload_rects[z] |= texture_rect;
+}
 
-			if (x < tx) {
-				continue;
-			}
-			if (x > tx) {
-				break;
-			}
+/**
+**	@brief	Mark a tile's overlay pixels to be redrawn in the next minimap update, after its visibility has changed
+**
+**	@param	pos	The map position of the tile
+**	@param	z	The map layer of the tile
+*/
+void minimap::UpdateSeenXY(const Vec2i &pos, const int z)
+{
+	if (z >= static_cast<int>(this->dirty_tiles.size())) {
+		return;
+	}
 
-			const CMapField &mf = *CMap::Map.MapLayers[z]->Field(x + y);
-			const terrain_type *terrain = mf.GetTopTerrain(true);
+	const int index = pos.x + pos.y * CMap::Map.Info.MapWidths[z];
+	if (this->dirty_tiles[z][index]) {
+		return;
+	}
 
-			const QColor color = terrain ? terrain->get_minimap_color(season) : QColor(0, 0, 0);
+	this->dirty_tiles[z][index] = true;
+	this->dirty_tile_rects[z] |= QRect(pos, QSize(1, 1));
+}
 
-			const uint32_t c = Video.MapRGB(0, color.red(), color.green(), color.blue());
-			*(uint32_t *) &(this->terrain_texture_data[z][(mx + my * MinimapTextureWidth[z]) * 4]) = c;
-		}
+/**
+**	@brief	Mark the overlay pixels of all tiles to be redrawn in the next minimap update
+*/
+void minimap::update_all_seen()
+{
+	for (size_t z = 0; z < this->dirty_tiles.size(); ++z) {
+		std::fill(this->dirty_tiles[z].begin(), this->dirty_tiles[z].end(), true);
+		this->dirty_tile_rects[z] = QRect(0, 0, CMap::Map.Info.MapWidths[z], CMap::Map.Info.MapHeights[z]);
 	}
 }
 
 void minimap::update_territory_xy(const QPoint &pos, const int z)
 {
-	const int texture_width = this->get_texture_width(z);
-	const int texture_height = this->get_texture_height(z);
-
-	const int ty = pos.y() * CMap::Map.Info.MapWidths[z];
-	const int tx = pos.x();
-	const int non_land_territory_alpha = defines::get()->get_minimap_non_land_territory_alpha();
-
-	for (int my = YOffset[z]; my < texture_height - YOffset[z]; ++my) {
-		const int y = Minimap2MapY[z][my];
-		if (y < ty) {
-			continue;
-		}
-		if (y > ty) {
-			break;
-		}
-
-		for (int mx = XOffset[z]; mx < texture_width - XOffset[z]; ++mx) {
-			const int x = Minimap2MapX[z][mx];
-
-			if (x < tx) {
-				continue;
-			}
-			if (x > tx) {
-				break;
-			}
-
+	const QRect texture_rect = this->get_tile_texture_rect(pos, z);
+	for (int my = texture_rect.top(); my <= texture_rect.bottom(); ++my) {
+		for (int mx = texture_rect.left(); mx <= texture_rect.right(); ++mx) {
 			this->update_territory_pixel(mx, my, z);
 		}
 	}
+
+	//the overlay shows the territory of the tile in territory modes
+	this->UpdateSeenXY(pos, z);
 }
 
 void minimap::update_territory_pixel(const int mx, const int my, const int z)
@@ -428,9 +424,14 @@ void minimap::update_territory_pixel(const int mx, const int my, const int z)
 }
 
 /**
-**  Draw a unit on the minimap.
+**	@brief	Get the dot with which a unit is drawn on the minimap
+**
+**	@param	unit		The unit
+**	@param	red_phase	Whether attacked units should be shown red in this update
+**
+**	@return	The unit's dot, or nothing if the unit isn't drawn on the minimap
 */
-void minimap::DrawUnitOn(CUnit &unit, int red_phase)
+std::optional<minimap::unit_dot> minimap::get_unit_dot(const CUnit &unit, const int red_phase) const
 {
 	const int z = UI.CurrentMapLayer->ID;
 	const int texture_width = this->get_texture_width(z);
@@ -451,99 +452,195 @@ void minimap::DrawUnitOn(CUnit &unit, int red_phase)
 
 	//don't draw decorations or diminutive fauna units on the minimap
 	if (type->BoolFlag[DECORATION_INDEX].value || (type->BoolFlag[DIMINUTIVE_INDEX].value && type->BoolFlag[FAUNA_INDEX].value)) {
-		return;
+		return std::nullopt;
 	}
 
-	uint32_t color;
+	unit_dot dot;
 	if (unit.GetDisplayPlayer() == PlayerNumNeutral) {
-		color = Video.MapRGB(TheScreen->format, type->NeutralMinimapColorRGB);
+		dot.color = Video.MapRGB(TheScreen->format, type->NeutralMinimapColorRGB);
 	} else if (unit.Player == CPlayer::GetThisPlayer() && !Editor.Running) {
 		if (unit.Attacked && unit.Attacked + ATTACK_BLINK_DURATION > GameCycle &&
 			(red_phase || unit.Attacked + ATTACK_RED_DURATION > GameCycle)) {
-			color = ColorRed;
+			dot.color = ColorRed;
 		} else if (UI.Minimap.ShowSelected && unit.Selected) {
-			color = ColorWhite;
+			dot.color = ColorWhite;
 		} else {
-			color = ColorGreen;
+			dot.color = ColorGreen;
 		}
 	} else {
-		color = Video.MapRGB(TheScreen->format, unit.Player->get_minimap_color());
+		dot.color = Video.MapRGB(TheScreen->format, unit.Player->get_minimap_color());
 	}
 
-	int mx = 1 + UI.Minimap.XOffset[z] + Map2MinimapX[z][unit.tilePos.x];
-	int my = 1 + UI.Minimap.YOffset[z] + Map2MinimapY[z][unit.tilePos.y];
-	int w = Map2MinimapX[z][type->get_tile_width()];
+	const int mx = 1 + UI.Minimap.XOffset[z] + Map2MinimapX[z][unit.tilePos.x];
+	const int my = 1 + UI.Minimap.YOffset[z] + Map2MinimapY[z][unit.tilePos.y];
+	const int w = Map2MinimapX[z][type->get_tile_width()];
+	const int h = Map2MinimapY[z][type->get_tile_height()];
 
-	if (mx + w >= texture_width) { // clip right side
-		w = texture_width - mx;
+	//the dot starts one pixel before the unit's minimap position, as the unit's position is offset by one pixel above; clip it to the texture
+	dot.rect = QRect(mx - 1, my - 1, w + 1, h + 1) & QRect(0, 0, texture_width, texture_height);
+	if (dot.rect.isEmpty()) {
+		return std::nullopt;
 	}
 
-	int h0 = Map2MinimapY[z][type->get_tile_height()];
-	if (my + h0 >= texture_height) { // clip bottom side
-		h0 = texture_height - my;
-	}
+	return dot;
+}
 
-	while (w-- >= 0) {
-		int h = h0;
-		while (h-- >= 0) {
-			*(uint32_t *) &(this->overlay_texture_data[z][((mx + w) + (my + h) * MinimapTextureWidth[z]) * 4]) = color;
+void minimap::draw_unit_dot(const unit_dot &dot, const int z)
+{
+	for (int my = dot.rect.top(); my <= dot.rect.bottom(); ++my) {
+		for (int mx = dot.rect.left(); mx <= dot.rect.right(); ++mx) {
+			*(uint32_t *) &(this->overlay_texture_data[z][(mx + my * MinimapTextureWidth[z]) * 4]) = dot.color;
 		}
 	}
 }
 
+minimap::overlay_state minimap::get_overlay_state() const
+{
+	const CPlayer *this_player = CPlayer::GetThisPlayer();
+
+	overlay_state state;
+	state.mode = this->get_mode();
+	if (this_player != nullptr) {
+		state.team_mask = (1u << this_player->Index) | this_player->get_mutual_shared_vision_mask();
+	}
+	state.revealed_player_mask = CPlayer::get_revealed_player_mask();
+	state.reveal_map = ReplayRevealMap;
+	state.no_fog_of_war = CMap::Map.NoFogOfWar;
+	state.transparent = this->Transparent;
+	return state;
+}
+
 /**
-**  Update the minimap with the current game information
+**	@brief	Get the overlay texture rectangle showing a tile
+**
+**	@param	tile_pos	The tile's map position
+**	@param	z			The map layer of the tile
+**
+**	@return	The texture rectangle whose pixels are mapped to the tile
 */
-void minimap::Update()
+QRect minimap::get_tile_texture_rect(const QPoint &tile_pos, const int z) const
 {
-	static int red_phase;
+	const int texture_width = this->get_texture_width(z);
+	const int texture_height = this->get_texture_height(z);
 
-	int red_phase_changed = red_phase != (int)((FrameCounter / FRAMES_PER_SECOND) & 1);
-	if (red_phase_changed) {
-		red_phase = !red_phase;
+	//the first pixel mapped to a tile is the first one whose scaled position is not less than the tile's
+	int start_x = XOffset[z] + (tile_pos.x() * MinimapScaleX[z] + MINIMAP_FAC - 1) / MINIMAP_FAC;
+	int start_y = YOffset[z] + (tile_pos.y() * MinimapScaleY[z] + MINIMAP_FAC - 1) / MINIMAP_FAC;
+	int end_x = XOffset[z] + ((tile_pos.x() + 1) * MinimapScaleX[z] + MINIMAP_FAC - 1) / MINIMAP_FAC;
+	int end_y = YOffset[z] + ((tile_pos.y() + 1) * MinimapScaleY[z] + MINIMAP_FAC - 1) / MINIMAP_FAC;
+
+	//the pixels left over within the map area after the last row or column are mapped to it
+	if (tile_pos.x() == CMap::Map.Info.MapWidths[z] - 1) {
+		end_x = texture_width - XOffset[z];
+	}
+	if (tile_pos.y() == CMap::Map.Info.MapHeights[z] - 1) {
+		end_y = texture_height - YOffset[z];
 	}
 
-	const int z = UI.CurrentMapLayer->ID;
+	start_x = std::max(start_x, XOffset[z]);
+	start_y = std::max(start_y, YOffset[z]);
+	end_x = std::min(end_x, texture_width - XOffset[z]);
+	end_y = std::min(end_y, texture_height - YOffset[z]);
 
-	// Clear Minimap background if not transparent
-	if (!Transparent) {
-		memset(this->overlay_texture_data[z], 0, MinimapTextureWidth[z] * MinimapTextureHeight[z] * 4);
+	return QRect(start_x, start_y, end_x - start_x, end_y - start_y);
+}
+
+/**
+**	@brief	Redraw the overlay pixels of the tiles which were marked as dirty
+**
+**	@param	z	The map layer
+**
+**	@return	The bounding rectangle of the redrawn texture pixels
+*/
+QRect minimap::update_dirty_tiles(const int z)
+{
+	QRect &dirty_tile_rect = this->dirty_tile_rects[z];
+	if (dirty_tile_rect.isNull()) {
+		return QRect();
 	}
 
-	if (minimap_mode_has_overlay(this->get_mode())) {
-		memcpy(this->overlay_texture_data[z], this->mode_overlay_texture_data[this->get_mode()][z], MinimapTextureWidth[z] * MinimapTextureHeight[z] * 4);
+	std::vector<bool> &dirty_tiles = this->dirty_tiles[z];
+	const int map_width = CMap::Map.Info.MapWidths[z];
+	QRect updated_rect;
+
+	if (dirty_tile_rect == QRect(0, 0, map_width, CMap::Map.Info.MapHeights[z])) {
+		//the whole map is dirty, so redraw the whole texture, including its border
+		updated_rect = QRect(0, 0, this->get_texture_width(z), this->get_texture_height(z));
+		this->update_overlay_rect(updated_rect, z);
+		std::fill(dirty_tiles.begin(), dirty_tiles.end(), false);
+	} else {
+		for (int y = dirty_tile_rect.top(); y <= dirty_tile_rect.bottom(); ++y) {
+			for (int x = dirty_tile_rect.left(); x <= dirty_tile_rect.right(); ++x) {
+				const int index = x + y * map_width;
+				if (!dirty_tiles[index]) {
+					continue;
+				}
+
+				dirty_tiles[index] = false;
+
+				const QRect texture_rect = this->get_tile_texture_rect(QPoint(x, y), z);
+				this->update_overlay_rect(texture_rect, z);
+				updated_rect |= texture_rect;
+			}
+		}
 	}
 
+	dirty_tile_rect = QRect();
+
+	return updated_rect;
+}
+
+/**
+**	@brief	Redraw the overlay pixels in a texture rectangle, without units
+**
+**	@param	rect	The texture rectangle
+**	@param	z		The map layer
+*/
+void minimap::update_overlay_rect(const QRect &rect, const int z)
+{
 	const int texture_width = this->get_texture_width(z);
 	const int texture_height = this->get_texture_height(z);
 
+	const unsigned char *mode_overlay_data = nullptr;
+	if (minimap_mode_has_overlay(this->get_mode())) {
+		mode_overlay_data = this->mode_overlay_texture_data[this->get_mode()][z];
+	}
+
 	const uint32_t unexplored_color = Video.MapRGB(nullptr, 0, 0, 0);
 	const uint32_t explored_color = Video.MapRGBA(nullptr, 0, 0, 0, 128); //explored but not visible
-	for (int my = 0; my < texture_height; ++my) {
-		for (int mx = 0; mx < texture_width; ++mx) {
+	for (int my = rect.top(); my <= rect.bottom(); ++my) {
+		for (int mx = rect.left(); mx <= rect.right(); ++mx) {
+			const int pixel_index = (mx + my * MinimapTextureWidth[z]) * 4;
+			uint32_t &c = *(uint32_t *) &(this->overlay_texture_data[z][pixel_index]);
+
 			if (mx < XOffset[z] || mx >= texture_width - XOffset[z] || my < YOffset[z] || my >= texture_height - YOffset[z]) {
-				*(uint32_t *) &(this->overlay_texture_data[z][(mx + my * MinimapTextureWidth[z]) * 4]) = Video.MapRGB(nullptr, 0, 0, 0);
+				c = unexplored_color;
 				continue;
 			}
-			
+
+			if (mode_overlay_data != nullptr) {
+				c = *(const uint32_t *) &(mode_overlay_data[pixel_index]);
+			} else if (!this->Transparent) {
+				// Clear Minimap background if not transparent
+				c = 0;
+			}
+
 			int visiontype; // 0 unexplored, 1 explored, >1 visible.
 
 			if (ReplayRevealMap) {
 				visiontype = 2;
 			} else {
-				const Vec2i tilePos(Minimap2MapX[z][mx], Minimap2MapY[z][my] / UI.CurrentMapLayer->get_width());
-				visiontype = CMap::Map.Field(tilePos, z)->playerInfo.TeamVisibilityState(*CPlayer::GetThisPlayer());
+				visiontype = CMap::Map.Field(Minimap2MapX[z][mx] + Minimap2MapY[z][my], z)->playerInfo.TeamVisibilityState(*CPlayer::GetThisPlayer());
 			}
 
 			switch (visiontype) {
 				case 0:
-					*(uint32_t *) &(this->overlay_texture_data[z][(mx + my * MinimapTextureWidth[z]) * 4]) = unexplored_color;
+					c = unexplored_color;
 					break;
 				case 1:
 					if (this->is_fog_of_war_visible()) {
-						uint32_t *c = (uint32_t *) &(this->overlay_texture_data[z][(mx + my * MinimapTextureWidth[z]) * 4]);
-						if (*c == 0) {
-							*c = explored_color;
+						if (c == 0) {
+							c = explored_color;
 						}
 					}
 					break;
@@ -552,16 +649,75 @@ void minimap::Update()
 			}
 		}
 	}
+}
+
+/**
+**  Update the minimap with the current game information
+**
+**	Only the pixels of tiles marked as dirty and of unit dots which changed since the last update are redrawn.
+*/
+void minimap::Update()
+{
+	static int red_phase;
+
+	int red_phase_changed = red_phase != (int)((FrameCounter / FRAMES_PER_SECOND) & 1);
+	if (red_phase_changed) {
+		red_phase = !red_phase;
+	}
+
+	const int z = UI.CurrentMapLayer->ID;
+
+	const overlay_state state = this->get_overlay_state();
+	if (state != this->overlay_states[z]) {
+		this->overlay_states[z] = state;
+		std::fill(this->dirty_tiles[z].begin(), this->dirty_tiles[z].end(), true);
+		this->dirty_tile_rects[z] = QRect(0, 0, CMap::Map.Info.MapWidths[z], CMap::Map.Info.MapHeights[z]);
+	}
+
+	std::vector<unit_dot> unit_dots;
 
 	if (this->are_units_visible()) {
-		//draw units on the map
+		//the dots of all units are computed each update, which is linear in the quantity of units; only the redrawing and uploading of the texture is limited to what changed
 		for (CUnitManager::Iterator it = UnitManager.begin(); it != UnitManager.end(); ++it) {
-			CUnit &unit = **it;
-			if (unit.IsVisibleOnMinimap()) {
-				this->DrawUnitOn(unit, red_phase);
+			const CUnit &unit = **it;
+			if (!unit.IsVisibleOnMinimap()) {
+				continue;
+			}
+
+			const std::optional<unit_dot> dot = this->get_unit_dot(unit, red_phase);
+			if (dot.has_value()) {
+				unit_dots.push_back(dot.value());
 			}
 		}
+
+		std::sort(unit_dots.begin(), unit_dots.end());
+	}
+
+	const std::vector<unit_dot> &old_unit_dots = this->unit_dots[z];
+
+	QRect updated_rect = this->update_dirty_tiles(z);
+
+	//redraw the background of the dots which are gone, or which have changed color
+	std::vector<unit_dot> removed_unit_dots;
+	std::set_difference(old_unit_dots.begin(), old_unit_dots.end(), unit_dots.begin(), unit_dots.end(), std::back_inserter(removed_unit_dots));
+	for (const unit_dot &dot : removed_unit_dots) {
+		this->update_overlay_rect(dot.rect, z);
+		updated_rect |= dot.rect;
 	}
+
+	//draw the dots which are new, or whose pixels may have been overwritten by the redrawing
+	QRect upload_rect = updated_rect;
+	for (const unit_dot &dot : unit_dots) {
+		if (!dot.rect.intersects(updated_rect) && std::binary_search(old_unit_dots.begin(), old_unit_dots.end(), dot)) {
+			continue;
+		}
+
+		this->draw_unit_dot(dot, z);
+		upload_rect |= dot.rect;
+	}
+
+	this->overlay_upload_rects[z] |= upload_rect;
+	this->unit_dots[z] = std::move(unit_dots);
 }
 
 /**
@@ -596,22 +752,51 @@ static void DrawEvents()
 /**
 **  Draw the minimap on the screen
 */
-void minimap::Draw() const
+void minimap::Draw()
 {
 	const int z = UI.CurrentMapLayer->ID;
 
 	if (this->is_terrain_visible()) {
-		this->draw_texture(this->terrain_textures[z], this->terrain_texture_data[z], z);
+		this->upload_texture_rect(this->terrain_textures[z], this->terrain_texture_data[z], this->terrain_upload_rects[z], z);
+		this->draw_texture(this->terrain_textures[z], z);
 	}
 
-	this->draw_texture(this->overlay_textures[z], this->overlay_texture_data[z], z);
+	this->upload_texture_rect(this->overlay_textures[z], this->overlay_texture_data[z], this->overlay_upload_rects[z], z);
+	this->draw_texture(this->overlay_textures[z], z);
 	DrawEvents();
 }
 
-void minimap::draw_texture(const GLuint &texture, const unsigned char *texture_data, const int z) const
+/**
+**	@brief	Upload the changed part of a minimap texture's data
+**
+**	@param	texture			The texture
+**	@param	texture_data	The texture's data
+**	@param	rect			The changed texture rectangle, which is reset after uploading it
+**	@param	z				The map layer of the texture
+*/
+void minimap::upload_texture_rect(const GLuint &texture, const unsigned char *texture_data, QRect &rect, const int z)
+{
+	if (rect.isNull()) {
+		return;
+	}
+
+	glBindTexture(GL_TEXTURE_2D, texture);
+
+#ifdef USE_GLES
+	//the row length can't be set for unpacking, so upload whole rows instead
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, rect.y(), MinimapTextureWidth[z], rect.height(), GL_RGBA, GL_UNSIGNED_BYTE, texture_data + rect.y() * MinimapTextureWidth[z] * 4);
+#else
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, MinimapTextureWidth[z]);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, rect.x(), rect.y(), rect.width(), rect.height(), GL_RGBA, GL_UNSIGNED_BYTE, texture_data + (rect.x() + rect.y() * MinimapTextureWidth[z]) * 4);
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+#endif
+
+	rect = QRect();
+}
+
+void minimap::draw_texture(const GLuint &texture, const int z) const
 {
 	glBindTexture(GL_TEXTURE_2D, texture);
-	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, MinimapTextureWidth[z], MinimapTextureHeight[z], GL_RGBA, GL_UNSIGNED_BYTE, texture_data);
 
 #ifdef USE_GLES
 	float texCoord[] = {
@@ -751,6 +936,13 @@ void minimap::Destroy()
 	this->overlay_texture_data.clear();
 	this->overlay_textures.clear();
 
+	this->terrain_upload_rects.clear();
+	this->overlay_upload_rects.clear();
+	this->dirty_tiles.clear();
+	this->dirty_tile_rects.clear();
+	this->unit_dots.clear();
+	this->overlay_states.clear();
+
 	for (size_t z = 0; z < Minimap2MapX.size(); ++z) {
 		delete[] Minimap2MapX[z];
 		Minimap2MapX[z] = nullptr;
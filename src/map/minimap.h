@@ -46,6 +46,55 @@ enum class minimap_mode;
 
 class minimap final
 {
+private:
+	//a unit's dot on the minimap overlay texture
+	struct unit_dot final
+	{
+		QRect rect;
+		uint32_t color = 0;
+
+		bool operator ==(const unit_dot &other) const
+		{
+			return this->rect == other.rect && this->color == other.color;
+		}
+
+		bool operator <(const unit_dot &other) const
+		{
+			if (this->rect.y() != other.rect.y()) {
+				return this->rect.y() < other.rect.y();
+			} else if (this->rect.x() != other.rect.x()) {
+				return this->rect.x() < other.rect.x();
+			} else if (this->rect.width() != other.rect.width()) {
+				return this->rect.width() < other.rect.width();
+			} else if (this->rect.height() != other.rect.height()) {
+				return this->rect.height() < other.rect.height();
+			}
+
+			return this->color < other.color;
+		}
+	};
+
+	//the state which affects every pixel of the overlay, so that a change to it requires redrawing the overlay as a whole
+	struct overlay_state final
+	{
+		minimap_mode mode{};
+		uint32_t team_mask = 0;
+		uint32_t revealed_player_mask = 0;
+		bool reveal_map = false;
+		bool no_fog_of_war = false;
+		bool transparent = false;
+
+		bool operator ==(const overlay_state &other) const
+		{
+			return this->mode == other.mode && this->team_mask == other.team_mask && this->revealed_player_mask == other.revealed_player_mask && this->reveal_map == other.reveal_map && this->no_fog_of_war == other.no_fog_of_war && this->transparent == other.transparent;
+		}
+
+		bool operator !=(const overlay_state &other) const
+		{
+			return !(*this == other);
+		}
+	};
+
 public:
 	minimap();
 
@@ -55,7 +104,8 @@ private:
 
 public:
 	void UpdateXY(const Vec2i &pos, int z);
-	void UpdateSeenXY(const Vec2i &) {}
+	void UpdateSeenXY(const Vec2i &pos, const int z);
+	void update_all_seen();
 	void update_territory_xy(const QPoint &pos, const int z);
 	void update_territory_pixel(const int mx, const int my, const int z);
 	void Update();
@@ -67,10 +117,20 @@ public:
 	void Reload();
 #endif
 	void Destroy();
-	void Draw() const;
-	void draw_texture(const GLuint &texture, const unsigned char *texture_data, const int z) const;
+	void Draw();
+	void upload_texture_rect(const GLuint &texture, const unsigned char *texture_data, QRect &rect, const int z);
+	void draw_texture(const GLuint &texture, const int z) const;
 	void DrawViewportArea(const CViewport &viewport) const;
-	void DrawUnitOn(CUnit &unit, int red_phase);
+
+private:
+	overlay_state get_overlay_state() const;
+	QRect get_tile_texture_rect(const QPoint &tile_pos, const int z) const;
+	QRect update_dirty_tiles(const int z);
+	void update_overlay_rect(const QRect &rect, const int z);
+	std::optional<unit_dot> get_unit_dot(const CUnit &unit, const int red_phase) const;
+	void draw_unit_dot(const unit_dot &dot, const int z);
+
+public:
 	void AddEvent(const Vec2i &pos, int z, IntColor color);
 
 	QPoint texture_to_tile_pos(const QPoint &texture_pos) const;
@@ -157,6 +217,19 @@ private:
 
 	//texture data for the overlay with units and unexplored terrain
 	std::vector<unsigned char *> overlay_texture_data;
+
+	//texture rectangles per map layer which have changed since the textures were last uploaded
+	std::vector<QRect> terrain_upload_rects;
+	std::vector<QRect> overlay_upload_rects;
+
+	//tiles per map layer whose overlay pixels have to be redrawn, together with their bounding rectangle
+	std::vector<std::vector<bool>> dirty_tiles;
+	std::vector<QRect> dirty_tile_rects;
+
+	//the unit dots drawn in the last overlay update, sorted, per map layer
+	std::vector<std::vector<unit_dot>> unit_dots;
+
+	std::vector<overlay_state> overlay_states;
 };
 
 }
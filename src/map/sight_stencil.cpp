@@ -0,0 +1,75 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+//      (c) Copyright 2020 by Andrettin
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+//
+
+#include "stratagus.h"
+
+#include "map/sight_stencil.h"
+
+#include "util/util.h"
+
+namespace stratagus {
+
+/**
+**	@brief	Get the stencil for a sight range and unit tile size, creating it if it doesn't exist yet
+**
+**	Sight is only (un)marked from the main thread, so the cache needs no locking.
+*/
+const sight_stencil &sight_stencil::get(const int range, const int width, const int height)
+{
+	std::unique_ptr<sight_stencil> &stencil = sight_stencil::stencils[std::make_tuple(range, width, height)];
+
+	if (stencil == nullptr) {
+		stencil = std::make_unique<sight_stencil>(range, width, height);
+	}
+
+	return *stencil;
+}
+
+sight_stencil::sight_stencil(const int range, const int width, const int height) : range(range), height(height)
+{
+	this->spans.resize(height + range * 2);
+
+	//the rows above and below the unit narrow down as a circle around its edges
+	for (int distance = 1; distance <= range; ++distance) {
+		const int offset_x = isqrt(square(range + 1) - square(distance) - 1);
+
+		span &upper_span = this->spans[range - distance];
+		upper_span.min_offset_x = -offset_x;
+		upper_span.max_offset_x = width + offset_x;
+
+		this->spans[range + height + distance - 1] = upper_span;
+	}
+
+	//the rows alongside the unit extend by the full range to each side
+	for (int offset_y = 0; offset_y < height; ++offset_y) {
+		span &middle_span = this->spans[range + offset_y];
+		middle_span.min_offset_x = -range;
+		middle_span.max_offset_x = width + range;
+	}
+}
+
+}
@@ -0,0 +1,93 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+//      (c) Copyright 2020 by Andrettin
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+//
+
+#pragma once
+
+namespace stratagus {
+
+/**
+**	@brief	A precomputed sight circle for a given sight range and unit tile size
+**
+**	The circle is stored as one horizontal span per row, relative to the top-left tile of the unit, so that sight can be (un)marked without recomputing the circle's extents for every row.
+*/
+class sight_stencil final
+{
+public:
+	struct span final
+	{
+		int min_offset_x = 0; //inclusive
+		int max_offset_x = 0; //exclusive
+	};
+
+	static const sight_stencil &get(const int range, const int width, const int height);
+
+	explicit sight_stencil(const int range, const int width, const int height);
+
+	int get_range() const
+	{
+		return this->range;
+	}
+
+	int get_min_offset_y() const
+	{
+		return -this->range;
+	}
+
+	int get_max_offset_y() const
+	{
+		return this->height + this->range; //exclusive
+	}
+
+	/**
+	**	@brief	Get the span of tiles for a row
+	**
+	**	@param	offset_y	The row's offset from the unit's top-left tile; must be within [get_min_offset_y(), get_max_offset_y())
+	*/
+	const span &get_span(const int offset_y) const
+	{
+		return this->spans[offset_y + this->range];
+	}
+
+	bool contains(const int offset_x, const int offset_y) const
+	{
+		if (offset_y < this->get_min_offset_y() || offset_y >= this->get_max_offset_y()) {
+			return false;
+		}
+
+		const span &row_span = this->get_span(offset_y);
+		return offset_x >= row_span.min_offset_x && offset_x < row_span.max_offset_x;
+	}
+
+private:
+	int range = 0;
+	int height = 0;
+	std::vector<span> spans;
+
+	static inline std::map<std::tuple<int, int, int>, std::unique_ptr<sight_stencil>> stencils;
+};
+
+}
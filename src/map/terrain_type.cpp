@@ -38,6 +38,7 @@
 #include "time/season.h"
 #include "upgrade/upgrade_structs.h"
 #include "util/container_util.h"
+#include "util/image_util.h"
 #include "util/string_util.h"
 #include "util/vector_util.h"
 #include "video.h"
@@ -467,24 +468,25 @@ void terrain_type::calculate_minimap_color(const season *season)
 	int green = 0;
 	int blue = 0;
 
-	for (int x = 0; x < image.width(); ++x) {
-		for (int y = 0; y < image.height(); ++y) {
-			const QPoint pixel_pos = QPoint(x, y);
-			const QColor pixel_color = image.pixelColor(pixel_pos);
+	//sum each color once, weighted by the quantity of pixels it has
+	const std::map<QRgb, int> rgb_counts = stratagus::image::get_rgb_counts(image);
 
-			if (pixel_color.alpha() != 255) { //transparent pixel, ignore
-				continue;
-			}
+	for (const auto &[rgb, count] : rgb_counts) {
+		QColor pixel_color;
+		pixel_color.setRgba(rgb);
 
-			if (vector::contains(defines::get()->get_conversible_player_color()->get_colors(), pixel_color)) {
-				continue;
-			}
+		if (pixel_color.alpha() != 255) { //transparent pixel, ignore
+			continue;
+		}
 
-			red += pixel_color.red();
-			green += pixel_color.green();
-			blue += pixel_color.blue();
-			pixel_count++;
+		if (vector::contains(defines::get()->get_conversible_player_color()->get_colors(), pixel_color)) {
+			continue;
 		}
+
+		red += pixel_color.red() * count;
+		green += pixel_color.green() * count;
+		blue += pixel_color.blue() * count;
+		pixel_count += count;
 	}
 
 	if (pixel_count == 0) {
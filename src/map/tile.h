@@ -37,23 +37,27 @@
 **    This is the tile number, that the player sitting on the computer
 **    currently knows. Idea: Can be uses for illusions.
 **
-**  CMapFieldPlayerInfo::Visible[]
+**  CMapFieldPlayerInfo::ExploredPlayers
 **
-**    Counter how many units of the player can see this field. 0 the
-**    field is not explored, 1 explored, n-1 unit see it. Currently
-**    no more than 253 units can see a field.
+**    Bit mask of the players who have explored this field.
 **
-**  CMapFieldPlayerInfo::VisCloak[]
+**  CMapFieldPlayerInfo::VisiblePlayers
 **
-**    Visiblity for cloaking.
+**    Bit mask of the players who have at least one unit seeing this
+**    field. How many units of each player see it is counted in the
+**    sight planes of the map layer (see stratagus::visibility_planes).
 **
-**  CMapFieldPlayerInfo::Radar[]
+**  CMapFieldPlayerInfo::CloakDetectingPlayers
 **
-**    Visiblity for radar.
+**    Bit mask of the players who can see cloaked units on this field.
 **
-**  CMapFieldPlayerInfo::RadarJammer[]
+**  CMapFieldPlayerInfo::RadarPlayers
 **
-**    Jamming capabilities.
+**    Bit mask of the players with radar vision of this field.
+**
+**  CMapFieldPlayerInfo::RadarJammingPlayers
+**
+**    Bit mask of the players jamming radar on this field.
 */
 
 /**
@@ -128,6 +132,8 @@ class CGraphic;
 struct lua_State;
 
 namespace stratagus {
+	class binary_reader;
+	class binary_writer;
 	class resource;
 	class site;
 	class terrain_feature;
@@ -137,15 +143,6 @@ namespace stratagus {
 class CMapFieldPlayerInfo
 {
 public:
-	CMapFieldPlayerInfo()
-	{
-		memset(Visible, 0, sizeof(Visible));
-		memset(VisCloak, 0, sizeof(VisCloak));
-		memset(VisEthereal, 0, sizeof(VisEthereal));
-		memset(Radar, 0, sizeof(Radar));
-		memset(RadarJammer, 0, sizeof(RadarJammer));
-	}
-
 	/// Check if a field for the user is explored.
 	bool IsExplored(const CPlayer &player) const;
 	//Wyrmgus start
@@ -165,6 +162,32 @@ public:
 	*/
 	unsigned char TeamVisibilityState(const CPlayer &player) const;
 
+	/**
+	**  Get how a field is seen by a player, not counting shared vision
+	**
+	**  @param player_index  Index of the player to check for.
+	**
+	**  @return        0 unexplored, 1 explored, 2 visible.
+	*/
+	unsigned char GetVisibilityState(const int player_index) const
+	{
+		const uint32_t player_bit = 1u << player_index;
+		if (VisiblePlayers & player_bit) {
+			return 2;
+		}
+		return (ExploredPlayers & player_bit) ? 1 : 0;
+	}
+
+	bool IsExploredBy(const int player_index) const
+	{
+		return (ExploredPlayers & (1u << player_index)) != 0;
+	}
+
+	void SetExploredBy(const int player_index)
+	{
+		ExploredPlayers |= 1u << player_index;
+	}
+
 public:
 	//Wyrmgus start
 //	unsigned short SeenTile = 0;              /// last seen tile (FOW)
@@ -175,22 +198,29 @@ public:
 	std::vector<std::pair<stratagus::terrain_type *, short>> SeenTransitionTiles;			/// Transition tiles; the pair contains the terrain type and the tile index
 	std::vector<std::pair<stratagus::terrain_type *, short>> SeenOverlayTransitionTiles;		/// Overlay transition tiles; the pair contains the terrain type and the tile index
 	//Wyrmgus end
-	unsigned short Visible[PlayerMax];    /// Seen counter 0 unexplored
-	unsigned char VisCloak[PlayerMax];    /// Visiblity for cloaking.
-	unsigned char VisEthereal[PlayerMax];    /// Visiblity for ethereal.
-	unsigned char Radar[PlayerMax];       /// Visiblity for radar.
-	unsigned char RadarJammer[PlayerMax]; /// Jamming capabilities.
+	uint32_t ExploredPlayers = 0;          /// Players who explored the field.
+	uint32_t VisiblePlayers = 0;           /// Players who currently see the field.
+	uint32_t CloakDetectingPlayers = 0;    /// Visiblity for cloaking.
+	uint32_t EtherealDetectingPlayers = 0; /// Visiblity for ethereal.
+	uint32_t RadarPlayers = 0;             /// Visiblity for radar.
+	uint32_t RadarJammingPlayers = 0;      /// Jamming capabilities.
 };
 
 /// Describes a field of the map
 class CMapField
 {
 public:
+	static void save_tile_planes(const CMapField *fields, const unsigned int field_count, stratagus::binary_writer &writer);
+	static void load_tile_planes(CMapField *fields, const unsigned int field_count, stratagus::binary_reader &reader);
+
 	CMapField();
 
 	void Save(CFile &file) const;
 	void parse(lua_State *l);
+private:
+	void load_terrain_identifier(const std::string &identifier, const bool overlay);
 
+public:
 	//Wyrmgus start
 	void SetTerrain(stratagus::terrain_type *terrain_type);
 	void RemoveOverlayTerrain();
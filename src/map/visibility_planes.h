@@ -0,0 +1,108 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+//      (c) Copyright 2020 by Andrettin
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+//
+
+#pragma once
+
+namespace stratagus {
+
+/**
+**	@brief	The per-player visibility counters of a map layer, stored as one contiguous plane per player and kind of counter
+**
+**	A plane is only allocated once the player first marks a tile with that kind of counter, so e.g. the radar planes take no memory in games without radar.
+**	Whether a counter is non-zero is mirrored in the player bit masks of CMapFieldPlayerInfo, which is what visibility checks read; the counters themselves are only needed when marking or unmarking sight.
+*/
+class visibility_planes final
+{
+public:
+	explicit visibility_planes(const int tile_count) : tile_count(tile_count)
+	{
+	}
+
+	/**
+	**	@brief	Get the quantity of sight markers of a player on a tile, i.e. how many of the player's units currently see it
+	*/
+	uint16_t get_sight_count(const int player_index, const unsigned int tile_index) const
+	{
+		return visibility_planes::get_plane_value(this->sight_count_planes[player_index], tile_index);
+	}
+
+	uint16_t &get_sight_count_ref(const int player_index, const unsigned int tile_index)
+	{
+		return this->get_plane_value_ref(this->sight_count_planes[player_index], tile_index);
+	}
+
+	uint8_t &get_cloak_detection_count_ref(const int player_index, const unsigned int tile_index)
+	{
+		return this->get_plane_value_ref(this->cloak_detection_count_planes[player_index], tile_index);
+	}
+
+	uint8_t &get_ethereal_detection_count_ref(const int player_index, const unsigned int tile_index)
+	{
+		return this->get_plane_value_ref(this->ethereal_detection_count_planes[player_index], tile_index);
+	}
+
+	uint8_t &get_radar_count_ref(const int player_index, const unsigned int tile_index)
+	{
+		return this->get_plane_value_ref(this->radar_count_planes[player_index], tile_index);
+	}
+
+	uint8_t &get_radar_jammer_count_ref(const int player_index, const unsigned int tile_index)
+	{
+		return this->get_plane_value_ref(this->radar_jammer_count_planes[player_index], tile_index);
+	}
+
+private:
+	template <typename T>
+	static T get_plane_value(const std::vector<T> &plane, const unsigned int tile_index)
+	{
+		if (plane.empty()) {
+			return 0;
+		}
+
+		return plane[tile_index];
+	}
+
+	template <typename T>
+	T &get_plane_value_ref(std::vector<T> &plane, const unsigned int tile_index)
+	{
+		if (plane.empty()) {
+			plane.resize(this->tile_count, 0);
+		}
+
+		return plane[tile_index];
+	}
+
+private:
+	int tile_count = 0;
+	std::array<std::vector<uint16_t>, PlayerMax> sight_count_planes;
+	std::array<std::vector<uint8_t>, PlayerMax> cloak_detection_count_planes;
+	std::array<std::vector<uint8_t>, PlayerMax> ethereal_detection_count_planes;
+	std::array<std::vector<uint8_t>, PlayerMax> radar_count_planes;
+	std::array<std::vector<uint8_t>, PlayerMax> radar_jammer_count_planes;
+};
+
+}
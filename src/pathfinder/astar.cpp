@@ -37,11 +37,13 @@
 #include "map/map.h"
 #include "map/map_layer.h"
 #include "map/tileset.h"
+#include "pathfinder/path_cluster_graph.h"
 #include "settings.h"
 #include "time/time_of_day.h"
 #include "unit/unit.h"
 #include "unit/unit_find.h"
 #include "unit/unit_type_type.h"
+#include "util/profiler.h"
 
 #include "pathfinder.h"
 
@@ -149,124 +151,36 @@ static std::vector<int *> CostMoveToCache;
 //Wyrmgus end
 static const int CacheNotSet = -5;
 
-/*----------------------------------------------------------------------------
---  Profile
-----------------------------------------------------------------------------*/
+/// paths longer than this are routed through the cluster graph first
+static constexpr int HierarchicalPathMinDistance = stratagus::path_cluster_graph::cluster_size * 3;
+/// maximum distance from the start of the waypoint up to which the tile-level path is calculated, for hierarchical paths
+static constexpr int HierarchicalPathWaypointRange = stratagus::path_cluster_graph::cluster_size * 2;
 
-#ifdef ASTAR_PROFILE
-
-#ifdef USE_WIN32
-#include <windows.h>
-#else
-
-union LARGE_INTEGER {
-	uint64_t QuadPart;
-	uint32_t DoublePart[2];
-};
-inline int QueryPerformanceCounter(LARGE_INTEGER *ptr)
-{
-	unsigned int lo, hi;
-	__asm__ __volatile__(       // serialize
-		"xorl %%eax,%%eax \n        cpuid"
-		::: "%rax", "%rbx", "%rcx", "%rdx");
-	/* We cannot use "=A", since this would use %rax on x86_64 */
-	__asm__ __volatile__("rdtsc" : "=a"(lo), "=d"(hi));
-	ptr->DoublePart[0] = lo;
-	ptr->DoublePart[1] = hi;
-	return 1;
+/**
+**  Cached cluster graph routes, shared by units starting in the same cluster region (i.e. able to reach each other within the cluster) and going to the same goal.
+**  Entries are only valid while none of the clusters their route passes through have changed.
+*/
+struct AStarPathCacheKey {
+	int StartRegion;
+	Vec2i GoalPos;
+	Vec2i UnitSize;
+	unsigned long MovementMask;
+	int Z;
+
+	bool operator <(const AStarPathCacheKey &rhs) const
+	{
+		return std::tie(StartRegion, GoalPos, UnitSize, MovementMask, Z) < std::tie(rhs.StartRegion, rhs.GoalPos, rhs.UnitSize, rhs.MovementMask, rhs.Z);
+	}
 };
 
-inline int QueryPerformanceFrequency(LARGE_INTEGER *ptr)
-{
-	ptr->QuadPart = 1000;
-	return 1;
-}
-
-#endif
-
-#undef max
-#undef min
-static std::map<const char *const, LARGE_INTEGER> functionTimerMap;
-struct ProfileData {
-	unsigned long Calls;
-	unsigned long TotalTime;
+struct AStarPathCacheEntry {
+	std::vector<QPoint> Path;
+	std::vector<std::pair<int, unsigned int>> ClusterRevisions; /// the clusters the route passes through, with their revision when it was cached
 };
-static std::map<const char *const, ProfileData> functionProfiles;
-
-inline void ProfileInit()
-{
-	functionTimerMap.clear();
-	functionProfiles.clear();
-}
-
-inline void ProfileBegin(const char *const function)
-{
-	LARGE_INTEGER counter;
-	if (!QueryPerformanceCounter(&counter)) {
-		return;
-	}
-	functionTimerMap[function] = counter;
-}
-
-inline void ProfileEnd(const char *const function)
-{
-	LARGE_INTEGER counter;
-	if (!QueryPerformanceCounter(&counter)) {
-		return;
-	}
-	unsigned long time = (unsigned long)(counter.QuadPart - functionTimerMap[function].QuadPart);
-	ProfileData *data = &functionProfiles[function];
-	data->Calls++;
-	data->TotalTime += time;
-}
-
-static bool compProfileData(const ProfileData *lhs, const ProfileData *rhs)
-{
-	return (lhs->TotalTime > rhs->TotalTime);
-}
-
-
-inline void ProfilePrint()
-{
-	LARGE_INTEGER frequency;
-	if (!QueryPerformanceFrequency(&frequency)) {
-		return;
-	}
-	std::vector<ProfileData *> prof;
-	for (std::map<const char *const, ProfileData>::iterator i = functionProfiles.begin();
-		 i != functionProfiles.end(); ++i) {
-		ProfileData *data = &i->second;
-		prof.insert(std::upper_bound(prof.begin(), prof.end(), data, compProfileData), data);
-	}
-
-	FILE *fd = fopen("profile.txt", "wb");
-	fprintf(fd, "    total\t    calls\t      per\tname\n");
-
-	for (std::vector<ProfileData *>::iterator i = prof.begin(); i != prof.end(); ++i) {
-		ProfileData *data = (*i);
-		fprintf(fd, "%9.3f\t%9lu\t%9.3f\t",
-				(double)data->TotalTime / frequency.QuadPart * 1000.0,
-				data->Calls,
-				(double)data->TotalTime / frequency.QuadPart * 1000.0 / data->Calls);
-		for (std::map<const char *const, ProfileData>::iterator j =
-				 functionProfiles.begin(); j != functionProfiles.end(); ++j) {
-			ProfileData *data2 = &j->second;
-			if (data == data2) {
-				fprintf(fd, "%s\n", j->first);
-			}
-		}
 
-	}
-
-	fclose(fd);
-}
-
-#else
-#define ProfileInit()
-#define ProfileBegin(f)
-#define ProfileEnd(f)
-#define ProfilePrint()
-#endif
+static std::map<AStarPathCacheKey, AStarPathCacheEntry> AStarPathCache;
+static constexpr size_t MAX_PATH_CACHE_SIZE = 4096;
+static AStarPathCacheStats PathCacheStats;
 
 /*----------------------------------------------------------------------------
 --  Functions
@@ -332,7 +246,8 @@ void InitAStar()
 	}
 	//Wyrmgus end
 
-	ProfileInit();
+	AStarPathCache.clear();
+	PathCacheStats = AStarPathCacheStats();
 }
 
 /**
@@ -388,7 +303,7 @@ void FreeAStar()
 	}
 	//Wyrmgus end
 
-	ProfilePrint();
+	AStarPathCache.clear();
 }
 
 /**
@@ -413,7 +328,7 @@ static void AStarPrepare(int z)
 static void AStarCleanUp(int z)
 //Wyrmgus end
 {
-	ProfileBegin("AStarCleanUp");
+	const stratagus::profile_zone profile("AStarCleanUp");
 
 	//Wyrmgus start
 //	if (CloseSetSize >= Threshold) {
@@ -433,7 +348,6 @@ static void AStarCleanUp(int z)
 			//Wyrmgus end
 		}
 	}
-	ProfileEnd("AStarCleanUp");
 }
 
 //Wyrmgus start
@@ -441,7 +355,7 @@ static void AStarCleanUp(int z)
 static void CostMoveToCacheCleanUp(int z)
 //Wyrmgus end
 {
-	ProfileBegin("CostMoveToCacheCleanUp");
+	const stratagus::profile_zone profile("CostMoveToCacheCleanUp");
 	//Wyrmgus start
 //	int AStarMapMax =  AStarMapWidth * AStarMapHeight;
 	int AStarMapMax =  AStarMapWidth[z] * AStarMapHeight[z];
@@ -489,7 +403,6 @@ static void CostMoveToCacheCleanUp(int z)
 		//Wyrmgus end
 	}
 #endif
-	ProfileEnd("CostMoveToCacheCleanUp");
 }
 
 /**
@@ -530,8 +443,6 @@ static void AStarRemoveMinimum(int pos, int z)
 static inline int AStarAddNode(const Vec2i &pos, int o, int costs, int z)
 //Wyrmgus end
 {
-	ProfileBegin("AStarAddNode");
-
 	//Wyrmgus start
 //	int bigi = 0, smalli = OpenSetSize;
 	int bigi = 0, smalli = OpenSetSize[z];
@@ -551,7 +462,6 @@ static inline int AStarAddNode(const Vec2i &pos, int o, int costs, int z)
 //				"(current value %d)\n", OpenSetMaxSize);
 				"(current value %d)\n", OpenSetMaxSize[z]);
 				//Wyrmgus end
-		ProfileEnd("AStarAddNode");
 		return PF_FAILED;
 	}
 
@@ -616,8 +526,6 @@ static inline int AStarAddNode(const Vec2i &pos, int o, int costs, int z)
 	++OpenSetSize[z];
 	//Wyrmgus end
 
-	ProfileEnd("AStarAddNode");
-
 	return 0;
 }
 
@@ -631,8 +539,6 @@ static inline int AStarAddNode(const Vec2i &pos, int o, int costs, int z)
 static void AStarReplaceNode(int pos, int z)
 //Wyrmgus end
 {
-	ProfileBegin("AStarReplaceNode");
-
 	Open node;
 
 	// Remove the outdated node
@@ -650,7 +556,6 @@ static void AStarReplaceNode(int pos, int z)
 //	AStarAddNode(node.pos, node.O, node.Costs);
 	AStarAddNode(node.pos, node.O, node.Costs, z);
 	//Wyrmgus end
-	ProfileEnd("AStarReplaceNode");
 }
 
 
@@ -664,8 +569,6 @@ static void AStarReplaceNode(int pos, int z)
 static int AStarFindNode(int eo, int z)
 //Wyrmgus end
 {
-	ProfileBegin("AStarFindNode");
-
 	//Wyrmgus start
 //	for (int i = 0; i < OpenSetSize; ++i) {
 	for (int i = 0; i < OpenSetSize[z]; ++i) {
@@ -674,11 +577,9 @@ static int AStarFindNode(int eo, int z)
 //		if (OpenSet[i].O == eo) {
 		if (OpenSet[z][i].O == eo) {
 		//Wyrmgus end
-			ProfileEnd("AStarFindNode");
 			return i;
 		}
 	}
-	ProfileEnd("AStarFindNode");
 	return -1;
 }
 
@@ -1111,14 +1012,13 @@ static int AStarMarkGoal(const Vec2i &goal, int gw, int gh,
 						 int tilesizex, int tilesizey, int minrange, int maxrange, const CUnit &unit, int z)
 						 //Wyrmgus end
 {
-	ProfileBegin("AStarMarkGoal");
+	const stratagus::profile_zone profile("AStarMarkGoal");
 
 	if (minrange == 0 && maxrange == 0 && gw == 0 && gh == 0) {
 		//Wyrmgus start
 //		if (goal.x + tilesizex > AStarMapWidth || goal.y + tilesizey > AStarMapHeight) {
 		if (goal.x + tilesizex - 1 > AStarMapWidth[z] || goal.y + tilesizey - 1 > AStarMapHeight[z]) {
 		//Wyrmgus end
-			ProfileEnd("AStarMarkGoal");
 			return 0;
 		}
 		//Wyrmgus start
@@ -1131,10 +1031,8 @@ static int AStarMarkGoal(const Vec2i &goal, int gw, int gh,
 //			AStarMatrix[offset].InGoal = 1;
 			AStarMatrix[z][offset].InGoal = 1;
 			//Wyrmgus end
-			ProfileEnd("AStarMarkGoal");
 			return 1;
 		} else {
-			ProfileEnd("AStarMarkGoal");
 			return 0;
 		}
 	}
@@ -1160,7 +1058,6 @@ static int AStarMarkGoal(const Vec2i &goal, int gw, int gh,
 
 	visitor.Visit();
 
-	ProfileEnd("AStarMarkGoal");
 	return goal_reachable;
 }
 
@@ -1174,7 +1071,7 @@ static int AStarMarkGoal(const Vec2i &goal, int gw, int gh,
 static int AStarSavePath(const Vec2i &startPos, const Vec2i &endPos, char *path, int pathLen, int z)
 //Wyrmgus end
 {
-	ProfileBegin("AStarSavePath");
+	const stratagus::profile_zone profile("AStarSavePath");
 
 	int fullPathLength;
 	int pathPos;
@@ -1228,7 +1125,6 @@ static int AStarSavePath(const Vec2i &startPos, const Vec2i &endPos, char *path,
 		}
 	}
 
-	ProfileEnd("AStarSavePath");
 	return fullPathLength;
 }
 
@@ -1243,19 +1139,15 @@ static int AStarFindSimplePath(const Vec2i &startPos, const Vec2i &goal, int gw,
 							   char *path, const CUnit &unit, int z, bool allow_diagonal)
 							   //Wyrmgus end
 {
-	ProfileBegin("AStarFindSimplePath");
+	const stratagus::profile_zone profile("AStarFindSimplePath");
 	// At exact destination point already
 	if (goal == startPos && minrange == 0) {
-		ProfileEnd("AStarFindSimplePath");
 		return PF_REACHED;
 	}
 
 	// Don't allow unit inside destination area
 	if (goal.x <= startPos.x && startPos.x <= goal.x + gw - 1
 		&& goal.y <= startPos.y && startPos.y <= goal.y + gh - 1) {
-		//Wyrmgus start
-		ProfileEnd("AStarFindSimplePath"); // seems like this should be here
-		//Wyrmgus end
 		return PF_FAILED;
 	}
 
@@ -1264,7 +1156,6 @@ static int AStarFindSimplePath(const Vec2i &startPos, const Vec2i &goal, int gw,
 
 	// Within range of destination
 	if (minrange <= distance && distance <= maxrange) {
-		ProfileEnd("AStarFindSimplePath");
 		return PF_REACHED;
 	}
 
@@ -1277,21 +1168,104 @@ static int AStarFindSimplePath(const Vec2i &startPos, const Vec2i &goal, int gw,
 //		if (CostMoveTo(GetIndex(goal.x, goal.y), unit) == -1) {
 		if (CostMoveTo(GetIndex(goal.x, goal.y, z), unit, z) == -1) {
 		//Wyrmgus end
-			ProfileEnd("AStarFindSimplePath");
 			return PF_UNREACHABLE;
 		}
 
 		if (path) {
 			path[0] = XY2Heading[diff.x + 1][diff.y + 1];
 		}
-		ProfileEnd("AStarFindSimplePath");
 		return 1;
 	}
 
-	ProfileEnd("AStarFindSimplePath");
 	return PF_FAILED;
 }
 
+/**
+**  Find a nearby waypoint for a long path, by routing it through the cluster graph
+**
+**  @return  True if a waypoint was found, or false if the path should be searched for at the tile level
+*/
+static bool AStarFindHierarchicalWaypoint(const Vec2i &startPos, const Vec2i &goalPos, const CUnit &unit, int z, Vec2i &waypoint)
+{
+	const stratagus::profile_zone profile("AStarFindHierarchicalWaypoint");
+
+	stratagus::path_cluster_graph *graph = stratagus::path_cluster_graph::get(z, unit.Type->MovementMask);
+
+	const int start_region = graph->get_tile_region(startPos);
+	if (start_region == -1) {
+		return false;
+	}
+
+	const auto is_entry_current = [graph](const AStarPathCacheEntry &entry) {
+		for (const std::pair<int, unsigned int> &cluster_revision : entry.ClusterRevisions) {
+			if (graph->get_cluster_revision(cluster_revision.first) != cluster_revision.second) {
+				return false;
+			}
+		}
+		return true;
+	};
+
+	const AStarPathCacheKey key = {start_region, goalPos, unit.Type->get_tile_size(), unit.Type->MovementMask, z};
+	auto find_iterator = AStarPathCache.find(key);
+
+	if (find_iterator != AStarPathCache.end() && is_entry_current(find_iterator->second)) {
+		PathCacheStats.Hits++;
+	} else {
+		PathCacheStats.Misses++;
+
+		std::vector<QPoint> route = graph->find_path(startPos, goalPos);
+
+		// failed routes aren't cached, as they may be caused by a change somewhere outside the clusters the route would pass through
+		if (route.empty()) {
+			if (find_iterator != AStarPathCache.end()) {
+				PathCacheStats.Invalidations++;
+				AStarPathCache.erase(find_iterator);
+			}
+			return false;
+		}
+
+		if (find_iterator == AStarPathCache.end()) {
+			if (AStarPathCache.size() >= MAX_PATH_CACHE_SIZE) {
+				AStarPathCache.clear();
+				PathCacheStats.Flushes++;
+			}
+			find_iterator = AStarPathCache.emplace(key, AStarPathCacheEntry()).first;
+		} else {
+			PathCacheStats.Invalidations++;
+		}
+
+		AStarPathCacheEntry &entry = find_iterator->second;
+		entry.Path = std::move(route);
+		entry.ClusterRevisions.clear();
+
+		std::vector<int> cluster_indices;
+		cluster_indices.push_back(graph->get_cluster_index(startPos));
+		for (const QPoint &path_pos : entry.Path) {
+			cluster_indices.push_back(graph->get_cluster_index(path_pos));
+		}
+		std::sort(cluster_indices.begin(), cluster_indices.end());
+		cluster_indices.erase(std::unique(cluster_indices.begin(), cluster_indices.end()), cluster_indices.end());
+
+		for (const int cluster_index : cluster_indices) {
+			entry.ClusterRevisions.emplace_back(cluster_index, graph->get_cluster_revision(cluster_index));
+		}
+	}
+
+	const std::vector<QPoint> &abstract_path = find_iterator->second.Path;
+
+	bool found = false;
+	for (const QPoint &path_pos : abstract_path) {
+		if (AStarCosts(path_pos, startPos) > HierarchicalPathWaypointRange) {
+			break;
+		}
+
+		waypoint = path_pos;
+		found = true;
+	}
+
+	return found && waypoint != startPos;
+}
+
 /**
 **  Find path.
 */
@@ -1312,10 +1286,7 @@ int AStarFindPath(const Vec2i &startPos, const Vec2i &goalPos, int gw, int gh,
 	allow_diagonal = allow_diagonal && !unit.Type->BoolFlag[RAIL_INDEX].value; //rail units cannot move diagonally
 	//Wyrmgus end
 
-	ProfileBegin("AStarFindPath");
-
-	AStarGoalX = goalPos.x;
-	AStarGoalY = goalPos.y;
+	const stratagus::profile_zone profile("AStarFindPath");
 
 	//  Check for simple cases first
 	int ret = AStarFindSimplePath(startPos, goalPos, gw, gh, tilesizex, tilesizey,
@@ -1324,10 +1295,29 @@ int AStarFindPath(const Vec2i &startPos, const Vec2i &goalPos, int gw, int gh,
 								  minrange, maxrange, path, unit, z, allow_diagonal);
 								  //Wyrmgus end
 	if (ret != PF_FAILED) {
-		ProfileEnd("AStarFindPath");
 		return ret;
 	}
 
+	//  Long paths for moving units are routed through the cluster graph, only calculating the tile-level path up to a nearby waypoint;
+	//  the waypoint is always nearer than the minimum distance, so this doesn't recurse further.
+	//  The cluster graph is built from the actual terrain, so it is only used if the pathfinder may know unseen terrain;
+	//  otherwise, unexplored tiles have to be treated as passable, as the tile-level search does
+	if (AStarKnowUnseenTerrain && path != nullptr && max_length == 0 && allow_diagonal && tilesizex == 1 && tilesizey == 1
+		&& (unit.Type->UnitType == UnitTypeType::Land || unit.Type->UnitType == UnitTypeType::Naval)
+		&& AStarCosts(startPos, goalPos) > HierarchicalPathMinDistance) {
+		Vec2i waypoint;
+		if (AStarFindHierarchicalWaypoint(startPos, goalPos, unit, z, waypoint)) {
+			ret = AStarFindPath(startPos, waypoint, 0, 0, tilesizex, tilesizey, 0, 0, path, pathlen, unit, 0, z, allow_diagonal);
+			if (ret > 0) {
+				return ret;
+			}
+			// the waypoint may be blocked by units, fall back to a full search
+		}
+	}
+
+	AStarGoalX = goalPos.x;
+	AStarGoalY = goalPos.y;
+
 	//  Initialize
 	//Wyrmgus start
 //	AStarCleanUp();
@@ -1349,7 +1339,6 @@ int AStarFindPath(const Vec2i &startPos, const Vec2i &goalPos, int gw, int gh,
 	//Wyrmgus end
 		// goal is not reachable
 		ret = PF_UNREACHABLE;
-		ProfileEnd("AStarFindPath");
 		return ret;
 	}
 
@@ -1378,7 +1367,6 @@ int AStarFindPath(const Vec2i &startPos, const Vec2i &goalPos, int gw, int gh,
 	if (AStarAddNode(startPos, eo, 1 + costToGoal, z) == PF_FAILED) {
 	//Wyrmgus end
 		ret = PF_FAILED;
-		ProfileEnd("AStarFindPath");
 		return ret;
 	}
 	//Wyrmgus start
@@ -1388,7 +1376,6 @@ int AStarFindPath(const Vec2i &startPos, const Vec2i &goalPos, int gw, int gh,
 	if (AStarMatrix[z][eo].InGoal) {
 	//Wyrmgus end
 		ret = PF_REACHED;
-		ProfileEnd("AStarFindPath");
 		return ret;
 	}
 	Vec2i endPos;
@@ -1402,7 +1389,6 @@ int AStarFindPath(const Vec2i &startPos, const Vec2i &goalPos, int gw, int gh,
 		//Wyrmgus start
 		if (max_length != 0 && length > max_length) {
 			ret = PF_FAILED;
-			ProfileEnd("AStarFindPath");
 			return ret;
 		}
 		//Wyrmgus end
@@ -1441,7 +1427,6 @@ int AStarFindPath(const Vec2i &startPos, const Vec2i &goalPos, int gw, int gh,
 			// Nearest point to goal.
 			AstarDebugPrint("way too long\n");
 			ret = PF_FAILED;
-			ProfileEnd("AStarFindPath");
 			return ret;
 		}
 #endif
@@ -1527,7 +1512,6 @@ int AStarFindPath(const Vec2i &startPos, const Vec2i &goalPos, int gw, int gh,
 				if (AStarAddNode(endPos, eo, AStarMatrix[z][eo].CostFromStart + costToGoal, z) == PF_FAILED) {
 				//Wyrmgus end
 					ret = PF_FAILED;
-					ProfileEnd("AStarFindPath");
 					return ret;
 				}
 				// we add the point to the close set
@@ -1561,7 +1545,6 @@ int AStarFindPath(const Vec2i &startPos, const Vec2i &goalPos, int gw, int gh,
 					if (AStarAddNode(endPos, eo, AStarMatrix[z][eo].CostFromStart + costToGoal, z) == PF_FAILED) {
 					//Wyrmgus end
 						ret = PF_FAILED;
-						ProfileEnd("AStarFindPath");
 						return ret;
 					}
 				} else {
@@ -1581,7 +1564,6 @@ int AStarFindPath(const Vec2i &startPos, const Vec2i &goalPos, int gw, int gh,
 		if (OpenSetSize[z] <= 0) { // no new nodes generated
 		//Wyrmgus end
 			ret = PF_UNREACHABLE;
-			ProfileEnd("AStarFindPath");
 			return ret;
 		}
 		
@@ -1597,7 +1579,6 @@ int AStarFindPath(const Vec2i &startPos, const Vec2i &goalPos, int gw, int gh,
 
 	ret = path_length;
 
-	ProfileEnd("AStarFindPath");
 	return ret;
 }
 
@@ -1660,6 +1641,13 @@ void AStarFreeStats(StatsNode *stats)
 	delete[] stats;
 }
 
+AStarPathCacheStats AStarGetPathCacheStats()
+{
+	AStarPathCacheStats stats = PathCacheStats;
+	stats.Size = AStarPathCache.size();
+	return stats;
+}
+
 /*----------------------------------------------------------------------------
 --  Configurable costs
 ----------------------------------------------------------------------------*/
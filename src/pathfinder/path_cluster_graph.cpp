@@ -0,0 +1,526 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+//      (c) Copyright 2020 by Andrettin
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+//
+
+#include "stratagus.h"
+
+#include "pathfinder/path_cluster_graph.h"
+
+#include "map/map.h"
+#include "map/tileset.h"
+#include "pathfinder.h"
+#include "util/point_util.h"
+
+namespace stratagus {
+
+/// the cluster graphs for each map layer, mapped to the movement mask they were built for
+static std::vector<std::map<unsigned long, std::unique_ptr<path_cluster_graph>>> graphs_by_layer;
+
+path_cluster_graph *path_cluster_graph::get(const int z, const unsigned long movement_mask)
+{
+	if (z >= static_cast<int>(graphs_by_layer.size())) {
+		graphs_by_layer.resize(z + 1);
+	}
+
+	std::unique_ptr<path_cluster_graph> &graph = graphs_by_layer[z][movement_mask];
+	if (graph == nullptr) {
+		graph = std::make_unique<path_cluster_graph>(z, movement_mask);
+	}
+
+	return graph.get();
+}
+
+void path_cluster_graph::clear_all()
+{
+	graphs_by_layer.clear();
+}
+
+void path_cluster_graph::on_tile_changed(const QPoint &tile_pos, const int z)
+{
+	if (z >= static_cast<int>(graphs_by_layer.size())) {
+		return;
+	}
+
+	for (const auto &kv_pair : graphs_by_layer[z]) {
+		kv_pair.second->set_tile_dirty(tile_pos);
+	}
+}
+
+path_cluster_graph::path_cluster_graph(const int z, const unsigned long movement_mask)
+	: z(z), movement_mask(movement_mask)
+{
+	this->map_size = QSize(CMap::Map.Info.MapWidths[z], CMap::Map.Info.MapHeights[z]);
+	this->cluster_grid_size = QSize(
+		(this->map_size.width() + path_cluster_graph::cluster_size - 1) / path_cluster_graph::cluster_size,
+		(this->map_size.height() + path_cluster_graph::cluster_size - 1) / path_cluster_graph::cluster_size
+	);
+
+	this->clusters.resize(this->cluster_grid_size.width() * this->cluster_grid_size.height());
+
+	for (int cluster_y = 0; cluster_y < this->cluster_grid_size.height(); ++cluster_y) {
+		for (int cluster_x = 0; cluster_x < this->cluster_grid_size.width(); ++cluster_x) {
+			const QPoint top_left(cluster_x * path_cluster_graph::cluster_size, cluster_y * path_cluster_graph::cluster_size);
+			const QPoint bottom_right(
+				std::min(top_left.x() + path_cluster_graph::cluster_size, this->map_size.width()) - 1,
+				std::min(top_left.y() + path_cluster_graph::cluster_size, this->map_size.height()) - 1
+			);
+			this->clusters[point::to_index(cluster_x, cluster_y, this->cluster_grid_size)].rect = QRect(top_left, bottom_right);
+		}
+	}
+}
+
+/**
+**	@brief	Mark the clusters affected by a change in a tile's passability as needing to be rebuilt
+**
+**	@param	tile_pos	The position of the changed tile
+*/
+void path_cluster_graph::set_tile_dirty(const QPoint &tile_pos)
+{
+	const int cluster_x = tile_pos.x() / path_cluster_graph::cluster_size;
+	const int cluster_y = tile_pos.y() / path_cluster_graph::cluster_size;
+	const int local_x = tile_pos.x() % path_cluster_graph::cluster_size;
+	const int local_y = tile_pos.y() % path_cluster_graph::cluster_size;
+
+	const auto set_cluster_dirty = [this](const int cluster_x, const int cluster_y) {
+		cluster &cluster = this->clusters[point::to_index(cluster_x, cluster_y, this->cluster_grid_size)];
+		cluster.dirty = true;
+		++cluster.revision;
+	};
+
+	set_cluster_dirty(cluster_x, cluster_y);
+
+	//tiles on the border of a cluster also affect the portals of the neighboring cluster
+	if (local_x == 0 && cluster_x > 0) {
+		set_cluster_dirty(cluster_x - 1, cluster_y);
+	} else if (local_x == path_cluster_graph::cluster_size - 1 && cluster_x < this->cluster_grid_size.width() - 1) {
+		set_cluster_dirty(cluster_x + 1, cluster_y);
+	}
+
+	if (local_y == 0 && cluster_y > 0) {
+		set_cluster_dirty(cluster_x, cluster_y - 1);
+	} else if (local_y == path_cluster_graph::cluster_size - 1 && cluster_y < this->cluster_grid_size.height() - 1) {
+		set_cluster_dirty(cluster_x, cluster_y + 1);
+	}
+
+	this->has_dirty_clusters = true;
+}
+
+/**
+**	@brief	Find a path between two positions through the cluster portals
+**
+**	@param	start_pos	The start position
+**	@param	goal_pos	The goal position
+**
+**	@return	The portal tiles traversed by the path, ending in the goal's cluster; empty if no path was found, or if both positions are in the same cluster
+*/
+std::vector<QPoint> path_cluster_graph::find_path(const QPoint &start_pos, const QPoint &goal_pos)
+{
+	this->rebuild_dirty_clusters();
+
+	const int start_cluster_index = this->get_cluster_index(start_pos);
+	const int goal_cluster_index = this->get_cluster_index(goal_pos);
+
+	if (start_cluster_index == goal_cluster_index) {
+		return {};
+	}
+
+	std::map<int, int> costs;
+	std::map<int, int> previous_tile_indices;
+	std::priority_queue<std::pair<int, int>, std::vector<std::pair<int, int>>, std::greater<std::pair<int, int>>> open_set;
+
+	const cluster &start_cluster = this->clusters[start_cluster_index];
+	const std::vector<int> start_costs = this->calculate_local_costs(start_cluster, point::to_index(start_pos, this->map_size));
+	for (const portal &portal : start_cluster.portals) {
+		const QPoint local_pos = this->get_tile_pos(portal.tile_index) - start_cluster.rect.topLeft();
+		const int cost = start_costs[point::to_index(local_pos, path_cluster_graph::cluster_size)];
+		if (cost < 0) {
+			continue;
+		}
+
+		costs[portal.tile_index] = cost;
+		previous_tile_indices[portal.tile_index] = -1;
+		open_set.emplace(cost + this->estimate_cost(portal.tile_index, goal_pos), portal.tile_index);
+	}
+
+	while (!open_set.empty()) {
+		const int estimated_cost = open_set.top().first;
+		const int tile_index = open_set.top().second;
+		open_set.pop();
+
+		const int cost = costs[tile_index];
+		if (estimated_cost > cost + this->estimate_cost(tile_index, goal_pos)) {
+			continue; //outdated entry, the tile was reached again with a lower cost
+		}
+
+		const int cluster_index = this->get_cluster_index(tile_index);
+
+		if (cluster_index == goal_cluster_index) {
+			std::vector<QPoint> path;
+			for (int path_tile_index = tile_index; path_tile_index != -1; path_tile_index = previous_tile_indices[path_tile_index]) {
+				path.push_back(this->get_tile_pos(path_tile_index));
+			}
+			std::reverse(path.begin(), path.end());
+			return path;
+		}
+
+		const portal *portal = this->get_portal(cluster_index, tile_index);
+		if (portal == nullptr) {
+			continue;
+		}
+
+		const auto visit = [&](const int other_tile_index, const int edge_cost) {
+			const int new_cost = cost + edge_cost;
+			const auto find_iterator = costs.find(other_tile_index);
+			if (find_iterator != costs.end() && find_iterator->second <= new_cost) {
+				return;
+			}
+
+			costs[other_tile_index] = new_cost;
+			previous_tile_indices[other_tile_index] = tile_index;
+			open_set.emplace(new_cost + this->estimate_cost(other_tile_index, goal_pos), other_tile_index);
+		};
+
+		for (const std::pair<int, int> &edge : portal->edges) {
+			visit(edge.first, edge.second);
+		}
+
+		for (const int exit_tile_index : portal->exit_tile_indices) {
+			visit(exit_tile_index, this->get_tile_move_cost(exit_tile_index));
+		}
+	}
+
+	return {};
+}
+
+/**
+**	@brief	Get the region of a tile, i.e. the group of tiles of its cluster which can be reached from it without leaving the cluster
+**
+**	Paths through the graph from any tile of a region use the same portals, so they can be shared between start positions in the same region.
+**
+**	@param	tile_pos	The position of the tile
+**
+**	@return	The region, which is unique across the clusters of the graph, or -1 if the tile is impassable
+*/
+int path_cluster_graph::get_tile_region(const QPoint &tile_pos)
+{
+	this->rebuild_dirty_clusters();
+
+	const int cluster_index = this->get_cluster_index(tile_pos);
+	const cluster &cluster = this->clusters[cluster_index];
+	const int local_region = cluster.tile_regions[point::to_index(tile_pos - cluster.rect.topLeft(), path_cluster_graph::cluster_size)];
+	if (local_region == -1) {
+		return -1;
+	}
+
+	return cluster_index * path_cluster_graph::cluster_area + local_region;
+}
+
+int path_cluster_graph::get_cluster_index(const int tile_index) const
+{
+	return this->get_cluster_index(this->get_tile_pos(tile_index));
+}
+
+QPoint path_cluster_graph::get_tile_pos(const int tile_index) const
+{
+	return point::from_index(tile_index, this->map_size);
+}
+
+/**
+**	@brief	Get whether a tile can be crossed with the graph's movement mask
+**
+**	Units are ignored, except for buildings, in the same way as in the tile-level A* cost function.
+*/
+bool path_cluster_graph::is_tile_passable(const int tile_index) const
+{
+	const CMapField *mf = CMap::Map.Field(tile_index, this->z);
+
+	//for purposes of this check, don't count MapFieldWaterAllowed and MapFieldCoastAllowed if there is a bridge present
+	unsigned long check_flags = mf->Flags;
+	if (check_flags & MapFieldBridge) {
+		check_flags &= ~(MapFieldWaterAllowed | MapFieldCoastAllowed);
+	}
+
+	return (check_flags & this->movement_mask & ~(MapFieldLandUnit | MapFieldAirUnit | MapFieldSeaUnit)) == 0;
+}
+
+int path_cluster_graph::get_tile_move_cost(const int tile_index) const
+{
+	//add a cost for walking, as in the tile-level A*
+	return 1 + CMap::Map.Field(tile_index, this->z)->getCost();
+}
+
+int path_cluster_graph::estimate_cost(const int tile_index, const QPoint &goal_pos) const
+{
+	const QPoint tile_pos = this->get_tile_pos(tile_index);
+	return std::max(std::abs(tile_pos.x() - goal_pos.x()), std::abs(tile_pos.y() - goal_pos.y()));
+}
+
+const path_cluster_graph::portal *path_cluster_graph::get_portal(const int cluster_index, const int tile_index) const
+{
+	for (const portal &portal : this->clusters[cluster_index].portals) {
+		if (portal.tile_index == tile_index) {
+			return &portal;
+		}
+	}
+
+	return nullptr;
+}
+
+void path_cluster_graph::add_portal(cluster &cluster, const int tile_index, const int exit_tile_index)
+{
+	//a corner tile can be a portal for two borders at once
+	for (portal &portal : cluster.portals) {
+		if (portal.tile_index == tile_index) {
+			portal.exit_tile_indices.push_back(exit_tile_index);
+			return;
+		}
+	}
+
+	cluster.portals.emplace_back(tile_index);
+	cluster.portals.back().exit_tile_indices.push_back(exit_tile_index);
+}
+
+/**
+**	@brief	Add portals for the passable stretches of a cluster border
+**
+**	Since the runs depend only on the tiles at both sides of the border, the neighboring cluster ends up with the mirrored portals.
+**
+**	@param	cluster		The cluster
+**	@param	start_pos	The first tile of the border, inside the cluster
+**	@param	step		The offset between successive border tiles
+**	@param	exit_offset	The offset from a border tile to its neighbor across the border
+**	@param	length		The quantity of tiles in the border
+*/
+void path_cluster_graph::add_border_portals(cluster &cluster, const QPoint &start_pos, const QPoint &step, const QPoint &exit_offset, const int length)
+{
+	int run_start = -1;
+
+	for (int i = 0; i <= length; ++i) {
+		bool passable = false;
+		if (i < length) {
+			const QPoint tile_pos = start_pos + step * i;
+			passable = this->is_tile_passable(point::to_index(tile_pos, this->map_size)) && this->is_tile_passable(point::to_index(tile_pos + exit_offset, this->map_size));
+		}
+
+		if (passable) {
+			if (run_start == -1) {
+				run_start = i;
+			}
+			continue;
+		}
+
+		if (run_start == -1) {
+			continue;
+		}
+
+		const int run_end = i - 1;
+		std::vector<int> portal_offsets;
+		if (run_end - run_start + 1 > path_cluster_graph::max_portal_run_length) {
+			portal_offsets.push_back(run_start);
+			portal_offsets.push_back(run_end);
+		} else {
+			portal_offsets.push_back((run_start + run_end) / 2);
+		}
+
+		for (const int portal_offset : portal_offsets) {
+			const QPoint tile_pos = start_pos + step * portal_offset;
+			this->add_portal(cluster, point::to_index(tile_pos, this->map_size), point::to_index(tile_pos + exit_offset, this->map_size));
+		}
+
+		run_start = -1;
+	}
+}
+
+void path_cluster_graph::rebuild_dirty_clusters()
+{
+	if (!this->has_dirty_clusters) {
+		return;
+	}
+
+	//the portals of all dirty clusters need to be in place before the edges are calculated, since the edge calculation of a cluster doesn't depend on its neighbors, but the path search relies on the portals of both sides of a border mirroring each other
+	for (cluster &cluster : this->clusters) {
+		if (cluster.dirty) {
+			this->rebuild_cluster_regions(cluster);
+			this->rebuild_cluster_portals(cluster);
+		}
+	}
+
+	for (cluster &cluster : this->clusters) {
+		if (cluster.dirty) {
+			this->rebuild_cluster_edges(cluster);
+			cluster.dirty = false;
+		}
+	}
+
+	this->has_dirty_clusters = false;
+}
+
+/**
+**	@brief	Group the passable tiles of a cluster into regions, using the same adjacency as the local cost calculation
+*/
+void path_cluster_graph::rebuild_cluster_regions(cluster &cluster)
+{
+	cluster.tile_regions.assign(path_cluster_graph::cluster_area, -1);
+
+	const QPoint &top_left = cluster.rect.topLeft();
+	int region_count = 0;
+	std::vector<QPoint> tile_stack;
+
+	for (int y = cluster.rect.top(); y <= cluster.rect.bottom(); ++y) {
+		for (int x = cluster.rect.left(); x <= cluster.rect.right(); ++x) {
+			const QPoint start_pos(x, y);
+			const int start_local_index = point::to_index(start_pos - top_left, path_cluster_graph::cluster_size);
+			if (cluster.tile_regions[start_local_index] != -1 || !this->is_tile_passable(point::to_index(start_pos, this->map_size))) {
+				continue;
+			}
+
+			const int region = region_count++;
+			cluster.tile_regions[start_local_index] = region;
+			tile_stack.push_back(start_pos);
+
+			while (!tile_stack.empty()) {
+				const QPoint tile_pos = tile_stack.back();
+				tile_stack.pop_back();
+
+				for (int i = 0; i < 8; ++i) {
+					const QPoint adjacent_pos(tile_pos.x() + Heading2X[i], tile_pos.y() + Heading2Y[i]);
+					if (!cluster.rect.contains(adjacent_pos)) {
+						continue;
+					}
+
+					const int adjacent_local_index = point::to_index(adjacent_pos - top_left, path_cluster_graph::cluster_size);
+					if (cluster.tile_regions[adjacent_local_index] != -1 || !this->is_tile_passable(point::to_index(adjacent_pos, this->map_size))) {
+						continue;
+					}
+
+					cluster.tile_regions[adjacent_local_index] = region;
+					tile_stack.push_back(adjacent_pos);
+				}
+			}
+		}
+	}
+}
+
+void path_cluster_graph::rebuild_cluster_portals(cluster &cluster)
+{
+	cluster.portals.clear();
+
+	const QRect &rect = cluster.rect;
+
+	if (rect.top() > 0) {
+		this->add_border_portals(cluster, rect.topLeft(), QPoint(1, 0), QPoint(0, -1), rect.width());
+	}
+
+	if (rect.bottom() < this->map_size.height() - 1) {
+		this->add_border_portals(cluster, rect.bottomLeft(), QPoint(1, 0), QPoint(0, 1), rect.width());
+	}
+
+	if (rect.left() > 0) {
+		this->add_border_portals(cluster, rect.topLeft(), QPoint(0, 1), QPoint(-1, 0), rect.height());
+	}
+
+	if (rect.right() < this->map_size.width() - 1) {
+		this->add_border_portals(cluster, rect.topRight(), QPoint(0, 1), QPoint(1, 0), rect.height());
+	}
+}
+
+void path_cluster_graph::rebuild_cluster_edges(cluster &cluster)
+{
+	for (portal &portal : cluster.portals) {
+		portal.edges.clear();
+
+		const std::vector<int> local_costs = this->calculate_local_costs(cluster, portal.tile_index);
+
+		for (const path_cluster_graph::portal &other_portal : cluster.portals) {
+			if (&other_portal == &portal) {
+				continue;
+			}
+
+			const QPoint local_pos = this->get_tile_pos(other_portal.tile_index) - cluster.rect.topLeft();
+			const int cost = local_costs[point::to_index(local_pos, path_cluster_graph::cluster_size)];
+			if (cost >= 0) {
+				portal.edges.emplace_back(other_portal.tile_index, cost);
+			}
+		}
+	}
+}
+
+/**
+**	@brief	Calculate the costs of reaching the tiles of a cluster from a given tile, without leaving the cluster
+**
+**	@param	cluster				The cluster
+**	@param	start_tile_index	The start tile, which must be in the cluster
+**
+**	@return	The cost for each tile of the cluster, indexed with the cluster size as the width, and -1 for unreachable tiles
+*/
+std::vector<int> path_cluster_graph::calculate_local_costs(const cluster &cluster, const int start_tile_index) const
+{
+	std::vector<int> costs(path_cluster_graph::cluster_area, -1);
+	std::priority_queue<std::pair<int, int>, std::vector<std::pair<int, int>>, std::greater<std::pair<int, int>>> queue;
+
+	const QPoint &top_left = cluster.rect.topLeft();
+	const QPoint start_local_pos = this->get_tile_pos(start_tile_index) - top_left;
+	const int start_local_index = point::to_index(start_local_pos, path_cluster_graph::cluster_size);
+	costs[start_local_index] = 0;
+	queue.emplace(0, start_local_index);
+
+	while (!queue.empty()) {
+		const int cost = queue.top().first;
+		const int local_index = queue.top().second;
+		queue.pop();
+
+		if (cost > costs[local_index]) {
+			continue;
+		}
+
+		const QPoint tile_pos = point::from_index(local_index, path_cluster_graph::cluster_size) + top_left;
+
+		for (int i = 0; i < 8; ++i) {
+			const QPoint adjacent_pos(tile_pos.x() + Heading2X[i], tile_pos.y() + Heading2Y[i]);
+			if (!cluster.rect.contains(adjacent_pos)) {
+				continue;
+			}
+
+			const int adjacent_tile_index = point::to_index(adjacent_pos, this->map_size);
+			if (!this->is_tile_passable(adjacent_tile_index)) {
+				continue;
+			}
+
+			const int adjacent_local_index = point::to_index(adjacent_pos - top_left, path_cluster_graph::cluster_size);
+			const int new_cost = cost + this->get_tile_move_cost(adjacent_tile_index);
+			if (costs[adjacent_local_index] != -1 && costs[adjacent_local_index] <= new_cost) {
+				continue;
+			}
+
+			costs[adjacent_local_index] = new_cost;
+			queue.emplace(new_cost, adjacent_local_index);
+		}
+	}
+
+	return costs;
+}
+
+}
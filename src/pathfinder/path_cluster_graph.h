@@ -0,0 +1,112 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+//      (c) Copyright 2020 by Andrettin
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+//
+
+#pragma once
+
+namespace stratagus {
+
+/**
+**	@brief	Hierarchical abstraction of the passability of a map layer for a given movement mask
+**
+**	The map layer is divided into square clusters, which are connected to each other by portals placed on passable stretches of their borders.
+**	Long paths are first routed through the portals, and the tile-level A* is then only run up to a nearby waypoint.
+*/
+class path_cluster_graph final
+{
+public:
+	static constexpr int cluster_size = 16;
+	static constexpr int cluster_area = cluster_size * cluster_size;
+	static constexpr int max_portal_run_length = 8; //runs of passable border tiles longer than this get a portal at each end, instead of a single one in the middle
+
+	static path_cluster_graph *get(const int z, const unsigned long movement_mask);
+	static void clear_all();
+	static void on_tile_changed(const QPoint &tile_pos, const int z);
+
+private:
+	struct portal final
+	{
+		explicit portal(const int tile_index) : tile_index(tile_index)
+		{
+		}
+
+		int tile_index = -1; //the index of the portal's tile in the map layer
+		std::vector<int> exit_tile_indices; //the tiles across the cluster border which this portal leads to
+		std::vector<std::pair<int, int>> edges; //the other portals of the same cluster reachable from this one, and the cost to reach them
+	};
+
+	struct cluster final
+	{
+		QRect rect;
+		std::vector<portal> portals;
+		std::vector<int> tile_regions; //the region of each tile of the cluster, i.e. the group of passable tiles connected to each other within the cluster, or -1 for impassable tiles
+		unsigned int revision = 0; //incremented whenever the cluster is marked as dirty
+		bool dirty = true;
+	};
+
+public:
+	explicit path_cluster_graph(const int z, const unsigned long movement_mask);
+
+	void set_tile_dirty(const QPoint &tile_pos);
+
+	std::vector<QPoint> find_path(const QPoint &start_pos, const QPoint &goal_pos);
+	int get_tile_region(const QPoint &tile_pos);
+
+	unsigned int get_cluster_revision(const int cluster_index) const
+	{
+		return this->clusters[cluster_index].revision;
+	}
+
+	int get_cluster_index(const QPoint &tile_pos) const
+	{
+		return tile_pos.x() / path_cluster_graph::cluster_size + tile_pos.y() / path_cluster_graph::cluster_size * this->cluster_grid_size.width();
+	}
+
+private:
+	int get_cluster_index(const int tile_index) const;
+	QPoint get_tile_pos(const int tile_index) const;
+	bool is_tile_passable(const int tile_index) const;
+	int get_tile_move_cost(const int tile_index) const;
+	int estimate_cost(const int tile_index, const QPoint &goal_pos) const;
+	const portal *get_portal(const int cluster_index, const int tile_index) const;
+	void add_portal(cluster &cluster, const int tile_index, const int exit_tile_index);
+	void add_border_portals(cluster &cluster, const QPoint &start_pos, const QPoint &step, const QPoint &exit_offset, const int length);
+	void rebuild_dirty_clusters();
+	void rebuild_cluster_regions(cluster &cluster);
+	void rebuild_cluster_portals(cluster &cluster);
+	void rebuild_cluster_edges(cluster &cluster);
+	std::vector<int> calculate_local_costs(const cluster &cluster, const int start_tile_index) const;
+
+private:
+	int z = -1;
+	unsigned long movement_mask = 0;
+	QSize map_size;
+	QSize cluster_grid_size;
+	std::vector<cluster> clusters;
+	bool has_dirty_clusters = true;
+};
+
+}
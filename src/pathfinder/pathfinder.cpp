@@ -40,6 +40,7 @@
 #include "actions.h"
 #include "map/map.h"
 #include "map/map_layer.h"
+#include "pathfinder/path_cluster_graph.h"
 #include "unit/unit.h"
 #include "unit/unit_type.h"
 
@@ -70,11 +71,105 @@ extern int AStarFindPath(const Vec2i &startPos, const Vec2i &goalPos, int gw, in
 --  Variables
 ----------------------------------------------------------------------------*/
 
+/// Stamp of the border of the traversal buffers, which is higher than any generation
+static constexpr unsigned int TerrainTraversalBorderStamp = UINT_MAX;
+
+/// Scratch buffers not in use by any traversal; per thread, as traversals may run in worker threads
+static thread_local std::vector<std::unique_ptr<TerrainTraversal::ScratchBuffer>> TerrainTraversalFreeBuffers;
+
+/// Revision of the free scratch buffers, increased when they are released; each thread frees its buffers when it sees a newer revision
+static std::atomic<unsigned int> TerrainTraversalFreeBuffersRevision = 0;
+
+/// Revision of the free scratch buffers of the thread
+static thread_local unsigned int TerrainTraversalThreadFreeBuffersRevision = 0;
+
+/**
+**  Free the scratch buffers of the thread if they have been released since it last used them
+*/
+static void UpdateTerrainTraversalFreeBuffers()
+{
+	const unsigned int revision = TerrainTraversalFreeBuffersRevision.load(std::memory_order_relaxed);
+
+	if (TerrainTraversalThreadFreeBuffersRevision != revision) {
+		TerrainTraversalFreeBuffers.clear();
+		TerrainTraversalThreadFreeBuffersRevision = revision;
+	}
+}
+
+/**
+**  Release the scratch buffers not in use by any traversal, e.g. when the map changes, as their sizes are those of the previous map's layers
+**
+**  The buffers of the calling thread are freed at once, while other threads free theirs the next time they run a traversal.
+*/
+void TerrainTraversal::ReleaseFreeBuffers()
+{
+	++TerrainTraversalFreeBuffersRevision;
+	UpdateTerrainTraversalFreeBuffers();
+}
+
+TerrainTraversal::~TerrainTraversal()
+{
+	if (m_buffer != nullptr) {
+		UpdateTerrainTraversalFreeBuffers();
+		TerrainTraversalFreeBuffers.emplace_back(m_buffer);
+	}
+}
+
 void TerrainTraversal::SetSize(unsigned int width, unsigned int height)
 {
-	m_values.resize((width + 2) * (height + 2));
-	m_extented_width = width + 2;
-	m_height = height;
+	if (m_buffer != nullptr && m_buffer->ExtendedWidth == width + 2 && m_buffer->Height == height) {
+		return;
+	}
+
+	UpdateTerrainTraversalFreeBuffers();
+
+	if (m_buffer != nullptr) {
+		TerrainTraversalFreeBuffers.emplace_back(m_buffer);
+		m_buffer = nullptr;
+	}
+
+	//prefer a free buffer of the same size, so that it needn't be reset
+	auto find_iterator = std::find_if(TerrainTraversalFreeBuffers.begin(), TerrainTraversalFreeBuffers.end(), [width, height](const std::unique_ptr<ScratchBuffer> &buffer) {
+		return buffer->ExtendedWidth == width + 2 && buffer->Height == height;
+	});
+	if (find_iterator == TerrainTraversalFreeBuffers.end() && !TerrainTraversalFreeBuffers.empty()) {
+		find_iterator = TerrainTraversalFreeBuffers.end() - 1;
+	}
+
+	if (find_iterator != TerrainTraversalFreeBuffers.end()) {
+		m_buffer = find_iterator->release();
+		TerrainTraversalFreeBuffers.erase(find_iterator);
+	} else {
+		m_buffer = new ScratchBuffer;
+	}
+
+	if (m_buffer->ExtendedWidth == width + 2 && m_buffer->Height == height) {
+		return;
+	}
+
+	const unsigned int width_ext = width + 2;
+	m_buffer->ExtendedWidth = width_ext;
+	m_buffer->Height = height;
+	m_buffer->Generation = 0;
+	//replace the vectors rather than assigning to them, so that a buffer reused for a smaller size doesn't keep the memory of the larger one
+	m_buffer->Stamps = std::vector<unsigned int>(width_ext * (height + 2), 0);
+	m_buffer->Values = std::vector<dataType>(width_ext * (height + 2), 0);
+	//the frontier grows as needed, as most traversals only visit a small part of the map
+	m_buffer->Frontier = std::vector<PosNode>();
+
+	//the border is permanently set as invalid
+	for (unsigned int x = 0; x < width_ext; ++x) {
+		m_buffer->Stamps[x] = TerrainTraversalBorderStamp;
+		m_buffer->Values[x] = -1;
+		m_buffer->Stamps[(height + 1) * width_ext + x] = TerrainTraversalBorderStamp;
+		m_buffer->Values[(height + 1) * width_ext + x] = -1;
+	}
+	for (unsigned int y = 1; y < 1 + height; ++y) {
+		m_buffer->Stamps[y * width_ext] = TerrainTraversalBorderStamp;
+		m_buffer->Values[y * width_ext] = -1;
+		m_buffer->Stamps[y * width_ext + width + 1] = TerrainTraversalBorderStamp;
+		m_buffer->Values[y * width_ext + width + 1] = -1;
+	}
 }
 
 void TerrainTraversal::SetDiagonalAllowed(const bool allowed)
@@ -84,23 +179,26 @@ void TerrainTraversal::SetDiagonalAllowed(const bool allowed)
 
 void TerrainTraversal::Init()
 {
-	const unsigned int height = m_height;
-	const unsigned int width = m_extented_width - 2;
-	const unsigned int width_ext = m_extented_width;
-
-	memset(&m_values[0], '\xFF', width_ext * sizeof(dataType));
-	for (unsigned i = 1; i < 1 + height; ++i) {
-		m_values[i * width_ext] = -1;
-		memset(&m_values[i * width_ext + 1], '\0', width * sizeof(dataType));
-		m_values[i * width_ext + width + 1] = -1;
+	++m_buffer->Generation;
+
+	if (m_buffer->Generation == TerrainTraversalBorderStamp) {
+		//the generation counter wrapped around, so reset the stamps of everything but the border
+		for (unsigned int &stamp : m_buffer->Stamps) {
+			if (stamp != TerrainTraversalBorderStamp) {
+				stamp = 0;
+			}
+		}
+		m_buffer->Generation = 1;
 	}
-	memset(&m_values[(height + 1) * width_ext], '\xFF', width_ext * sizeof(dataType));
+
+	m_buffer->Frontier.clear();
+	m_buffer->FrontierHead = 0;
 }
 
 void TerrainTraversal::PushPos(const Vec2i &pos)
 {
 	if (IsVisited(pos) == false) {
-		m_queue.push(PosNode(pos, pos));
+		m_buffer->Frontier.push_back(PosNode(pos, pos));
 		Set(pos, 1);
 	}
 }
@@ -116,7 +214,7 @@ void TerrainTraversal::PushNeighbor(const Vec2i &pos)
 		const Vec2i newPos = pos + offsets[i];
 
 		if (IsVisited(newPos) == false) {
-			m_queue.push(PosNode(newPos, pos));
+			m_buffer->Frontier.push_back(PosNode(newPos, pos));
 			Set(newPos, Get(pos) + 1);
 		}
 	}
@@ -161,12 +259,15 @@ bool TerrainTraversal::IsInvalid(const Vec2i &pos) const
 
 TerrainTraversal::dataType TerrainTraversal::Get(const Vec2i &pos) const
 {
-	return m_values[m_extented_width + 1 + pos.y * m_extented_width + pos.x];
+	const unsigned int index = m_buffer->ExtendedWidth + 1 + pos.y * m_buffer->ExtendedWidth + pos.x;
+	return m_buffer->Stamps[index] >= m_buffer->Generation ? m_buffer->Values[index] : 0;
 }
 
 void TerrainTraversal::Set(const Vec2i &pos, TerrainTraversal::dataType value)
 {
-	m_values[m_extented_width + 1 + pos.y * m_extented_width + pos.x] = value;
+	const unsigned int index = m_buffer->ExtendedWidth + 1 + pos.y * m_buffer->ExtendedWidth + pos.x;
+	m_buffer->Stamps[index] = m_buffer->Generation;
+	m_buffer->Values[index] = value;
 }
 
 /*----------------------------------------------------------------------------
@@ -182,6 +283,8 @@ void InitPathfinder()
 //	InitAStar(Map.Info.MapWidth, Map.Info.MapHeight);
 	InitAStar();
 	//Wyrmgus end
+
+	stratagus::path_cluster_graph::clear_all();
 }
 
 /**
@@ -190,6 +293,21 @@ void InitPathfinder()
 void FreePathfinder()
 {
 	FreeAStar();
+
+	TerrainTraversal::ReleaseFreeBuffers();
+
+	stratagus::path_cluster_graph::clear_all();
+}
+
+/**
+**  Notify the pathfinder that the passability of a tile may have changed
+**
+**  @param pos  Map tile position.
+**  @param z    Map layer of the tile.
+*/
+void PathfinderTileChanged(const Vec2i &pos, int z)
+{
+	stratagus::path_cluster_graph::on_tile_changed(pos, z);
 }
 
 /*----------------------------------------------------------------------------
@@ -224,9 +224,9 @@ void Spell_AdjustVariable::ProcessConfigData(const CConfigData *config_data)
 
 		// Increase field
 		if (this->Var[i].ModifIncrease) {
-			unit->Variable[i].Increase = this->Var[i].Increase;
+			unit->set_variable_increase(i, this->Var[i].Increase);
 		}
-		unit->Variable[i].Increase += this->Var[i].AddIncrease;
+		unit->change_variable_increase(i, this->Var[i].AddIncrease);
 
 		// Value field
 		if (this->Var[i].ModifValue) {
@@ -68,6 +68,7 @@ public:
 	~PImpl();
 
 	int open(const char *name, long flags);
+	int open_memory();
 	int close();
 	void flush();
 	int read(void *buf, size_t len);
@@ -75,6 +76,11 @@ public:
 	long tell();
 	int write(const void *buf, size_t len);
 
+	const std::string &get_memory_buffer() const
+	{
+		return cl_memory;
+	}
+
 private:
 	PImpl(const PImpl &rhs); // No implementation
 	const PImpl &operator = (const PImpl &rhs); // No implementation
@@ -91,6 +97,7 @@ private:
 #ifdef USE_PHYSFS
 	PHYSFS_File *cl_pf;
 #endif
+	std::string cl_memory; /// in-memory buffer
 };
 
 CFile::CFile() : pimpl(new CFile::PImpl)
@@ -116,6 +123,19 @@ int CFile::open(const char *name, long flags)
 	return pimpl->open(name, flags);
 }
 
+/**
+**  Open an in-memory buffer for writing
+**
+**  The written data can be retrieved with get_memory_buffer, until the
+**  file is opened again.
+**
+**  @return 0
+*/
+int CFile::open_memory()
+{
+	return pimpl->open_memory();
+}
+
 /**
 **  CLclose Library file close
 */
@@ -159,6 +179,25 @@ long CFile::tell()
 	return pimpl->tell();
 }
 
+/**
+**  CLwrite Library file write
+**
+**  @param buf  Pointer to the data to write.
+**  @param len  number of bytes to write.
+*/
+int CFile::write(const void *buf, size_t len)
+{
+	return pimpl->write(buf, len);
+}
+
+/**
+**  Get the data written to an in-memory file
+*/
+const std::string &CFile::get_memory_buffer() const
+{
+	return pimpl->get_memory_buffer();
+}
+
 /**
 **  CLprintf Library file write
 **
@@ -366,6 +405,13 @@ int CFile::PImpl::open(const char *name, long openflags)
 	return 0;
 }
 
+int CFile::PImpl::open_memory()
+{
+	cl_memory.clear();
+	cl_type = CLF_TYPE_MEMORY;
+	return 0;
+}
+
 int CFile::PImpl::close()
 {
 	int ret = EOF;
@@ -375,6 +421,9 @@ int CFile::PImpl::close()
 		if (tp == CLF_TYPE_PLAIN) {
 			ret = fclose(cl_plain);
 		}
+		if (tp == CLF_TYPE_MEMORY) {
+			ret = 0;
+		}
 #ifdef USE_ZLIB
 		if (tp == CLF_TYPE_GZIP) {
 			ret = gzclose(cl_gz);
@@ -406,6 +455,10 @@ int CFile::PImpl::read(void *buf, size_t len)
 		if (cl_type == CLF_TYPE_PLAIN) {
 			ret = fread(buf, 1, len, cl_plain);
 		}
+		if (cl_type == CLF_TYPE_MEMORY) {
+			errno = EBADF; // write-only
+			ret = -1;
+		}
 #ifdef USE_ZLIB
 		if (cl_type == CLF_TYPE_GZIP) {
 			ret = gzread(cl_gz, buf, len);
@@ -457,6 +510,10 @@ int CFile::PImpl::write(const void *buf, size_t size)
 		if (tp == CLF_TYPE_PLAIN) {
 			ret = fwrite(buf, size, 1, cl_plain);
 		}
+		if (tp == CLF_TYPE_MEMORY) {
+			cl_memory.append(static_cast<const char *>(buf), size);
+			ret = static_cast<int>(size);
+		}
 #ifdef USE_ZLIB
 		if (tp == CLF_TYPE_GZIP) {
 			ret = gzwrite(cl_gz, buf, size);
@@ -513,6 +570,9 @@ long CFile::PImpl::tell()
 		if (tp == CLF_TYPE_PLAIN) {
 			ret = ftell(cl_plain);
 		}
+		if (tp == CLF_TYPE_MEMORY) {
+			ret = static_cast<long>(cl_memory.size());
+		}
 #ifdef USE_ZLIB
 		if (tp == CLF_TYPE_GZIP) {
 			ret = gztell(cl_gz);
@@ -46,6 +46,7 @@
 #include "font.h"
 //Wyrmgus end
 #include "game.h"
+#include "game/benchmark.h"
 //Wyrmgus start
 #include "grand_strategy.h"
 #include "luacallback.h"
@@ -80,6 +81,7 @@
 //Wyrmgus start
 #include "unit/unit_manager.h"
 #include "upgrade/upgrade.h"
+#include "util/profiler.h"
 //Wyrmgus end
 #include "video.h"
 #include "world.h"
@@ -208,6 +210,29 @@ void DrawMapArea()
 	}
 }
 
+/**
+**	@brief	Draw the time spent in each profiler zone over the last frames, over the map area
+*/
+static void DrawProfilerSummary()
+{
+	static constexpr size_t max_summary_entries = 16;
+
+	const std::vector<stratagus::profiler::summary_entry> summary = stratagus::profiler::get()->get_summary();
+
+	CLabel label(GetSmallFont());
+	const int x = UI.MapArea.X + 4;
+	int y = UI.MapArea.Y + 4;
+
+	for (size_t i = 0; i < summary.size() && i < max_summary_entries; ++i) {
+		const stratagus::profiler::summary_entry &entry = summary[i];
+
+		char buf[256];
+		snprintf(buf, sizeof(buf), "%.*s: %.2f ms (max %.2f ms)", static_cast<int>(entry.name.size()), entry.name.data(), entry.mean_milliseconds, entry.max_milliseconds);
+		label.Draw(x, y, buf);
+		y += label.Height();
+	}
+}
+
 /**
 **  Display update.
 **
@@ -216,6 +241,8 @@ void DrawMapArea()
 */
 void UpdateDisplay()
 {
+	const stratagus::profile_zone profile("UpdateDisplay");
+
 	if (GameRunning || Editor.Running == EditorEditing) {
 		// to prevent empty spaces in the UI
 #if defined(USE_OPENGL) || defined(USE_GLES)
@@ -292,6 +319,10 @@ void UpdateDisplay()
 		
 		DrawPopups();
 		//Wyrmgus end
+
+		if (stratagus::profiler::is_enabled()) {
+			DrawProfilerSummary();
+		}
 	}
 
 	DrawPieMenu(); // draw pie menu only if needed
@@ -317,6 +348,8 @@ static void InitGameCallbacks()
 
 static void GameLogicLoop()
 {
+	const stratagus::profile_zone profile("GameLogicLoop");
+
 	// Can't find a better place.
 	// FIXME: We need to find a better place!
 	SaveGameLoading = false;
@@ -335,16 +368,40 @@ static void GameLogicLoop()
 		SinglePlayerReplayEachCycle();
 		++GameCycle;
 		MultiPlayerReplayEachCycle();
-		NetworkCommands(); // Get network commands
-		TriggersEachCycle();// handle triggers
-		UnitActions();      // handle units
-		MissileActions();   // handle missiles
-		PlayersEachCycle(); // handle players
+
+		{
+			const stratagus::profile_zone profile("NetworkCommands");
+			NetworkCommands(); // Get network commands
+		}
+
+		{
+			const stratagus::profile_zone profile("TriggersEachCycle");
+			TriggersEachCycle();// handle triggers
+		}
+
+		{
+			const stratagus::profile_zone profile("UnitActions");
+			UnitActions();      // handle units
+		}
+
+		{
+			const stratagus::profile_zone profile("MissileActions");
+			MissileActions();   // handle missiles
+		}
+
+		{
+			const stratagus::profile_zone profile("PlayersEachCycle");
+			PlayersEachCycle(); // handle players
+		}
+
 		UpdateTimer();      // update game timer
 
-		for (size_t z = 0; z < CMap::Map.MapLayers.size(); ++z) {
-			CMapLayer *map_layer = CMap::Map.MapLayers[z];
-			map_layer->DoPerCycleLoop();
+		{
+			const stratagus::profile_zone profile("MapLayerPerCycleLoop");
+			for (size_t z = 0; z < CMap::Map.MapLayers.size(); ++z) {
+				CMapLayer *map_layer = CMap::Map.MapLayers[z];
+				map_layer->DoPerCycleLoop();
+			}
 		}
 		
 		//
@@ -398,6 +455,7 @@ static void GameLogicLoop()
 		int player = (GameCycle - 1) % CYCLES_PER_SECOND;
 		Assert(player >= 0);
 		if (player < NumPlayers) {
+			const stratagus::profile_zone profile("PlayersEachSecond");
 			PlayersEachSecond(player);
 			if ((player + CYCLES_PER_SECOND) < NumPlayers) {
 				PlayersEachSecond(player + CYCLES_PER_SECOND);
@@ -407,12 +465,14 @@ static void GameLogicLoop()
 		player = (GameCycle - 1) % (CYCLES_PER_MINUTE / 2);
 		Assert(player >= 0);
 		if (player < NumPlayers) {
+			const stratagus::profile_zone profile("PlayersEachHalfMinute");
 			PlayersEachHalfMinute(player);
 		}
 
 		player = (GameCycle - 1) % CYCLES_PER_MINUTE;
 		Assert(player >= 0);
 		if (player < NumPlayers) {
+			const stratagus::profile_zone profile("PlayersEachMinute");
 			PlayersEachMinute(player);
 		}
 		//Wyrmgus end
@@ -425,16 +485,18 @@ static void GameLogicLoop()
 			UI.StatusLine.Set(_("Autosave"));
 			//Wyrmgus start
 //			SaveGame("autosave.sav");
-			CclCommand("if (RunSaveGame ~= nil) then RunSaveGame(\"autosave.sav\") end;");
+			SaveGameInBackground("autosave.sav");
 			//Wyrmgus end
 		}
 	}
 
+	UpdateBackgroundSaveGame(); // report the autosave's result once it has been written
 	UpdateMessages();     // update messages
 	ParticleManager.update(); // handle particles
 	CheckMusicFinished(); // Check for next song
 
-	if (FastForwardCycle <= GameCycle || !(GameCycle & 0x3f)) {
+	//the benchmark runs the game as fast as possible, without waiting for real time
+	if (!stratagus::benchmark::get()->is_enabled() && (FastForwardCycle <= GameCycle || !(GameCycle & 0x3f))) {
 		WaitEventsOneFrame();
 	}
 
@@ -450,6 +512,13 @@ static	int RealVideoSyncSpeed;
 
 static void DisplayLoop()
 {
+	const stratagus::profile_zone profile("DisplayLoop");
+
+#if defined(USE_OPENGL) || defined(USE_GLES)
+	//make the textures which have been prepared in the background for the upcoming time of day
+	MakePreparedTextures();
+#endif
+
 	/* update only if screen changed */
 	ValidateOpenGLScreen();
 
@@ -461,6 +530,7 @@ static void DisplayLoop()
 	 *	FIXME: still not secure
 	 */
 	if (UI.Minimap.UpdateCache) {
+		const stratagus::profile_zone profile("MinimapUpdate");
 		UI.Minimap.Update();
 		UI.Minimap.UpdateCache = false;
 	}
@@ -496,11 +566,44 @@ static void DisplayLoop()
 #endif
 }
 
+/**
+**	@brief	Run the game logic for the benchmark, without updating the display, and measure the time taken by each cycle
+*/
+static void BenchmarkGameLoop()
+{
+	stratagus::benchmark *benchmark = stratagus::benchmark::get();
+	benchmark->start_game();
+
+	while (GameRunning && !benchmark->is_finished()) {
+		const std::chrono::steady_clock::time_point cycle_start_time = std::chrono::steady_clock::now();
+		GameLogicLoop();
+		benchmark->add_cycle_duration(std::chrono::steady_clock::now() - cycle_start_time);
+
+		if (stratagus::profiler::is_enabled()) {
+			stratagus::profiler::get()->end_frame();
+		}
+	}
+
+	benchmark->print_results();
+
+	//exit once the benchmark is done, even if the game ended before reaching its cycle count
+	StopGame(GameExit);
+}
+
 static void SingleGameLoop()
 {
+	if (stratagus::benchmark::get()->is_enabled()) {
+		BenchmarkGameLoop();
+		return;
+	}
+
 	while (GameRunning) {
 		DisplayLoop();
 		GameLogicLoop();
+
+		if (stratagus::profiler::is_enabled()) {
+			stratagus::profiler::get()->end_frame();
+		}
 	}
 }
 
@@ -511,6 +511,7 @@ void CleanPlayers()
 {
 	CPlayer::SetThisPlayer(nullptr);
 	CPlayer::revealed_players.clear();
+	CPlayer::revealed_player_mask = 0;
 	for (unsigned int i = 0; i < PlayerMax; ++i) {
 		CPlayer::Players[i]->Clear();
 	}
@@ -590,8 +591,10 @@ void CPlayer::set_revealed(const bool revealed)
 
 	if (revealed) {
 		CPlayer::revealed_players.push_back(this);
+		CPlayer::revealed_player_mask |= 1u << this->Index;
 	} else {
 		stratagus::vector::remove(CPlayer::revealed_players, this);
+		CPlayer::revealed_player_mask &= ~(1u << this->Index);
 	}
 }
 
@@ -1585,13 +1588,18 @@ int CPlayer::get_player_color_usage_count(const stratagus::player_color *player_
 
 void CPlayer::update_minimap_territory()
 {
-	for (const auto &kv_pair : this->UnitsByType) {
-		const stratagus::unit_type *unit_type = kv_pair.first;
+	for (size_t i = 0; i < this->UnitsByType.size(); ++i) {
+		const std::vector<CUnit *> &type_units = this->UnitsByType[i];
+		if (type_units.empty()) {
+			continue;
+		}
+
+		const stratagus::unit_type *unit_type = stratagus::unit_type::get_all()[i];
 		if (!unit_type->BoolFlag[TOWNHALL_INDEX].value) {
 			continue;
 		}
 
-		for (const CUnit *town_hall : kv_pair.second) {
+		for (const CUnit *town_hall : type_units) {
 			town_hall->settlement->update_minimap_territory();
 		}
 	}
@@ -2032,8 +2040,12 @@ std::vector<const CUpgrade *> CPlayer::GetResearchableUpgrades()
 {
 	std::vector<const CUpgrade *> researchable_upgrades;
 
-	for (const auto &kv_pair : this->UnitTypesAiActiveCount) {
-		const stratagus::unit_type *type = kv_pair.first;
+	for (size_t i = 0; i < this->UnitTypesAiActiveCount.size(); ++i) {
+		if (this->UnitTypesAiActiveCount[i] == 0) {
+			continue;
+		}
+
+		const stratagus::unit_type *type = stratagus::unit_type::get_all()[i];
 
 		for (const CUpgrade *upgrade : AiHelpers.get_researched_upgrades(type)) {
 			if (!stratagus::vector::contains(researchable_upgrades, upgrade)) {
@@ -2079,6 +2091,7 @@ void CPlayer::Clear()
 	this->Enemy = 0;
 	this->Allied = 0;
 	this->shared_vision.clear();
+	CPlayer::update_mutual_shared_vision_masks();
 	this->StartPos.x = 0;
 	this->StartPos.y = 0;
 	//Wyrmgus start
@@ -3487,48 +3500,103 @@ int CPlayer::GetUpgradeCostsMask(const CUpgrade *upgrade) const
 
 //Wyrmgus end
 
-void CPlayer::SetUnitTypeCount(const stratagus::unit_type *type, int quantity)
+static void set_unit_type_quantity(std::vector<int> &quantities, const stratagus::unit_type *type, const int quantity)
 {
 	if (!type) {
 		return;
 	}
-	
-	if (quantity <= 0) {
-		if (this->UnitTypesCount.find(type) != this->UnitTypesCount.end()) {
-			this->UnitTypesCount.erase(type);
+
+	const size_t slot = static_cast<size_t>(type->Slot);
+
+	if (slot >= quantities.size()) {
+		if (quantity <= 0) {
+			return;
 		}
-	} else {
-		this->UnitTypesCount[type] = quantity;
+
+		quantities.resize(std::max(slot + 1, stratagus::unit_type::get_all().size()), 0);
 	}
+
+	quantities[slot] = std::max(quantity, 0);
 }
 
-void CPlayer::ChangeUnitTypeCount(const stratagus::unit_type *type, int quantity)
+static int get_unit_type_quantity(const std::vector<int> &quantities, const stratagus::unit_type *type)
 {
-	this->SetUnitTypeCount(type, this->GetUnitTypeCount(type) + quantity);
+	if (!type || static_cast<size_t>(type->Slot) >= quantities.size()) {
+		return 0;
+	}
+
+	return quantities[type->Slot];
 }
 
-int CPlayer::GetUnitTypeCount(const stratagus::unit_type *type) const
+/**
+**	@brief	Add a unit to the list of units of its type
+**
+**	@param	units_by_type	The unit lists, indexed by unit type slot
+**	@param	unit			The unit
+**	@param	slot_member		The member of the unit which stores its index in the list
+*/
+static void add_unit_to_type_units(std::vector<std::vector<CUnit *>> &units_by_type, CUnit *unit, size_t CUnit::*slot_member)
 {
-	if (type && this->UnitTypesCount.find(type) != this->UnitTypesCount.end()) {
-		return this->UnitTypesCount.find(type)->second;
-	} else {
-		return 0;
+	const size_t type_slot = static_cast<size_t>(unit->Type->Slot);
+
+	if (type_slot >= units_by_type.size()) {
+		units_by_type.resize(std::max(type_slot + 1, stratagus::unit_type::get_all().size()));
 	}
+
+	std::vector<CUnit *> &type_units = units_by_type[type_slot];
+	unit->*slot_member = type_units.size();
+	type_units.push_back(unit);
 }
 
-void CPlayer::SetUnitTypeUnderConstructionCount(const stratagus::unit_type *type, int quantity)
+/**
+**	@brief	Remove a unit from the list of units of its type, replacing it with the last unit of the list
+**
+**	@param	units_by_type	The unit lists, indexed by unit type slot
+**	@param	unit			The unit
+**	@param	slot_member		The member of the unit which stores its index in the list
+*/
+static void remove_unit_from_type_units(std::vector<std::vector<CUnit *>> &units_by_type, CUnit *unit, size_t CUnit::*slot_member)
 {
-	if (!type) {
+	const size_t unit_slot = unit->*slot_member;
+	if (unit_slot == static_cast<size_t>(-1)) {
 		return;
 	}
-	
-	if (quantity <= 0) {
-		if (this->UnitTypesUnderConstructionCount.find(type) != this->UnitTypesUnderConstructionCount.end()) {
-			this->UnitTypesUnderConstructionCount.erase(type);
-		}
-	} else {
-		this->UnitTypesUnderConstructionCount[type] = quantity;
+
+	const size_t type_slot = static_cast<size_t>(unit->Type->Slot);
+	if (type_slot >= units_by_type.size() || unit_slot >= units_by_type[type_slot].size()) {
+		//the lists have been cleared since the unit was added to them
+		unit->*slot_member = static_cast<size_t>(-1);
+		return;
 	}
+
+	std::vector<CUnit *> &type_units = units_by_type[type_slot];
+	Assert(type_units[unit_slot] == unit);
+
+	CUnit *last_unit = type_units.back();
+	type_units[unit_slot] = last_unit;
+	last_unit->*slot_member = unit_slot;
+	type_units.pop_back();
+	unit->*slot_member = static_cast<size_t>(-1);
+}
+
+void CPlayer::SetUnitTypeCount(const stratagus::unit_type *type, int quantity)
+{
+	set_unit_type_quantity(this->UnitTypesCount, type, quantity);
+}
+
+void CPlayer::ChangeUnitTypeCount(const stratagus::unit_type *type, int quantity)
+{
+	this->SetUnitTypeCount(type, this->GetUnitTypeCount(type) + quantity);
+}
+
+int CPlayer::GetUnitTypeCount(const stratagus::unit_type *type) const
+{
+	return get_unit_type_quantity(this->UnitTypesCount, type);
+}
+
+void CPlayer::SetUnitTypeUnderConstructionCount(const stratagus::unit_type *type, int quantity)
+{
+	set_unit_type_quantity(this->UnitTypesUnderConstructionCount, type, quantity);
 }
 
 void CPlayer::ChangeUnitTypeUnderConstructionCount(const stratagus::unit_type *type, int quantity)
@@ -3538,26 +3606,12 @@ void CPlayer::ChangeUnitTypeUnderConstructionCount(const stratagus::unit_type *t
 
 int CPlayer::GetUnitTypeUnderConstructionCount(const stratagus::unit_type *type) const
 {
-	if (type && this->UnitTypesUnderConstructionCount.find(type) != this->UnitTypesUnderConstructionCount.end()) {
-		return this->UnitTypesUnderConstructionCount.find(type)->second;
-	} else {
-		return 0;
-	}
+	return get_unit_type_quantity(this->UnitTypesUnderConstructionCount, type);
 }
 
 void CPlayer::SetUnitTypeAiActiveCount(const stratagus::unit_type *type, int quantity)
 {
-	if (!type) {
-		return;
-	}
-	
-	if (quantity <= 0) {
-		if (this->UnitTypesAiActiveCount.find(type) != this->UnitTypesAiActiveCount.end()) {
-			this->UnitTypesAiActiveCount.erase(type);
-		}
-	} else {
-		this->UnitTypesAiActiveCount[type] = quantity;
-	}
+	set_unit_type_quantity(this->UnitTypesAiActiveCount, type, quantity);
 }
 
 void CPlayer::ChangeUnitTypeAiActiveCount(const stratagus::unit_type *type, int quantity)
@@ -3567,11 +3621,29 @@ void CPlayer::ChangeUnitTypeAiActiveCount(const stratagus::unit_type *type, int
 
 int CPlayer::GetUnitTypeAiActiveCount(const stratagus::unit_type *type) const
 {
-	if (type && this->UnitTypesAiActiveCount.find(type) != this->UnitTypesAiActiveCount.end()) {
-		return this->UnitTypesAiActiveCount.find(type)->second;
-	} else {
-		return 0;
+	return get_unit_type_quantity(this->UnitTypesAiActiveCount, type);
+}
+
+const std::vector<CUnit *> &CPlayer::GetUnitsByType(const stratagus::unit_type *type) const
+{
+	static const std::vector<CUnit *> empty_vector;
+
+	if (!type || static_cast<size_t>(type->Slot) >= this->UnitsByType.size()) {
+		return empty_vector;
+	}
+
+	return this->UnitsByType[type->Slot];
+}
+
+const std::vector<CUnit *> &CPlayer::GetAiActiveUnitsByType(const stratagus::unit_type *type) const
+{
+	static const std::vector<CUnit *> empty_vector;
+
+	if (!type || static_cast<size_t>(type->Slot) >= this->AiActiveUnitsByType.size()) {
+		return empty_vector;
 	}
+
+	return this->AiActiveUnitsByType[type->Slot];
 }
 
 void CPlayer::IncreaseCountsForUnit(CUnit *unit, bool type_change)
@@ -3579,11 +3651,11 @@ void CPlayer::IncreaseCountsForUnit(CUnit *unit, bool type_change)
 	const stratagus::unit_type *type = unit->Type;
 
 	this->ChangeUnitTypeCount(type, 1);
-	this->UnitsByType[type].push_back(unit);
+	add_unit_to_type_units(this->UnitsByType, unit, &CUnit::PlayerTypeSlot);
 	
 	if (unit->Active) {
 		this->ChangeUnitTypeAiActiveCount(type, 1);
-		this->AiActiveUnitsByType[type].push_back(unit);
+		add_unit_to_type_units(this->AiActiveUnitsByType, unit, &CUnit::PlayerAiActiveTypeSlot);
 	}
 
 	if (type->BoolFlag[TOWNHALL_INDEX].value) {
@@ -3611,21 +3683,14 @@ void CPlayer::DecreaseCountsForUnit(CUnit *unit, bool type_change)
 
 	this->ChangeUnitTypeCount(type, -1);
 	
-	stratagus::vector::remove(this->UnitsByType[type], unit);
-			
-	if (this->UnitsByType[type].empty()) {
-		this->UnitsByType.erase(type);
-	}
+	remove_unit_from_type_units(this->UnitsByType, unit, &CUnit::PlayerTypeSlot);
 	
 	if (unit->Active) {
 		this->ChangeUnitTypeAiActiveCount(type, -1);
-		
-		stratagus::vector::remove(this->AiActiveUnitsByType[type], unit);
-		
-		if (this->AiActiveUnitsByType[type].empty()) {
-			this->AiActiveUnitsByType.erase(type);
-		}
 	}
+
+	//remove the unit from the AI active list whenever it is in it, even if its AI has been deactivated in the meantime, so that the list does not keep units which are no longer owned by the player
+	remove_unit_from_type_units(this->AiActiveUnitsByType, unit, &CUnit::PlayerAiActiveTypeSlot);
 	
 	if (type->BoolFlag[TOWNHALL_INDEX].value) {
 		this->NumTownHalls--;
@@ -3662,13 +3727,18 @@ int CPlayer::get_population() const
 {
 	int people_count = 0;
 
-	for (const auto &kv_pair : this->UnitTypesCount) {
-		const stratagus::unit_type *unit_type = kv_pair.first;
+	for (size_t i = 0; i < this->UnitTypesCount.size(); ++i) {
+		const int unit_type_count = this->UnitTypesCount[i];
+		if (unit_type_count == 0) {
+			continue;
+		}
+
+		const stratagus::unit_type *unit_type = stratagus::unit_type::get_all()[i];
 		if (!unit_type->BoolFlag[ORGANIC_INDEX].value || unit_type->BoolFlag[FAUNA_INDEX].value) {
 			continue;
 		}
 
-		people_count += kv_pair.second;
+		people_count += unit_type_count;
 	}
 
 	return static_cast<int>(pow(people_count, 2)) * stratagus::base_population_per_unit;
@@ -3945,6 +4015,7 @@ void CPlayer::SetDiplomacyCrazyWith(const CPlayer &player)
 void CPlayer::ShareVisionWith(const CPlayer &player)
 {
 	this->shared_vision.insert(player.Index);
+	CPlayer::update_mutual_shared_vision_masks();
 	
 	if (GameCycle > 0 && player.Index == CPlayer::GetThisPlayer()->Index) {
 		CPlayer::GetThisPlayer()->Notify(_("%s is now sharing vision with us"), _(this->Name.c_str()));
@@ -3954,6 +4025,7 @@ void CPlayer::ShareVisionWith(const CPlayer &player)
 void CPlayer::UnshareVisionWith(const CPlayer &player)
 {
 	this->shared_vision.erase(player.Index);
+	CPlayer::update_mutual_shared_vision_masks();
 	
 	if (GameCycle > 0 && player.Index == CPlayer::GetThisPlayer()->Index) {
 		CPlayer::GetThisPlayer()->Notify(_("%s is no longer sharing vision with us"), _(this->Name.c_str()));
@@ -4119,6 +4191,29 @@ bool CPlayer::has_mutual_shared_vision_with(const CPlayer &player) const
 	return this->shared_vision.contains(player.Index) && player.shared_vision.contains(this->Index);
 }
 
+/**
+**  Recalculate the mutual shared vision masks of all players
+**
+**  Must be called whenever the shared vision of any player changes, since mutual shared vision depends on both players.
+*/
+void CPlayer::update_mutual_shared_vision_masks()
+{
+	for (CPlayer *player : CPlayer::Players) {
+		if (player == nullptr) {
+			continue;
+		}
+
+		player->mutual_shared_vision_mask = 0;
+
+		for (const int other_player_index : player->shared_vision) {
+			const CPlayer *other_player = CPlayer::Players[other_player_index];
+			if (other_player != nullptr && other_player->shared_vision.contains(player->Index)) {
+				player->mutual_shared_vision_mask |= 1u << other_player_index;
+			}
+		}
+	}
+}
+
 /**
 **  Check if the player and the unit share vision
 */
@@ -191,7 +191,7 @@ int LuaCall(int narg, int clear, bool exitOnError)
 /**
 **  Get the (uncompressed) content of the file into a string
 */
-static bool GetFileContent(const std::string &file, std::string &content)
+bool GetFileContent(const std::string &file, std::string &content)
 {
 	CFile fp;
 
@@ -235,7 +235,21 @@ int LuaLoadFile(const std::string &file, const std::string &strArg)
 	if (GetFileContent(file, content) == false) {
 		return -1;
 	}
-	const int status = luaL_loadbuffer(Lua, content.c_str(), content.size(), file.c_str());
+
+	return LuaLoadBuffer(content, file, strArg);
+}
+
+/**
+**  Execute Lua code from a buffer
+**
+**  @param buffer  The Lua code to execute
+**  @param name    Name of the chunk, used in error messages
+**
+**  @return        0 for success, else exit.
+*/
+int LuaLoadBuffer(const std::string_view &buffer, const std::string &name, const std::string &strArg)
+{
+	const int status = luaL_loadbuffer(Lua, buffer.data(), buffer.size(), name.c_str());
 
 	if (!status) {
 		if (!strArg.empty()) {
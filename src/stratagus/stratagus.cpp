@@ -181,6 +181,7 @@ extern void beos_init(int argc, char **argv);
 #include "database/preferences.h"
 #include "editor.h"
 #include "game.h"
+#include "game/benchmark.h"
 #include "guichan.h"
 #include "iocompat.h"
 #include "iolib.h"
@@ -206,6 +207,7 @@ extern void beos_init(int argc, char **argv);
 #include "video.h"
 #include "widgets.h"
 #include "util/exception_util.h"
+#include "util/profiler.h"
 #include "util/util.h"
 
 #include "missile.h" //for FreeBurningBuildingFrames
@@ -397,6 +399,14 @@ void Exit(int err)
 		return;
 	}
 	
+	if (stratagus::profiler::is_enabled()) {
+		try {
+			stratagus::profiler::get()->export_chrome_trace(std::filesystem::path(Parameters::Instance.GetUserDirectory()) / "profile_trace.json");
+		} catch (const std::exception &exception) {
+			stratagus::exception::report(exception);
+		}
+	}
+
 	StopMusic();
 	QuitSound();
 	NetworkQuitGame();
@@ -447,6 +457,7 @@ static void Usage()
 	printf(
 		"\n\nUsage: %s [OPTIONS] [map.smp|map.smp.gz]\n"
 		"\t-a\t\tEnables asserts check in engine code (for debugging)\n"
+		"\t-B cycles\tRun the given map or saved game for a number of cycles without sound or display updates, and print the cycle timings and sync hash\n"
 		"\t-c file.lua\tConfiguration start file (default stratagus.lua)\n"
 		"\t-d datapath\tPath to stratagus data (default current directory)\n"
 		"\t-D depth\tVideo mode depth = pixel per point\n"
@@ -467,6 +478,7 @@ static void Usage()
 		"\t-P port\t\tNetwork port to use\n"
 		"\t-s sleep\tNumber of frames for the AI to sleep before it starts\n"
 		"\t-S speed\tSync speed (100 = 30 frames/s)\n"
+		"\t-t\t\tEnables the profiler, showing a summary in-game and writing a Chrome trace to the user path on exit\n"
 		"\t-u userpath\tPath where stratagus saves preferences, log and savegame\n"
 		"\t-v mode\t\tVideo mode resolution in format <xres>x<yres>\n"
 		"\t-W\t\tWindowed video mode\n"
@@ -522,10 +534,13 @@ static void RedirectOutput()
 void ParseCommandLine(int argc, char **argv, Parameters &parameters)
 {
 	for (;;) {
-		switch (getopt(argc, argv, "ac:d:D:eE:FG:hiI:lN:oOP:ps:S:u:v:Wx:Z?-")) {
+		switch (getopt(argc, argv, "aB:c:d:D:eE:FG:hiI:lN:oOP:ps:S:tu:v:Wx:Z?-")) {
 			case 'a':
 				EnableAssert = true;
 				continue;
+			case 'B':
+				stratagus::benchmark::get()->set_cycle_count(strtoul(optarg, nullptr, 10));
+				continue;
 			case 'c':
 				parameters.luaStartFilename = optarg;
 				if (strlen(optarg) > 4 &&
@@ -581,6 +596,9 @@ void ParseCommandLine(int argc, char **argv, Parameters &parameters)
 			case 'S':
 				VideoSyncSpeed = atoi(optarg);
 				continue;
+			case 't':
+				stratagus::profiler::set_enabled(true);
+				continue;
 			case 'u':
 				Parameters::Instance.SetUserDirectory(optarg);
 				continue;
@@ -656,6 +674,12 @@ void ParseCommandLine(int argc, char **argv, Parameters &parameters)
 			CliMapName[index] = '/';
 		}
 	}
+
+	if (stratagus::benchmark::get()->is_enabled() && CliMapName.empty()) {
+		fprintf(stderr, "the benchmark requires a map or saved game to be given\n");
+		Usage();
+		ExitFatal(-1);
+	}
 }
 
 #ifdef USE_WIN32
@@ -755,8 +779,8 @@ int stratagusMain(int argc, char **argv)
 	// Setup video display
 	InitVideo();
 
-	// Setup sound card
-	if (!InitSound()) {
+	// Setup sound card, unless running the benchmark
+	if (!stratagus::benchmark::get()->is_enabled() && !InitSound()) {
 		InitMusic();
 	}
 
@@ -781,6 +805,12 @@ int stratagusMain(int argc, char **argv)
 	UnitManager.Init();	// Units memory management
 	PreMenuSetup();		// Load everything needed for menus
 
+	if (stratagus::benchmark::get()->is_enabled()) {
+		//run the benchmark instead of showing the menus; the game exits when the benchmark is done
+		initGuichan();
+		stratagus::benchmark::get()->run(CliMapName);
+	}
+
 	MenuLoop();
 
 	Exit(0);
@@ -41,6 +41,8 @@
 #include "util/geojson_util.h"
 #include "util/vector_util.h"
 
+#include <QCryptographicHash>
+
 namespace stratagus {
 
 world *world::add(const std::string &identifier, const stratagus::module *module)
@@ -106,6 +108,54 @@ std::vector<QVariantList> world::parse_geojson_folder(const std::string_view &fo
 	return geojson_data_list;
 }
 
+/**
+**	@brief	Get a hash of the GeoJSON files in a map folder of the world
+**
+**	The hash covers the relative paths and contents of the files, so that it changes whenever the geodata parsed from the folder could change.
+**
+**	@param	folder	The map folder
+**
+**	@return	The hash
+*/
+QByteArray world::get_geojson_folder_hash(const std::string_view &folder) const
+{
+	QCryptographicHash hash(QCryptographicHash::Sha1);
+
+	for (const std::filesystem::path &path : database::get()->get_maps_paths()) {
+		const std::filesystem::path map_path = path / this->get_identifier() / folder;
+
+		if (!std::filesystem::exists(map_path)) {
+			continue;
+		}
+
+		std::vector<std::filesystem::path> filepaths;
+		for (const std::filesystem::directory_entry &dir_entry : std::filesystem::recursive_directory_iterator(map_path)) {
+			if (dir_entry.is_regular_file() && dir_entry.path().extension() == ".geojson") {
+				filepaths.push_back(dir_entry.path());
+			}
+		}
+
+		//sort the files, as the order of directory iteration is unspecified
+		std::sort(filepaths.begin(), filepaths.end());
+
+		for (const std::filesystem::path &filepath : filepaths) {
+			std::ifstream ifstream(filepath, std::ios::binary);
+
+			if (!ifstream) {
+				throw std::runtime_error("Failed to open file: " + filepath.string());
+			}
+
+			const std::string file_content(std::istreambuf_iterator<char>{ifstream}, std::istreambuf_iterator<char>{});
+
+			hash.addData(QByteArray::fromStdString(filepath.lexically_relative(path).generic_string()));
+			hash.addData(QByteArray::number(static_cast<qulonglong>(file_content.size())));
+			hash.addData(file_content.data(), static_cast<int>(file_content.size()));
+		}
+	}
+
+	return hash.result();
+}
+
 terrain_geodata_map world::parse_terrain_geojson_folder() const
 {
 	terrain_geodata_map terrain_data;
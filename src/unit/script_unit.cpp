@@ -756,6 +756,8 @@ static int CclUnit(lua_State *l)
 		UpdateForNewUnit(*unit, 0);
 	}
 
+	unit->update_increasing_variables();
+
 	//  Revealers are units that can see while removed
 	if (unit->Removed && unit->Type->BoolFlag[REVEALER_INDEX].value) {
 		MapMarkUnitSight(*unit);
@@ -1894,7 +1896,7 @@ static int CclSetUnitVariable(lua_State *l)
 	//Wyrmgus end
 	} else if (!strcmp(name, "RegenerationRate")) {
 		value = LuaToNumber(l, 3);
-		unit->Variable[HP_INDEX].Increase = std::min(unit->Variable[HP_INDEX].Max, value);
+		unit->set_variable_increase(HP_INDEX, std::min(unit->Variable[HP_INDEX].Max, value));
 	} else if (!strcmp(name, "IndividualUpgrade")) {
 		LuaCheckArgs(l, 4);
 		std::string upgrade_ident = LuaToString(l, 3);
@@ -2029,7 +2031,7 @@ static int CclSetUnitVariable(lua_State *l)
 			} else if (!strcmp(type, "Max")) {
 				unit->Variable[index].Max = value;
 			} else if (!strcmp(type, "Increase")) {
-				unit->Variable[index].Increase = value;
+				unit->set_variable_increase(index, value);
 			} else if (!strcmp(type, "Enable")) {
 				unit->Variable[index].Enable = value;
 			} else {
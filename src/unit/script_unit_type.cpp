@@ -679,8 +679,8 @@ static int CclDefineUnitType(lua_State *l)
 			const stratagus::unit_type *parent_type = stratagus::unit_type::get(parent_ident);
 			type->set_parent(parent_type);
 		} else if (!strcmp(value, "Variations")) {
-			type->DefaultStat.Variables[VARIATION_INDEX].Enable = 1;
-			type->DefaultStat.Variables[VARIATION_INDEX].Value = 0;
+			type->DefaultStat.Variables.get_mutable()[VARIATION_INDEX].Enable = 1;
+			type->DefaultStat.Variables.get_mutable()[VARIATION_INDEX].Value = 0;
 			//remove previously defined variations, if any
 			type->variations.clear();
 			//remove previously defined layer variations, if any
@@ -815,7 +815,7 @@ static int CclDefineUnitType(lua_State *l)
 				lua_pop(l, 1);
 			}
 			
-			type->DefaultStat.Variables[VARIATION_INDEX].Max = type->variations.size();
+			type->DefaultStat.Variables.get_mutable()[VARIATION_INDEX].Max = type->variations.size();
 		//Wyrmgus end
 		} else if (!strcmp(value, "Image")) {
 			if (!lua_istable(l, -1)) {
@@ -1046,8 +1046,8 @@ static int CclDefineUnitType(lua_State *l)
 		} else if (!strcmp(value, "MaxOnBoard")) {
 			type->MaxOnBoard = LuaToNumber(l, -1);
 			//Wyrmgus start
-			type->DefaultStat.Variables[TRANSPORT_INDEX].Max = type->MaxOnBoard;
-			type->DefaultStat.Variables[TRANSPORT_INDEX].Enable = 1;
+			type->DefaultStat.Variables.get_mutable()[TRANSPORT_INDEX].Max = type->MaxOnBoard;
+			type->DefaultStat.Variables.get_mutable()[TRANSPORT_INDEX].Enable = 1;
 			//Wyrmgus end
 		} else if (!strcmp(value, "BoardSize")) {
 			type->BoardSize = LuaToNumber(l, -1);
@@ -1092,7 +1092,7 @@ static int CclDefineUnitType(lua_State *l)
 			}
 		//Wyrmgus end
 		} else if (!strcmp(value, "RegenerationRate")) {
-			type->DefaultStat.Variables[HP_INDEX].Increase = LuaToNumber(l, -1);
+			type->DefaultStat.Variables.get_mutable()[HP_INDEX].Increase = LuaToNumber(l, -1);
 		} else if (!strcmp(value, "BurnPercent")) {
 			type->BurnPercent = LuaToNumber(l, -1);
 		} else if (!strcmp(value, "BurnDamageRate")) {
@@ -1101,12 +1101,12 @@ static int CclDefineUnitType(lua_State *l)
 			type->PoisonDrain = LuaToNumber(l, -1);
 		} else if (!strcmp(value, "ShieldPoints")) {
 			if (lua_istable(l, -1)) {
-				DefineVariableField(l, type->DefaultStat.Variables[SHIELD_INDEX], -1);
+				DefineVariableField(l, type->DefaultStat.Variables.get_mutable()[SHIELD_INDEX], -1);
 			} else if (lua_isnumber(l, -1)) {
-				type->DefaultStat.Variables[SHIELD_INDEX].Max = LuaToNumber(l, -1);
-				type->DefaultStat.Variables[SHIELD_INDEX].Value = 0;
-				type->DefaultStat.Variables[SHIELD_INDEX].Increase = 1;
-				type->DefaultStat.Variables[SHIELD_INDEX].Enable = 1;
+				type->DefaultStat.Variables.get_mutable()[SHIELD_INDEX].Max = LuaToNumber(l, -1);
+				type->DefaultStat.Variables.get_mutable()[SHIELD_INDEX].Value = 0;
+				type->DefaultStat.Variables.get_mutable()[SHIELD_INDEX].Increase = 1;
+				type->DefaultStat.Variables.get_mutable()[SHIELD_INDEX].Enable = 1;
 			}
 		} else if (!strcmp(value, "TileSize")) {
 			Vec2i tile_size;
@@ -1139,17 +1139,17 @@ static int CclDefineUnitType(lua_State *l)
 		} else if (!strcmp(value, "MinAttackRange")) {
 			type->MinAttackRange = LuaToNumber(l, -1);
 		} else if (!strcmp(value, "MaxAttackRange")) {
-			type->DefaultStat.Variables[ATTACKRANGE_INDEX].Value = LuaToNumber(l, -1);
-			type->DefaultStat.Variables[ATTACKRANGE_INDEX].Max = LuaToNumber(l, -1);
-			type->DefaultStat.Variables[ATTACKRANGE_INDEX].Enable = 1;
+			type->DefaultStat.Variables.get_mutable()[ATTACKRANGE_INDEX].Value = LuaToNumber(l, -1);
+			type->DefaultStat.Variables.get_mutable()[ATTACKRANGE_INDEX].Max = LuaToNumber(l, -1);
+			type->DefaultStat.Variables.get_mutable()[ATTACKRANGE_INDEX].Enable = 1;
 		//Wyrmgus start
 //		} else if (!strcmp(value, "MaxHarvesters")) {
 //			type->DefaultStat.Variables[MAXHARVESTERS_INDEX].Value = LuaToNumber(l, -1);
 //			type->DefaultStat.Variables[MAXHARVESTERS_INDEX].Max = LuaToNumber(l, -1);
 		//Wyrmgus end
 		} else if (!strcmp(value, "Priority")) {
-			type->DefaultStat.Variables[PRIORITY_INDEX].Value  = LuaToNumber(l, -1);
-			type->DefaultStat.Variables[PRIORITY_INDEX].Max  = LuaToNumber(l, -1);
+			type->DefaultStat.Variables.get_mutable()[PRIORITY_INDEX].Value  = LuaToNumber(l, -1);
+			type->DefaultStat.Variables.get_mutable()[PRIORITY_INDEX].Max  = LuaToNumber(l, -1);
 		} else if (!strcmp(value, "AnnoyComputerFactor")) {
 			type->AnnoyComputerFactor = LuaToNumber(l, -1);
 		} else if (!strcmp(value, "AiAdjacentRange")) {
@@ -1351,8 +1351,8 @@ static int CclDefineUnitType(lua_State *l)
 			if (type->MaxOnBoard == 0) { // set default value.
 				type->MaxOnBoard = 1;
 				//Wyrmgus start
-				type->DefaultStat.Variables[TRANSPORT_INDEX].Max = type->MaxOnBoard;
-				type->DefaultStat.Variables[TRANSPORT_INDEX].Enable = 1;
+				type->DefaultStat.Variables.get_mutable()[TRANSPORT_INDEX].Max = type->MaxOnBoard;
+				type->DefaultStat.Variables.get_mutable()[TRANSPORT_INDEX].Enable = 1;
 				//Wyrmgus end
 			}
 
@@ -1619,9 +1619,9 @@ static int CclDefineUnitType(lua_State *l)
 		} else if (!strcmp(value, "Quote")) {
 			type->set_quote(LuaToString(l, -1));
 		} else if (!strcmp(value, "Gender")) {
-			type->DefaultStat.Variables[GENDER_INDEX].Enable = 1;
-			type->DefaultStat.Variables[GENDER_INDEX].Value = static_cast<int>(stratagus::string_to_gender(LuaToString(l, -1)));
-			type->DefaultStat.Variables[GENDER_INDEX].Max = type->DefaultStat.Variables[GENDER_INDEX].Value;
+			type->DefaultStat.Variables.get_mutable()[GENDER_INDEX].Enable = 1;
+			type->DefaultStat.Variables.get_mutable()[GENDER_INDEX].Value = static_cast<int>(stratagus::string_to_gender(LuaToString(l, -1)));
+			type->DefaultStat.Variables.get_mutable()[GENDER_INDEX].Max = type->DefaultStat.Variables[GENDER_INDEX].Value;
 		} else if (!strcmp(value, "Background")) {
 			type->set_background(LuaToString(l, -1));
 		} else if (!strcmp(value, "RequirementsString")) {
@@ -1722,13 +1722,13 @@ static int CclDefineUnitType(lua_State *l)
 			int index = UnitTypeVar.VariableNameLookup[value];
 			if (index != -1) { // valid index
 				if (lua_isboolean(l, -1)) {
-					type->DefaultStat.Variables[index].Enable = LuaToBoolean(l, -1);
+					type->DefaultStat.Variables.get_mutable()[index].Enable = LuaToBoolean(l, -1);
 				} else if (lua_istable(l, -1)) {
-					DefineVariableField(l, type->DefaultStat.Variables[index], -1);
+					DefineVariableField(l, type->DefaultStat.Variables.get_mutable()[index], -1);
 				} else if (lua_isnumber(l, -1)) {
-					type->DefaultStat.Variables[index].Enable = 1;
-					type->DefaultStat.Variables[index].Value = LuaToNumber(l, -1);
-					type->DefaultStat.Variables[index].Max = LuaToNumber(l, -1);
+					type->DefaultStat.Variables.get_mutable()[index].Enable = 1;
+					type->DefaultStat.Variables.get_mutable()[index].Value = LuaToNumber(l, -1);
+					type->DefaultStat.Variables.get_mutable()[index].Max = LuaToNumber(l, -1);
 				} else { // Error
 					LuaError(l, "incorrect argument for the variable in unittype");
 				}
@@ -1772,7 +1772,7 @@ static int CclDefineUnitStats(lua_State *l)
 
 	CUnitStats *stats = &type->Stats[playerId];
 	if (stats->Variables.empty()) {
-		stats->Variables.resize(UnitTypeVar.GetNumberVariable());
+		stats->Variables.get_mutable().resize(UnitTypeVar.GetNumberVariable());
 	}
 
 	// Parse the list: (still everything could be changed!)
@@ -1862,11 +1862,11 @@ static int CclDefineUnitStats(lua_State *l)
 			if (i != -1) { // valid index
 				lua_rawgeti(l, 3, j + 1);
 				if (lua_istable(l, -1)) {
-					DefineVariableField(l, stats->Variables[i], -1);
+					DefineVariableField(l, stats->Variables.get_mutable()[i], -1);
 				} else if (lua_isnumber(l, -1)) {
-					stats->Variables[i].Enable = 1;
-					stats->Variables[i].Value = LuaToNumber(l, -1);
-					stats->Variables[i].Max = LuaToNumber(l, -1);
+					stats->Variables.get_mutable()[i].Enable = 1;
+					stats->Variables.get_mutable()[i].Value = LuaToNumber(l, -1);
+					stats->Variables.get_mutable()[i].Max = LuaToNumber(l, -1);
 				} else { // Error
 					LuaError(l, "incorrect argument for the variable in unittype");
 				}
@@ -2723,7 +2723,7 @@ static int CclDefineVariables(lua_State *l)
 	//update previously-defined unit types
 	for (stratagus::unit_type *unit_type : stratagus::unit_type::get_all()) {
 		for (size_t i = unit_type->DefaultStat.Variables.size(); i < UnitTypeVar.GetNumberVariable(); ++i) {
-			unit_type->DefaultStat.Variables.push_back(UnitTypeVar.Variable[i]);
+			unit_type->DefaultStat.Variables.get_mutable().push_back(UnitTypeVar.Variable[i]);
 		}
 	}
 
@@ -3781,7 +3781,7 @@ void SetModStat(const std::string &mod_file, const std::string &ident, const std
 	stratagus::unit_type *type = stratagus::unit_type::get(ident);
 	
 	if (type->ModDefaultStats.find(mod_file) == type->ModDefaultStats.end()) {
-		type->ModDefaultStats[mod_file].Variables.resize(UnitTypeVar.GetNumberVariable());
+		type->ModDefaultStats[mod_file].Variables.get_mutable().resize(UnitTypeVar.GetNumberVariable());
 	}
 	
 	if (variable_key == "Costs") {
@@ -3834,52 +3834,52 @@ void SetModStat(const std::string &mod_file, const std::string &ident, const std
 		if (variable_index != -1) { // valid index
 			if (variable_type == "Value") {
 				if (GameRunning || Editor.Running == EditorEditing) {
-					type->MapDefaultStat.Variables[variable_index].Value -= type->ModDefaultStats[mod_file].Variables[variable_index].Value;
+					type->MapDefaultStat.Variables.get_mutable()[variable_index].Value -= type->ModDefaultStats[mod_file].Variables[variable_index].Value;
 					for (int player = 0; player < PlayerMax; ++player) {
-						type->Stats[player].Variables[variable_index].Value -= type->ModDefaultStats[mod_file].Variables[variable_index].Value;
+						type->Stats[player].Variables.get_mutable()[variable_index].Value -= type->ModDefaultStats[mod_file].Variables[variable_index].Value;
 					}
 				}
-				type->ModDefaultStats[mod_file].Variables[variable_index].Value = value;
+				type->ModDefaultStats[mod_file].Variables.get_mutable()[variable_index].Value = value;
 				if (GameRunning || Editor.Running == EditorEditing) {
-					type->MapDefaultStat.Variables[variable_index].Value += type->ModDefaultStats[mod_file].Variables[variable_index].Value;
+					type->MapDefaultStat.Variables.get_mutable()[variable_index].Value += type->ModDefaultStats[mod_file].Variables[variable_index].Value;
 					for (int player = 0; player < PlayerMax; ++player) {
-						type->Stats[player].Variables[variable_index].Value += type->ModDefaultStats[mod_file].Variables[variable_index].Value;
+						type->Stats[player].Variables.get_mutable()[variable_index].Value += type->ModDefaultStats[mod_file].Variables[variable_index].Value;
 					}
 				}
 			} else if (variable_type == "Max") {
 				if (GameRunning || Editor.Running == EditorEditing) {
-					type->MapDefaultStat.Variables[variable_index].Max -= type->ModDefaultStats[mod_file].Variables[variable_index].Max;
+					type->MapDefaultStat.Variables.get_mutable()[variable_index].Max -= type->ModDefaultStats[mod_file].Variables[variable_index].Max;
 					for (int player = 0; player < PlayerMax; ++player) {
-						type->Stats[player].Variables[variable_index].Max -= type->ModDefaultStats[mod_file].Variables[variable_index].Max;
+						type->Stats[player].Variables.get_mutable()[variable_index].Max -= type->ModDefaultStats[mod_file].Variables[variable_index].Max;
 					}
 				}
-				type->ModDefaultStats[mod_file].Variables[variable_index].Max = value;
+				type->ModDefaultStats[mod_file].Variables.get_mutable()[variable_index].Max = value;
 				if (GameRunning || Editor.Running == EditorEditing) {
-					type->MapDefaultStat.Variables[variable_index].Max += type->ModDefaultStats[mod_file].Variables[variable_index].Max;
+					type->MapDefaultStat.Variables.get_mutable()[variable_index].Max += type->ModDefaultStats[mod_file].Variables[variable_index].Max;
 					for (int player = 0; player < PlayerMax; ++player) {
-						type->Stats[player].Variables[variable_index].Max += type->ModDefaultStats[mod_file].Variables[variable_index].Max;
+						type->Stats[player].Variables.get_mutable()[variable_index].Max += type->ModDefaultStats[mod_file].Variables[variable_index].Max;
 					}
 				}
 			} else if (variable_type == "Increase") {
 				if (GameRunning || Editor.Running == EditorEditing) {
-					type->MapDefaultStat.Variables[variable_index].Increase -= type->ModDefaultStats[mod_file].Variables[variable_index].Increase;
+					type->MapDefaultStat.Variables.get_mutable()[variable_index].Increase -= type->ModDefaultStats[mod_file].Variables[variable_index].Increase;
 					for (int player = 0; player < PlayerMax; ++player) {
-						type->Stats[player].Variables[variable_index].Increase -= type->ModDefaultStats[mod_file].Variables[variable_index].Increase;
+						type->Stats[player].Variables.get_mutable()[variable_index].Increase -= type->ModDefaultStats[mod_file].Variables[variable_index].Increase;
 					}
 				}
-				type->ModDefaultStats[mod_file].Variables[variable_index].Increase = value;
+				type->ModDefaultStats[mod_file].Variables.get_mutable()[variable_index].Increase = value;
 				if (GameRunning || Editor.Running == EditorEditing) {
-					type->MapDefaultStat.Variables[variable_index].Increase += type->ModDefaultStats[mod_file].Variables[variable_index].Increase;
+					type->MapDefaultStat.Variables.get_mutable()[variable_index].Increase += type->ModDefaultStats[mod_file].Variables[variable_index].Increase;
 					for (int player = 0; player < PlayerMax; ++player) {
-						type->Stats[player].Variables[variable_index].Increase += type->ModDefaultStats[mod_file].Variables[variable_index].Increase;
+						type->Stats[player].Variables.get_mutable()[variable_index].Increase += type->ModDefaultStats[mod_file].Variables[variable_index].Increase;
 					}
 				}
 			} else if (variable_type == "Enable") {
-				type->ModDefaultStats[mod_file].Variables[variable_index].Enable = value;
+				type->ModDefaultStats[mod_file].Variables.get_mutable()[variable_index].Enable = value;
 				if (GameRunning || Editor.Running == EditorEditing) {
-					type->MapDefaultStat.Variables[variable_index].Enable = type->ModDefaultStats[mod_file].Variables[variable_index].Enable;
+					type->MapDefaultStat.Variables.get_mutable()[variable_index].Enable = type->ModDefaultStats[mod_file].Variables[variable_index].Enable;
 					for (int player = 0; player < PlayerMax; ++player) {
-						type->Stats[player].Variables[variable_index].Enable = type->ModDefaultStats[mod_file].Variables[variable_index].Enable;
+						type->Stats[player].Variables.get_mutable()[variable_index].Enable = type->ModDefaultStats[mod_file].Variables[variable_index].Enable;
 					}
 				}
 			} else {
@@ -84,6 +84,7 @@
 #include "ui/ui.h"
 #include "unit/unit_find.h"
 #include "unit/unit_manager.h"
+#include "unit/unit_spatial_index.h"
 #include "unit/unit_type.h"
 #include "unit/unit_type_type.h"
 #include "unit/unit_type_variation.h"
@@ -138,6 +139,17 @@
 **  belonging to a player. This pointer is only needed to speed
 **  up, the remove of the unit pointer from Player::Units[].
 **
+**  CUnit::PlayerTypeSlot
+**
+**  The index into Player::UnitsByType[] for the unit's type, where
+**  the unit pointer is stored, or -1 if it is not there. It allows
+**  removing the unit from that list without searching it.
+**
+**  CUnit::PlayerAiActiveTypeSlot
+**
+**  The same as CUnit::PlayerTypeSlot, but for the list of units of
+**  the type which have their AI active, Player::AiActiveUnitsByType[].
+**
 **  CUnit::Container
 **
 **  Pointer to the unit containing it, or null if the unit is
@@ -426,6 +438,8 @@ void CUnit::Init()
 	Refs = 0;
 	ReleaseCycle = 0;
 	PlayerSlot = static_cast<size_t>(-1);
+	PlayerTypeSlot = static_cast<size_t>(-1);
+	PlayerAiActiveTypeSlot = static_cast<size_t>(-1);
 	InsideCount = 0;
 	BoardCount = 0;
 	UnitInside = nullptr;
@@ -498,6 +512,7 @@ void CUnit::Init()
 	memset(VisCount, 0, sizeof(VisCount));
 	memset(&Seen, 0, sizeof(Seen));
 	this->Variable.clear();
+	this->increasing_variables.clear();
 	TTL = 0;
 	Threshold = 0;
 	GroupId = 0;
@@ -610,6 +625,7 @@ void CUnit::Release(bool final)
 	delete[] AutoCastSpell;
 	delete[] SpellCoolDownTimers;
 	this->Variable.clear();
+	this->increasing_variables.clear();
 	for (std::vector<COrder *>::iterator order = Orders.begin(); order != Orders.end(); ++order) {
 		delete *order;
 	}
@@ -933,6 +949,7 @@ void CUnit::SetCharacter(const std::string &character_ident, bool custom_hero)
 		}
 		
 		this->Variable = this->Character->get_unit_type()->Stats[this->Player->Index].Variables;
+		this->update_increasing_variables();
 	} else {
 		fprintf(stderr, "Character \"%s\" has no unit type.\n", character_ident.c_str());
 		return;
@@ -1564,7 +1581,7 @@ void CUnit::EquipItem(CUnit &item, bool affect_character)
 		} else if (i == HITPOINTBONUS_INDEX) {
 			Variable[HP_INDEX].Value += item.Variable[i].Value;
 			Variable[HP_INDEX].Max += item.Variable[i].Max;
-			Variable[HP_INDEX].Increase += item.Variable[i].Increase;
+			this->change_variable_increase(HP_INDEX, item.Variable[i].Increase);
 		} else if (i == SIGHTRANGE_INDEX || i == DAYSIGHTRANGEBONUS_INDEX || i == NIGHTSIGHTRANGEBONUS_INDEX) {
 			if (!SaveGameLoading) {
 				MapUnmarkUnitSight(*this);
@@ -1601,7 +1618,7 @@ void CUnit::DeequipItem(CUnit &item, bool affect_character)
 		} else if (i == HITPOINTBONUS_INDEX) {
 			Variable[HP_INDEX].Value -= item.Variable[i].Value;
 			Variable[HP_INDEX].Max -= item.Variable[i].Max;
-			Variable[HP_INDEX].Increase -= item.Variable[i].Increase;
+			this->change_variable_increase(HP_INDEX, -item.Variable[i].Increase);
 		} else if (i == SIGHTRANGE_INDEX || i == DAYSIGHTRANGEBONUS_INDEX || i == NIGHTSIGHTRANGEBONUS_INDEX) {
 			MapUnmarkUnitSight(*this);
 			Variable[i].Value -= item.Variable[i].Value;
@@ -2772,6 +2789,7 @@ void CUnit::Init(const stratagus::unit_type &type)
 	} else {
 		this->Variable.clear();
 	}
+	this->update_increasing_variables();
 
 	IndividualUpgrades.clear();
 
@@ -2953,6 +2971,7 @@ void CUnit::AssignToPlayer(CPlayer &player)
 		if (UnitTypeVar.GetNumberVariable()) {
 			Assert(!Stats->Variables.empty());
 			this->Variable = Stats->Variables;
+			this->update_increasing_variables();
 		}
 	}
 	
@@ -3201,6 +3220,62 @@ void MapUnmarkUnitSight(CUnit &unit)
 	}
 }
 
+/**
+**  Check whether the sight of a unit moving to a tile can be updated with
+**  MapMoveUnitSight instead of being unmarked and marked again.
+**
+**  @param unit  unit which is about to move.
+**  @param pos   map tile position the unit moves to.
+**  @param z     map layer the unit moves to.
+*/
+static bool CanMoveUnitSight(const CUnit &unit, const Vec2i &pos, int z)
+{
+	// Only single tile steps of a unit with nothing inside it, whose own
+	// field flags cannot block the view of its sight.
+	return unit.Container == nullptr && unit.InsideCount == 0
+		&& unit.MapLayer != nullptr && unit.MapLayer->ID == z
+		&& abs(pos.x - unit.tilePos.x) <= 1 && abs(pos.y - unit.tilePos.y) <= 1
+		&& (unit.Type->FieldFlags & MapFieldAirUnpassable) == 0;
+}
+
+/**
+**  Update on vision table the Sight of a unit which moved a single tile,
+**  only (un)marking the tiles whose visibility from the unit changed.
+**
+**  @param unit             unit which moved.
+**  @param old_pos          map tile position of the unit before moving.
+**  @param old_sight_range  sight range of the unit before moving.
+**  @see CanMoveUnitSight.
+*/
+static void MapMoveUnitSight(const CUnit &unit, const Vec2i &old_pos, int old_sight_range)
+{
+	const int w = unit.Type->get_tile_width();
+	const int h = unit.Type->get_tile_height();
+	const int z = unit.MapLayer->ID;
+
+	MapSightDelta(*unit.Player, old_pos, old_sight_range, unit.tilePos, unit.CurrentSightRange, w, h, MapMarkTileSight, MapUnmarkTileSight, z);
+
+	if (unit.Type->BoolFlag[DETECTCLOAK_INDEX].value) {
+		MapSightDelta(*unit.Player, old_pos, old_sight_range, unit.tilePos, unit.CurrentSightRange, w, h, MapMarkTileDetectCloak, MapUnmarkTileDetectCloak, z);
+	}
+
+	if (unit.Variable[ETHEREALVISION_INDEX].Value) {
+		MapSightDelta(*unit.Player, old_pos, old_sight_range, unit.tilePos, unit.CurrentSightRange, w, h, MapMarkTileDetectEthereal, MapUnmarkTileDetectEthereal, z);
+	}
+
+	if (!unit.IsUnusable()) {
+		const int radar_range = unit.Stats->Variables[RADAR_INDEX].Value;
+		if (radar_range) {
+			MapSightDelta(*unit.Player, old_pos, radar_range, unit.tilePos, radar_range, w, h, MapMarkTileRadar, MapUnmarkTileRadar, z);
+		}
+
+		const int radar_jammer_range = unit.Stats->Variables[RADARJAMMER_INDEX].Value;
+		if (radar_jammer_range) {
+			MapSightDelta(*unit.Player, old_pos, radar_jammer_range, unit.tilePos, radar_jammer_range, w, h, MapMarkTileRadarJammer, MapUnmarkTileRadarJammer, z);
+		}
+	}
+}
+
 /**
 **  Update the Unit Current sight range to good value and transported units inside.
 **
@@ -3264,6 +3339,24 @@ void UpdateUnitSightRange(CUnit &unit)
 	}
 }
 
+/**
+**  Notify the pathfinder of the tiles of a unit, if the unit is an obstacle to movement.
+**
+**  @param unit  unit whose tiles changed.
+*/
+static void NotifyPathfinderOfUnitTiles(const CUnit &unit)
+{
+	if ((unit.Type->FieldFlags & ~(MapFieldLandUnit | MapFieldSeaUnit | MapFieldAirUnit)) == 0) {
+		return;
+	}
+
+	for (int y = 0; y < unit.Type->get_tile_height(); ++y) {
+		for (int x = 0; x < unit.Type->get_tile_width(); ++x) {
+			PathfinderTileChanged(unit.tilePos + Vec2i(x, y), unit.MapLayer->ID);
+		}
+	}
+}
+
 /**
 **  Mark the field with the FieldFlags.
 **
@@ -3291,6 +3384,8 @@ void MarkUnitFieldFlags(const CUnit &unit)
 		} while (--w);
 		index += unit.MapLayer->get_width();
 	} while (--h);
+
+	NotifyPathfinderOfUnitTiles(unit);
 }
 
 class _UnmarkUnitFieldFlags
@@ -3339,6 +3434,8 @@ void UnmarkUnitFieldFlags(const CUnit &unit)
 		} while (--w);
 		index += unit.MapLayer->get_width();
 	} while (--h);
+
+	NotifyPathfinderOfUnitTiles(unit);
 }
 
 /**
@@ -3670,7 +3767,13 @@ static void UnitInXY(CUnit &unit, const Vec2i &pos, const int z)
 void CUnit::MoveToXY(const Vec2i &pos, int z)
 //Wyrmgus end
 {
-	MapUnmarkUnitSight(*this);
+	const Vec2i old_pos = this->tilePos;
+	const int old_sight_range = this->CurrentSightRange;
+	const bool move_sight = CanMoveUnitSight(*this, pos, z);
+
+	if (!move_sight) {
+		MapUnmarkUnitSight(*this);
+	}
 	CMap::Map.Remove(*this);
 	UnmarkUnitFieldFlags(*this);
 
@@ -3688,7 +3791,11 @@ void CUnit::MoveToXY(const Vec2i &pos, int z)
 	MarkUnitFieldFlags(*this);
 	//  Recalculate the seen count.
 	UnitCountSeen(*this);
-	MapMarkUnitSight(*this);
+	if (move_sight) {
+		MapMoveUnitSight(*this, old_pos, old_sight_range);
+	} else {
+		MapMarkUnitSight(*this);
+	}
 	
 	//Wyrmgus start
 	// if there is a trap in the new tile, trigger it
@@ -4485,12 +4592,12 @@ void UnitCountSeen(CUnit &unit)
 				int x = width;
 				do {
 					if (unit.Type->BoolFlag[PERMANENTCLOAK_INDEX].value && unit.Player != CPlayer::Players[p]) {
-						if (mf->playerInfo.VisCloak[p]) {
+						if (mf->playerInfo.CloakDetectingPlayers & (1u << p)) {
 							newv++;
 						}
 					//Wyrmgus start
 					} else if (unit.Type->BoolFlag[ETHEREAL_INDEX].value && unit.Player != CPlayer::Players[p]) {
-						if (mf->playerInfo.VisEthereal[p]) {
+						if (mf->playerInfo.EtherealDetectingPlayers & (1u << p)) {
 							newv++;
 						}
 					//Wyrmgus end
@@ -4718,6 +4825,9 @@ void CUnit::ChangeOwner(CPlayer &newplayer, bool show_change)
 	MapUnmarkUnitSight(*this);
 	newplayer.AddUnit(*this);
 	Stats = &Type->Stats[newplayer.Index];
+	if (!this->Removed && this->MapLayer != nullptr) {
+		this->MapLayer->get_unit_index()->on_unit_owner_changed(this);
+	}
 
 	//  Must change food/gold and other.
 	//Wyrmgus start
@@ -5505,6 +5615,79 @@ int CUnit::GetAvailableLevelUpUpgrades(bool only_units) const
 	return value;
 }
 
+/**
+**	@brief	Get whether a variable is the timer of an effect, which is decreased each cycle instead of having its increase applied each second
+**
+**	@param	var_index	The variable's index
+**
+**	@return	True if the variable is the timer of an effect, or false otherwise
+*/
+static bool is_effect_timer_variable(const int var_index)
+{
+	switch (var_index) {
+		case BLOODLUST_INDEX:
+		case HASTE_INDEX:
+		case SLOW_INDEX:
+		case INVISIBLE_INDEX:
+		case UNHOLYARMOR_INDEX:
+		case POISON_INDEX:
+		case STUN_INDEX:
+		case BLEEDING_INDEX:
+		case LEADERSHIP_INDEX:
+		case BLESSING_INDEX:
+		case INSPIRE_INDEX:
+		case PRECISION_INDEX:
+		case REGENERATION_INDEX:
+		case BARKSKIN_INDEX:
+		case INFUSION_INDEX:
+		case TERROR_INDEX:
+		case WITHER_INDEX:
+		case DEHYDRATION_INDEX:
+		case HYDRATING_INDEX:
+			return true;
+		default:
+			return false;
+	}
+}
+
+/**
+**	@brief	Set the increase of a variable, keeping the list of increasing variables up to date
+**
+**	@param	var_index	The variable's index
+**	@param	increase	The new increase
+*/
+void CUnit::set_variable_increase(const int var_index, const char increase)
+{
+	this->Variable.at(var_index).Increase = increase;
+
+	if (is_effect_timer_variable(var_index)) {
+		return;
+	}
+
+	const auto find_iterator = std::lower_bound(this->increasing_variables.begin(), this->increasing_variables.end(), var_index);
+	const bool listed = find_iterator != this->increasing_variables.end() && *find_iterator == var_index;
+
+	if (increase != 0 && !listed) {
+		this->increasing_variables.insert(find_iterator, var_index);
+	} else if (increase == 0 && listed) {
+		this->increasing_variables.erase(find_iterator);
+	}
+}
+
+/**
+**	@brief	Rebuild the list of increasing variables, for after the unit's variables have been replaced wholesale
+*/
+void CUnit::update_increasing_variables()
+{
+	this->increasing_variables.clear();
+
+	for (size_t i = 0; i < this->Variable.size(); ++i) {
+		if (this->Variable[i].Increase != 0 && !is_effect_timer_variable(i)) {
+			this->increasing_variables.push_back(i);
+		}
+	}
+}
+
 int CUnit::GetModifiedVariable(int index, int variable_type) const
 {
 	int value = 0;
@@ -415,6 +415,20 @@ public:
 		return this->Variable.at(var_index).Increase;
 	}
 
+	void set_variable_increase(const int var_index, const char increase);
+
+	void change_variable_increase(const int var_index, const int change)
+	{
+		this->set_variable_increase(var_index, this->get_variable_increase(var_index) + change);
+	}
+
+	const std::vector<int> &get_increasing_variables() const
+	{
+		return this->increasing_variables;
+	}
+
+	void update_increasing_variables();
+
 	int GetModifiedVariable(int index, int variable_type = 0) const;
 
 	int GetReactionRange() const;
@@ -480,12 +494,13 @@ public:
 	{
 		friend class CUnitManager;
 	public:
-		CUnitManagerData() : slot(-1), unitSlot(-1) {}
+		CUnitManagerData() : slot(-1), unitSlot(-1), generation(0) {}
 
 		int GetUnitId() const { return slot; }
 	private:
-		int slot;           /// index in UnitManager::unitSlots
+		int slot;           /// index of the unit slot in UnitManager
 		int unitSlot;       /// index in UnitManager::units
+		unsigned int generation; /// iteration generation of UnitManager in which the unit was added
 	};
 
 public:
@@ -494,6 +509,8 @@ public:
 	unsigned int     ReleaseCycle; /// When this unit could be recycled
 	CUnitManagerData UnitManagerData;
 	size_t PlayerSlot;  /// index in Player->Units
+	size_t PlayerTypeSlot;  /// index in Player->UnitsByType for the unit's type
+	size_t PlayerAiActiveTypeSlot;  /// index in Player->AiActiveUnitsByType for the unit's type
 
 	int    InsideCount;   /// Number of units inside.
 	int    BoardCount;    /// Number of units transported inside.
@@ -606,6 +623,9 @@ unsigned    ByPlayer : PlayerMax;   /// Track unit seen by player
 	} Seen;
 
 	std::vector<stratagus::unit_variable> Variable; /// array of User Defined variables.
+private:
+	std::vector<int> increasing_variables; /// indexes of the variables which have a nonzero increase each second, in ascending order
+public:
 
 	unsigned long TTL;  /// time to live
 
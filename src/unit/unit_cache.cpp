@@ -41,6 +41,7 @@
 #include "map/map_layer.h"
 
 #include "unit/unit.h"
+#include "unit/unit_spatial_index.h"
 #include "unit/unit_type.h"
 
 /**
@@ -65,6 +66,8 @@ void CMap::Insert(CUnit &unit)
 		} while (--j && unit.tilePos.x + (j - w) < unit.MapLayer->get_width());
 		index += unit.MapLayer->get_width();
 	} while (--i && unit.tilePos.y + (i - h) < unit.MapLayer->get_height());
+
+	unit.MapLayer->get_unit_index()->insert(&unit);
 }
 
 /**
@@ -89,6 +92,8 @@ void CMap::Remove(CUnit &unit)
 		} while (--j && unit.tilePos.x + (j - w) < unit.MapLayer->get_width());
 		index += unit.MapLayer->get_width();
 	} while (--i && unit.tilePos.y + (i - h) < unit.MapLayer->get_height());
+
+	unit.MapLayer->get_unit_index()->remove(&unit);
 }
 
 //Wyrmgus start
@@ -43,6 +43,7 @@ bool unit_class::has_unit_type(unit_type *unit_type) const
 void unit_class::remove_unit_type(unit_type *unit_type)
 {
 	vector::remove(this->unit_types, unit_type);
+	++unit_class::unit_types_revision;
 }
 
 }
\ No newline at end of file
@@ -58,6 +58,12 @@ public:
 		return this->index;
 	}
 
+	/// Get the revision of the unit types of all unit classes, which changes whenever a unit type is added to or removed from a unit class
+	static unsigned int get_unit_types_revision()
+	{
+		return unit_class::unit_types_revision;
+	}
+
 	const std::vector<unit_type *> &get_unit_types() const
 	{
 		return this->unit_types;
@@ -68,11 +74,14 @@ public:
 	void add_unit_type(unit_type *unit_type)
 	{
 		this->unit_types.push_back(unit_type);
+		++unit_class::unit_types_revision;
 	}
 
 	void remove_unit_type(unit_type *unit_type);
 
 private:
+	static inline unsigned int unit_types_revision = 0;
+
 	int index = -1;
 	std::vector<unit_type *> unit_types;
 };
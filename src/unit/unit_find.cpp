@@ -45,6 +45,8 @@
 #include "spells.h"
 #include "unit/unit.h"
 #include "unit/unit_manager.h"
+#include "unit/unit_spatial_index.h"
+#include "unit/unit_target_snapshot.h"
 #include "unit/unit_type.h"
 #include "unit/unit_type_type.h"
 #include "util/vector_util.h"
@@ -403,25 +405,30 @@ public:
 };
 //Wyrmgus end
 
-CUnit *FindDepositNearLoc(CPlayer &p, const Vec2i &pos, int range, int resource, int z)
+static void add_player_deposits(const CPlayer &player, const int resource, std::vector<CUnit *> &table)
 {
-	BestDepotFinder<true> finder(pos, resource, range, z);
-	std::vector<CUnit *> table;
-	for (const auto &kv_pair : p.UnitsByType) {
-		const stratagus::unit_type *unit_type = kv_pair.first;
+	for (size_t i = 0; i < player.UnitsByType.size(); ++i) {
+		const std::vector<CUnit *> &type_units = player.UnitsByType[i];
+		if (type_units.empty()) {
+			continue;
+		}
+
+		const stratagus::unit_type *unit_type = stratagus::unit_type::get_all()[i];
 		if (unit_type->CanStore[resource]) {
-			stratagus::vector::merge(table, kv_pair.second);
+			stratagus::vector::merge(table, type_units);
 		}
 	}
+}
+
+CUnit *FindDepositNearLoc(CPlayer &p, const Vec2i &pos, int range, int resource, int z)
+{
+	BestDepotFinder<true> finder(pos, resource, range, z);
+	std::vector<CUnit *> table;
+	add_player_deposits(p, resource, table);
 	for (int i = 0; i < PlayerMax - 1; ++i) {
 		const CPlayer *other_player = CPlayer::Players[i];
 		if (other_player->IsAllied(p) && p.IsAllied(*other_player)) {
-			for (const auto &kv_pair : other_player->UnitsByType) {
-				const stratagus::unit_type *unit_type = kv_pair.first;
-				if (unit_type->CanStore[resource]) {
-					stratagus::vector::merge(table, kv_pair.second);
-				}
-			}
+			add_player_deposits(*other_player, resource, table);
 		}
 	}
 	return finder.Find(table.begin(), table.end());
@@ -707,21 +714,11 @@ CUnit *FindDeposit(const CUnit &unit, int range, int resource)
 {
 	BestDepotFinder<false> finder(unit, resource, range);
 	std::vector<CUnit *> table;
-	for (const auto &kv_pair : unit.Player->UnitsByType) {
-		const stratagus::unit_type *unit_type = kv_pair.first;
-		if (unit_type->CanStore[resource]) {
-			stratagus::vector::merge(table, kv_pair.second);
-		}
-	}
+	add_player_deposits(*unit.Player, resource, table);
 	for (int i = 0; i < PlayerMax - 1; ++i) {
 		const CPlayer *other_player = CPlayer::Players[i];
 		if (other_player->IsAllied(*unit.Player) && unit.Player->IsAllied(*other_player)) {
-			for (const auto &kv_pair : other_player->UnitsByType) {
-				const stratagus::unit_type *unit_type = kv_pair.first;
-				if (unit_type->CanStore[resource]) {
-					stratagus::vector::merge(table, kv_pair.second);
-				}
-			}
+			add_player_deposits(*other_player, resource, table);
 		}
 	}
 	return finder.Find(table.begin(), table.end());
@@ -815,21 +812,9 @@ void FindUnitsByType(const stratagus::unit_type &type, std::vector<CUnit *> &uni
 */
 void FindPlayerUnitsByType(const CPlayer &player, const stratagus::unit_type &type, std::vector<CUnit *> &table, bool ai_active)
 {
-	std::vector<CUnit *> type_units;
-
-	if (ai_active) {
-		if (player.AiActiveUnitsByType.find(&type) != player.AiActiveUnitsByType.end()) {
-			type_units = player.AiActiveUnitsByType.find(&type)->second;;
-		}
-	} else {
-		if (player.UnitsByType.find(&type) != player.UnitsByType.end()) {
-			type_units = player.UnitsByType.find(&type)->second;;
-		}
-	}
+	const std::vector<CUnit *> &type_units = ai_active ? player.GetAiActiveUnitsByType(&type) : player.GetUnitsByType(&type);
 	
-	for (size_t i = 0; i < type_units.size(); ++i) {
-		CUnit *unit = type_units[i];
-
+	for (CUnit *unit : type_units) {
 		if (!unit->IsUnusable()) {
 			table.push_back(unit);
 		}
@@ -1507,6 +1492,49 @@ bool CheckObstaclesBetweenTiles(const Vec2i &unitPos, const Vec2i &goalPos, unsi
 	return true;
 }
 
+/**
+**  Get the range around a unit within which AttackUnitsInDistance selects the units it can choose a target from.
+**
+**  @param unit   The unit searching for a target.
+**  @param range  Distance range to look.
+**
+**  @return       The selection range.
+*/
+int GetTargetSelectionRange(const CUnit &unit, int range)
+{
+	// if necessary, take possible damage on allied units into account...
+	if (unit.GetMissile().Missile->get_range() > 1
+		&& (range + unit.GetMissile().Missile->get_range() < 15)) {
+		return unit.GetMissile().Missile->get_range() + range - 1;
+	}
+
+	return range;
+}
+
+/**
+**  Select the units around a unit which it can choose a target from.
+**
+**  Uses the units selected in parallel at the start of the cycle where possible, keeping those which are still on the unit's map layer.
+*/
+template <typename Pred>
+static void SelectTargetCandidates(const CUnit &unit, int range, std::vector<CUnit *> &table, Pred pred, bool circle)
+{
+	// If unit is removed, use containers x and y
+	const CUnit *firstContainer = unit.GetFirstContainer();
+
+	const std::vector<CUnit *> *candidates = stratagus::unit_target_snapshot::get()->get_candidates(unit, range, circle);
+	if (candidates == nullptr) {
+		SelectAroundUnit(*firstContainer, range, table, pred, circle);
+		return;
+	}
+
+	for (CUnit *candidate : *candidates) {
+		if (!candidate->Removed && candidate->MapLayer == firstContainer->MapLayer && pred(candidate)) {
+			table.push_back(candidate);
+		}
+	}
+}
+
 /**
 **  Attack units in distance.
 **
@@ -1524,20 +1552,28 @@ bool CheckObstaclesBetweenTiles(const Vec2i &unitPos, const Vec2i &goalPos, unsi
 CUnit *AttackUnitsInDistance(const CUnit &unit, int range, CUnitFilter pred, bool circle, bool include_neutral)
 //Wyrmgus end
 {
+	//skip the search if the spatial index shows that no other player has units in the area; neutral units can be hostile towards units of their own player, so this doesn't apply to them
+	const CUnit *search_center_unit = unit.GetFirstContainer();
+	if (unit.Player->Type != PlayerNeutral && search_center_unit->MapLayer != nullptr) {
+		const int search_range = range + unit.GetMissile().Missile->get_range();
+		const QRect search_rect(QPoint(search_center_unit->tilePos.x - search_range, search_center_unit->tilePos.y - search_range), QPoint(search_center_unit->tilePos.x + search_center_unit->Type->get_tile_width() - 1 + search_range, search_center_unit->tilePos.y + search_center_unit->Type->get_tile_height() - 1 + search_range));
+		if ((search_center_unit->MapLayer->get_unit_index()->get_player_mask(search_rect) & ~(1u << unit.Player->Index)) == 0) {
+			return nullptr;
+		}
+	}
+
 	// if necessary, take possible damage on allied units into account...
 	if (unit.GetMissile().Missile->get_range() > 1
 		&& (range + unit.GetMissile().Missile->get_range() < 15)) {
 		//  If catapult, count units near the target...
 		//   FIXME : make it configurable
 
-		const int missile_range = unit.GetMissile().Missile->get_range() + range - 1;
+		const int missile_range = GetTargetSelectionRange(unit, range);
 
 		Assert(2 * missile_range + 1 < 32);
 
-		// If unit is removed, use containers x and y
-		const CUnit *firstContainer = unit.GetFirstContainer();
 		std::vector<CUnit *> table;
-		SelectAroundUnit(*firstContainer, missile_range, table,
+		SelectTargetCandidates(unit, missile_range, table,
 			//Wyrmgus start
 //			MakeAndPredicate(HasNotSamePlayerAs(*CPlayer::Players[PlayerNumNeutral]), pred));
 			pred, circle);
@@ -1551,11 +1587,9 @@ CUnit *AttackUnitsInDistance(const CUnit &unit, int range, CUnitFilter pred, boo
 		}
 		return nullptr;
 	} else {
-		// If unit is removed, use containers x and y
-		const CUnit *firstContainer = unit.GetFirstContainer();
 		std::vector<CUnit *> table;
 
-		SelectAroundUnit(*firstContainer, range, table,
+		SelectTargetCandidates(unit, range, table,
 			//Wyrmgus start
 //			MakeAndPredicate(HasNotSamePlayerAs(*CPlayer::Players[PlayerNumNeutral]), pred));
 			pred, circle);
@@ -34,6 +34,7 @@
 #include "map/map_layer.h"
 #include "pathfinder.h"
 #include "unit/unit.h"
+#include "unit/unit_spatial_index.h"
 #include "unit/unit_type.h"
 
 class CPlayer;
@@ -304,6 +305,99 @@ private:
 	int z;
 };
 
+/**
+**  The area of a fixed selection, which is either a whole tile rectangle or the circle within it.
+*/
+class SelectionArea
+{
+public:
+	SelectionArea(const Vec2i &ltPos, const Vec2i &rbPos, bool circle) : circle(circle)
+	{
+		//Wyrmgus start
+		if (circle) {
+			middle_x = (rbPos.x + ltPos.x) / 2;
+			middle_y = (rbPos.y + ltPos.y) / 2;
+			radius = ((middle_x - ltPos.x) + (middle_y - ltPos.y)) / 2;
+		}
+		//Wyrmgus end
+	}
+
+	bool ContainsTile(const int x, const int y) const
+	{
+		if (!circle) {
+			return true;
+		}
+
+		double rel_x = x - middle_x;
+		double rel_y = y - middle_y;
+		double my = radius * radius - rel_x * rel_x;
+		return (rel_y * rel_y) <= my;
+	}
+
+private:
+	bool circle;
+	double middle_x = 0;
+	double middle_y = 0;
+	double radius = 0;
+};
+
+/**
+**  Select the units in a fixed area through the map layer's spatial index.
+**
+**  The units are returned in the order a scan of the area's tiles would find them, since the selection order affects which unit gets picked.
+**  This only reads the game state, so it can be called from worker threads while the game state is not being changed.
+*/
+template <typename Pred>
+void SelectFixedFromIndex(const Vec2i &ltPos, const Vec2i &rbPos, std::vector<CUnit *> &units, int z, Pred pred, bool circle = false)
+{
+	const CMapLayer *map_layer = CMap::Map.MapLayers[z];
+	const SelectionArea area(ltPos, rbPos, circle);
+	const QRect area_rect(QPoint(ltPos.x, ltPos.y), QPoint(rbPos.x, rbPos.y));
+
+	// the first tile a tile scan of the area would find each unit in, and the unit's position in that tile's unit cache
+	struct found_unit
+	{
+		int tile_index = 0;
+		size_t cache_position = 0;
+		CUnit *unit = nullptr;
+	};
+	std::vector<found_unit> found_units;
+
+	map_layer->get_unit_index()->for_each_unit_in_rect(area_rect, [&](CUnit *unit, const QRect &unit_tile_rect) {
+		if (unit->CacheLock != 0) {
+			return;
+		}
+
+		const QRect tile_rect = unit_tile_rect.intersected(area_rect);
+		for (int y = tile_rect.top(); y <= tile_rect.bottom(); ++y) {
+			for (int x = tile_rect.left(); x <= tile_rect.right(); ++x) {
+				if (area.ContainsTile(x, y)) {
+					if (pred(unit)) {
+						const int tile_index = x + y * map_layer->get_width();
+						const CUnitCache &cache = map_layer->Field(static_cast<unsigned int>(tile_index))->UnitCache;
+						const size_t cache_position = static_cast<size_t>(std::find(cache.begin(), cache.end(), unit) - cache.begin());
+						found_units.push_back({tile_index, cache_position, unit});
+					}
+					return;
+				}
+			}
+		}
+	});
+
+	std::sort(found_units.begin(), found_units.end(), [](const found_unit &lhs, const found_unit &rhs) {
+		if (lhs.tile_index != rhs.tile_index) {
+			return lhs.tile_index < rhs.tile_index;
+		}
+
+		return lhs.cache_position < rhs.cache_position;
+	});
+
+	units.reserve(found_units.size());
+	for (const found_unit &found_unit : found_units) {
+		units.push_back(found_unit.unit);
+	}
+}
+
 template <typename Pred>
 //Wyrmgus start
 //void SelectFixed(const Vec2i &ltPos, const Vec2i &rbPos, std::vector<CUnit *> &units, Pred pred)
@@ -314,29 +408,20 @@ void SelectFixed(const Vec2i &ltPos, const Vec2i &rbPos, std::vector<CUnit *> &u
 	Assert(CMap::Map.Info.IsPointOnMap(rbPos, z));
 	Assert(units.empty());
 	
-	const CMapLayer *map_layer = CMap::Map.MapLayers[z];
-	
-	//Wyrmgus start
-	double middle_x;
-	double middle_y;
-	double radius;
-	if (circle) {
-		middle_x = (rbPos.x + ltPos.x) / 2;
-		middle_y = (rbPos.y + ltPos.y) / 2;
-		radius = ((middle_x - ltPos.x) + (middle_y - ltPos.y)) / 2;
+	// Large areas are queried through the map layer's spatial index instead of the unit cache of each tile
+	if ((rbPos.x - ltPos.x + 1) * (rbPos.y - ltPos.y + 1) > stratagus::unit_spatial_index::bucket_size * stratagus::unit_spatial_index::bucket_size) {
+		SelectFixedFromIndex(ltPos, rbPos, units, z, pred, circle);
+		return;
 	}
-	//Wyrmgus end
+
+	const CMapLayer *map_layer = CMap::Map.MapLayers[z];
+	const SelectionArea area(ltPos, rbPos, circle);
 
 	for (Vec2i posIt = ltPos; posIt.y != rbPos.y + 1; ++posIt.y) {
 		for (posIt.x = ltPos.x; posIt.x != rbPos.x + 1; ++posIt.x) {
 			//Wyrmgus start
-			if (circle) {
-				double rel_x = posIt.x - middle_x;
-				double rel_y = posIt.y - middle_y;
-				double my = radius * radius - rel_x * rel_x;
-				if ((rel_y * rel_y) > my) {
-					continue;
-				}
+			if (!area.ContainsTile(posIt.x, posIt.y)) {
+				continue;
 			}
 			//Wyrmgus end
 
@@ -501,6 +586,8 @@ extern bool CheckObstaclesBetweenTiles(const Vec2i &unitPos, const Vec2i &goalPo
 extern CUnit *AttackUnitsInDistance(const CUnit &unit, int range, CUnitFilter pred, bool circle = false, bool include_neutral = false);
 extern CUnit *AttackUnitsInDistance(const CUnit &unit, int range, bool circle = false, bool include_neutral = false);
 //Wyrmgus end
+/// Get the range around a unit within which AttackUnitsInDistance selects the units it can choose from
+extern int GetTargetSelectionRange(const CUnit &unit, int range);
 
 /// Find best enemy in attack range to attack
 extern CUnit *AttackUnitsInRange(const CUnit &unit, CUnitFilter pred);
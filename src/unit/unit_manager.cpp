@@ -52,10 +52,33 @@ CUnitManager UnitManager;          /// Unit manager
 --  Functions
 ----------------------------------------------------------------------------*/
 
+/**
+**  A contiguous block of memory for the units of slot_chunk_size slots.
+**
+**  The units are constructed in it when their slot is first used, and
+**  destroyed when the unit manager is reinitialized.
+*/
+class CUnitManager::slot_chunk final
+{
+public:
+	CUnit *GetUnit(const unsigned int index)
+	{
+		return reinterpret_cast<CUnit *>(&this->storage[index * sizeof(CUnit)]);
+	}
+
+private:
+	alignas(CUnit) unsigned char storage[sizeof(CUnit) * CUnitManager::slot_chunk_size];
+};
+
 CUnitManager::CUnitManager() : lastCreated(nullptr)
 {
 }
 
+/**
+**  The slot units are destroyed by Init() when CleanUnits() runs on shutdown, not during static destruction.
+*/
+CUnitManager::~CUnitManager() = default;
+
 /**
 **  Initial memory allocation for units.
 */
@@ -64,15 +87,43 @@ void CUnitManager::Init()
 	lastCreated = nullptr;
 	//Assert(units.empty());
 	units.clear();
-	// Release memory of units in release list.
-	while (!releasedUnits.empty()) {
-		CUnit *unit = releasedUnits.front();
-		releasedUnits.pop_front();
-		delete unit;
+	// Release memory of all units, including the ones in the release list.
+	releasedUnits.clear();
+	this->DestroySlotUnits();
+
+	this->reset_allocation_counters();
+}
+
+/**
+**  Construct a unit in the next unused slot, allocating a new chunk if needed
+**
+**  @return  New unit
+*/
+CUnit *CUnitManager::CreateSlotUnit()
+{
+	const unsigned int slot = this->used_slot_count;
+
+	if (slot / slot_chunk_size >= this->slot_chunks.size()) {
+		this->slot_chunks.push_back(std::make_unique<slot_chunk>());
+	}
+
+	CUnit *unit = new (this->slot_chunks[slot / slot_chunk_size]->GetUnit(slot % slot_chunk_size)) CUnit;
+	unit->UnitManagerData.slot = slot;
+	++this->used_slot_count;
+	return unit;
+}
+
+/**
+**  Destroy the units of all used slots, and free their memory.
+*/
+void CUnitManager::DestroySlotUnits()
+{
+	for (unsigned int slot = 0; slot < this->used_slot_count; ++slot) {
+		this->GetSlotUnit(slot).~CUnit();
 	}
 
-	// Initialize the free unit slots
-	unitSlots.clear();
+	this->used_slot_count = 0;
+	this->slot_chunks.clear();
 }
 
 /**
@@ -90,13 +141,11 @@ CUnit *CUnitManager::AllocUnit()
 		unit->Init();
 		unit->UnitManagerData.slot = slot;
 		unit->UnitManagerData.unitSlot = -1;
+		++this->reused_allocation_count;
 		return unit;
 	} else {
-		CUnit *unit = new CUnit;
-
-		unit->UnitManagerData.slot = unitSlots.size();
-		unitSlots.push_back(unit);
-		return unit;
+		++this->new_slot_allocation_count;
+		return this->CreateSlotUnit();
 	}
 }
 
@@ -122,18 +171,37 @@ void CUnitManager::ReleaseUnit(CUnit *unit)
 		units.pop_back();
 	}
 	releasedUnits.push_back(unit);
-	unit->ReleaseCycle = GameCycle + 500; // can be reused after this time
+	unit->ReleaseCycle = GameCycle + release_delay; // can be reused after this time
 	//Refs = GameCycle + (NetworkMaxLag << 1); // could be reuse after this time
+	++this->release_count;
 }
 
 CUnit &CUnitManager::GetSlotUnit(int index) const
 {
-	return *unitSlots[index];
+	return *this->slot_chunks[index / slot_chunk_size]->GetUnit(index % slot_chunk_size);
 }
 
 unsigned int CUnitManager::GetUsedSlotCount() const
 {
-	return static_cast<unsigned int>(unitSlots.size());
+	return this->used_slot_count;
+}
+
+/**
+**  Get the unit of a slot if it is to be visited by for_each_unit_slot
+**
+**  @param slot  Unit slot
+**
+**  @return  The unit if it is in the unit list and was added before the current iteration generation, or null otherwise
+*/
+CUnit *CUnitManager::GetIterableSlotUnit(const unsigned int slot) const
+{
+	CUnit &unit = this->GetSlotUnit(slot);
+
+	if (unit.UnitManagerData.unitSlot == -1 || unit.UnitManagerData.generation == this->iteration_generation) {
+		return nullptr;
+	}
+
+	return &unit;
 }
 
 CUnitManager::Iterator CUnitManager::begin()
@@ -151,6 +219,11 @@ bool CUnitManager::empty() const
 	return units.empty();
 }
 
+size_t CUnitManager::size() const
+{
+	return units.size();
+}
+
 CUnit *CUnitManager::lastCreatedUnit()
 {
 	return this->lastCreated;
@@ -160,6 +233,7 @@ void CUnitManager::Add(CUnit *unit)
 {
 	lastCreated = unit;
 	unit->UnitManagerData.unitSlot = static_cast<int>(units.size());
+	unit->UnitManagerData.generation = this->iteration_generation;
 	units.push_back(unit);
 }
 
@@ -170,9 +244,9 @@ void CUnitManager::Add(CUnit *unit)
 */
 void CUnitManager::Save(CFile &file) const
 {
-	file.printf("SlotUsage(%lu, {", (long unsigned int)unitSlots.size());
+	file.printf("SlotUsage(%lu, {", (long unsigned int)this->used_slot_count);
 
-	for (std::list<CUnit *>::const_iterator it = releasedUnits.begin(); it != releasedUnits.end(); ++it) {
+	for (std::deque<CUnit *>::const_iterator it = releasedUnits.begin(); it != releasedUnits.end(); ++it) {
 		const CUnit &unit = **it;
 		file.printf("{Slot = %d, FreeCycle = %u}, ", UnitNumber(unit), unit.ReleaseCycle);
 	}
@@ -209,9 +283,7 @@ void CUnitManager::Load(lua_State *l)
 		LuaError(l, "incorrect argument");
 	}
 	for (unsigned int i = 0; i < unitCount; i++) {
-		CUnit *unit = new CUnit;
-		unitSlots.push_back(unit);
-		unit->UnitManagerData.slot = i;
+		this->CreateSlotUnit();
 	}
 	const unsigned int args = lua_rawlen(l, 2);
 	for (unsigned int i = 0; i < args; i++) {
@@ -231,8 +303,12 @@ void CUnitManager::Load(lua_State *l)
 			}
 		}
 		Assert(unit_index != -1 && cycle != static_cast<unsigned long>(-1));
-		ReleaseUnit(unitSlots[unit_index]);
-		unitSlots[unit_index]->ReleaseCycle = cycle;
+		CUnit &unit = GetSlotUnit(unit_index);
+		ReleaseUnit(&unit);
+		unit.ReleaseCycle = cycle;
 		lua_pop(l, 1);
 	}
+
+	// Releasing the units of the loaded game is not churn.
+	this->reset_allocation_counters();
 }
@@ -40,8 +40,18 @@ class CUnitManager
 {
 public:
 	typedef std::vector<CUnit *>::iterator Iterator;
+
+	/// Quantity of unit slots in each contiguous chunk of unit memory
+	static constexpr unsigned int slot_chunk_size = 256;
+	/// Game cycles before a released unit can be reused, as it may still be referenced by a CUnitPtr until then
+	static constexpr unsigned int release_delay = 500;
+
+private:
+	class slot_chunk;
+
 public:
 	CUnitManager();
+	~CUnitManager();
 	void Init();
 
 	CUnit *AllocUnit();
@@ -57,15 +67,87 @@ public:
 
 	CUnit *lastCreatedUnit();
 
+	size_t size() const;
+
 	// Following is mainly for scripting
 	CUnit &GetSlotUnit(int index) const;
 	unsigned int GetUsedSlotCount() const;
 
+	CUnit *GetIterableSlotUnit(const unsigned int slot) const;
+
+	/// Start a new iteration generation; units added from then on are skipped by for_each_unit_slot until the next one
+	void StartIterationGeneration()
+	{
+		++this->iteration_generation;
+	}
+
+	/**
+	**	@brief	Call a function for the units of every stride-th slot from a given one, which were in the unit list when the current iteration generation started
+	**
+	**	Unlike iterating over begin()/end(), this stays valid while units are added or released by the function: slots never move, released units keep their memory until their slot is reused after release_delay cycles, and units added during the iteration belong to the new generation.
+	*/
+	template <typename function_type>
+	void for_each_unit_slot(const unsigned int first_slot, const unsigned int stride, const function_type &function) const
+	{
+		for (unsigned int slot = first_slot; slot < this->used_slot_count; slot += stride) {
+			CUnit *unit = this->GetIterableSlotUnit(slot);
+			if (unit != nullptr) {
+				function(*unit);
+			}
+		}
+	}
+
+	/// Get how many units were allocated in a new slot since the last reset of the counters
+	unsigned int get_new_slot_allocation_count() const
+	{
+		return this->new_slot_allocation_count;
+	}
+
+	/// Get how many units were allocated by reusing a released unit since the last reset of the counters
+	unsigned int get_reused_allocation_count() const
+	{
+		return this->reused_allocation_count;
+	}
+
+	/// Get how many units were released since the last reset of the counters
+	unsigned int get_release_count() const
+	{
+		return this->release_count;
+	}
+
+	/// Get how many released units are waiting to be reused
+	size_t get_released_unit_count() const
+	{
+		return this->releasedUnits.size();
+	}
+
+	/// Get how many chunks of unit memory have been allocated
+	size_t get_slot_chunk_count() const
+	{
+		return this->slot_chunks.size();
+	}
+
+	void reset_allocation_counters()
+	{
+		this->new_slot_allocation_count = 0;
+		this->reused_allocation_count = 0;
+		this->release_count = 0;
+	}
+
 private:
+	CUnit *CreateSlotUnit();
+	void DestroySlotUnits();
+
 	std::vector<CUnit *> units;
-	std::vector<CUnit *> unitSlots;
-	std::list<CUnit *> releasedUnits;
+	/// Contiguous memory for the units, with slot n at index n % slot_chunk_size of chunk n / slot_chunk_size
+	std::vector<std::unique_ptr<slot_chunk>> slot_chunks;
+	unsigned int used_slot_count = 0;
+	std::deque<CUnit *> releasedUnits;
 	CUnit *lastCreated;
+	unsigned int iteration_generation = 0;
+	unsigned int new_slot_allocation_count = 0;
+	unsigned int reused_allocation_count = 0;
+	unsigned int release_count = 0;
 };
 
 
@@ -0,0 +1,173 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+//      (c) Copyright 2020 by Andrettin
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+//
+
+#include "stratagus.h"
+
+#include "unit/unit_spatial_index.h"
+
+#include "player.h"
+#include "unit/unit.h"
+#include "unit/unit_type.h"
+
+namespace stratagus {
+
+static_assert(PlayerMax <= 32);
+
+unit_spatial_index::unit_spatial_index(const QSize &map_size) : map_size(map_size)
+{
+	this->bucket_grid_size = QSize((map_size.width() + unit_spatial_index::bucket_size - 1) / unit_spatial_index::bucket_size, (map_size.height() + unit_spatial_index::bucket_size - 1) / unit_spatial_index::bucket_size);
+	this->buckets.resize(this->bucket_grid_size.width() * this->bucket_grid_size.height());
+}
+
+int unit_spatial_index::get_unit_player_index(const CUnit *unit)
+{
+	return unit->Player->Index;
+}
+
+const unit_type *unit_spatial_index::get_unit_type(const CUnit *unit)
+{
+	return unit->Type;
+}
+
+/**
+**	@brief	Get the tile rectangle occupied by a unit, as its tiles are marked in the unit cache, clipped to the map
+*/
+QRect unit_spatial_index::get_unit_tile_rect(const CUnit *unit) const
+{
+	return QRect(unit->tilePos, unit->Type->get_tile_size()).intersected(QRect(QPoint(0, 0), this->map_size));
+}
+
+/**
+**	@brief	Get the bucket a unit is kept in, i.e. the one of the top-left tile of its occupied tile rectangle
+*/
+unit_spatial_index::bucket &unit_spatial_index::get_unit_bucket(const CUnit *unit)
+{
+	const QRect tile_rect = this->get_unit_tile_rect(unit);
+	return this->buckets[tile_rect.x() / unit_spatial_index::bucket_size + tile_rect.y() / unit_spatial_index::bucket_size * this->bucket_grid_size.width()];
+}
+
+/**
+**	@brief	Add a unit to the index, at its current position
+**
+**	@param	unit	The unit
+*/
+void unit_spatial_index::insert(CUnit *unit)
+{
+	const QRect tile_rect = this->get_unit_tile_rect(unit);
+	bucket &bucket = this->get_unit_bucket(unit);
+
+	unit_entry entry;
+	entry.unit = unit;
+	entry.tile_rect = tile_rect;
+	bucket.units.push_back(std::move(entry));
+	bucket.player_mask |= 1u << unit->Player->Index;
+
+	this->max_unit_size = std::max(this->max_unit_size, std::max(tile_rect.width(), tile_rect.height()));
+}
+
+/**
+**	@brief	Remove a unit from the index, while it is still at the position it was inserted at
+**
+**	@param	unit	The unit
+*/
+void unit_spatial_index::remove(CUnit *unit)
+{
+	bucket &bucket = this->get_unit_bucket(unit);
+
+	const auto find_iterator = std::find_if(bucket.units.begin(), bucket.units.end(), [unit](const unit_entry &entry) {
+		return entry.unit == unit;
+	});
+
+	Assert(find_iterator != bucket.units.end());
+	if (find_iterator == bucket.units.end()) {
+		return;
+	}
+
+	//the order within a bucket is not relied upon, so swap-remove
+	*find_iterator = std::move(bucket.units.back());
+	bucket.units.pop_back();
+
+	bucket.player_mask = 0;
+	for (const unit_entry &entry : bucket.units) {
+		bucket.player_mask |= 1u << entry.unit->Player->Index;
+	}
+}
+
+/**
+**	@brief	Update the player mask of a unit's bucket after the unit has changed owner
+**
+**	@param	unit	The unit, if it is currently placed on the map
+*/
+void unit_spatial_index::on_unit_owner_changed(const CUnit *unit)
+{
+	bucket &bucket = this->get_unit_bucket(unit);
+	bucket.player_mask |= 1u << unit->Player->Index;
+}
+
+/**
+**	@brief	Get the mask of players who may own units intersecting a tile rectangle
+**
+**	@param	tile_rect	The tile rectangle
+**
+**	@return	A mask with a bit set for each player index which may own a unit in the rectangle
+*/
+uint32_t unit_spatial_index::get_player_mask(const QRect &tile_rect) const
+{
+	const QRect bucket_rect = this->get_bucket_rect(tile_rect);
+	uint32_t player_mask = 0;
+
+	for (int bucket_y = bucket_rect.top(); bucket_y <= bucket_rect.bottom(); ++bucket_y) {
+		for (int bucket_x = bucket_rect.left(); bucket_x <= bucket_rect.right(); ++bucket_x) {
+			player_mask |= this->buckets[bucket_x + bucket_y * this->bucket_grid_size.width()].player_mask;
+		}
+	}
+
+	return player_mask;
+}
+
+/**
+**	@brief	Get the rectangle of buckets which can contain units intersecting a tile rectangle
+**
+**	The rectangle is extended towards the top-left by the size of the largest unit, since units are kept in the bucket of their top-left tile.
+**
+**	@param	tile_rect	The tile rectangle
+*/
+QRect unit_spatial_index::get_bucket_rect(const QRect &tile_rect) const
+{
+	const int min_x = std::max(0, tile_rect.left() - this->max_unit_size + 1) / unit_spatial_index::bucket_size;
+	const int min_y = std::max(0, tile_rect.top() - this->max_unit_size + 1) / unit_spatial_index::bucket_size;
+	const int max_x = std::min(this->map_size.width() - 1, tile_rect.right()) / unit_spatial_index::bucket_size;
+	const int max_y = std::min(this->map_size.height() - 1, tile_rect.bottom()) / unit_spatial_index::bucket_size;
+
+	if (max_x < min_x || max_y < min_y || tile_rect.right() < 0 || tile_rect.bottom() < 0) {
+		return QRect();
+	}
+
+	return QRect(QPoint(min_x, min_y), QPoint(max_x, max_y));
+}
+
+}
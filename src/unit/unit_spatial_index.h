@@ -0,0 +1,150 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+//      (c) Copyright 2020 by Andrettin
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+//
+
+#pragma once
+
+class CUnit;
+
+namespace stratagus {
+
+class unit_type;
+
+/**
+**	@brief	Coarse uniform grid of the units placed on a map layer, for range queries which would otherwise have to walk the unit cache of every tile in their area
+**
+**	Each unit is kept in the bucket of its top-left tile, together with the tile rectangle it occupies. Queries extend the buckets they visit by the size of the largest unit placed so far, so that units overlapping the area from an outside bucket are found as well.
+**	Each bucket also has a mask of the players owning units in it, which allows rejecting an area by owner without visiting any unit. The mask may contain players which no longer have units in the bucket, but never lacks one which does.
+*/
+class unit_spatial_index final
+{
+public:
+	static constexpr int bucket_size = 8;
+
+	explicit unit_spatial_index(const QSize &map_size);
+
+	void insert(CUnit *unit);
+	void remove(CUnit *unit);
+	void on_unit_owner_changed(const CUnit *unit);
+
+	uint32_t get_player_mask(const QRect &tile_rect) const;
+
+	/**
+	**	@brief	Call a function for each unit whose occupied tiles intersect a tile rectangle
+	**
+	**	The function is called with the unit and its occupied tile rectangle. The units are visited in bucket order, which depends on the order of placement.
+	**
+	**	@param	tile_rect	The tile rectangle
+	**	@param	function	The function
+	*/
+	template <typename function_type>
+	void for_each_unit_in_rect(const QRect &tile_rect, const function_type &function) const
+	{
+		const QRect bucket_rect = this->get_bucket_rect(tile_rect);
+
+		for (int bucket_y = bucket_rect.top(); bucket_y <= bucket_rect.bottom(); ++bucket_y) {
+			for (int bucket_x = bucket_rect.left(); bucket_x <= bucket_rect.right(); ++bucket_x) {
+				const bucket &bucket = this->buckets[bucket_x + bucket_y * this->bucket_grid_size.width()];
+
+				for (const unit_entry &entry : bucket.units) {
+					if (entry.tile_rect.intersects(tile_rect)) {
+						function(entry.unit, entry.tile_rect);
+					}
+				}
+			}
+		}
+	}
+
+	/**
+	**	@brief	Call a function for each unit of the given players, and optionally of a given unit type, whose occupied tiles intersect a tile rectangle
+	**
+	**	Buckets without units of the players are skipped without visiting their units, so this is faster than filtering the units of for_each_unit_in_rect, e.g. when looking for the units of a player's enemies near its own units.
+	**
+	**	@param	tile_rect	The tile rectangle
+	**	@param	player_mask	The mask of the player indexes whose units are visited
+	**	@param	unit_type	The unit type of the visited units, or null to visit units of any type
+	**	@param	function	The function
+	*/
+	template <typename function_type>
+	void for_each_unit_in_rect(const QRect &tile_rect, const uint32_t player_mask, const unit_type *unit_type, const function_type &function) const
+	{
+		const QRect bucket_rect = this->get_bucket_rect(tile_rect);
+
+		for (int bucket_y = bucket_rect.top(); bucket_y <= bucket_rect.bottom(); ++bucket_y) {
+			for (int bucket_x = bucket_rect.left(); bucket_x <= bucket_rect.right(); ++bucket_x) {
+				const bucket &bucket = this->buckets[bucket_x + bucket_y * this->bucket_grid_size.width()];
+
+				if ((bucket.player_mask & player_mask) == 0) {
+					continue;
+				}
+
+				for (const unit_entry &entry : bucket.units) {
+					if (!entry.tile_rect.intersects(tile_rect)) {
+						continue;
+					}
+
+					if ((player_mask & (1u << unit_spatial_index::get_unit_player_index(entry.unit))) == 0) {
+						continue;
+					}
+
+					if (unit_type != nullptr && unit_spatial_index::get_unit_type(entry.unit) != unit_type) {
+						continue;
+					}
+
+					function(entry.unit, entry.tile_rect);
+				}
+			}
+		}
+	}
+
+private:
+	static int get_unit_player_index(const CUnit *unit);
+	static const unit_type *get_unit_type(const CUnit *unit);
+
+	QRect get_bucket_rect(const QRect &tile_rect) const;
+	QRect get_unit_tile_rect(const CUnit *unit) const;
+
+	struct unit_entry
+	{
+		CUnit *unit = nullptr;
+		QRect tile_rect;
+	};
+
+	struct bucket
+	{
+		std::vector<unit_entry> units;
+		uint32_t player_mask = 0;
+	};
+
+	bucket &get_unit_bucket(const CUnit *unit);
+
+	QSize map_size;
+	QSize bucket_grid_size;
+	std::vector<bucket> buckets;
+	int max_unit_size = 1; //the greatest width or height of the units placed so far
+};
+
+}
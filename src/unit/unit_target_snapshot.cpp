@@ -0,0 +1,168 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+//      (c) Copyright 2020 by Andrettin
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+//
+
+#include "stratagus.h"
+
+#include "unit/unit_target_snapshot.h"
+
+#include "actions.h"
+#include "map/map.h"
+#include "map/map_layer.h"
+#include "unit/unit.h"
+#include "unit/unit_find.h"
+#include "unit/unit_manager.h"
+#include "unit/unit_type.h"
+#include "util/thread_pool.h"
+
+namespace stratagus {
+
+/**
+**	@brief	Select the units around each unit which may look for a target, using the worker threads
+**
+**	Must be called while no game state is being changed, i.e. at the start of UnitActions, after the unit manager's iteration generation has been started.
+*/
+void unit_target_snapshot::take()
+{
+	this->entries.resize(UnitManager.GetUsedSlotCount());
+
+	thread_pool::get()->parallel_for(this->entries.size(), [this](const size_t begin, const size_t end) {
+		for (size_t slot = begin; slot < end; ++slot) {
+			unit_entry &entry = this->entries[slot];
+			entry.valid = false;
+			entry.candidates.clear();
+
+			const CUnit *unit = UnitManager.GetIterableSlotUnit(static_cast<unsigned int>(slot));
+			if (unit != nullptr) {
+				this->take_unit(*unit);
+			}
+		}
+	});
+
+	this->active = true;
+}
+
+/**
+**	@brief	End the commit phase, after which the snapshot is no longer used
+*/
+void unit_target_snapshot::clear()
+{
+	this->active = false;
+}
+
+/**
+**	@brief	Select the units around a unit which it could choose a target from within its reaction range
+**
+**	Runs on the worker threads, so it must only read game state. Each unit writes only to its own slot's entry.
+**
+**	@param	unit	The unit
+*/
+void unit_target_snapshot::take_unit(const CUnit &unit)
+{
+	if (unit.Destroyed || unit.Type == nullptr || unit.Player == nullptr) {
+		return;
+	}
+
+	//only units in the actions which look for targets in their reaction range are taken into the snapshot; the others search the unit caches if they need to
+	switch (unit.CurrentAction()) {
+		case UnitAction::Still:
+		case UnitAction::StandGround:
+		case UnitAction::Follow:
+		case UnitAction::Defend:
+		case UnitAction::Attack:
+		case UnitAction::Patrol:
+			break;
+		default:
+			return;
+	}
+
+	if (!unit.CanAttack()) {
+		return;
+	}
+
+	const CUnit *first_container = unit.GetFirstContainer();
+	if (first_container->Removed || first_container->MapLayer == nullptr) {
+		return;
+	}
+
+	const int range = GetTargetSelectionRange(unit, unit.GetReactionRange());
+
+	//mirror the area of SelectAroundUnit
+	const Vec2i offset(range, range);
+	const Vec2i type_size(first_container->Type->get_tile_size() - QSize(1, 1));
+	Vec2i min_pos = first_container->tilePos - offset;
+	Vec2i max_pos = first_container->tilePos + type_size + offset;
+	const int z = first_container->MapLayer->ID;
+	CMap::Map.FixSelectionArea(min_pos, max_pos, z);
+
+	unit_entry &entry = this->entries[UnitNumber(unit)];
+	SelectFixedFromIndex(min_pos, max_pos, entry.candidates, z, IsNotTheSameUnitAs(*first_container), true);
+	entry.first_container = first_container;
+	entry.tile_pos = QPoint(first_container->tilePos.x, first_container->tilePos.y);
+	entry.z = z;
+	entry.range = range;
+	entry.valid = true;
+}
+
+/**
+**	@brief	Get the units a unit can choose a target from, as selected at the start of the cycle
+**
+**	@param	unit	The unit searching for targets
+**	@param	range	The selection range
+**	@param	circle	Whether the selection is circular
+**
+**	@return	The selected units, which may since have left the map, or null if the search has to select the units from the unit caches
+*/
+const std::vector<CUnit *> *unit_target_snapshot::get_candidates(const CUnit &unit, const int range, const bool circle) const
+{
+	if (!this->active || !circle) {
+		return nullptr;
+	}
+
+	const int slot = UnitNumber(unit);
+	if (slot < 0 || slot >= static_cast<int>(this->entries.size())) {
+		return nullptr;
+	}
+
+	const unit_entry &entry = this->entries[slot];
+	if (!entry.valid || entry.range != range) {
+		return nullptr;
+	}
+
+	//the selection is only used if the unit is still where it was taken, as otherwise it would cover a different area
+	const CUnit *first_container = unit.GetFirstContainer();
+	if (first_container != entry.first_container || first_container->Removed || first_container->MapLayer == nullptr || first_container->MapLayer->ID != entry.z) {
+		return nullptr;
+	}
+
+	if (first_container->tilePos.x != entry.tile_pos.x() || first_container->tilePos.y != entry.tile_pos.y()) {
+		return nullptr;
+	}
+
+	return &entry.candidates;
+}
+
+}
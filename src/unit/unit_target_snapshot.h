@@ -0,0 +1,69 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+//      (c) Copyright 2020 by Andrettin
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+//
+
+#pragma once
+
+#include "util/singleton.h"
+
+class CUnit;
+
+namespace stratagus {
+
+/**
+**	@brief	Frozen snapshot of the units around each unit which may look for targets, gathered in parallel at the start of each game cycle's unit actions
+**
+**	The unit actions of a cycle run in two phases. First, the units around each unit which may look for a target in its reaction range are selected on the worker threads, against the game state of the start of the cycle; nothing changes the game state meanwhile, and each unit only writes to the entry of its own slot.
+**	Then the units act serially and in slot order, as before. A unit searching for a target takes the units it can choose from out of the snapshot instead of the unit caches, while the choice itself, and everything it changes, is made against the current game state.
+**	The snapshot is taken in the same way regardless of the quantity of threads, so the outcome of a cycle, and with it the sync hash, is the same on every machine.
+*/
+class unit_target_snapshot final : public singleton<unit_target_snapshot>
+{
+public:
+	void take();
+	void clear();
+
+	const std::vector<CUnit *> *get_candidates(const CUnit &unit, const int range, const bool circle) const;
+
+private:
+	void take_unit(const CUnit &unit);
+
+private:
+	struct unit_entry
+	{
+		bool valid = false;
+		const CUnit *first_container = nullptr; //the unit whose position the units were selected around, which is itself excluded from them
+		QPoint tile_pos; //the position of the first container when the snapshot was taken
+		int z = -1;
+		int range = 0; //the selection range
+		std::vector<CUnit *> candidates; //the selected units, in the order SelectAroundUnit gives them
+	};
+
+	bool active = false;
+	std::vector<unit_entry> entries; //indexed by unit slot
+};
+
+}
@@ -548,9 +548,9 @@ unit_type::unit_type(const std::string &identifier) : detailed_data_entry(identi
 
 	this->BoolFlag.resize(UnitTypeVar.GetNumberBoolFlag());
 
-	this->DefaultStat.Variables.resize(UnitTypeVar.GetNumberVariable());
+	this->DefaultStat.Variables.get_mutable().resize(UnitTypeVar.GetNumberVariable());
 	for (unsigned int i = 0; i < UnitTypeVar.GetNumberVariable(); ++i) {
-		this->DefaultStat.Variables[i] = UnitTypeVar.Variable[i];
+		this->DefaultStat.Variables.get_mutable()[i] = UnitTypeVar.Variable[i];
 	}
 }
 
@@ -622,8 +622,8 @@ void unit_type::process_sml_property(const sml_property &property)
 		this->FireMissile.Name = value;
 		this->FireMissile.Missile = nullptr;
 	} else if (key == "priority") {
-		this->DefaultStat.Variables[PRIORITY_INDEX].Value = std::stoi(value);
-		this->DefaultStat.Variables[PRIORITY_INDEX].Max = std::stoi(value);
+		this->DefaultStat.Variables.get_mutable()[PRIORITY_INDEX].Value = std::stoi(value);
+		this->DefaultStat.Variables.get_mutable()[PRIORITY_INDEX].Max = std::stoi(value);
 	} else if (key == "button_key") {
 		this->button_key = value;
 	} else if (key == "button_hint") {
@@ -648,13 +648,13 @@ void unit_type::process_sml_property(const sml_property &property)
 			throw std::runtime_error("Invalid unit type type: \"" + value + "\"");
 		}
 	} else if (key == "max_attack_range") {
-		this->DefaultStat.Variables[ATTACKRANGE_INDEX].Value = std::stoi(value);
-		this->DefaultStat.Variables[ATTACKRANGE_INDEX].Max = std::stoi(value);
-		this->DefaultStat.Variables[ATTACKRANGE_INDEX].Enable = 1;
+		this->DefaultStat.Variables.get_mutable()[ATTACKRANGE_INDEX].Value = std::stoi(value);
+		this->DefaultStat.Variables.get_mutable()[ATTACKRANGE_INDEX].Max = std::stoi(value);
+		this->DefaultStat.Variables.get_mutable()[ATTACKRANGE_INDEX].Enable = 1;
 	} else if (key == "max_on_board") {
 		this->MaxOnBoard = std::stoi(value);
-		this->DefaultStat.Variables[TRANSPORT_INDEX].Max = this->MaxOnBoard;
-		this->DefaultStat.Variables[TRANSPORT_INDEX].Enable = 1;
+		this->DefaultStat.Variables.get_mutable()[TRANSPORT_INDEX].Max = this->MaxOnBoard;
+		this->DefaultStat.Variables.get_mutable()[TRANSPORT_INDEX].Enable = 1;
 	} else if (key == "annoy_computer_factor") {
 		this->AnnoyComputerFactor = std::stoi(value);
 	} else if (key == "can_target_land") {
@@ -706,11 +706,11 @@ void unit_type::process_sml_property(const sml_property &property)
 		int index = UnitTypeVar.VariableNameLookup[pascal_case_key.c_str()]; // variable index
 		if (index != -1) { // valid index
 			if (string::is_number(value)) {
-				this->DefaultStat.Variables[index].Enable = 1;
-				this->DefaultStat.Variables[index].Value = std::stoi(value);
-				this->DefaultStat.Variables[index].Max = std::stoi(value);
+				this->DefaultStat.Variables.get_mutable()[index].Enable = 1;
+				this->DefaultStat.Variables.get_mutable()[index].Value = std::stoi(value);
+				this->DefaultStat.Variables.get_mutable()[index].Max = std::stoi(value);
 			} else if (IsStringBool(value)) {
-				this->DefaultStat.Variables[index].Enable = string::to_bool(value);
+				this->DefaultStat.Variables.get_mutable()[index].Enable = string::to_bool(value);
 			} else { // error
 				fprintf(stderr, "Invalid value (\"%s\") for variable \"%s\" when defining unit type \"%s\".\n", value.c_str(), key.c_str(), this->get_identifier().c_str());
 			}
@@ -770,8 +770,8 @@ void unit_type::process_sml_scope(const sml_data &scope)
 	} else if (tag == "can_transport") {
 		if (this->MaxOnBoard == 0) { // set default value.
 			this->MaxOnBoard = 1;
-			this->DefaultStat.Variables[TRANSPORT_INDEX].Max = this->MaxOnBoard;
-			this->DefaultStat.Variables[TRANSPORT_INDEX].Enable = 1;
+			this->DefaultStat.Variables.get_mutable()[TRANSPORT_INDEX].Max = this->MaxOnBoard;
+			this->DefaultStat.Variables.get_mutable()[TRANSPORT_INDEX].Enable = 1;
 		}
 
 		if (this->BoolFlag.size() < UnitTypeVar.GetNumberBoolFlag()) {
@@ -808,8 +808,8 @@ void unit_type::process_sml_scope(const sml_data &scope)
 			database::process_sml_data(res_info_ptr, child_scope);
 		});
 	} else if (tag == "variations") {
-		this->DefaultStat.Variables[VARIATION_INDEX].Enable = 1;
-		this->DefaultStat.Variables[VARIATION_INDEX].Value = 0;
+		this->DefaultStat.Variables.get_mutable()[VARIATION_INDEX].Enable = 1;
+		this->DefaultStat.Variables.get_mutable()[VARIATION_INDEX].Value = 0;
 
 		scope.for_each_child([&](const sml_data &child_scope) {
 			const std::string &tag = child_scope.get_tag();
@@ -820,7 +820,7 @@ void unit_type::process_sml_scope(const sml_data &scope)
 			this->variations.push_back(std::move(variation));
 		});
 
-		this->DefaultStat.Variables[VARIATION_INDEX].Max = static_cast<int>(this->variations.size());
+		this->DefaultStat.Variables.get_mutable()[VARIATION_INDEX].Max = static_cast<int>(this->variations.size());
 	} else if (tag == "button_icons") {
 		this->ButtonIcons.clear();
 
@@ -910,8 +910,8 @@ void unit_type::ProcessConfigData(const CConfigData *config_data)
 				fprintf(stderr, "Invalid unit type type: \"%s\".\n", value.c_str());
 			}
 		} else if (key == "priority") {
-			this->DefaultStat.Variables[PRIORITY_INDEX].Value = std::stoi(value);
-			this->DefaultStat.Variables[PRIORITY_INDEX].Max  = std::stoi(value);
+			this->DefaultStat.Variables.get_mutable()[PRIORITY_INDEX].Value = std::stoi(value);
+			this->DefaultStat.Variables.get_mutable()[PRIORITY_INDEX].Max  = std::stoi(value);
 		} else if (key == "description") {
 			this->set_description(value);
 		} else if (key == "background") {
@@ -925,9 +925,9 @@ void unit_type::ProcessConfigData(const CConfigData *config_data)
 		} else if (key == "building_rules_string") {
 			this->BuildingRulesString = value;
 		} else if (key == "max_attack_range") {
-			this->DefaultStat.Variables[ATTACKRANGE_INDEX].Value = std::stoi(value);
-			this->DefaultStat.Variables[ATTACKRANGE_INDEX].Max = std::stoi(value);
-			this->DefaultStat.Variables[ATTACKRANGE_INDEX].Enable = 1;
+			this->DefaultStat.Variables.get_mutable()[ATTACKRANGE_INDEX].Value = std::stoi(value);
+			this->DefaultStat.Variables.get_mutable()[ATTACKRANGE_INDEX].Max = std::stoi(value);
+			this->DefaultStat.Variables.get_mutable()[ATTACKRANGE_INDEX].Enable = 1;
 		} else if (key == "missile") {
 			this->Missile.Name = value;
 			this->Missile.Missile = nullptr;
@@ -1025,11 +1025,11 @@ void unit_type::ProcessConfigData(const CConfigData *config_data)
 			int index = UnitTypeVar.VariableNameLookup[key.c_str()]; // variable index
 			if (index != -1) { // valid index
 				if (string::is_number(value)) {
-					this->DefaultStat.Variables[index].Enable = 1;
-					this->DefaultStat.Variables[index].Value = std::stoi(value);
-					this->DefaultStat.Variables[index].Max = std::stoi(value);
+					this->DefaultStat.Variables.get_mutable()[index].Enable = 1;
+					this->DefaultStat.Variables.get_mutable()[index].Value = std::stoi(value);
+					this->DefaultStat.Variables.get_mutable()[index].Max = std::stoi(value);
 				} else if (IsStringBool(value)) {
-					this->DefaultStat.Variables[index].Enable = string::to_bool(value);
+					this->DefaultStat.Variables.get_mutable()[index].Enable = string::to_bool(value);
 				} else { // error
 					fprintf(stderr, "Invalid value (\"%s\") for variable \"%s\" when defining unit type \"%s\".\n", value.c_str(), key.c_str(), this->Ident.c_str());
 				}
@@ -1200,13 +1200,13 @@ void unit_type::ProcessConfigData(const CConfigData *config_data)
 					std::string value = child_config_data->Properties[j].second;
 					
 					if (key == "enable") {
-						this->DefaultStat.Variables[index].Enable = string::to_bool(value);
+						this->DefaultStat.Variables.get_mutable()[index].Enable = string::to_bool(value);
 					} else if (key == "value") {
-						this->DefaultStat.Variables[index].Value = std::stoi(value);
+						this->DefaultStat.Variables.get_mutable()[index].Value = std::stoi(value);
 					} else if (key == "max") {
-						this->DefaultStat.Variables[index].Max = std::stoi(value);
+						this->DefaultStat.Variables.get_mutable()[index].Max = std::stoi(value);
 					} else if (key == "increase") {
-						this->DefaultStat.Variables[index].Increase = std::stoi(value);
+						this->DefaultStat.Variables.get_mutable()[index].Increase = std::stoi(value);
 					} else {
 						fprintf(stderr, "Invalid variable property: \"%s\".\n", key.c_str());
 					}
@@ -1252,9 +1252,9 @@ void unit_type::initialize()
 
 	//unit type's level must be at least 1
 	if (this->DefaultStat.Variables[LEVEL_INDEX].Value == 0) {
-		this->DefaultStat.Variables[LEVEL_INDEX].Enable = 1;
-		this->DefaultStat.Variables[LEVEL_INDEX].Value = 1;
-		this->DefaultStat.Variables[LEVEL_INDEX].Max = 1;
+		this->DefaultStat.Variables.get_mutable()[LEVEL_INDEX].Enable = 1;
+		this->DefaultStat.Variables.get_mutable()[LEVEL_INDEX].Value = 1;
+		this->DefaultStat.Variables.get_mutable()[LEVEL_INDEX].Max = 1;
 	}
 
 	// FIXME: try to simplify/combine the flags instead
@@ -1489,10 +1489,10 @@ void unit_type::set_parent(const unit_type *parent_type)
 	this->Explosion.Missile = nullptr;
 	this->corpse_type = parent_type->corpse_type;
 	this->MinAttackRange = parent_type->MinAttackRange;
-	this->DefaultStat.Variables[ATTACKRANGE_INDEX].Value = parent_type->DefaultStat.Variables[ATTACKRANGE_INDEX].Value;
-	this->DefaultStat.Variables[ATTACKRANGE_INDEX].Max = parent_type->DefaultStat.Variables[ATTACKRANGE_INDEX].Max;
-	this->DefaultStat.Variables[PRIORITY_INDEX].Value = parent_type->DefaultStat.Variables[PRIORITY_INDEX].Value;
-	this->DefaultStat.Variables[PRIORITY_INDEX].Max  = parent_type->DefaultStat.Variables[PRIORITY_INDEX].Max;
+	this->DefaultStat.Variables.get_mutable()[ATTACKRANGE_INDEX].Value = parent_type->DefaultStat.Variables[ATTACKRANGE_INDEX].Value;
+	this->DefaultStat.Variables.get_mutable()[ATTACKRANGE_INDEX].Max = parent_type->DefaultStat.Variables[ATTACKRANGE_INDEX].Max;
+	this->DefaultStat.Variables.get_mutable()[PRIORITY_INDEX].Value = parent_type->DefaultStat.Variables[PRIORITY_INDEX].Value;
+	this->DefaultStat.Variables.get_mutable()[PRIORITY_INDEX].Max  = parent_type->DefaultStat.Variables[PRIORITY_INDEX].Max;
 	this->AnnoyComputerFactor = parent_type->AnnoyComputerFactor;
 	this->TrainQuantity = parent_type->TrainQuantity;
 	this->CostModifier = parent_type->CostModifier;
@@ -1559,10 +1559,10 @@ void unit_type::set_parent(const unit_type *parent_type)
 	this->DefaultStat.UnitStock = parent_type->DefaultStat.UnitStock;
 
 	for (unsigned int i = 0; i < UnitTypeVar.GetNumberVariable(); ++i) {
-		this->DefaultStat.Variables[i].Enable = parent_type->DefaultStat.Variables[i].Enable;
-		this->DefaultStat.Variables[i].Value = parent_type->DefaultStat.Variables[i].Value;
-		this->DefaultStat.Variables[i].Max = parent_type->DefaultStat.Variables[i].Max;
-		this->DefaultStat.Variables[i].Increase = parent_type->DefaultStat.Variables[i].Increase;
+		this->DefaultStat.Variables.get_mutable()[i].Enable = parent_type->DefaultStat.Variables[i].Enable;
+		this->DefaultStat.Variables.get_mutable()[i].Value = parent_type->DefaultStat.Variables[i].Value;
+		this->DefaultStat.Variables.get_mutable()[i].Max = parent_type->DefaultStat.Variables[i].Max;
+		this->DefaultStat.Variables.get_mutable()[i].Increase = parent_type->DefaultStat.Variables[i].Increase;
 	}
 	for (unsigned int i = 0; i < UnitTypeVar.GetNumberBoolFlag(); ++i) {
 		this->BoolFlag[i].value = parent_type->BoolFlag[i].value;
@@ -1630,8 +1630,8 @@ void unit_type::set_parent(const unit_type *parent_type)
 		this->ButtonIcons[iterator->first].Load();
 	}
 	this->DefaultEquipment = parent_type->DefaultEquipment;
-	this->DefaultStat.Variables[PRIORITY_INDEX].Value = parent_type->DefaultStat.Variables[PRIORITY_INDEX].Value + 1; //increase priority by 1 to make it be chosen by the AI when building over the previous unit
-	this->DefaultStat.Variables[PRIORITY_INDEX].Max = parent_type->DefaultStat.Variables[PRIORITY_INDEX].Max + 1;
+	this->DefaultStat.Variables.get_mutable()[PRIORITY_INDEX].Value = parent_type->DefaultStat.Variables[PRIORITY_INDEX].Value + 1; //increase priority by 1 to make it be chosen by the AI when building over the previous unit
+	this->DefaultStat.Variables.get_mutable()[PRIORITY_INDEX].Max = parent_type->DefaultStat.Variables[PRIORITY_INDEX].Max + 1;
 }
 
 void unit_type::UpdateDefaultBoolFlags()
@@ -1965,11 +1965,11 @@ void UpdateUnitStats(stratagus::unit_type &type, int reset)
 		type.MapDefaultStat = type.DefaultStat;
 		for (std::map<std::string, CUnitStats>::iterator iterator = type.ModDefaultStats.begin(); iterator != type.ModDefaultStats.end(); ++iterator) {
 			for (size_t i = 0; i < UnitTypeVar.GetNumberVariable(); ++i) {
-				type.MapDefaultStat.Variables[i].Value += iterator->second.Variables[i].Value;
-				type.MapDefaultStat.Variables[i].Max += iterator->second.Variables[i].Max;
-				type.MapDefaultStat.Variables[i].Increase += iterator->second.Variables[i].Increase;
+				type.MapDefaultStat.Variables.get_mutable()[i].Value += iterator->second.Variables[i].Value;
+				type.MapDefaultStat.Variables.get_mutable()[i].Max += iterator->second.Variables[i].Max;
+				type.MapDefaultStat.Variables.get_mutable()[i].Increase += iterator->second.Variables[i].Increase;
 				if (iterator->second.Variables[i].Enable != 0) {
-					type.MapDefaultStat.Variables[i].Enable = iterator->second.Variables[i].Enable;
+					type.MapDefaultStat.Variables.get_mutable()[i].Enable = iterator->second.Variables[i].Enable;
 				}
 			}
 
@@ -54,4 +54,56 @@ public:
 	char Enable = 0;    /// True if the unit doesn't have this variable. (f.e shield)
 };
 
+/**
+**	@brief	A list of unit variables, whose copies share the same data until one of them is modified
+**
+**	Read access is always const, so that reading from a non-const owner does not separate it from the shared data; modification has to go through get_mutable().
+*/
+class shared_unit_variables final
+{
+public:
+	shared_unit_variables() : variables(shared_unit_variables::get_empty_variables())
+	{
+	}
+
+	const unit_variable &operator [](const size_t index) const
+	{
+		return (*this->variables)[index];
+	}
+
+	operator const std::vector<unit_variable> &() const
+	{
+		return *this->variables;
+	}
+
+	size_t size() const
+	{
+		return this->variables->size();
+	}
+
+	bool empty() const
+	{
+		return this->variables->empty();
+	}
+
+	std::vector<unit_variable> &get_mutable()
+	{
+		//copy the data first if it is shared with other instances
+		if (this->variables.use_count() > 1) {
+			this->variables = std::make_shared<std::vector<unit_variable>>(*this->variables);
+		}
+
+		return *this->variables;
+	}
+
+private:
+	static const std::shared_ptr<std::vector<unit_variable>> &get_empty_variables()
+	{
+		static const std::shared_ptr<std::vector<unit_variable>> empty_variables = std::make_shared<std::vector<unit_variable>>();
+		return empty_variables;
+	}
+
+	std::shared_ptr<std::vector<unit_variable>> variables;
+};
+
 }
\ No newline at end of file
@@ -734,7 +734,7 @@ static int CclDefineModifier(lua_State *l)
 		}
 		const char *key = LuaToString(l, j + 1, 1);
 		if (!strcmp(key, "regeneration-rate")) {
-			um->Modifier.Variables[HP_INDEX].Increase = LuaToNumber(l, j + 1, 2);
+			um->Modifier.Variables.get_mutable()[HP_INDEX].Increase = LuaToNumber(l, j + 1, 2);
 		} else if (!strcmp(key, "cost")) {
 			//Wyrmgus start
 //			if (!lua_istable(l, j + 1) || lua_rawlen(l, j + 1) != 2) {
@@ -825,17 +825,17 @@ static int CclDefineModifier(lua_State *l)
 						um->ModifyPercent[index] = LuaToNumber(l, j + 1, 2);
 					//Wyrmgus start
 					} else if (!strcmp(value, "Increase")) {
-						um->Modifier.Variables[index].Increase = LuaToNumber(l, j + 1, 2);
+						um->Modifier.Variables.get_mutable()[index].Increase = LuaToNumber(l, j + 1, 2);
 					//Wyrmgus end
 					}
 				} else {
 					lua_rawgeti(l, j + 1, 2);
 					if (lua_istable(l, -1)) {
-						DefineVariableField(l, um->Modifier.Variables[index], -1);
+						DefineVariableField(l, um->Modifier.Variables.get_mutable()[index], -1);
 					} else if (lua_isnumber(l, -1)) {
-						um->Modifier.Variables[index].Enable = 1;
-						um->Modifier.Variables[index].Value = LuaToNumber(l, -1);
-						um->Modifier.Variables[index].Max = LuaToNumber(l, -1);
+						um->Modifier.Variables.get_mutable()[index].Enable = 1;
+						um->Modifier.Variables.get_mutable()[index].Value = LuaToNumber(l, -1);
+						um->Modifier.Variables.get_mutable()[index].Max = LuaToNumber(l, -1);
 					} else {
 						LuaError(l, "bad argument type for '%s'\n" _C_ key);
 					}
@@ -1414,12 +1414,21 @@ static void ApplyUpgradeModifier(CPlayer &player, const stratagus::upgrade_modif
 	}
 	//Wyrmgus end
 
-	for (stratagus::unit_type *unit_type : stratagus::unit_type::get_all()) {
-		CUnitStats &stat = unit_type->Stats[pn];
+	int varModified = 0;
+	for (unsigned int j = 0; j < UnitTypeVar.GetNumberVariable(); j++) {
+		varModified |= um->Modifier.Variables[j].Value
+					   | um->Modifier.Variables[j].Max
+					   | um->Modifier.Variables[j].Increase
+					   | um->Modifier.Variables[j].Enable
+					   | um->ModifyPercent[j];
+	}
+
+	size_t initialized_unit_type_count = 0;
+	for (const stratagus::unit_type *unit_type : stratagus::unit_type::get_all()) {
 		// add/remove allowed units
 
 		//Wyrmgus start
-		if (stat.Variables.empty()) { // unit type's stats not initialized
+		if (unit_type->Stats[pn].Variables.empty()) { // unit type's stats not initialized
 			break;
 		}
 		//Wyrmgus end
@@ -1427,239 +1436,243 @@ static void ApplyUpgradeModifier(CPlayer &player, const stratagus::upgrade_modif
 		// FIXME: check if modify is allowed
 
 		player.Allow.Units[unit_type->Slot] += um->ChangeUnits[unit_type->Slot];
+		++initialized_unit_type_count;
+	}
+
+	// only go through the unit types to which this modifier should be applied
+	for (stratagus::unit_type *unit_type : um->get_affected_unit_types()) {
+		if (static_cast<size_t>(unit_type->Slot) >= initialized_unit_type_count) {
+			continue;
+		}
 
-		// this modifier should be applied to unittype id == z
-		if (um->applies_to(unit_type)) {
+		CUnitStats &stat = unit_type->Stats[pn];
 
-			// if a unit type's supply is changed, we need to update the player's supply accordingly
-			if (um->Modifier.Variables[SUPPLY_INDEX].Value) {
-				std::vector<CUnit *> unitupgrade;
+		// if a unit type's supply is changed, we need to update the player's supply accordingly
+		if (um->Modifier.Variables[SUPPLY_INDEX].Value) {
+			std::vector<CUnit *> unitupgrade;
 
-				FindUnitsByType(*unit_type, unitupgrade);
-				for (size_t j = 0; j != unitupgrade.size(); ++j) {
-					CUnit &unit = *unitupgrade[j];
-					if (unit.Player->Index == pn && unit.IsAlive()) {
-						unit.Player->Supply += um->Modifier.Variables[SUPPLY_INDEX].Value;
-					}
+			FindUnitsByType(*unit_type, unitupgrade);
+			for (size_t j = 0; j != unitupgrade.size(); ++j) {
+				CUnit &unit = *unitupgrade[j];
+				if (unit.Player->Index == pn && unit.IsAlive()) {
+					unit.Player->Supply += um->Modifier.Variables[SUPPLY_INDEX].Value;
 				}
 			}
-			
-			// if a unit type's demand is changed, we need to update the player's demand accordingly
-			if (um->Modifier.Variables[DEMAND_INDEX].Value) {
-				std::vector<CUnit *> unitupgrade;
+		}
+		
+		// if a unit type's demand is changed, we need to update the player's demand accordingly
+		if (um->Modifier.Variables[DEMAND_INDEX].Value) {
+			std::vector<CUnit *> unitupgrade;
 
-				FindUnitsByType(*unit_type, unitupgrade);
-				for (size_t j = 0; j != unitupgrade.size(); ++j) {
-					CUnit &unit = *unitupgrade[j];
-					if (unit.Player->Index == pn && unit.IsAlive()) {
-						unit.Player->Demand += um->Modifier.Variables[DEMAND_INDEX].Value;
-					}
+			FindUnitsByType(*unit_type, unitupgrade);
+			for (size_t j = 0; j != unitupgrade.size(); ++j) {
+				CUnit &unit = *unitupgrade[j];
+				if (unit.Player->Index == pn && unit.IsAlive()) {
+					unit.Player->Demand += um->Modifier.Variables[DEMAND_INDEX].Value;
 				}
 			}
-			
-			// upgrade costs :)
-			for (unsigned int j = 0; j < MaxCosts; ++j) {
-				stat.Costs[j] += um->Modifier.Costs[j];
-				stat.Storing[j] += um->Modifier.Storing[j];
-				if (um->Modifier.ImproveIncomes[j]) {
-					if (!stat.ImproveIncomes[j]) {
-						stat.ImproveIncomes[j] += stratagus::resource::get_all()[j]->DefaultIncome + um->Modifier.ImproveIncomes[j];
-					} else {
-						stat.ImproveIncomes[j] += um->Modifier.ImproveIncomes[j];
-					}
-					//update player's income
-					std::vector<CUnit *> unitupgrade;
-					FindUnitsByType(*unit_type, unitupgrade);
-					if (unitupgrade.size() > 0) {
-						player.Incomes[j] = std::max(player.Incomes[j], stat.ImproveIncomes[j]);
-					}
+		}
+		
+		// upgrade costs :)
+		for (unsigned int j = 0; j < MaxCosts; ++j) {
+			stat.Costs[j] += um->Modifier.Costs[j];
+			stat.Storing[j] += um->Modifier.Storing[j];
+			if (um->Modifier.ImproveIncomes[j]) {
+				if (!stat.ImproveIncomes[j]) {
+					stat.ImproveIncomes[j] += stratagus::resource::get_all()[j]->DefaultIncome + um->Modifier.ImproveIncomes[j];
+				} else {
+					stat.ImproveIncomes[j] += um->Modifier.ImproveIncomes[j];
 				}
-
-				stat.ResourceDemand[j] += um->Modifier.ResourceDemand[j];
-			}
-			
-			for (const auto &kv_pair : um->Modifier.UnitStock) {
-				const stratagus::unit_type *unit_type = stratagus::unit_type::get_all()[kv_pair.first];
-				const int unit_stock = kv_pair.second;
-				if (unit_stock != 0) {
-					stat.ChangeUnitStock(unit_type, unit_stock);
+				//update player's income
+				std::vector<CUnit *> unitupgrade;
+				FindUnitsByType(*unit_type, unitupgrade);
+				if (unitupgrade.size() > 0) {
+					player.Incomes[j] = std::max(player.Incomes[j], stat.ImproveIncomes[j]);
 				}
 			}
 
-			int varModified = 0;
+			stat.ResourceDemand[j] += um->Modifier.ResourceDemand[j];
+		}
+		
+		for (const auto &kv_pair : um->Modifier.UnitStock) {
+			const stratagus::unit_type *unit_type = stratagus::unit_type::get_all()[kv_pair.first];
+			const int unit_stock = kv_pair.second;
+			if (unit_stock != 0) {
+				stat.ChangeUnitStock(unit_type, unit_stock);
+			}
+		}
+
+		// the variables are only modified (and thus stop being shared with other players) if the modifier changes any of them
+		if (varModified) {
+			std::vector<stratagus::unit_variable> &stat_variables = stat.Variables.get_mutable();
 			for (unsigned int j = 0; j < UnitTypeVar.GetNumberVariable(); j++) {
-				varModified |= um->Modifier.Variables[j].Value
-							   | um->Modifier.Variables[j].Max
-							   | um->Modifier.Variables[j].Increase
-							   | um->Modifier.Variables[j].Enable
-							   | um->ModifyPercent[j];
-				stat.Variables[j].Enable |= um->Modifier.Variables[j].Enable;
+				stat_variables[j].Enable |= um->Modifier.Variables[j].Enable;
 				if (um->ModifyPercent[j]) {
 					if (j != MANA_INDEX || um->ModifyPercent[j] < 0) {
-						stat.Variables[j].Value += stat.Variables[j].Value * um->ModifyPercent[j] / 100;
+						stat_variables[j].Value += stat_variables[j].Value * um->ModifyPercent[j] / 100;
 					}
-					stat.Variables[j].Max += stat.Variables[j].Max * um->ModifyPercent[j] / 100;
+					stat_variables[j].Max += stat_variables[j].Max * um->ModifyPercent[j] / 100;
 				} else {
 					if (j != MANA_INDEX || um->Modifier.Variables[j].Value < 0) {
-						stat.Variables[j].Value += um->Modifier.Variables[j].Value;
+						stat_variables[j].Value += um->Modifier.Variables[j].Value;
 					}
-					stat.Variables[j].Max += um->Modifier.Variables[j].Max;
-					stat.Variables[j].Increase += um->Modifier.Variables[j].Increase;
+					stat_variables[j].Max += um->Modifier.Variables[j].Max;
+					stat_variables[j].Increase += um->Modifier.Variables[j].Increase;
 				}
 
-				stat.Variables[j].Max = std::max(stat.Variables[j].Max, 0);
+				stat_variables[j].Max = std::max(stat_variables[j].Max, 0);
 				//Wyrmgus start
-//				clamp(&stat.Variables[j].Value, 0, stat.Variables[j].Max);
-				if (stat.Variables[j].Max > 0) {
-					clamp(&stat.Variables[j].Value, 0, stat.Variables[j].Max);
+//					clamp(&stat_variables[j].Value, 0, stat_variables[j].Max);
+				if (stat_variables[j].Max > 0) {
+					clamp(&stat_variables[j].Value, 0, stat_variables[j].Max);
 				}
 				//Wyrmgus end
 			}
-			
-			if (um->Modifier.Variables[TRADECOST_INDEX].Value) {
-				std::vector<CUnit *> unitupgrade;
+		}
+		
+		if (um->Modifier.Variables[TRADECOST_INDEX].Value) {
+			std::vector<CUnit *> unitupgrade;
 
-				FindUnitsByType(*unit_type, unitupgrade);
-				if (unitupgrade.size() > 0) {
-					player.TradeCost = std::min(player.TradeCost, stat.Variables[TRADECOST_INDEX].Value);
-				}
+			FindUnitsByType(*unit_type, unitupgrade);
+			if (unitupgrade.size() > 0) {
+				player.TradeCost = std::min(player.TradeCost, stat.Variables[TRADECOST_INDEX].Value);
 			}
+		}
 
-			// And now modify ingame units
-			//Wyrmgus start
-			std::vector<CUnit *> unitupgrade;
+		// And now modify ingame units
+		//Wyrmgus start
+		std::vector<CUnit *> unitupgrade;
 
-			FindUnitsByType(*unit_type, unitupgrade, true);
-			//Wyrmgus end
-			
-			if (varModified) {
-				//Wyrmgus start
+		FindUnitsByType(*unit_type, unitupgrade, true);
+		//Wyrmgus end
+		
+		if (varModified) {
+			//Wyrmgus start
 //				std::vector<CUnit *> unitupgrade;
 
 //				FindUnitsByType(*UnitTypes[z], unitupgrade, true);
+			//Wyrmgus end
+			for (size_t j = 0; j != unitupgrade.size(); ++j) {
+				CUnit &unit = *unitupgrade[j];
+
+				if (unit.Player->Index != player.Index) {
+					continue;
+				}
+				
+				//Wyrmgus start
+				if (
+					(CUpgrade::get_all()[um->UpgradeId]->is_weapon() && unit.EquippedItems[static_cast<int>(stratagus::item_slot::weapon)].size() > 0)
+					|| (CUpgrade::get_all()[um->UpgradeId]->is_shield() && unit.EquippedItems[static_cast<int>(stratagus::item_slot::shield)].size() > 0)
+					|| (CUpgrade::get_all()[um->UpgradeId]->is_boots() && unit.EquippedItems[static_cast<int>(stratagus::item_slot::boots)].size() > 0)
+					|| (CUpgrade::get_all()[um->UpgradeId]->is_arrows() && unit.EquippedItems[static_cast<int>(stratagus::item_slot::arrows)].size() > 0)
+				) { //if the unit already has an item equipped of the same equipment type as this upgrade, don't apply the modifier to it
+					continue;
+				}
+				
+				if (unit.Character && !strncmp(CUpgrade::get_all()[um->UpgradeId]->Ident.c_str(), "upgrade-deity-", 14)) { //heroes choose their own deities
+					continue;
+				}
 				//Wyrmgus end
-				for (size_t j = 0; j != unitupgrade.size(); ++j) {
-					CUnit &unit = *unitupgrade[j];
+				
+				for (unsigned int j = 0; j < UnitTypeVar.GetNumberVariable(); j++) {
+					unit.Variable[j].Enable |= um->Modifier.Variables[j].Enable;
+					if (um->ModifyPercent[j]) {
+						if (j != MANA_INDEX || um->ModifyPercent[j] < 0) {
+							unit.Variable[j].Value += unit.Variable[j].Value * um->ModifyPercent[j] / 100;
+						}
+						unit.Variable[j].Max += unit.Variable[j].Max * um->ModifyPercent[j] / 100;
+					} else {
+						if (j != MANA_INDEX || um->Modifier.Variables[j].Value < 0) {
+							unit.Variable[j].Value += um->Modifier.Variables[j].Value;
+						}
+						unit.change_variable_increase(j, um->Modifier.Variables[j].Increase);
+					}
 
-					if (unit.Player->Index != player.Index) {
-						continue;
+					unit.Variable[j].Max += um->Modifier.Variables[j].Max;
+					unit.Variable[j].Max = std::max(unit.Variable[j].Max, 0);
+					if (unit.Variable[j].Max > 0) {
+						clamp(&unit.Variable[j].Value, 0, unit.Variable[j].Max);
 					}
-					
 					//Wyrmgus start
-					if (
-						(CUpgrade::get_all()[um->UpgradeId]->is_weapon() && unit.EquippedItems[static_cast<int>(stratagus::item_slot::weapon)].size() > 0)
-						|| (CUpgrade::get_all()[um->UpgradeId]->is_shield() && unit.EquippedItems[static_cast<int>(stratagus::item_slot::shield)].size() > 0)
-						|| (CUpgrade::get_all()[um->UpgradeId]->is_boots() && unit.EquippedItems[static_cast<int>(stratagus::item_slot::boots)].size() > 0)
-						|| (CUpgrade::get_all()[um->UpgradeId]->is_arrows() && unit.EquippedItems[static_cast<int>(stratagus::item_slot::arrows)].size() > 0)
-					) { //if the unit already has an item equipped of the same equipment type as this upgrade, don't apply the modifier to it
-						continue;
-					}
-					
-					if (unit.Character && !strncmp(CUpgrade::get_all()[um->UpgradeId]->Ident.c_str(), "upgrade-deity-", 14)) { //heroes choose their own deities
-						continue;
+					if (j == ATTACKRANGE_INDEX && unit.Container) {
+						unit.Container->UpdateContainerAttackRange();
+					} else if (j == LEVEL_INDEX || j == POINTS_INDEX) {
+						unit.UpdateXPRequired();
+					} else if (IsKnowledgeVariable(j)) {
+						unit.CheckKnowledgeChange(j, um->Modifier.Variables[j].Value);
+					} else if ((j == SIGHTRANGE_INDEX || j == DAYSIGHTRANGEBONUS_INDEX || j == NIGHTSIGHTRANGEBONUS_INDEX) && !unit.Removed) {
+						// If Sight range is upgraded, we need to change EVERY unit
+						// to the new range, otherwise the counters get confused.
+						MapUnmarkUnitSight(unit);
+						UpdateUnitSightRange(unit);
+						MapMarkUnitSight(unit);
 					}
 					//Wyrmgus end
-					
-					for (unsigned int j = 0; j < UnitTypeVar.GetNumberVariable(); j++) {
-						unit.Variable[j].Enable |= um->Modifier.Variables[j].Enable;
-						if (um->ModifyPercent[j]) {
-							if (j != MANA_INDEX || um->ModifyPercent[j] < 0) {
-								unit.Variable[j].Value += unit.Variable[j].Value * um->ModifyPercent[j] / 100;
-							}
-							unit.Variable[j].Max += unit.Variable[j].Max * um->ModifyPercent[j] / 100;
-						} else {
-							if (j != MANA_INDEX || um->Modifier.Variables[j].Value < 0) {
-								unit.Variable[j].Value += um->Modifier.Variables[j].Value;
-							}
-							unit.Variable[j].Increase += um->Modifier.Variables[j].Increase;
-						}
-
-						unit.Variable[j].Max += um->Modifier.Variables[j].Max;
-						unit.Variable[j].Max = std::max(unit.Variable[j].Max, 0);
-						if (unit.Variable[j].Max > 0) {
-							clamp(&unit.Variable[j].Value, 0, unit.Variable[j].Max);
-						}
-						//Wyrmgus start
-						if (j == ATTACKRANGE_INDEX && unit.Container) {
-							unit.Container->UpdateContainerAttackRange();
-						} else if (j == LEVEL_INDEX || j == POINTS_INDEX) {
-							unit.UpdateXPRequired();
-						} else if (IsKnowledgeVariable(j)) {
-							unit.CheckKnowledgeChange(j, um->Modifier.Variables[j].Value);
-						} else if ((j == SIGHTRANGE_INDEX || j == DAYSIGHTRANGEBONUS_INDEX || j == NIGHTSIGHTRANGEBONUS_INDEX) && !unit.Removed) {
-							// If Sight range is upgraded, we need to change EVERY unit
-							// to the new range, otherwise the counters get confused.
-							MapUnmarkUnitSight(unit);
-							UpdateUnitSightRange(unit);
-							MapMarkUnitSight(unit);
-						}
-						//Wyrmgus end
-					}
-					
-					for (const auto &kv_pair : um->Modifier.UnitStock) {
-						const stratagus::unit_type *unit_type = stratagus::unit_type::get_all()[kv_pair.first];
-						const int unit_stock = kv_pair.second;
-						if (unit_stock < 0) {
-							unit.ChangeUnitStock(unit_type, unit_stock);
-						}
+				}
+				
+				for (const auto &kv_pair : um->Modifier.UnitStock) {
+					const stratagus::unit_type *unit_type = stratagus::unit_type::get_all()[kv_pair.first];
+					const int unit_stock = kv_pair.second;
+					if (unit_stock < 0) {
+						unit.ChangeUnitStock(unit_type, unit_stock);
 					}
 				}
 			}
-			
-			//Wyrmgus start
-			for (size_t j = 0; j != unitupgrade.size(); ++j) {
-				CUnit &unit = *unitupgrade[j];
+		}
+		
+		//Wyrmgus start
+		for (size_t j = 0; j != unitupgrade.size(); ++j) {
+			CUnit &unit = *unitupgrade[j];
 
-				if (unit.Player->Index != player.Index) {
-					continue;
+			if (unit.Player->Index != player.Index) {
+				continue;
+			}
+			
+			//add or remove starting abilities from the unit if the upgrade enabled/disabled them
+			for (const CUpgrade *ability_upgrade : unit.Type->StartingAbilities) {
+				if (!unit.GetIndividualUpgrade(ability_upgrade) && CheckDependencies(ability_upgrade, &unit)) {
+					IndividualUpgradeAcquire(unit, ability_upgrade);
+				} else if (unit.GetIndividualUpgrade(ability_upgrade) && !CheckDependencies(ability_upgrade, &unit)) {
+					IndividualUpgradeLost(unit, ability_upgrade);
 				}
-				
-				//add or remove starting abilities from the unit if the upgrade enabled/disabled them
-				for (const CUpgrade *ability_upgrade : unit.Type->StartingAbilities) {
-					if (!unit.GetIndividualUpgrade(ability_upgrade) && CheckDependencies(ability_upgrade, &unit)) {
-						IndividualUpgradeAcquire(unit, ability_upgrade);
-					} else if (unit.GetIndividualUpgrade(ability_upgrade) && !CheckDependencies(ability_upgrade, &unit)) {
-						IndividualUpgradeLost(unit, ability_upgrade);
+			}
+			
+			//change variation if current one becomes forbidden
+			const stratagus::unit_type_variation *current_variation = unit.GetVariation();
+			if (current_variation) {
+				bool upgrade_forbidden = false;
+				for (const CUpgrade *forbidden_upgrade : current_variation->UpgradesForbidden) {
+					if (um->UpgradeId == forbidden_upgrade->ID) {
+						upgrade_forbidden = true;
+						break;
 					}
 				}
-				
-				//change variation if current one becomes forbidden
-				const stratagus::unit_type_variation *current_variation = unit.GetVariation();
-				if (current_variation) {
+				if (upgrade_forbidden == true) {
+					unit.ChooseVariation();
+				}
+			}
+			for (int i = 0; i < MaxImageLayers; ++i) {
+				const stratagus::unit_type_variation *current_layer_variation = unit.GetLayerVariation(i);
+				if (current_layer_variation) {
 					bool upgrade_forbidden = false;
-					for (const CUpgrade *forbidden_upgrade : current_variation->UpgradesForbidden) {
+					for (const CUpgrade *forbidden_upgrade : current_layer_variation->UpgradesForbidden) {
 						if (um->UpgradeId == forbidden_upgrade->ID) {
 							upgrade_forbidden = true;
 							break;
 						}
 					}
-					if (upgrade_forbidden == true) {
-						unit.ChooseVariation();
-					}
-				}
-				for (int i = 0; i < MaxImageLayers; ++i) {
-					const stratagus::unit_type_variation *current_layer_variation = unit.GetLayerVariation(i);
-					if (current_layer_variation) {
-						bool upgrade_forbidden = false;
-						for (const CUpgrade *forbidden_upgrade : current_layer_variation->UpgradesForbidden) {
-							if (um->UpgradeId == forbidden_upgrade->ID) {
-								upgrade_forbidden = true;
-								break;
-							}
-						}
 
-						if (upgrade_forbidden == true) {
-							unit.ChooseVariation(nullptr, false, i);
-						}
+					if (upgrade_forbidden == true) {
+						unit.ChooseVariation(nullptr, false, i);
 					}
 				}
-				unit.UpdateButtonIcons();
-			}
-			//Wyrmgus end
-			
-			if (um->ConvertTo) {
-				ConvertUnitTypeTo(player, *unit_type, *um->ConvertTo);
 			}
+			unit.UpdateButtonIcons();
+		}
+		//Wyrmgus end
+		
+		if (um->ConvertTo) {
+			ConvertUnitTypeTo(player, *unit_type, *um->ConvertTo);
 		}
 	}
 }
@@ -1702,12 +1715,21 @@ static void RemoveUpgradeModifier(CPlayer &player, const stratagus::upgrade_modi
 		}
 	}
 
-	for (stratagus::unit_type *unit_type : stratagus::unit_type::get_all()) {
-		CUnitStats &stat = unit_type->Stats[pn];
+	int varModified = 0;
+	for (unsigned int j = 0; j < UnitTypeVar.GetNumberVariable(); j++) {
+		varModified |= um->Modifier.Variables[j].Value
+					   | um->Modifier.Variables[j].Max
+					   | um->Modifier.Variables[j].Increase
+					   | um->Modifier.Variables[j].Enable
+					   | um->ModifyPercent[j];
+	}
+
+	size_t initialized_unit_type_count = 0;
+	for (const stratagus::unit_type *unit_type : stratagus::unit_type::get_all()) {
 		// add/remove allowed units
 
 		//Wyrmgus start
-		if (stat.Variables.empty()) { // unit types stats not initialized
+		if (unit_type->Stats[pn].Variables.empty()) { // unit types stats not initialized
 			break;
 		}
 		//Wyrmgus end
@@ -1715,242 +1737,247 @@ static void RemoveUpgradeModifier(CPlayer &player, const stratagus::upgrade_modi
 		// FIXME: check if modify is allowed
 
 		player.Allow.Units[unit_type->Slot] -= um->ChangeUnits[unit_type->Slot];
+		++initialized_unit_type_count;
+	}
 
-		// this modifier should be applied to unittype id == z
-		if (um->applies_to(unit_type)) {
-			// if a unit type's supply is changed, we need to update the player's supply accordingly
-			if (um->Modifier.Variables[SUPPLY_INDEX].Value) {
-				std::vector<CUnit *> unitupgrade;
+	// only go through the unit types to which this modifier should be applied
+	for (stratagus::unit_type *unit_type : um->get_affected_unit_types()) {
+		if (static_cast<size_t>(unit_type->Slot) >= initialized_unit_type_count) {
+			continue;
+		}
 
-				FindUnitsByType(*unit_type, unitupgrade);
-				for (size_t j = 0; j != unitupgrade.size(); ++j) {
-					CUnit &unit = *unitupgrade[j];
-					if (unit.Player->Index == pn && unit.IsAlive()) {
-						unit.Player->Supply -= um->Modifier.Variables[SUPPLY_INDEX].Value;
-					}
+		CUnitStats &stat = unit_type->Stats[pn];
+
+		// if a unit type's supply is changed, we need to update the player's supply accordingly
+		if (um->Modifier.Variables[SUPPLY_INDEX].Value) {
+			std::vector<CUnit *> unitupgrade;
+
+			FindUnitsByType(*unit_type, unitupgrade);
+			for (size_t j = 0; j != unitupgrade.size(); ++j) {
+				CUnit &unit = *unitupgrade[j];
+				if (unit.Player->Index == pn && unit.IsAlive()) {
+					unit.Player->Supply -= um->Modifier.Variables[SUPPLY_INDEX].Value;
 				}
 			}
-			
-			// if a unit type's demand is changed, we need to update the player's demand accordingly
-			if (um->Modifier.Variables[DEMAND_INDEX].Value) {
-				std::vector<CUnit *> unitupgrade;
+		}
+		
+		// if a unit type's demand is changed, we need to update the player's demand accordingly
+		if (um->Modifier.Variables[DEMAND_INDEX].Value) {
+			std::vector<CUnit *> unitupgrade;
 
-				FindUnitsByType(*unit_type, unitupgrade);
-				for (size_t j = 0; j != unitupgrade.size(); ++j) {
-					CUnit &unit = *unitupgrade[j];
-					if (unit.Player->Index == pn && unit.IsAlive()) {
-						unit.Player->Demand -= um->Modifier.Variables[DEMAND_INDEX].Value;
-					}
+			FindUnitsByType(*unit_type, unitupgrade);
+			for (size_t j = 0; j != unitupgrade.size(); ++j) {
+				CUnit &unit = *unitupgrade[j];
+				if (unit.Player->Index == pn && unit.IsAlive()) {
+					unit.Player->Demand -= um->Modifier.Variables[DEMAND_INDEX].Value;
 				}
 			}
-			
-			// upgrade costs :)
-			for (unsigned int j = 0; j < MaxCosts; ++j) {
-				stat.Costs[j] -= um->Modifier.Costs[j];
-				stat.Storing[j] -= um->Modifier.Storing[j];
-				stat.ImproveIncomes[j] -= um->Modifier.ImproveIncomes[j];
-				//if this was the highest improve income, search for another
-				if (player.Incomes[j] && (stat.ImproveIncomes[j] + um->Modifier.ImproveIncomes[j]) == player.Incomes[j]) {
-					int m = stratagus::resource::get_all()[j]->DefaultIncome;
-
-					for (int k = 0; k < player.GetUnitCount(); ++k) {
-						//Wyrmgus start
+		}
+		
+		// upgrade costs :)
+		for (unsigned int j = 0; j < MaxCosts; ++j) {
+			stat.Costs[j] -= um->Modifier.Costs[j];
+			stat.Storing[j] -= um->Modifier.Storing[j];
+			stat.ImproveIncomes[j] -= um->Modifier.ImproveIncomes[j];
+			//if this was the highest improve income, search for another
+			if (player.Incomes[j] && (stat.ImproveIncomes[j] + um->Modifier.ImproveIncomes[j]) == player.Incomes[j]) {
+				int m = stratagus::resource::get_all()[j]->DefaultIncome;
+
+				for (int k = 0; k < player.GetUnitCount(); ++k) {
+					//Wyrmgus start
 //						m = std::max(m, player.GetUnit(k).Type->Stats[player.Index].ImproveIncomes[j]);
-						if (player.GetUnit(k).Type != nullptr) {
-							m = std::max(m, player.GetUnit(k).Type->Stats[player.Index].ImproveIncomes[j]);
-						}
-						//Wyrmgus end
+					if (player.GetUnit(k).Type != nullptr) {
+						m = std::max(m, player.GetUnit(k).Type->Stats[player.Index].ImproveIncomes[j]);
 					}
-					player.Incomes[j] = m;
+					//Wyrmgus end
 				}
-				//Wyrmgus start
-				stat.ResourceDemand[j] -= um->Modifier.ResourceDemand[j];
-				//Wyrmgus end
+				player.Incomes[j] = m;
 			}
+			//Wyrmgus start
+			stat.ResourceDemand[j] -= um->Modifier.ResourceDemand[j];
+			//Wyrmgus end
+		}
 
-			for (const auto &kv_pair : um->Modifier.UnitStock) {
-				const stratagus::unit_type *unit_type = stratagus::unit_type::get_all()[kv_pair.first];
-				const int unit_stock = kv_pair.second;
-				if (unit_stock != 0) {
-					stat.ChangeUnitStock(unit_type, -unit_stock);
-				}
+		for (const auto &kv_pair : um->Modifier.UnitStock) {
+			const stratagus::unit_type *unit_type = stratagus::unit_type::get_all()[kv_pair.first];
+			const int unit_stock = kv_pair.second;
+			if (unit_stock != 0) {
+				stat.ChangeUnitStock(unit_type, -unit_stock);
 			}
+		}
 
-			int varModified = 0;
+		// the variables are only modified (and thus stop being shared with other players) if the modifier changes any of them
+		if (varModified) {
+			std::vector<stratagus::unit_variable> &stat_variables = stat.Variables.get_mutable();
 			for (unsigned int j = 0; j < UnitTypeVar.GetNumberVariable(); j++) {
-				varModified |= um->Modifier.Variables[j].Value
-							   | um->Modifier.Variables[j].Max
-							   | um->Modifier.Variables[j].Increase
-							   | um->Modifier.Variables[j].Enable
-							   | um->ModifyPercent[j];
-				stat.Variables[j].Enable |= um->Modifier.Variables[j].Enable;
+				stat_variables[j].Enable |= um->Modifier.Variables[j].Enable;
 				if (um->ModifyPercent[j]) {
 					if (j != MANA_INDEX || um->Modifier.Variables[j].Value >= 0) {
-						stat.Variables[j].Value = stat.Variables[j].Value * 100 / (100 + um->ModifyPercent[j]);
+						stat_variables[j].Value = stat_variables[j].Value * 100 / (100 + um->ModifyPercent[j]);
 					}
-					stat.Variables[j].Max = stat.Variables[j].Max * 100 / (100 + um->ModifyPercent[j]);
+					stat_variables[j].Max = stat_variables[j].Max * 100 / (100 + um->ModifyPercent[j]);
 				} else {
 					if (j != MANA_INDEX || um->Modifier.Variables[j].Value >= 0) {
-						stat.Variables[j].Value -= um->Modifier.Variables[j].Value;
+						stat_variables[j].Value -= um->Modifier.Variables[j].Value;
 					}
-					stat.Variables[j].Max -= um->Modifier.Variables[j].Max;
-					stat.Variables[j].Increase -= um->Modifier.Variables[j].Increase;
+					stat_variables[j].Max -= um->Modifier.Variables[j].Max;
+					stat_variables[j].Increase -= um->Modifier.Variables[j].Increase;
 				}
 
-				stat.Variables[j].Max = std::max(stat.Variables[j].Max, 0);
+				stat_variables[j].Max = std::max(stat_variables[j].Max, 0);
 				//Wyrmgus start
-//				clamp(&stat.Variables[j].Value, 0, stat.Variables[j].Max);
-				if (stat.Variables[j].Max > 0) {
-					clamp(&stat.Variables[j].Value, 0, stat.Variables[j].Max);
+//					clamp(&stat_variables[j].Value, 0, stat_variables[j].Max);
+				if (stat_variables[j].Max > 0) {
+					clamp(&stat_variables[j].Value, 0, stat_variables[j].Max);
 				}
 				//Wyrmgus end
 			}
-			
-			if (um->Modifier.Variables[TRADECOST_INDEX].Value && (stat.Variables[TRADECOST_INDEX].Value + um->Modifier.Variables[TRADECOST_INDEX].Value) == player.TradeCost) {
-				int m = DefaultTradeCost;
+		}
+		
+		if (um->Modifier.Variables[TRADECOST_INDEX].Value && (stat.Variables[TRADECOST_INDEX].Value + um->Modifier.Variables[TRADECOST_INDEX].Value) == player.TradeCost) {
+			int m = DefaultTradeCost;
 
-				for (int k = 0; k < player.GetUnitCount(); ++k) {
-					if (player.GetUnit(k).Type != nullptr) {
-						m = std::min(m, player.GetUnit(k).Type->Stats[player.Index].Variables[TRADECOST_INDEX].Value);
-					}
+			for (int k = 0; k < player.GetUnitCount(); ++k) {
+				if (player.GetUnit(k).Type != nullptr) {
+					m = std::min(m, player.GetUnit(k).Type->Stats[player.Index].Variables[TRADECOST_INDEX].Value);
 				}
-				player.TradeCost = m;
 			}
+			player.TradeCost = m;
+		}
+
+		//Wyrmgus start
+		std::vector<CUnit *> unitupgrade;
 
+		FindUnitsByType(*unit_type, unitupgrade, true);
+		//Wyrmgus end
+		
+		// And now modify ingame units
+		if (varModified) {
 			//Wyrmgus start
+			/*
 			std::vector<CUnit *> unitupgrade;
 
-			FindUnitsByType(*unit_type, unitupgrade, true);
+			FindUnitsByType(*UnitTypes[z], unitupgrade, true);
+			*/
 			//Wyrmgus end
-			
-			// And now modify ingame units
-			if (varModified) {
-				//Wyrmgus start
-				/*
-				std::vector<CUnit *> unitupgrade;
+			for (size_t j = 0; j != unitupgrade.size(); ++j) {
+				CUnit &unit = *unitupgrade[j];
 
-				FindUnitsByType(*UnitTypes[z], unitupgrade, true);
-				*/
+				if (unit.Player->Index != player.Index) {
+					continue;
+				}
+				
+				//Wyrmgus start
+				if (
+					(CUpgrade::get_all()[um->UpgradeId]->is_weapon() && unit.EquippedItems[static_cast<int>(stratagus::item_slot::weapon)].size() > 0)
+					|| (CUpgrade::get_all()[um->UpgradeId]->is_shield() && unit.EquippedItems[static_cast<int>(stratagus::item_slot::shield)].size() > 0)
+					|| (CUpgrade::get_all()[um->UpgradeId]->is_boots() && unit.EquippedItems[static_cast<int>(stratagus::item_slot::boots)].size() > 0)
+					|| (CUpgrade::get_all()[um->UpgradeId]->is_arrows() && unit.EquippedItems[static_cast<int>(stratagus::item_slot::arrows)].size() > 0)
+				) { //if the unit already has an item equipped of the same equipment type as this upgrade, don't remove the modifier from it (it already doesn't have it)
+					continue;
+				}
 				//Wyrmgus end
-				for (size_t j = 0; j != unitupgrade.size(); ++j) {
-					CUnit &unit = *unitupgrade[j];
-
-					if (unit.Player->Index != player.Index) {
-						continue;
-					}
-					
-					//Wyrmgus start
-					if (
-						(CUpgrade::get_all()[um->UpgradeId]->is_weapon() && unit.EquippedItems[static_cast<int>(stratagus::item_slot::weapon)].size() > 0)
-						|| (CUpgrade::get_all()[um->UpgradeId]->is_shield() && unit.EquippedItems[static_cast<int>(stratagus::item_slot::shield)].size() > 0)
-						|| (CUpgrade::get_all()[um->UpgradeId]->is_boots() && unit.EquippedItems[static_cast<int>(stratagus::item_slot::boots)].size() > 0)
-						|| (CUpgrade::get_all()[um->UpgradeId]->is_arrows() && unit.EquippedItems[static_cast<int>(stratagus::item_slot::arrows)].size() > 0)
-					) { //if the unit already has an item equipped of the same equipment type as this upgrade, don't remove the modifier from it (it already doesn't have it)
-						continue;
-					}
-					//Wyrmgus end
-					
-					for (unsigned int j = 0; j < UnitTypeVar.GetNumberVariable(); j++) {
-						unit.Variable[j].Enable |= um->Modifier.Variables[j].Enable;
-						if (um->ModifyPercent[j]) {
-							if (j != MANA_INDEX || um->ModifyPercent[j] >= 0) {
-								unit.Variable[j].Value = unit.Variable[j].Value * 100 / (100 + um->ModifyPercent[j]);
-							}
-							unit.Variable[j].Max = unit.Variable[j].Max * 100 / (100 + um->ModifyPercent[j]);
-						} else {
-							if (j != MANA_INDEX || um->Modifier.Variables[j].Value >= 0) {
-								unit.Variable[j].Value -= um->Modifier.Variables[j].Value;
-							}
-							unit.Variable[j].Increase -= um->Modifier.Variables[j].Increase;
+				
+				for (unsigned int j = 0; j < UnitTypeVar.GetNumberVariable(); j++) {
+					unit.Variable[j].Enable |= um->Modifier.Variables[j].Enable;
+					if (um->ModifyPercent[j]) {
+						if (j != MANA_INDEX || um->ModifyPercent[j] >= 0) {
+							unit.Variable[j].Value = unit.Variable[j].Value * 100 / (100 + um->ModifyPercent[j]);
+						}
+						unit.Variable[j].Max = unit.Variable[j].Max * 100 / (100 + um->ModifyPercent[j]);
+					} else {
+						if (j != MANA_INDEX || um->Modifier.Variables[j].Value >= 0) {
+							unit.Variable[j].Value -= um->Modifier.Variables[j].Value;
 						}
+						unit.change_variable_increase(j, -um->Modifier.Variables[j].Increase);
+					}
 
-						unit.Variable[j].Max -= um->Modifier.Variables[j].Max;
-						unit.Variable[j].Max = std::max(unit.Variable[j].Max, 0);
+					unit.Variable[j].Max -= um->Modifier.Variables[j].Max;
+					unit.Variable[j].Max = std::max(unit.Variable[j].Max, 0);
 
-						if (unit.Variable[j].Max > 0) {
-							clamp(&unit.Variable[j].Value, 0, unit.Variable[j].Max);
-						}
+					if (unit.Variable[j].Max > 0) {
+						clamp(&unit.Variable[j].Value, 0, unit.Variable[j].Max);
+					}
 
-						//Wyrmgus start
-						if (j == ATTACKRANGE_INDEX && unit.Container) {
-							unit.Container->UpdateContainerAttackRange();
-						} else if (j == LEVEL_INDEX || j == POINTS_INDEX) {
-							unit.UpdateXPRequired();
-						} else if (IsKnowledgeVariable(j)) {
-							unit.CheckKnowledgeChange(j, - um->Modifier.Variables[j].Value);
-						} else if ((j == SIGHTRANGE_INDEX || j == DAYSIGHTRANGEBONUS_INDEX || j == NIGHTSIGHTRANGEBONUS_INDEX) && !unit.Removed) {
-							// If Sight range is upgraded, we need to change EVERY unit
-							// to the new range, otherwise the counters get confused.
-							MapUnmarkUnitSight(unit);
-							UpdateUnitSightRange(unit);
-							MapMarkUnitSight(unit);
-						}
-						//Wyrmgus end
+					//Wyrmgus start
+					if (j == ATTACKRANGE_INDEX && unit.Container) {
+						unit.Container->UpdateContainerAttackRange();
+					} else if (j == LEVEL_INDEX || j == POINTS_INDEX) {
+						unit.UpdateXPRequired();
+					} else if (IsKnowledgeVariable(j)) {
+						unit.CheckKnowledgeChange(j, - um->Modifier.Variables[j].Value);
+					} else if ((j == SIGHTRANGE_INDEX || j == DAYSIGHTRANGEBONUS_INDEX || j == NIGHTSIGHTRANGEBONUS_INDEX) && !unit.Removed) {
+						// If Sight range is upgraded, we need to change EVERY unit
+						// to the new range, otherwise the counters get confused.
+						MapUnmarkUnitSight(unit);
+						UpdateUnitSightRange(unit);
+						MapMarkUnitSight(unit);
 					}
-					
-					for (const auto &kv_pair : um->Modifier.UnitStock) {
-						const stratagus::unit_type *unit_type = stratagus::unit_type::get_all()[kv_pair.first];
-						const int unit_stock = kv_pair.second;
-						if (unit_stock > 0) {
-							unit.ChangeUnitStock(unit_type, -unit_stock);
-						}
+					//Wyrmgus end
+				}
+				
+				for (const auto &kv_pair : um->Modifier.UnitStock) {
+					const stratagus::unit_type *unit_type = stratagus::unit_type::get_all()[kv_pair.first];
+					const int unit_stock = kv_pair.second;
+					if (unit_stock > 0) {
+						unit.ChangeUnitStock(unit_type, -unit_stock);
 					}
 				}
 			}
-			
-			//Wyrmgus start
-			for (size_t j = 0; j != unitupgrade.size(); ++j) {
-				CUnit &unit = *unitupgrade[j];
+		}
+		
+		//Wyrmgus start
+		for (size_t j = 0; j != unitupgrade.size(); ++j) {
+			CUnit &unit = *unitupgrade[j];
 
-				if (unit.Player->Index != player.Index) {
-					continue;
+			if (unit.Player->Index != player.Index) {
+				continue;
+			}
+			
+			//add or remove starting abilities from the unit if the upgrade enabled/disabled them
+			for (const CUpgrade *ability_upgrade : unit.Type->StartingAbilities) {
+				if (!unit.GetIndividualUpgrade(ability_upgrade) && CheckDependencies(ability_upgrade, &unit)) {
+					IndividualUpgradeAcquire(unit, ability_upgrade);
+				} else if (unit.GetIndividualUpgrade(ability_upgrade) && !CheckDependencies(ability_upgrade, &unit)) {
+					IndividualUpgradeLost(unit, ability_upgrade);
 				}
-				
-				//add or remove starting abilities from the unit if the upgrade enabled/disabled them
-				for (const CUpgrade *ability_upgrade : unit.Type->StartingAbilities) {
-					if (!unit.GetIndividualUpgrade(ability_upgrade) && CheckDependencies(ability_upgrade, &unit)) {
-						IndividualUpgradeAcquire(unit, ability_upgrade);
-					} else if (unit.GetIndividualUpgrade(ability_upgrade) && !CheckDependencies(ability_upgrade, &unit)) {
-						IndividualUpgradeLost(unit, ability_upgrade);
+			}
+			
+			//change variation if current one becomes forbidden
+			const stratagus::unit_type_variation *current_variation = unit.GetVariation();
+			if (current_variation) {
+				bool upgrade_required = false;
+				for (const CUpgrade *required_upgrade : current_variation->UpgradesRequired) {
+					if (um->UpgradeId == required_upgrade->ID) {
+						upgrade_required = true;
+						break;
 					}
 				}
-				
-				//change variation if current one becomes forbidden
-				const stratagus::unit_type_variation *current_variation = unit.GetVariation();
-				if (current_variation) {
+				if (upgrade_required == true) {
+					unit.ChooseVariation();
+				}
+			}
+			for (int i = 0; i < MaxImageLayers; ++i) {
+				const stratagus::unit_type_variation *current_layer_variation = unit.GetLayerVariation(i);
+				if (current_layer_variation) {
 					bool upgrade_required = false;
-					for (const CUpgrade *required_upgrade : current_variation->UpgradesRequired) {
+					for (const CUpgrade *required_upgrade : current_layer_variation->UpgradesRequired) {
 						if (um->UpgradeId == required_upgrade->ID) {
 							upgrade_required = true;
 							break;
 						}
 					}
 					if (upgrade_required == true) {
-						unit.ChooseVariation();
+						unit.ChooseVariation(nullptr, false, i);
 					}
 				}
-				for (int i = 0; i < MaxImageLayers; ++i) {
-					const stratagus::unit_type_variation *current_layer_variation = unit.GetLayerVariation(i);
-					if (current_layer_variation) {
-						bool upgrade_required = false;
-						for (const CUpgrade *required_upgrade : current_layer_variation->UpgradesRequired) {
-							if (um->UpgradeId == required_upgrade->ID) {
-								upgrade_required = true;
-								break;
-							}
-						}
-						if (upgrade_required == true) {
-							unit.ChooseVariation(nullptr, false, i);
-						}
-					}
-				}
-				unit.UpdateButtonIcons();
-			}
-			//Wyrmgus end
-			
-			if (um->ConvertTo) {
-				ConvertUnitTypeTo(player, *um->ConvertTo, *unit_type);
 			}
+			unit.UpdateButtonIcons();
+		}
+		//Wyrmgus end
+		
+		if (um->ConvertTo) {
+			ConvertUnitTypeTo(player, *um->ConvertTo, *unit_type);
 		}
 	}
 }
@@ -1988,7 +2015,7 @@ void ApplyIndividualUpgradeModifier(CUnit &unit, const stratagus::upgrade_modifi
 			if (j != MANA_INDEX || um->Modifier.Variables[j].Value < 0) {
 				unit.Variable[j].Value += um->Modifier.Variables[j].Value;
 			}
-			unit.Variable[j].Increase += um->Modifier.Variables[j].Increase;
+			unit.change_variable_increase(j, um->Modifier.Variables[j].Increase);
 		}
 		unit.Variable[j].Max += um->Modifier.Variables[j].Max;
 		unit.Variable[j].Max = std::max(unit.Variable[j].Max, 0);
@@ -2084,7 +2111,7 @@ void RemoveIndividualUpgradeModifier(CUnit &unit, const stratagus::upgrade_modif
 			if (j != MANA_INDEX || um->Modifier.Variables[j].Value >= 0) {
 				unit.Variable[j].Value -= um->Modifier.Variables[j].Value;
 			}
-			unit.Variable[j].Increase -= um->Modifier.Variables[j].Increase;
+			unit.change_variable_increase(j, -um->Modifier.Variables[j].Increase);
 		}
 		unit.Variable[j].Max -= um->Modifier.Variables[j].Max;
 		unit.Variable[j].Max = std::max(unit.Variable[j].Max, 0);
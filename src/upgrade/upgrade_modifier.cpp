@@ -47,7 +47,7 @@ upgrade_modifier::upgrade_modifier()
 	memset(this->ChangeUnits, 0, sizeof(this->ChangeUnits));
 	
 	memset(this->ChangeUpgrades, '?', sizeof(this->ChangeUpgrades));
-	this->Modifier.Variables.resize(UnitTypeVar.GetNumberVariable());
+	this->Modifier.Variables.get_mutable().resize(UnitTypeVar.GetNumberVariable());
 	this->ModifyPercent = new int[UnitTypeVar.GetNumberVariable()];
 	memset(this->ModifyPercent, 0, UnitTypeVar.GetNumberVariable() * sizeof(int));
 }
@@ -93,9 +93,9 @@ void upgrade_modifier::ProcessConfigData(const CConfigData *config_data)
 			int index = UnitTypeVar.VariableNameLookup[key.c_str()]; // variable index
 			if (index != -1) { // valid index
 				if (string::is_number(value)) {
-					this->Modifier.Variables[index].Enable = 1;
-					this->Modifier.Variables[index].Value = std::stoi(value);
-					this->Modifier.Variables[index].Max = std::stoi(value);
+					this->Modifier.Variables.get_mutable()[index].Enable = 1;
+					this->Modifier.Variables.get_mutable()[index].Value = std::stoi(value);
+					this->Modifier.Variables.get_mutable()[index].Max = std::stoi(value);
 				} else { // error
 					fprintf(stderr, "Invalid value (\"%s\") for variable \"%s\" when defining modifier for upgrade \"%s\".\n", value.c_str(), key.c_str(), CUpgrade::get_all()[this->UpgradeId]->Ident.c_str());
 				}
@@ -116,9 +116,9 @@ void upgrade_modifier::process_sml_property(const sml_property &property)
 	const int index = UnitTypeVar.VariableNameLookup[variable_name.c_str()]; // variable index
 	if (index != -1) { // valid index
 		if (string::is_number(value)) {
-			this->Modifier.Variables[index].Enable = 1;
-			this->Modifier.Variables[index].Value = std::stoi(value);
-			this->Modifier.Variables[index].Max = std::stoi(value);
+			this->Modifier.Variables.get_mutable()[index].Enable = 1;
+			this->Modifier.Variables.get_mutable()[index].Value = std::stoi(value);
+			this->Modifier.Variables.get_mutable()[index].Max = std::stoi(value);
 		} else { // error
 			throw std::runtime_error("Invalid value (\"" + value +"\") for variable \"" + key + "\" when defining modifier for upgrade \"" + CUpgrade::get_all()[this->UpgradeId]->get_identifier() + "\".");
 		}
@@ -171,6 +171,40 @@ bool upgrade_modifier::applies_to(const unit_type *unit_type) const
 	return false;
 }
 
+/**
+**	@brief	Get the unit types to which the modifier applies, without having to check every unit type
+**
+**	The list is built on first use, after the modifier has been defined, and only rebuilt if the unit types of unit classes change afterwards.
+**
+**	@return	The unit types to which the modifier applies, in slot order
+*/
+const std::vector<unit_type *> &upgrade_modifier::get_affected_unit_types() const
+{
+	if (this->affected_unit_types_revision == unit_class::get_unit_types_revision()) {
+		return this->affected_unit_types;
+	}
+
+	std::vector<unit_type *> unit_types = this->get_unit_types();
+
+	for (const unit_class *unit_class : this->get_unit_classes()) {
+		for (unit_type *unit_type : unit_class->get_unit_types()) {
+			if (unit_type->get_unit_class() == unit_class) {
+				unit_types.push_back(unit_type);
+			}
+		}
+	}
+
+	std::sort(unit_types.begin(), unit_types.end(), [](const unit_type *a, const unit_type *b) {
+		return a->Slot < b->Slot;
+	});
+	unit_types.erase(std::unique(unit_types.begin(), unit_types.end()), unit_types.end());
+
+	this->affected_unit_types = std::move(unit_types);
+	this->affected_unit_types_revision = unit_class::get_unit_types_revision();
+
+	return this->affected_unit_types;
+}
+
 int upgrade_modifier::GetUnitStock(unit_type *unit_type) const
 {
 	auto find_iterator = this->UnitStock.find(unit_type);
@@ -0,0 +1,158 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+//      (c) Copyright 2020 by Andrettin
+//
+//      Permission is hereby granted, free of charge, to any person obtaining a
+//      copy of this software and associated documentation files (the
+//      "Software"), to deal in the Software without restriction, including
+//      without limitation the rights to use, copy, modify, merge, publish,
+//      distribute, sublicense, and/or sell copies of the Software, and to
+//      permit persons to whom the Software is furnished to do so, subject to
+//      the following conditions:
+//
+//      The above copyright notice and this permission notice shall be included
+//      in all copies or substantial portions of the Software.
+//
+//      THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//      OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//      MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+//      IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+//      CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+//      TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//      SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+namespace stratagus {
+
+//the integer type used to store a value, which for enums is their underlying type
+template <typename T, bool = std::is_enum_v<T>>
+struct binary_integer final
+{
+	using type = T;
+};
+
+template <typename T>
+struct binary_integer<T, true> final
+{
+	using type = std::underlying_type_t<T>;
+};
+
+/**
+**	@brief	Writes values to a byte buffer, in little-endian byte order regardless of the platform
+*/
+class binary_writer final
+{
+public:
+	explicit binary_writer(std::string &buffer) : buffer(buffer)
+	{
+	}
+
+	template <typename T>
+	void write(const T value)
+	{
+		static_assert(std::is_integral_v<T> || std::is_enum_v<T>);
+
+		using unsigned_type = std::make_unsigned_t<typename binary_integer<T>::type>;
+		const unsigned_type unsigned_value = static_cast<unsigned_type>(value);
+
+		for (size_t i = 0; i < sizeof(T); ++i) {
+			this->buffer.push_back(static_cast<char>((unsigned_value >> (i * 8)) & 0xFF));
+		}
+	}
+
+	void write_bytes(const void *data, const size_t size)
+	{
+		this->buffer.append(static_cast<const char *>(data), size);
+	}
+
+	void write_string(const std::string &str)
+	{
+		this->write<uint32_t>(static_cast<uint32_t>(str.size()));
+		this->buffer.append(str);
+	}
+
+	size_t get_size() const
+	{
+		return this->buffer.size();
+	}
+
+private:
+	std::string &buffer;
+};
+
+/**
+**	@brief	Reads values written by binary_writer from a byte buffer, which must outlive the reader
+**
+**	Reading past the end of the buffer throws an exception, so that truncated or corrupted data cannot be silently accepted.
+*/
+class binary_reader final
+{
+public:
+	explicit binary_reader(const std::string_view &data) : data(data)
+	{
+	}
+
+	template <typename T>
+	T read()
+	{
+		static_assert(std::is_integral_v<T> || std::is_enum_v<T>);
+
+		using unsigned_type = std::make_unsigned_t<typename binary_integer<T>::type>;
+		const std::string_view bytes = this->read_bytes(sizeof(T));
+
+		unsigned_type unsigned_value = 0;
+		for (size_t i = 0; i < sizeof(T); ++i) {
+			unsigned_value |= static_cast<unsigned_type>(static_cast<unsigned char>(bytes[i])) << (i * 8);
+		}
+
+		return static_cast<T>(unsigned_value);
+	}
+
+	std::string_view read_bytes(const size_t size)
+	{
+		if (size > this->get_remaining_size()) {
+			throw std::runtime_error("Tried to read " + std::to_string(size) + " byte(s) at position " + std::to_string(this->position) + " of binary data with a size of " + std::to_string(this->data.size()) + ".");
+		}
+
+		const std::string_view bytes = this->data.substr(this->position, size);
+		this->position += size;
+		return bytes;
+	}
+
+	std::string read_string()
+	{
+		const uint32_t size = this->read<uint32_t>();
+		return std::string(this->read_bytes(size));
+	}
+
+	size_t get_position() const
+	{
+		return this->position;
+	}
+
+	size_t get_remaining_size() const
+	{
+		return this->data.size() - this->position;
+	}
+
+	bool is_at_end() const
+	{
+		return this->position == this->data.size();
+	}
+
+private:
+	std::string_view data;
+	size_t position = 0;
+};
+
+}
@@ -31,41 +31,218 @@
 #include "util/geopath_util.h"
 #include "util/georectangle_util.h"
 #include "util/point_util.h"
+#include "util/thread_pool.h"
 
 namespace stratagus::geoshape {
 
-void write_to_image(const QGeoShape &geoshape, QImage &image, const QColor &color, const QGeoRectangle &georectangle, const std::string &image_checkpoint_save_filename)
+/**
+**	@brief	A non-horizontal polygon edge, in pixel space
+**
+**	The edge crosses the sample rows in [row_begin, row_end), with x being its position at row_begin.
+*/
+struct polygon_edge final
 {
-	QGeoRectangle bounding_georectangle = geoshape.boundingGeoRectangle();
+	int row_begin = 0;
+	int row_end = 0;
+	double x = 0;
+	double x_step = 0;
+	int winding = 0;
+};
 
-	if (!bounding_georectangle.intersects(georectangle)) {
+//the minimum quantity of rows for which rasterizing a polygon is split over the thread pool
+static constexpr int parallel_row_threshold = 64;
+
+static QPointF to_pixel_pos(const QGeoCoordinate &geocoordinate, const QRectF &unsigned_georectangle, const double x_scale, const double y_scale)
+{
+	const QPointF unsigned_geocoordinate = geocoordinate::to_unsigned_geocoordinate(geocoordinate);
+	return QPointF((unsigned_geocoordinate.x() - unsigned_georectangle.x()) * x_scale, (unsigned_geocoordinate.y() - unsigned_georectangle.y()) * y_scale);
+}
+
+/**
+**	@brief	Add the edges of a closed ring of geocoordinates to an edge list
+**
+**	Pixels are sampled at their top-left corner, the same position point::to_geocoordinate gives for them, so that an edge crosses the rows whose y lies in [top, bottom).
+*/
+static void add_ring_edges(const QList<QGeoCoordinate> &ring, const QRectF &unsigned_georectangle, const QSize &image_size, std::vector<polygon_edge> &edges)
+{
+	if (ring.size() < 3) {
 		return;
 	}
 
-	if (geoshape.type() == QGeoShape::PathType) {
-		const QGeoPath &geopath = static_cast<const QGeoPath &>(geoshape);
-		geopath::write_to_image(geopath, image, color, georectangle);
+	const double x_scale = image_size.width() / unsigned_georectangle.width();
+	const double y_scale = image_size.height() / unsigned_georectangle.height();
 
-		//if the geopath's width is 0, there is nothing further to do here, but otherwise, use the normal method of geoshape writing as well
-		if (geopath.width() == 0) {
-			return;
+	const QPointF first_pos = geoshape::to_pixel_pos(ring.front(), unsigned_georectangle, x_scale, y_scale);
+	QPointF previous_pos = first_pos;
+
+	for (int i = 1; i <= ring.size(); ++i) {
+		const QPointF pos = i < ring.size() ? geoshape::to_pixel_pos(ring.at(i), unsigned_georectangle, x_scale, y_scale) : first_pos;
+
+		if (pos.y() != previous_pos.y()) {
+			const bool downward = previous_pos.y() < pos.y();
+			const QPointF &top = downward ? previous_pos : pos;
+			const QPointF &bottom = downward ? pos : previous_pos;
+
+			polygon_edge edge;
+			edge.row_begin = std::clamp(static_cast<int>(std::ceil(top.y())), 0, image_size.height());
+			edge.row_end = std::clamp(static_cast<int>(std::ceil(bottom.y())), 0, image_size.height());
+
+			if (edge.row_begin < edge.row_end) {
+				edge.x_step = (bottom.x() - top.x()) / (bottom.y() - top.y());
+				edge.x = top.x() + (edge.row_begin - top.y()) * edge.x_step;
+				edge.winding = downward ? 1 : -1;
+				edges.push_back(edge);
+			}
 		}
 
-		//increase the bounding rectangle of geopaths slightly, as otherwise a part of the path's width is cut off
-		QGeoCoordinate bottom_left = bounding_georectangle.bottomLeft();
-		QGeoCoordinate top_right = bounding_georectangle.topRight();
-		bottom_left.setLatitude(bottom_left.latitude() - 0.1);
-		bottom_left.setLongitude(bottom_left.longitude() - 0.1);
-		top_right.setLatitude(top_right.latitude() + 0.1);
-		top_right.setLongitude(top_right.longitude() + 0.1);
-		bounding_georectangle.setBottomLeft(bottom_left);
-		bounding_georectangle.setTopRight(top_right);
+		previous_pos = pos;
 	}
+}
 
-	const double lon_per_pixel = geocoordinate::longitude_per_pixel(georectangle.width(), image.size());
-	const double lat_per_pixel = geocoordinate::latitude_per_pixel(georectangle.height(), image.size());
+/**
+**	@brief	Fill the spans of a row which lie inside the polygon
+**
+**	@param	line		The row's pixel data, in the RGBA8888 format
+**	@param	width		The width of the row, in pixels
+**	@param	crossings	The x positions at which the polygon's edges cross the row, together with the edges' winding
+**	@param	pixel		The pixel value to write
+**	@param	fill_rule	The rule deciding which spans between crossings are inside the polygon
+*/
+static void write_row(uchar *line, const int width, std::vector<std::pair<double, int>> &crossings, const std::array<uchar, 4> &pixel, const Qt::FillRule fill_rule)
+{
+	std::sort(crossings.begin(), crossings.end());
 
-	const QRectF unsigned_georectangle = georectangle::to_unsigned_georectangle(georectangle);
+	int winding_count = 0;
+	for (size_t i = 0; i + 1 < crossings.size(); ++i) {
+		winding_count += crossings[i].second;
+
+		const bool inside = (fill_rule == Qt::OddEvenFill) ? (winding_count % 2 != 0) : (winding_count != 0);
+		if (!inside) {
+			continue;
+		}
+
+		const int x_begin = std::max(static_cast<int>(std::ceil(crossings[i].first)), 0);
+		const int x_end = std::min(static_cast<int>(std::ceil(crossings[i + 1].first)), width);
+
+		for (int x = x_begin; x < x_end; ++x) {
+			uchar *pixel_data = line + x * 4;
+
+			if (pixel_data[3] != 0) {
+				continue; //ignore already-written pixels
+			}
+
+			std::copy(pixel.begin(), pixel.end(), pixel_data);
+		}
+	}
+}
+
+static void write_edges_to_image(std::vector<polygon_edge> &&edges, QImage &image, const QColor &color, const Qt::FillRule fill_rule)
+{
+	if (edges.empty()) {
+		return;
+	}
+
+	std::sort(edges.begin(), edges.end(), [](const polygon_edge &edge, const polygon_edge &other_edge) {
+		return edge.row_begin < other_edge.row_begin;
+	});
+
+	const int start_y = edges.front().row_begin;
+	int end_y = start_y;
+	for (const polygon_edge &edge : edges) {
+		end_y = std::max(end_y, edge.row_end);
+	}
+
+	const std::array<uchar, 4> pixel = {
+		static_cast<uchar>(color.red()),
+		static_cast<uchar>(color.green()),
+		static_cast<uchar>(color.blue()),
+		static_cast<uchar>(color.alpha())
+	};
+
+	//get the pixel data before splitting the work, as getting it for writing detaches the image
+	uchar *bits = image.bits();
+	const int bytes_per_line = image.bytesPerLine();
+	const int width = image.width();
+
+	//each band of rows keeps its own active edge list, so that bands can be processed independently from one another
+	const auto write_rows = [&](const size_t begin, const size_t end) {
+		std::vector<const polygon_edge *> active_edges;
+		std::vector<std::pair<double, int>> crossings;
+		size_t next_edge_index = 0;
+
+		for (int y = start_y + static_cast<int>(begin); y < start_y + static_cast<int>(end); ++y) {
+			while (next_edge_index < edges.size() && edges[next_edge_index].row_begin <= y) {
+				const polygon_edge &edge = edges[next_edge_index];
+				if (edge.row_end > y) {
+					active_edges.push_back(&edge);
+				}
+				++next_edge_index;
+			}
+
+			active_edges.erase(std::remove_if(active_edges.begin(), active_edges.end(), [y](const polygon_edge *edge) {
+				return edge->row_end <= y;
+			}), active_edges.end());
+
+			crossings.clear();
+			for (const polygon_edge *edge : active_edges) {
+				crossings.emplace_back(edge->x + (y - edge->row_begin) * edge->x_step, edge->winding);
+			}
+
+			geoshape::write_row(bits + y * bytes_per_line, width, crossings, pixel, fill_rule);
+		}
+	};
+
+	const int row_count = end_y - start_y;
+	if (row_count >= parallel_row_threshold) {
+		thread_pool::get()->parallel_for(row_count, write_rows);
+	} else {
+		write_rows(0, row_count);
+	}
+}
+
+/**
+**	@brief	Rasterize a polygon row by row from its edges
+**
+**	The edges are taken as straight lines in linear latitude and longitude, the space the image maps to. QGeoPolygon::contains instead tests containment in a Mercator projection, so for edges which are neither parallels nor meridians, the two can disagree about the pixels next to an edge, increasingly so at higher latitudes and for longer edges.
+**	Polygons crossing the antimeridian are not handled: their edges are rasterized as if they went the long way around, across the image.
+*/
+static void write_polygon_to_image(const QGeoPolygon &geopolygon, QImage &image, const QColor &color, const QRectF &unsigned_georectangle, const Qt::FillRule fill_rule)
+{
+	std::vector<polygon_edge> edges;
+
+	add_ring_edges(geopolygon.path(), unsigned_georectangle, image.size(), edges);
+
+	//holes are further rings of the polygon, which the fill rule then excludes
+	for (int i = 0; i < geopolygon.holesCount(); ++i) {
+		add_ring_edges(geopolygon.holePath(i), unsigned_georectangle, image.size(), edges);
+	}
+
+	geoshape::write_edges_to_image(std::move(edges), image, color, fill_rule);
+}
+
+static void write_rectangle_to_image(const QGeoRectangle &geoshape_rectangle, QImage &image, const QColor &color, const QRectF &unsigned_georectangle)
+{
+	const QList<QGeoCoordinate> ring = {
+		geoshape_rectangle.topLeft(),
+		geoshape_rectangle.topRight(),
+		geoshape_rectangle.bottomRight(),
+		geoshape_rectangle.bottomLeft()
+	};
+
+	std::vector<polygon_edge> edges;
+	add_ring_edges(ring, unsigned_georectangle, image.size(), edges);
+	geoshape::write_edges_to_image(std::move(edges), image, color, Qt::OddEvenFill);
+}
+
+/**
+**	@brief	Write a geoshape to an image by testing each pixel in its bounding rectangle for containment
+**
+**	This is used for the shapes which have no edge representation, such as circles or paths with a width.
+*/
+static void write_contained_pixels_to_image(const QGeoShape &geoshape, const QGeoRectangle &bounding_georectangle, QImage &image, const QColor &color, const QRectF &unsigned_georectangle)
+{
+	const double lon_per_pixel = geocoordinate::longitude_per_pixel(unsigned_georectangle.width(), image.size());
+	const double lat_per_pixel = geocoordinate::latitude_per_pixel(unsigned_georectangle.height(), image.size());
 
 	const QRectF unsigned_bounding_georectangle = georectangle::to_unsigned_georectangle(bounding_georectangle);
 
@@ -79,31 +256,92 @@ void write_to_image(const QGeoShape &geoshape, QImage &image, const QColor &colo
 	const int start_y = std::max(geocoordinate::unsigned_latitude_to_y(start_lat - unsigned_georectangle.y(), lat_per_pixel) - 1, 0);
 	const int end_y = std::min(geocoordinate::unsigned_latitude_to_y(end_lat - unsigned_georectangle.y(), lat_per_pixel) + 1, image.height() - 1);
 
-	int pixel_checkpoint_count = 0;
-	static constexpr int pixel_checkpoint_threshold = 32 * 32;
+	const std::array<uchar, 4> pixel = {
+		static_cast<uchar>(color.red()),
+		static_cast<uchar>(color.green()),
+		static_cast<uchar>(color.blue()),
+		static_cast<uchar>(color.alpha())
+	};
+
+	//this is not split over the thread pool, as QGeoShape::contains updates cached data of the shape
+	for (int y = start_y; y <= end_y; ++y) {
+		uchar *line = image.scanLine(y);
 
-	for (int x = start_x; x <= end_x; ++x) {
-		for (int y = start_y; y <= end_y; ++y) {
-			const QPoint pixel_pos(x, y);
-			const QGeoCoordinate coordinate = point::to_geocoordinate(pixel_pos, image.size(), unsigned_georectangle);
+		for (int x = start_x; x <= end_x; ++x) {
+			uchar *pixel_data = line + x * 4;
 
-			if (image.pixelColor(pixel_pos).alpha() != 0) {
+			if (pixel_data[3] != 0) {
 				continue; //ignore already-written pixels
 			}
 
+			const QGeoCoordinate coordinate = point::to_geocoordinate(QPoint(x, y), image.size(), unsigned_georectangle);
+
 			if (!geoshape.contains(coordinate)) {
 				continue;
 			}
 
-			image.setPixelColor(pixel_pos, color);
-			pixel_checkpoint_count++;
+			std::copy(pixel.begin(), pixel.end(), pixel_data);
+		}
+	}
+}
+
+/**
+**	@brief	Write a geoshape to an image
+**
+**	Polygons and rectangles are rasterized row by row from their edges, while other shapes are written by testing each pixel in their bounding rectangle. Pixels which have already been written to (i.e. which are not fully transparent) are left unchanged.
+**
+**	@param	geoshape		The geoshape
+**	@param	image			The image, which is converted to the RGBA8888 format if it has a different one
+**	@param	color			The color to write the geoshape with
+**	@param	georectangle	The georectangle covered by the image
+**	@param	fill_rule		The fill rule used for polygons
+*/
+void write_to_image(const QGeoShape &geoshape, QImage &image, const QColor &color, const QGeoRectangle &georectangle, const Qt::FillRule fill_rule)
+{
+	QGeoRectangle bounding_georectangle = geoshape.boundingGeoRectangle();
+
+	if (!bounding_georectangle.intersects(georectangle)) {
+		return;
+	}
+
+	if (image.format() != QImage::Format_RGBA8888) {
+		image = image.convertToFormat(QImage::Format_RGBA8888);
+	}
+
+	const QRectF unsigned_georectangle = georectangle::to_unsigned_georectangle(georectangle);
+
+	switch (geoshape.type()) {
+		case QGeoShape::PolygonType:
+			geoshape::write_polygon_to_image(static_cast<const QGeoPolygon &>(geoshape), image, color, unsigned_georectangle, fill_rule);
+			return;
+		case QGeoShape::RectangleType:
+			geoshape::write_rectangle_to_image(static_cast<const QGeoRectangle &>(geoshape), image, color, unsigned_georectangle);
+			return;
+		case QGeoShape::PathType: {
+			const QGeoPath &geopath = static_cast<const QGeoPath &>(geoshape);
+			geopath::write_to_image(geopath, image, color, georectangle);
 
-			if (pixel_checkpoint_count >= pixel_checkpoint_threshold) {
-				image.save(QString::fromStdString(image_checkpoint_save_filename));
-				pixel_checkpoint_count = 0;
+			//if the geopath's width is 0, there is nothing further to do here, but otherwise, use the normal method of geoshape writing as well
+			if (geopath.width() == 0) {
+				return;
 			}
+
+			//increase the bounding rectangle of geopaths slightly, as otherwise a part of the path's width is cut off
+			QGeoCoordinate bottom_left = bounding_georectangle.bottomLeft();
+			QGeoCoordinate top_right = bounding_georectangle.topRight();
+			bottom_left.setLatitude(bottom_left.latitude() - 0.1);
+			bottom_left.setLongitude(bottom_left.longitude() - 0.1);
+			top_right.setLatitude(top_right.latitude() + 0.1);
+			top_right.setLongitude(top_right.longitude() + 0.1);
+			bounding_georectangle.setBottomLeft(bottom_left);
+			bounding_georectangle.setTopRight(top_right);
+			break;
 		}
+		default:
+			break;
 	}
+
+	geoshape::write_contained_pixels_to_image(geoshape, bounding_georectangle, image, color, unsigned_georectangle);
 }
 
 }
@@ -27,11 +27,32 @@
 
 #include "util/image_util.h"
 
+#include "database/database.h" //for the scaled image cache path
+#include "util/binary_stream.h"
 #include "util/container_util.h"
+#include "util/exception_util.h"
+#include "util/thread_pool.h"
 #include "xbrz.h"
 
+#include <QCryptographicHash>
+
 namespace stratagus::image {
 
+static constexpr const char *scaled_image_cache_magic = "WYRMSCAL";
+static constexpr uint16_t scaled_image_cache_version = 1;
+
+//the minimum quantity of pixels for which a scaled image is cached, as smaller images are not worth the file operations
+static constexpr int min_cached_scaled_pixel_count = 128 * 128;
+
+//the maximum size of the scaled image cache, above which the least recently used scaled images are removed from it
+static constexpr uintmax_t max_scaled_image_cache_size = 1024 * 1024 * 1024;
+
+//how old a leftover temporary file of the scaled image cache must be to be removed, so that the files of writes in progress are not removed
+static constexpr std::chrono::hours scaled_image_cache_temp_file_max_age(1);
+
+//the quantity of source rows in each slice of an image scaled by the thread pool, kept large enough to avoid xBRZ's overhead for the first row of a slice
+static constexpr int scale_slice_row_count = 16;
+
 QImage scale(const QImage &src_image, const int scale_factor)
 {
 	if (src_image.format() != QImage::Format_RGBA8888) {
@@ -41,13 +62,286 @@ QImage scale(const QImage &src_image, const int scale_factor)
 
 	QImage result_image(src_image.size() * scale_factor, QImage::Format_RGBA8888);
 
+	if (result_image.isNull()) {
+		throw std::runtime_error("Failed to allocate image to be scaled.");
+	}
+
+	const uint32_t *src_data = reinterpret_cast<const uint32_t *>(src_image.constBits());
+	uint32_t *dst_data = reinterpret_cast<uint32_t *>(result_image.bits());
+	const int width = src_image.width();
+	const int height = src_image.height();
+
+	//xBRZ can scale non-overlapping row slices of the same image concurrently
+	const int slice_count = (height + scale_slice_row_count - 1) / scale_slice_row_count;
+	thread_pool::get()->parallel_for(slice_count, [&](const size_t begin, const size_t end) {
+		const int first_row = static_cast<int>(begin) * scale_slice_row_count;
+		const int last_row = std::min(static_cast<int>(end) * scale_slice_row_count, height);
+		xbrz::scale(scale_factor, src_data, dst_data, width, height, xbrz::ScalerCfg(), first_row, last_row);
+	});
+
+	return result_image;
+}
+
+/**
+**	@brief	Scale each frame of an image individually with xBRZ
+**
+**	Frames are distributed over the thread pool, with each frame's rows being copied to and from contiguous buffers, since xBRZ does not support a pitch.
+*/
+static QImage scale_frames(const QImage &src_image, const int scale_factor, const QSize &old_frame_size)
+{
+	const QSize new_frame_size = old_frame_size * scale_factor;
+
+	const QSize result_size = src_image.size() * scale_factor;
+	QImage result_image(result_size, QImage::Format_RGBA8888);
+
+	if (result_image.isNull()) {
+		throw std::runtime_error("Failed to allocate image to be scaled.");
+	}
+
+	const int horizontal_frame_count = src_image.width() / old_frame_size.width();
+	const int vertical_frame_count = src_image.height() / old_frame_size.height();
+
+	if (src_image.width() % old_frame_size.width() != 0 || src_image.height() % old_frame_size.height() != 0) {
+		//the parts of the image which are not in any frame are not scaled
+		result_image.fill(Qt::transparent);
+	}
+
+	static constexpr int bpp = 4;
 	const unsigned char *src_data = src_image.constBits();
+	const int src_bytes_per_line = src_image.bytesPerLine();
 	unsigned char *dst_data = result_image.bits();
-	xbrz::scale(scale_factor, reinterpret_cast<const uint32_t *>(src_data), reinterpret_cast<uint32_t *>(dst_data), src_image.width(), src_image.height());
+	const int dst_bytes_per_line = result_image.bytesPerLine();
+	const size_t old_frame_line_size = static_cast<size_t>(old_frame_size.width()) * bpp;
+	const size_t new_frame_line_size = static_cast<size_t>(new_frame_size.width()) * bpp;
+
+	const int frame_count = horizontal_frame_count * vertical_frame_count;
+	thread_pool::get()->parallel_for(frame_count, [&](const size_t begin, const size_t end) {
+		std::vector<uint32_t> src_frame_data(old_frame_size.width() * old_frame_size.height());
+		std::vector<uint32_t> dst_frame_data(new_frame_size.width() * new_frame_size.height());
+
+		for (size_t frame_index = begin; frame_index < end; ++frame_index) {
+			const int frame_x = static_cast<int>(frame_index) % horizontal_frame_count;
+			const int frame_y = static_cast<int>(frame_index) / horizontal_frame_count;
+
+			for (int y = 0; y < old_frame_size.height(); ++y) {
+				const unsigned char *src_line = src_data + (frame_y * old_frame_size.height() + y) * src_bytes_per_line + frame_x * old_frame_line_size;
+				memcpy(&src_frame_data[y * old_frame_size.width()], src_line, old_frame_line_size);
+			}
+
+			xbrz::scale(scale_factor, src_frame_data.data(), dst_frame_data.data(), old_frame_size.width(), old_frame_size.height());
+
+			for (int y = 0; y < new_frame_size.height(); ++y) {
+				unsigned char *dst_line = dst_data + (frame_y * new_frame_size.height() + y) * dst_bytes_per_line + frame_x * new_frame_line_size;
+				memcpy(dst_line, &dst_frame_data[y * new_frame_size.width()], new_frame_line_size);
+			}
+		}
+	});
 
 	return result_image;
 }
 
+static QByteArray get_scaled_image_cache_key(const QImage &src_image, const int scale_factor, const QSize &old_frame_size)
+{
+	QCryptographicHash hash(QCryptographicHash::Sha1);
+
+	for (const int value : {static_cast<int>(scaled_image_cache_version), scale_factor, src_image.width(), src_image.height(), old_frame_size.width(), old_frame_size.height()}) {
+		hash.addData(QByteArray::number(value));
+		hash.addData(",", 1);
+	}
+
+	const int line_size = src_image.width() * 4;
+	for (int y = 0; y < src_image.height(); ++y) {
+		hash.addData(reinterpret_cast<const char *>(src_image.constScanLine(y)), line_size);
+	}
+
+	return hash.result();
+}
+
+static std::filesystem::path get_scaled_image_cache_path()
+{
+	return database::get_cache_path() / "scaled_images";
+}
+
+static std::filesystem::path get_scaled_image_cache_filepath(const QByteArray &key)
+{
+	return image::get_scaled_image_cache_path() / (key.toHex().toStdString() + ".bin");
+}
+
+/**
+**	@brief	Limit the size of the scaled image cache
+**
+**	The least recently used scaled images are removed until the cache fits in its maximum size, using the files' modification time, which is updated whenever a scaled image is loaded from the cache. Temporary files left behind by interrupted writes are removed as well.
+*/
+static void prune_scaled_image_cache()
+{
+	try {
+		const std::filesystem::path cache_path = image::get_scaled_image_cache_path();
+
+		if (!std::filesystem::exists(cache_path)) {
+			return;
+		}
+
+		struct cache_file final
+		{
+			std::filesystem::path filepath;
+			uintmax_t size = 0;
+			std::filesystem::file_time_type last_write_time;
+		};
+
+		std::vector<cache_file> cache_files;
+		uintmax_t cache_size = 0;
+		const std::filesystem::file_time_type now = std::filesystem::file_time_type::clock::now();
+
+		for (const std::filesystem::directory_entry &entry : std::filesystem::directory_iterator(cache_path)) {
+			if (!entry.is_regular_file()) {
+				continue;
+			}
+
+			const std::filesystem::file_time_type last_write_time = entry.last_write_time();
+
+			if (entry.path().extension() == ".tmp") {
+				if (now - last_write_time > scaled_image_cache_temp_file_max_age) {
+					std::filesystem::remove(entry.path());
+				}
+				continue;
+			}
+
+			cache_files.push_back({entry.path(), entry.file_size(), last_write_time});
+			cache_size += entry.file_size();
+		}
+
+		if (cache_size <= max_scaled_image_cache_size) {
+			return;
+		}
+
+		std::sort(cache_files.begin(), cache_files.end(), [](const cache_file &lhs, const cache_file &rhs) {
+			return lhs.last_write_time < rhs.last_write_time;
+		});
+
+		for (const cache_file &cache_file : cache_files) {
+			if (cache_size <= max_scaled_image_cache_size) {
+				break;
+			}
+
+			std::filesystem::remove(cache_file.filepath);
+			cache_size -= cache_file.size;
+		}
+	} catch (const std::exception &exception) {
+		exception::report(exception);
+	}
+}
+
+/**
+**	@brief	Load a scaled image from the cache
+**
+**	@return	The scaled image, or a null image if it is not in the cache
+*/
+static QImage load_cached_scaled_image(const QByteArray &key, const QSize &size)
+{
+	try {
+		const std::filesystem::path filepath = image::get_scaled_image_cache_filepath(key);
+
+		if (!std::filesystem::exists(filepath)) {
+			return QImage();
+		}
+
+		std::ifstream ifstream(filepath, std::ios::binary);
+		if (!ifstream) {
+			return QImage();
+		}
+
+		const std::string file_content(std::istreambuf_iterator<char>{ifstream}, std::istreambuf_iterator<char>{});
+		binary_reader reader(file_content);
+
+		if (reader.read_bytes(std::strlen(scaled_image_cache_magic)) != scaled_image_cache_magic || reader.read<uint16_t>() != scaled_image_cache_version) {
+			return QImage();
+		}
+
+		const int width = static_cast<int>(reader.read<uint32_t>());
+		const int height = static_cast<int>(reader.read<uint32_t>());
+		if (width != size.width() || height != size.height()) {
+			return QImage();
+		}
+
+		const std::string_view compressed_data = reader.read_bytes(reader.get_remaining_size());
+		const QByteArray data = qUncompress(reinterpret_cast<const uchar *>(compressed_data.data()), static_cast<int>(compressed_data.size()));
+
+		const int line_size = width * 4;
+		if (data.size() != line_size * height) {
+			return QImage();
+		}
+
+		QImage image(size, QImage::Format_RGBA8888);
+		for (int y = 0; y < height; ++y) {
+			memcpy(image.scanLine(y), data.constData() + y * line_size, line_size);
+		}
+
+		//mark the scaled image as recently used, so that it is kept when the cache is pruned
+		std::error_code error_code;
+		std::filesystem::last_write_time(filepath, std::filesystem::file_time_type::clock::now(), error_code);
+
+		return image;
+	} catch (const std::exception &exception) {
+		exception::report(exception);
+		return QImage();
+	}
+}
+
+static void save_cached_scaled_image(const QByteArray &key, const QImage &image)
+{
+	const std::filesystem::path filepath = image::get_scaled_image_cache_filepath(key);
+
+	const int line_size = image.width() * 4;
+	QByteArray data;
+	data.reserve(line_size * image.height());
+	for (int y = 0; y < image.height(); ++y) {
+		data.append(reinterpret_cast<const char *>(image.constScanLine(y)), line_size);
+	}
+
+	//use a fast compression level, as the cache is meant to be quicker than scaling the image again
+	const QByteArray compressed_data = qCompress(data, 1);
+
+	std::string buffer;
+	binary_writer writer(buffer);
+	writer.write_bytes(scaled_image_cache_magic, std::strlen(scaled_image_cache_magic));
+	writer.write<uint16_t>(scaled_image_cache_version);
+	writer.write<uint32_t>(static_cast<uint32_t>(image.width()));
+	writer.write<uint32_t>(static_cast<uint32_t>(image.height()));
+	writer.write_bytes(compressed_data.constData(), compressed_data.size());
+
+	std::filesystem::create_directories(filepath.parent_path());
+
+	//write to a temporary file first, so that an interrupted write cannot leave a partial cache file behind; the temporary file is specific to the process and thread, as the same image can be scaled by more than one of them at a time
+	std::filesystem::path temp_filepath = filepath;
+	temp_filepath += "." + std::to_string(QCoreApplication::applicationPid()) + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+
+	{
+		std::ofstream ofstream(temp_filepath, std::ios::binary);
+		if (!ofstream) {
+			throw std::runtime_error("Failed to open file: " + temp_filepath.string());
+		}
+
+		ofstream.write(buffer.data(), buffer.size());
+
+		if (!ofstream) {
+			throw std::runtime_error("Failed to write file: " + temp_filepath.string());
+		}
+	}
+
+	std::filesystem::rename(temp_filepath, filepath);
+}
+
+/**
+**	@brief	Scale an image with xBRZ, scaling each of its frames individually
+**
+**	Scaled images are cached on disk, keyed by a hash of the source image's pixels, its frame size and the scale factor. The cache is pruned to its maximum size before it is first used.
+**
+**	@param	src_image		The image to be scaled
+**	@param	scale_factor	The scale factor
+**	@param	old_frame_size	The size of the image's frames
+**
+**	@return	The scaled image
+*/
 QImage scale(const QImage &src_image, const int scale_factor, const QSize &old_frame_size)
 {
 	if (src_image.format() != QImage::Format_RGBA8888) {
@@ -55,50 +349,82 @@ QImage scale(const QImage &src_image, const int scale_factor, const QSize &old_f
 		return image::scale(reformatted_src_image, scale_factor, old_frame_size);
 	}
 
+	const bool cached = src_image.width() * src_image.height() >= min_cached_scaled_pixel_count;
+	QByteArray cache_key;
+
+	if (cached) {
+		static std::once_flag prune_once_flag;
+		std::call_once(prune_once_flag, image::prune_scaled_image_cache);
+
+		cache_key = image::get_scaled_image_cache_key(src_image, scale_factor, old_frame_size);
+
+		QImage cached_image = image::load_cached_scaled_image(cache_key, src_image.size() * scale_factor);
+		if (!cached_image.isNull()) {
+			return cached_image;
+		}
+	}
+
+	QImage result_image;
 	if (src_image.size() == old_frame_size) {
-		return image::scale(src_image, scale_factor); //image has only one frame
+		result_image = image::scale(src_image, scale_factor); //image has only one frame
+	} else {
+		result_image = image::scale_frames(src_image, scale_factor, old_frame_size);
 	}
 
-	//scale an image with xBRZ
-	const QSize new_frame_size = old_frame_size * scale_factor;
+	if (cached) {
+		try {
+			image::save_cached_scaled_image(cache_key, result_image);
+		} catch (const std::exception &exception) {
+			exception::report(exception);
+		}
+	}
 
-	const int bpp = src_image.depth() / 8;
-	const QSize result_size = src_image.size() * scale_factor;
-	QImage result_image(result_size, QImage::Format_RGBA8888);
+	return result_image;
+}
 
-	if (result_image.isNull()) {
-		throw std::runtime_error("Failed to allocate image to be scaled.");
+/**
+**	@brief	Call a function for each run of identical pixels in an image's rows
+**
+**	Sprite sheets tend to have long runs of identical pixels, such as transparent areas, so processing runs rather than individual pixels saves most of the per-pixel work of callers.
+**
+**	@param	image		The image, which must be in the RGBA8888 or RGB888 format
+**	@param	function	The function, called with the run's color and its length in pixels
+*/
+template <typename function_type>
+static void for_each_rgb_run(const QImage &image, const function_type &function)
+{
+	if (image.format() != QImage::Format_RGBA8888 && image.format() != QImage::Format_RGB888) {
+		throw std::runtime_error("Invalid image format for processing RGB values: \"" + std::to_string(image.format()) + "\".");
 	}
 
-	unsigned char *dst_data = result_image.bits();
+	const int bpp = image.depth() / 8;
 
-	//if a simple scale factor is being used for the resizing, then use xBRZ for the rescaling
-	const int horizontal_frame_count = src_image.width() / old_frame_size.width();
-	const int vertical_frame_count = src_image.height() / old_frame_size.height();
+	for (int y = 0; y < image.height(); ++y) {
+		const unsigned char *line = image.constScanLine(y);
+		QRgb run_rgb = 0;
+		int run_length = 0;
 
-	//scale each frame individually
-	for (int frame_x = 0; frame_x < horizontal_frame_count; ++frame_x) {
-		for (int frame_y = 0; frame_y < vertical_frame_count; ++frame_y) {
-			const QImage src_frame_image = src_image.copy(frame_x * old_frame_size.width(), frame_y * old_frame_size.height(), old_frame_size.width(), old_frame_size.height());
-			QImage result_frame_image = image::scale(src_frame_image, scale_factor);
-
-			const unsigned char *frame_data = result_frame_image.constBits();
-
-			for (int x = 0; x < new_frame_size.width(); ++x) {
-				for (int y = 0; y < new_frame_size.height(); ++y) {
-					const int frame_pixel_index = y * new_frame_size.width() + x;
-					const int pixel_x = frame_x * new_frame_size.width() + x;
-					const int pixel_y = frame_y * new_frame_size.height() + y;
-					const int pixel_index = pixel_y * result_image.width() + pixel_x;
-					for (int i = 0; i < bpp; ++i) {
-						dst_data[pixel_index * bpp + i] = frame_data[frame_pixel_index * bpp + i];
-					}
-				}
+		for (int x = 0; x < image.width(); ++x) {
+			const unsigned char *pixel = line + x * bpp;
+			const QRgb rgb = qRgba(pixel[0], pixel[1], pixel[2], bpp == 4 ? pixel[3] : 255);
+
+			if (run_length > 0 && rgb == run_rgb) {
+				++run_length;
+				continue;
+			}
+
+			if (run_length > 0) {
+				function(run_rgb, run_length);
 			}
+
+			run_rgb = rgb;
+			run_length = 1;
 		}
-	}
 
-	return result_image;
+		if (run_length > 0) {
+			function(run_rgb, run_length);
+		}
+	}
 }
 
 std::set<QRgb> get_rgbs(const QImage &image)
@@ -109,39 +435,213 @@ std::set<QRgb> get_rgbs(const QImage &image)
 
 	std::set<QRgb> rgb_set;
 
-	const unsigned char *image_data = image.constBits();
-	const int pixel_count = image.width() * image.height();
-	const int bpp = image.depth() / 8;
+	image::for_each_rgb_run(image, [&rgb_set](const QRgb rgb, const int run_length) {
+		Q_UNUSED(run_length)
+		rgb_set.insert(rgb);
+	});
 
-	static constexpr int red_index = 0;
-	static constexpr int green_index = 1;
-	static constexpr int blue_index = 2;
-	static constexpr int alpha_index = 3;
+	return rgb_set;
+}
+
+/**
+**	@brief	Get the quantity of pixels of each RGBA value in an image
+**
+**	@param	image	The image, which must either be in the Indexed8 format, or in the RGBA8888 or RGB888 format
+**
+**	@return	The pixel count of each RGBA value
+*/
+std::map<QRgb, int> get_rgb_counts(const QImage &image)
+{
+	std::map<QRgb, int> rgb_counts;
+
+	if (image.format() == QImage::Format_Indexed8) {
+		std::vector<int> index_counts(image.colorCount(), 0);
+
+		for (int y = 0; y < image.height(); ++y) {
+			const unsigned char *line = image.constScanLine(y);
+
+			for (int x = 0; x < image.width(); ++x) {
+				++index_counts[line[x]];
+			}
+		}
+
+		for (int i = 0; i < image.colorCount(); ++i) {
+			if (index_counts[i] > 0) {
+				rgb_counts[image.color(i)] += index_counts[i];
+			}
+		}
+
+		return rgb_counts;
+	}
+
+	image::for_each_rgb_run(image, [&rgb_counts](const QRgb rgb, const int run_length) {
+		rgb_counts[rgb] += run_length;
+	});
+
+	return rgb_counts;
+}
+
+/**
+**	@brief	Get whether an image has a pixel with the RGB values of any of the given colors, regardless of its alpha
+**
+**	The image's pixels are tested against a lookup of the colors' red values first, and then against a sorted array of the colors, stopping at the first match.
+**
+**	@param	image	The image, which must either have a color table, or be in the RGBA8888 or RGB888 format
+**	@param	colors	The colors
+**
+**	@return	True if the image has a pixel with the RGB values of any of the colors, or false otherwise
+*/
+bool has_any_rgb(const QImage &image, const std::vector<QColor> &colors)
+{
+	std::array<bool, 256> red_lookup{};
+	std::vector<QRgb> rgbs;
+
+	for (const QColor &color : colors) {
+		red_lookup[color.red()] = true;
+		rgbs.push_back(color.rgb() & RGB_MASK);
+	}
+
+	std::sort(rgbs.begin(), rgbs.end());
+
+	const auto matches = [&red_lookup, &rgbs](const int red, const int green, const int blue) {
+		if (!red_lookup[red]) {
+			return false;
+		}
+
+		return std::binary_search(rgbs.begin(), rgbs.end(), qRgb(red, green, blue) & RGB_MASK);
+	};
+
+	if (!image.colorTable().empty()) {
+		for (const QRgb rgb : image.colorTable()) {
+			if (matches(qRed(rgb), qGreen(rgb), qBlue(rgb))) {
+				return true;
+			}
+		}
+
+		return false;
+	}
 
 	if (image.format() != QImage::Format_RGBA8888 && image.format() != QImage::Format_RGB888) {
-		throw std::runtime_error("Invalid image format for image::get_rgbs: \"" + std::to_string(image.format()) + "\".");
+		throw std::runtime_error("Invalid image format for image::has_any_rgb: \"" + std::to_string(image.format()) + "\".");
 	}
 
-	if (bpp == 4) {
-		for (int i = 0; i < pixel_count; ++i) {
-			const int pixel_index = i * bpp;
-			const unsigned char &red = image_data[pixel_index + red_index];
-			const unsigned char &green = image_data[pixel_index + green_index];
-			const unsigned char &blue = image_data[pixel_index + blue_index];
-			const unsigned char &alpha = image_data[pixel_index + alpha_index];
-			rgb_set.insert(qRgba(red, green, blue, alpha));
+	if (rgbs.empty()) {
+		return false;
+	}
+
+	const int bpp = image.depth() / 8;
+	const int line_size = image.width() * bpp;
+
+	for (int y = 0; y < image.height(); ++y) {
+		const unsigned char *line = image.constScanLine(y);
+
+		for (int i = 0; i < line_size; i += bpp) {
+			if (matches(line[i], line[i + 1], line[i + 2])) {
+				return true;
+			}
 		}
-	} else if (bpp == 3) {
-		for (int i = 0; i < pixel_count; ++i) {
-			const int pixel_index = i * bpp;
-			const unsigned char &red = image_data[pixel_index + red_index];
-			const unsigned char &green = image_data[pixel_index + green_index];
-			const unsigned char &blue = image_data[pixel_index + blue_index];
-			rgb_set.insert(qRgba(red, green, blue, 255));
+	}
+
+	return false;
+}
+
+/**
+**	@brief	Replace the pixels of an image which have the RGB values of one of the given colors, keeping their alpha
+**
+**	The replacements are applied in order, so that a pixel changed to a color which is replaced later in the list is changed again. Since the result only depends on a pixel's original color, it is computed once per replaced color, and pixels are then tested against a lookup of the replaced colors' red values.
+**
+**	@param	image		The image, which must be in the RGBA8888 format
+**	@param	old_colors	The colors to be replaced
+**	@param	new_colors	The colors to replace them with, in the same order
+*/
+void replace_rgbs(QImage &image, const std::vector<QColor> &old_colors, const std::vector<QColor> &new_colors)
+{
+	if (image.format() != QImage::Format_RGBA8888) {
+		throw std::runtime_error("Invalid image format for image::replace_rgbs: \"" + std::to_string(image.format()) + "\".");
+	}
+
+	if (old_colors.size() > new_colors.size()) {
+		throw std::runtime_error("Cannot replace " + std::to_string(old_colors.size()) + " colors with " + std::to_string(new_colors.size()) + " colors.");
+	}
+
+	std::array<bool, 256> red_lookup{};
+	std::vector<std::pair<QRgb, QRgb>> replacements;
+
+	for (const QColor &old_color : old_colors) {
+		red_lookup[old_color.red()] = true;
+
+		QRgb rgb = old_color.rgb() & RGB_MASK;
+		for (size_t i = 0; i < old_colors.size(); ++i) {
+			if (rgb == (old_colors[i].rgb() & RGB_MASK)) {
+				rgb = new_colors[i].rgb() & RGB_MASK;
+			}
 		}
+
+		replacements.emplace_back(old_color.rgb() & RGB_MASK, rgb);
 	}
 
-	return rgb_set;
+	const int line_size = image.width() * 4;
+
+	for (int y = 0; y < image.height(); ++y) {
+		unsigned char *line = image.scanLine(y);
+
+		for (int i = 0; i < line_size; i += 4) {
+			if (!red_lookup[line[i]]) {
+				continue;
+			}
+
+			const QRgb rgb = qRgb(line[i], line[i + 1], line[i + 2]) & RGB_MASK;
+			for (const auto &[old_rgb, new_rgb] : replacements) {
+				if (rgb == old_rgb) {
+					line[i] = static_cast<unsigned char>(qRed(new_rgb));
+					line[i + 1] = static_cast<unsigned char>(qGreen(new_rgb));
+					line[i + 2] = static_cast<unsigned char>(qBlue(new_rgb));
+					break;
+				}
+			}
+		}
+	}
+}
+
+/**
+**	@brief	Add a change to each color channel of an image's pixels, clamping the results
+**
+**	The changed value of each channel is taken from a lookup table, so that the per-pixel work has no branches.
+**
+**	@param	image			The image, which must be in the RGBA8888 format
+**	@param	red_change		The change to the red channel
+**	@param	green_change	The change to the green channel
+**	@param	blue_change		The change to the blue channel
+*/
+void apply_color_modification(QImage &image, const int red_change, const int green_change, const int blue_change)
+{
+	if (red_change == 0 && green_change == 0 && blue_change == 0) {
+		return;
+	}
+
+	if (image.format() != QImage::Format_RGBA8888) {
+		throw std::runtime_error("Invalid image format for image::apply_color_modification: \"" + std::to_string(image.format()) + "\".");
+	}
+
+	std::array<std::array<unsigned char, 256>, 3> lookups;
+	const std::array<int, 3> changes = { red_change, green_change, blue_change };
+	for (size_t channel = 0; channel < changes.size(); ++channel) {
+		for (int value = 0; value < 256; ++value) {
+			lookups[channel][value] = static_cast<unsigned char>(std::clamp(value + changes[channel], 0, 255));
+		}
+	}
+
+	const int line_size = image.width() * 4;
+
+	for (int y = 0; y < image.height(); ++y) {
+		unsigned char *line = image.scanLine(y);
+
+		for (int i = 0; i < line_size; i += 4) {
+			line[i] = lookups[0][line[i]];
+			line[i + 1] = lookups[1][line[i + 1]];
+			line[i + 2] = lookups[2][line[i + 2]];
+		}
+	}
 }
 
 color_set get_colors(const QImage &image)
@@ -34,6 +34,10 @@ namespace stratagus::image {
 extern QImage scale(const QImage &src_image, const int scale_factor);
 extern QImage scale(const QImage &src_image, const int scale_factor, const QSize &old_frame_size);
 extern std::set<QRgb> get_rgbs(const QImage &image);
+extern std::map<QRgb, int> get_rgb_counts(const QImage &image);
+extern bool has_any_rgb(const QImage &image, const std::vector<QColor> &colors);
 extern color_set get_colors(const QImage &image);
+extern void replace_rgbs(QImage &image, const std::vector<QColor> &old_colors, const std::vector<QColor> &new_colors);
+extern void apply_color_modification(QImage &image, const int red_change, const int green_change, const int blue_change);
 
 }
@@ -0,0 +1,156 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+//      (c) Copyright 2020 by Andrettin
+//
+//      Permission is hereby granted, free of charge, to any person obtaining a
+//      copy of this software and associated documentation files (the
+//      "Software"), to deal in the Software without restriction, including
+//      without limitation the rights to use, copy, modify, merge, publish,
+//      distribute, sublicense, and/or sell copies of the Software, and to
+//      permit persons to whom the Software is furnished to do so, subject to
+//      the following conditions:
+//
+//      The above copyright notice and this permission notice shall be included
+//      in all copies or substantial portions of the Software.
+//
+//      THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//      OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//      MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+//      IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+//      CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+//      TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//      SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include "util/point_util.h"
+
+namespace stratagus {
+
+/**
+**	@brief	An ordered list of points within a rectangle, from which points are taken by their index in the list
+**
+**	Taking a point removes all of its copies from the list, while keeping the remaining points in the same order, as erasing them from a vector would; this way the point picked for a given random index is the same as with a vector, but without the linear cost of erasing.
+**
+**	The list is a Fenwick tree over the sequence of added points, which gives logarithmic time for adding, finding and removing them; each point in the rectangle links to its copies in the sequence, so that they can be removed without a search.
+*/
+class ordered_point_pool final
+{
+public:
+	explicit ordered_point_pool(const QRect &rect)
+		: rect(rect), first_copy_indexes(rect.isValid() ? rect.width() * rect.height() : 0, -1)
+	{
+	}
+
+	bool empty() const
+	{
+		return this->count == 0;
+	}
+
+	size_t size() const
+	{
+		return this->count;
+	}
+
+	bool contains(const QPoint &point) const
+	{
+		return this->first_copy_indexes[this->get_point_index(point)] != -1;
+	}
+
+	void push_back(const QPoint &point)
+	{
+		const int point_index = this->get_point_index(point);
+
+		this->points.push_back(point);
+		this->next_copy_indexes.push_back(this->first_copy_indexes[point_index]);
+		this->first_copy_indexes[point_index] = static_cast<int>(this->points.size()) - 1;
+
+		//add the new entry to the Fenwick tree, with its node containing the sum of the range of entries it covers
+		const size_t tree_index = this->points.size();
+		int node_value = 1;
+		for (size_t i = tree_index - 1; i > tree_index - lowest_bit(tree_index); i -= lowest_bit(i)) {
+			node_value += this->tree[i - 1];
+		}
+		this->tree.push_back(node_value);
+
+		++this->count;
+	}
+
+	/**
+	**	@brief	Remove the point at an index of the list, together with any other copies of it, and return it
+	*/
+	QPoint take(const size_t index)
+	{
+		const QPoint point = this->points[this->find_entry(index)];
+
+		const int point_index = this->get_point_index(point);
+		for (int i = this->first_copy_indexes[point_index]; i != -1; i = this->next_copy_indexes[i]) {
+			this->remove_entry(static_cast<size_t>(i));
+		}
+		this->first_copy_indexes[point_index] = -1;
+
+		return point;
+	}
+
+private:
+	static size_t lowest_bit(const size_t value)
+	{
+		return value & (~value + 1);
+	}
+
+	int get_point_index(const QPoint &point) const
+	{
+		Assert(this->rect.contains(point));
+		return point::to_index(point - this->rect.topLeft(), this->rect.width());
+	}
+
+	//get the position in the sequence of the entry at the index in the list of remaining entries
+	size_t find_entry(const size_t index) const
+	{
+		Assert(index < this->count);
+
+		size_t step = 1;
+		while (step * 2 <= this->tree.size()) {
+			step *= 2;
+		}
+
+		size_t tree_index = 0;
+		size_t remaining = index + 1;
+		for (; step > 0; step /= 2) {
+			if (tree_index + step <= this->tree.size() && static_cast<size_t>(this->tree[tree_index + step - 1]) < remaining) {
+				tree_index += step;
+				remaining -= this->tree[tree_index - 1];
+			}
+		}
+
+		return tree_index;
+	}
+
+	void remove_entry(const size_t entry_index)
+	{
+		for (size_t tree_index = entry_index + 1; tree_index <= this->tree.size(); tree_index += lowest_bit(tree_index)) {
+			--this->tree[tree_index - 1];
+		}
+
+		--this->count;
+	}
+
+private:
+	QRect rect;
+	std::vector<QPoint> points; //the sequence of added points, including removed ones
+	std::vector<int> next_copy_indexes; //for each entry in the sequence, the index of the previous live copy of the same point, or -1
+	std::vector<int> first_copy_indexes; //for each point in the rectangle, the index of its latest live copy in the sequence, or -1
+	std::vector<int> tree; //Fenwick tree of the quantity of live entries in the sequence
+	size_t count = 0;
+};
+
+}
@@ -0,0 +1,209 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+//      (c) Copyright 2020 by Andrettin
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+//
+
+#include "stratagus.h"
+
+#include "util/profiler.h"
+
+namespace stratagus {
+
+struct profiler::thread_buffer final
+{
+	explicit thread_buffer(const size_t thread_index)
+		: thread_index(thread_index), zones(profiler::thread_buffer_capacity)
+	{
+	}
+
+	const size_t thread_index;
+	std::mutex mutex; //only contended when the buffer is read while its thread records zones
+	std::vector<zone_record> zones;
+	size_t zone_count = 0; //the quantity of zones recorded over the buffer's lifetime; the next zone is placed at this modulo the capacity
+	size_t summarized_zone_count = 0; //the quantity of zones which have already been added to a summary frame
+};
+
+profiler::thread_buffer *profiler::get_thread_buffer()
+{
+	//the buffer is also owned by the profiler, so that the zones of threads which have finished can still be exported
+	static thread_local std::shared_ptr<thread_buffer> buffer;
+
+	if (buffer == nullptr) {
+		std::lock_guard<std::mutex> lock(this->mutex);
+		buffer = std::make_shared<thread_buffer>(this->thread_buffers.size());
+		this->thread_buffers.push_back(buffer);
+	}
+
+	return buffer.get();
+}
+
+/**
+**	@brief	Get a zone name built at runtime, stored for the lifetime of the profiler
+**
+**	@param	name	The zone name
+**
+**	@return	The stored zone name, which is the same for equal names
+*/
+const char *profiler::get_zone_name(const std::string &name)
+{
+	std::lock_guard<std::mutex> lock(this->zone_name_mutex);
+	return this->zone_names.insert(name).first->c_str();
+}
+
+void profiler::record_zone(const char *name, const clock::time_point &begin, const clock::time_point &end, const uint16_t depth)
+{
+	thread_buffer *buffer = this->get_thread_buffer();
+
+	std::lock_guard<std::mutex> lock(buffer->mutex);
+	zone_record &zone = buffer->zones[buffer->zone_count % profiler::thread_buffer_capacity];
+	zone.name = name;
+	zone.begin = begin;
+	zone.end = end;
+	zone.depth = depth;
+	++buffer->zone_count;
+}
+
+/**
+**	@brief	Add the zones recorded since the previous frame to the summary, as a new frame
+*/
+void profiler::end_frame()
+{
+	std::map<std::string_view, clock::duration> frame_durations;
+
+	std::lock_guard<std::mutex> lock(this->mutex);
+
+	for (const std::shared_ptr<thread_buffer> &buffer : this->thread_buffers) {
+		std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+
+		//skip the zones which have already been overwritten
+		const size_t first_zone = std::max(buffer->summarized_zone_count, buffer->zone_count - std::min(buffer->zone_count, profiler::thread_buffer_capacity));
+
+		for (size_t i = first_zone; i < buffer->zone_count; ++i) {
+			const zone_record &zone = buffer->zones[i % profiler::thread_buffer_capacity];
+			frame_durations[zone.name] += zone.end - zone.begin;
+		}
+
+		buffer->summarized_zone_count = buffer->zone_count;
+	}
+
+	this->summary_frames.push_back(std::move(frame_durations));
+	while (this->summary_frames.size() > profiler::summary_frame_count) {
+		this->summary_frames.pop_front();
+	}
+}
+
+/**
+**	@brief	Get the time spent in each zone over the last frames
+**
+**	The times of zones recorded by other threads are included in the frames in which they were summarized, so the total for a frame can exceed its duration.
+**
+**	@return	The summary entries, sorted by their mean time in descending order
+*/
+std::vector<profiler::summary_entry> profiler::get_summary() const
+{
+	std::map<std::string_view, summary_entry> entries;
+
+	std::lock_guard<std::mutex> lock(this->mutex);
+
+	if (this->summary_frames.empty()) {
+		return {};
+	}
+
+	for (const std::map<std::string_view, clock::duration> &frame_durations : this->summary_frames) {
+		for (const auto &[name, duration] : frame_durations) {
+			const double milliseconds = std::chrono::duration<double, std::milli>(duration).count();
+
+			summary_entry &entry = entries[name];
+			entry.name = name;
+			entry.mean_milliseconds += milliseconds;
+			entry.max_milliseconds = std::max(entry.max_milliseconds, milliseconds);
+		}
+	}
+
+	std::vector<summary_entry> summary;
+	for (auto &[name, entry] : entries) {
+		entry.mean_milliseconds /= this->summary_frames.size();
+		summary.push_back(entry);
+	}
+
+	std::sort(summary.begin(), summary.end(), [](const summary_entry &a, const summary_entry &b) {
+		return a.mean_milliseconds > b.mean_milliseconds;
+	});
+
+	return summary;
+}
+
+/**
+**	@brief	Export the recorded zones in the Chrome trace event format, which can be opened in chrome://tracing or Perfetto
+**
+**	@param	filepath	The path of the JSON file to write
+*/
+void profiler::export_chrome_trace(const std::filesystem::path &filepath) const
+{
+	std::ofstream ofstream(filepath);
+	if (!ofstream) {
+		throw std::runtime_error("Failed to open file: " + filepath.string());
+	}
+
+	const auto to_microseconds = [](const clock::duration &duration) {
+		return std::chrono::duration<double, std::micro>(duration).count();
+	};
+
+	ofstream << std::fixed;
+	ofstream.precision(3);
+	ofstream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+	bool first = true;
+
+	std::lock_guard<std::mutex> lock(this->mutex);
+
+	for (const std::shared_ptr<thread_buffer> &buffer : this->thread_buffers) {
+		std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+
+		const size_t first_zone = buffer->zone_count - std::min(buffer->zone_count, profiler::thread_buffer_capacity);
+
+		for (size_t i = first_zone; i < buffer->zone_count; ++i) {
+			const zone_record &zone = buffer->zones[i % profiler::thread_buffer_capacity];
+
+			if (!first) {
+				ofstream << ",";
+			}
+			first = false;
+
+			//zone names are identifiers of code sections, and so contain no characters which need escaping
+			ofstream << "\n{\"name\":\"" << zone.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->thread_index;
+			ofstream << ",\"ts\":" << to_microseconds(zone.begin - this->start_time) << ",\"dur\":" << to_microseconds(zone.end - zone.begin);
+			ofstream << ",\"args\":{\"depth\":" << zone.depth << "}}";
+		}
+	}
+
+	ofstream << "\n]}\n";
+
+	if (!ofstream) {
+		throw std::runtime_error("Failed to write file: " + filepath.string());
+	}
+}
+
+}
@@ -0,0 +1,142 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+//      (c) Copyright 2020 by Andrettin
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+//
+
+#pragma once
+
+#include "util/singleton.h"
+
+namespace stratagus {
+
+/**
+**	@brief	Records the time spent in named zones of code, to export it as a Chrome trace and to summarize it over the last frames
+**
+**	Each thread records its zones into its own ring buffer, so that recording threads do not contend with each other. While the profiler is disabled, entering a zone only costs checking whether it is enabled.
+*/
+class profiler final : public singleton<profiler>
+{
+public:
+	using clock = std::chrono::steady_clock;
+
+	static constexpr size_t thread_buffer_capacity = 65536; //the quantity of zones kept for each thread, after which the oldest ones are overwritten
+	static constexpr size_t summary_frame_count = 60; //the quantity of frames over which the summary is calculated
+
+	struct zone_record final
+	{
+		const char *name = nullptr;
+		clock::time_point begin;
+		clock::time_point end;
+		uint16_t depth = 0;
+	};
+
+	struct summary_entry final
+	{
+		std::string_view name;
+		double mean_milliseconds = 0; //the mean time spent in the zone per frame
+		double max_milliseconds = 0; //the highest time spent in the zone in a single frame
+	};
+
+	static bool is_enabled()
+	{
+		return profiler::enabled.load(std::memory_order_relaxed);
+	}
+
+	static void set_enabled(const bool enabled)
+	{
+		if (enabled) {
+			profiler::get(); //create the profiler before any zone is entered, as zone times are relative to its creation
+		}
+
+		profiler::enabled.store(enabled, std::memory_order_relaxed);
+	}
+
+	const char *get_zone_name(const std::string &name);
+	void record_zone(const char *name, const clock::time_point &begin, const clock::time_point &end, const uint16_t depth);
+	void end_frame();
+	std::vector<summary_entry> get_summary() const;
+	void export_chrome_trace(const std::filesystem::path &filepath) const;
+
+private:
+	struct thread_buffer;
+
+	thread_buffer *get_thread_buffer();
+
+private:
+	static inline std::atomic<bool> enabled = false;
+	const clock::time_point start_time = clock::now();
+	mutable std::mutex mutex; //protects the list of thread buffers and the summary frames
+	std::vector<std::shared_ptr<thread_buffer>> thread_buffers;
+	std::mutex zone_name_mutex;
+	std::set<std::string> zone_names; //the names of zones which are built at runtime, kept for the lifetime of the profiler
+	std::deque<std::map<std::string_view, clock::duration>> summary_frames; //the time spent in each zone, for each of the last frames
+};
+
+/**
+**	@brief	Records the time from its construction to its destruction as a profiler zone
+**
+**	@param	name	The name of the zone, which must outlive the profiler, e.g. a string literal
+*/
+class profile_zone final
+{
+public:
+	explicit profile_zone(const char *name) : name(name), active(name != nullptr && profiler::is_enabled())
+	{
+		if (this->active) {
+			this->depth = profile_zone::current_depth++;
+			this->begin = profiler::clock::now();
+		}
+	}
+
+	/**
+	**	@brief	Records a zone whose name is built at runtime, e.g. to time each instance of a data type separately
+	**
+	**	@param	name	The name of the zone, which is only stored while the profiler is enabled
+	*/
+	explicit profile_zone(const std::string &name) : profile_zone(profiler::is_enabled() ? profiler::get()->get_zone_name(name) : nullptr)
+	{
+	}
+
+	~profile_zone()
+	{
+		if (this->active) {
+			profiler::get()->record_zone(this->name, this->begin, profiler::clock::now(), this->depth);
+			--profile_zone::current_depth;
+		}
+	}
+
+	profile_zone(const profile_zone &other) = delete;
+	profile_zone &operator =(const profile_zone &other) = delete;
+
+private:
+	static inline thread_local uint16_t current_depth = 0; //the quantity of active zones in the thread
+
+	const char *name = nullptr;
+	const bool active = false;
+	uint16_t depth = 0;
+	profiler::clock::time_point begin;
+};
+
+}
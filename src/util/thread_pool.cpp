@@ -0,0 +1,186 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+//      (c) Copyright 2020 by Andrettin
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+//
+
+#include "stratagus.h"
+
+#include "util/thread_pool.h"
+
+namespace stratagus {
+
+thread_pool::thread_pool()
+{
+	const unsigned hardware_concurrency = std::thread::hardware_concurrency();
+	const unsigned worker_count = hardware_concurrency > 1 ? hardware_concurrency - 1 : 0;
+
+	for (unsigned i = 0; i < worker_count; ++i) {
+		this->threads.emplace_back(&thread_pool::run_worker, this);
+	}
+}
+
+thread_pool::~thread_pool()
+{
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->stopping = true;
+	}
+
+	this->condition.notify_all();
+
+	for (std::thread &thread : this->threads) {
+		thread.join();
+	}
+}
+
+/**
+**	@brief	Queue a task to be run by one of the worker threads
+**
+**	If the pool has no worker threads, the task is run immediately on the calling thread.
+**
+**	@param	task	The task
+*/
+void thread_pool::post(std::function<void()> &&task)
+{
+	if (this->threads.empty()) {
+		task();
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->tasks.push(std::move(task));
+	}
+
+	this->condition.notify_one();
+}
+
+/**
+**	@brief	Run a function over the index range [0, count), split into chunks processed by the worker threads and the calling thread
+**
+**	Returns only after all chunks have been processed. The chunk boundaries depend on the thread count, so the function must not let the result of an index depend on which chunk it was in.
+**
+**	@param	count		The quantity of indexes to process
+**	@param	function	The function, called with the [begin, end) bounds of each chunk
+*/
+void thread_pool::parallel_for(const size_t count, const std::function<void(const size_t, const size_t)> &function)
+{
+	if (count == 0) {
+		return;
+	}
+
+	const size_t thread_count = this->get_thread_count();
+	if (thread_count == 1 || count == 1) {
+		function(0, count);
+		return;
+	}
+
+	//use more chunks than threads, so that uneven chunks get balanced out
+	const size_t chunk_count = std::min(count, thread_count * 4);
+	const size_t chunk_size = (count + chunk_count - 1) / chunk_count;
+
+	struct parallel_for_state
+	{
+		std::atomic<size_t> next_chunk = 0;
+		size_t finished_chunks = 0;
+		std::exception_ptr exception;
+		std::mutex mutex;
+		std::condition_variable condition;
+	};
+
+	//the state is shared with the posted helpers, since a helper might only start running after all chunks have already been processed
+	auto state = std::make_shared<parallel_for_state>();
+
+	const auto process_chunks = [state, count, chunk_count, chunk_size, &function]() {
+		while (true) {
+			const size_t chunk = state->next_chunk++;
+			if (chunk >= chunk_count) {
+				return;
+			}
+
+			const size_t begin = chunk * chunk_size;
+			const size_t end = std::min(begin + chunk_size, count);
+
+			std::exception_ptr exception;
+			if (begin < end) {
+				try {
+					function(begin, end);
+				} catch (...) {
+					exception = std::current_exception();
+				}
+			}
+
+			std::lock_guard<std::mutex> lock(state->mutex);
+			if (exception && !state->exception) {
+				state->exception = exception;
+			}
+			++state->finished_chunks;
+			if (state->finished_chunks == chunk_count) {
+				state->condition.notify_all();
+			}
+		}
+	};
+
+	const size_t helper_count = std::min(this->threads.size(), chunk_count - 1);
+	for (size_t i = 0; i < helper_count; ++i) {
+		this->post(process_chunks);
+	}
+
+	process_chunks();
+
+	std::unique_lock<std::mutex> lock(state->mutex);
+	state->condition.wait(lock, [&state, chunk_count]() {
+		return state->finished_chunks == chunk_count;
+	});
+
+	if (state->exception) {
+		std::rethrow_exception(state->exception);
+	}
+}
+
+void thread_pool::run_worker()
+{
+	while (true) {
+		std::function<void()> task;
+
+		{
+			std::unique_lock<std::mutex> lock(this->mutex);
+			this->condition.wait(lock, [this]() {
+				return this->stopping || !this->tasks.empty();
+			});
+
+			if (this->tasks.empty()) {
+				return;
+			}
+
+			task = std::move(this->tasks.front());
+			this->tasks.pop();
+		}
+
+		task();
+	}
+}
+
+}
@@ -0,0 +1,67 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+//      (c) Copyright 2020 by Andrettin
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+//
+
+#pragma once
+
+#include "util/singleton.h"
+
+namespace stratagus {
+
+/**
+**	@brief	A pool of persistent worker threads, used to spread independent work over the available cores
+**
+**	The pool is created with one worker less than the hardware concurrency, since the thread which calls parallel_for also processes work items while waiting.
+*/
+class thread_pool final : public singleton<thread_pool>
+{
+public:
+	thread_pool();
+	~thread_pool();
+
+	/**
+	**	@brief	Get the quantity of threads which can process work, including the calling one
+	*/
+	size_t get_thread_count() const
+	{
+		return this->threads.size() + 1;
+	}
+
+	void post(std::function<void()> &&task);
+	void parallel_for(const size_t count, const std::function<void(const size_t, const size_t)> &function);
+
+private:
+	void run_worker();
+
+private:
+	std::vector<std::thread> threads;
+	std::mutex mutex;
+	std::condition_variable condition;
+	std::queue<std::function<void()>> tasks;
+	bool stopping = false;
+};
+
+}
@@ -48,16 +48,26 @@
 //Wyrmgus start
 #include "unit/unit.h" //for using CPreference
 //Wyrmgus end
+#include "util/exception_util.h"
 #include "util/image_util.h"
 #include "util/point_util.h"
+#include "util/thread_pool.h"
 #include "video.h"
 #include "xbrz.h"
 
 std::map<std::string, CGraphic *> CGraphic::graphics_by_filepath;
 std::list<CGraphic *> CGraphic::graphics;
 
+#if defined(USE_OPENGL) || defined(USE_GLES)
+static void DiscardPreparedTextureImages(const CGraphic *graphic);
+#endif
+
 CGraphic::~CGraphic()
 {
+#if defined(USE_OPENGL) || defined(USE_GLES)
+	DiscardPreparedTextureImages(this);
+#endif
+
 	if (this->textures != nullptr) {
 		glDeleteTextures(this->NumTextures, this->textures);
 		delete[] this->textures;
@@ -843,23 +853,8 @@ void CGraphic::Load(const bool create_grayscale_textures, const int scale_factor
 
 	NumFrames = GraphicWidth / Width * GraphicHeight / Height;
 
-	this->player_color = false;
-	const stratagus::color_set color_set = stratagus::image::get_colors(this->get_image());
-	for (const QColor &color : color_set) {
-		if (!this->player_color) {
-			const stratagus::player_color *conversible_player_color = stratagus::defines::get()->get_conversible_player_color();
-			for (const QColor &player_color : conversible_player_color->get_colors()) {
-				if (color.red() == player_color.red() && color.green() == player_color.green() && color.blue() == player_color.blue()) {
-					this->player_color = true;
-					break;
-				}
-			}
-		}
-
-		if (this->player_color) {
-			break; //nothing left to check
-		}
-	}
+	const stratagus::player_color *conversible_player_color = stratagus::defines::get()->get_conversible_player_color();
+	this->player_color = stratagus::image::has_any_rgb(this->get_image(), conversible_player_color->get_colors());
 	
 	MakeTexture(this, false, nullptr);
 
@@ -1033,12 +1028,12 @@ static int PowerOf2(int x)
 **  Make an OpenGL texture or textures out of a graphic object.
 **
 **  @param g        The graphic object.
+**  @param image    The image to make the texture from, which must be in the RGBA8888 format.
 **  @param texture  Texture.
-**  @param colors   Unit colors.
 **  @param ow       Offset width.
 **  @param oh       Offset height.
 */
-void MakeTextures2(const CGraphic *g, const QImage &image, GLuint texture, const int ow, const int oh, const stratagus::time_of_day *time_of_day)
+void MakeTextures2(const CGraphic *g, const QImage &image, GLuint texture, const int ow, const int oh)
 {
 	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 	int maxw = std::min<int>(image.width() - ow, GLMaxTextureSize);
@@ -1053,18 +1048,6 @@ void MakeTextures2(const CGraphic *g, const QImage &image, GLuint texture, const
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 
-	//Wyrmgus start
-	int time_of_day_red = 0;
-	int time_of_day_green = 0;
-	int time_of_day_blue = 0;
-	
-	if (time_of_day && time_of_day->HasColorModification()) {
-		time_of_day_red = time_of_day->ColorModification.R;
-		time_of_day_green = time_of_day->ColorModification.G;
-		time_of_day_blue = time_of_day->ColorModification.B;
-	}
-	//Wyrmgus end
-
 	if (image.isNull()) {
 		throw std::runtime_error("Cannot generate a texture for a null image.");
 	}
@@ -1076,36 +1059,10 @@ void MakeTextures2(const CGraphic *g, const QImage &image, GLuint texture, const
 		throw std::runtime_error("The image BPP must be 4 for generating textures.");
 	}
 
-	const unsigned char *image_data = image.constBits();
-	for (int x = 0; x < maxw; ++x) {
-		for (int y = 0; y < maxh; ++y) {
-			const int src_index = ((oh + y) * image.width() + ow + x) * bpp;
-			const unsigned char &src_red = image_data[src_index];
-			const unsigned char &src_green = image_data[src_index + 1];
-			const unsigned char &src_blue = image_data[src_index + 2];
-			const unsigned char &src_alpha = image_data[src_index + 3];
-
-			const int dst_index = (y * w + x) * 4;
-			unsigned char &dst_red = tex[dst_index];
-			unsigned char &dst_green = tex[dst_index + 1];
-			unsigned char &dst_blue = tex[dst_index + 2];
-			unsigned char &dst_alpha = tex[dst_index + 3];
-
-			dst_red = src_red;
-			dst_green = src_green;
-			dst_blue = src_blue;
-			dst_alpha = src_alpha;
-
-			if (time_of_day_red != 0) {
-				dst_red = std::max<int>(0, std::min<int>(255, dst_red + time_of_day_red));
-			}
-			if (time_of_day_green != 0) {
-				dst_green = std::max<int>(0, std::min<int>(255, dst_green + time_of_day_green));
-			}
-			if (time_of_day_blue != 0) {
-				dst_blue = std::max<int>(0, std::min<int>(255, dst_blue + time_of_day_blue));
-			}
-		}
+	//copy the part of the image covered by the texture row by row
+	for (int y = 0; y < maxh; ++y) {
+		const unsigned char *src_line = image.constScanLine(oh + y) + ow * bpp;
+		memcpy(&tex[y * w * 4], src_line, maxw * bpp);
 	}
 
 	GLint internalformat = GL_RGBA;
@@ -1123,7 +1080,61 @@ void MakeTextures2(const CGraphic *g, const QImage &image, GLuint texture, const
 	}
 }
 
-static void MakeTextures(CGraphic *g, const bool grayscale, const stratagus::player_color *player_color, const stratagus::time_of_day *time_of_day)
+/**
+**	@brief	Create the image from which the textures of a graphic are made
+**
+**	This does not use OpenGL, and only reads the parameters it is given, so that it can be run outside of the main thread.
+**
+**	@param	source_image		The graphic's image
+**	@param	size				The graphic's size, to which the image is scaled
+**	@param	original_frame_size	The graphic's original frame size
+**	@param	grayscale			Whether to make the image grayscale
+**	@param	player_color		The player color to apply to the image, or null if none should be applied
+**	@param	color_modification	The color modification to apply to the image, or null if none should be applied
+**
+**	@return	The image, in the RGBA8888 format
+*/
+static QImage CreateTextureImage(const QImage &source_image, const QSize &size, const QSize &original_frame_size, const bool grayscale, const stratagus::player_color *player_color, const CColor *color_modification)
+{
+	QImage image = source_image;
+	if (image.format() != QImage::Format_RGBA8888) {
+		image = image.convertToFormat(QImage::Format_RGBA8888);
+	}
+
+	if (grayscale) {
+		if (Preference.SepiaForGrayscale) {
+			ApplySepiaScale(image);
+		} else {
+			ApplyGrayScale(image);
+		}
+	} else if (player_color != nullptr) {
+		const stratagus::player_color *conversible_player_color = stratagus::defines::get()->get_conversible_player_color();
+		stratagus::image::replace_rgbs(image, conversible_player_color->get_colors(), player_color->get_colors());
+	}
+
+	if (image.size() != size) {
+		//the texture needs to be rescaled compared to the source image
+		if (size.width() > image.width() && size.height() > image.height() && (size.width() % image.width()) == 0 && (size.height() % image.height()) == 0 && (size.width() / image.width()) == (size.height() / image.height())) {
+			//if a simple scale factor is being used for the resizing, then use xBRZ for the rescaling
+			const int scale_factor = size.width() / image.width();
+			image = stratagus::image::scale(image, scale_factor, original_frame_size);
+		} else {
+			image = image.scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+			if (image.format() != QImage::Format_RGBA8888) {
+				//the image's format could have changed due to the rescaling
+				image = image.convertToFormat(QImage::Format_RGBA8888);
+			}
+		}
+	}
+
+	if (color_modification != nullptr) {
+		stratagus::image::apply_color_modification(image, color_modification->R, color_modification->G, color_modification->B);
+	}
+
+	return image;
+}
+
+static void MakeTexturesFromImage(CGraphic *g, const bool grayscale, const stratagus::player_color *player_color, const CColor *color_modification, const QImage &image)
 {
 	int tw = (g->get_width() - 1) / GLMaxTextureSize + 1;
 	const int th = (g->get_height() - 1) / GLMaxTextureSize + 1;
@@ -1145,9 +1156,9 @@ static void MakeTextures(CGraphic *g, const bool grayscale, const stratagus::pla
 	CPlayerColorGraphic *cg = dynamic_cast<CPlayerColorGraphic *>(g);
 	GLuint *textures;
 	if (!player_color || !cg) {
-		if (time_of_day && time_of_day->HasColorModification()) {
-			textures = g->texture_color_modifications[time_of_day->ColorModification] = new GLuint[g->NumTextures];
-			glGenTextures(g->NumTextures, g->texture_color_modifications[time_of_day->ColorModification]);
+		if (color_modification != nullptr) {
+			textures = g->texture_color_modifications[*color_modification] = new GLuint[g->NumTextures];
+			glGenTextures(g->NumTextures, g->texture_color_modifications[*color_modification]);
 		} else if (grayscale) {
 			textures = g->grayscale_textures = new GLuint[g->NumTextures];
 			glGenTextures(g->NumTextures, g->grayscale_textures);
@@ -1155,68 +1166,32 @@ static void MakeTextures(CGraphic *g, const bool grayscale, const stratagus::pla
 			textures = g->textures = new GLuint[g->NumTextures];
 			glGenTextures(g->NumTextures, g->textures);
 		}
-	} else if (time_of_day && time_of_day->HasColorModification()) {
-		textures = cg->player_color_texture_color_modifications[player_color][time_of_day->ColorModification] = new GLuint[cg->NumTextures];
-		glGenTextures(cg->NumTextures, cg->player_color_texture_color_modifications[player_color][time_of_day->ColorModification]);
+	} else if (color_modification != nullptr) {
+		textures = cg->player_color_texture_color_modifications[player_color][*color_modification] = new GLuint[cg->NumTextures];
+		glGenTextures(cg->NumTextures, cg->player_color_texture_color_modifications[player_color][*color_modification]);
 	} else {
 		textures = cg->player_color_textures[player_color] = new GLuint[cg->NumTextures];
 		glGenTextures(cg->NumTextures, cg->player_color_textures[player_color]);
 	}
 
-	QImage image = g->get_image();
-	if (image.format() != QImage::Format_RGBA8888) {
-		image = image.convertToFormat(QImage::Format_RGBA8888);
-	}
-
-	if (grayscale) {
-		if (Preference.SepiaForGrayscale) {
-			ApplySepiaScale(image);
-		} else {
-			ApplyGrayScale(image);
-		}
-	} else if (player_color != nullptr && g->has_player_color()) {
-		const int bpp = image.depth() / 8;
-		unsigned char *image_data = image.bits();
-		const stratagus::player_color *conversible_player_color = stratagus::defines::get()->get_conversible_player_color();
-		const std::vector<QColor> &conversible_colors = conversible_player_color->get_colors();
-		const std::vector<QColor> &colors = player_color->get_colors();
-
-		for (int i = 0; i < image.sizeInBytes(); i += bpp) {
-			unsigned char &red = image_data[i];
-			unsigned char &green = image_data[i + 1];
-			unsigned char &blue = image_data[i + 2];
-
-			for (size_t z = 0; z < conversible_colors.size(); ++z) {
-				const QColor &color = conversible_colors[z];
-				if (red == color.red() && green == color.green() && blue == color.blue()) {
-					red = colors[z].red();
-					green = colors[z].green();
-					blue = colors[z].blue();
-				}
-			}
+	for (int j = 0; j < th; ++j) {
+		for (int i = 0; i < tw; ++i) {
+			MakeTextures2(g, image, textures[j * tw + i], GLMaxTextureSize * i, GLMaxTextureSize * j);
 		}
 	}
+}
 
-	if (image.size() != g->get_size()) {
-		//the texture needs to be rescaled compared to the source image
-		if (g->get_width() > image.width() && g->get_height() > image.height() && (g->get_width() % image.width()) == 0 && (g->get_height() % image.height()) == 0 && (g->get_width() / image.width()) == (g->get_height() / image.height())) {
-			//if a simple scale factor is being used for the resizing, then use xBRZ for the rescaling
-			const int scale_factor = g->get_width() / image.width();
-			image = stratagus::image::scale(image, scale_factor, g->get_original_frame_size());
-		} else {
-			image = image.scaled(g->get_size(), Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
-			if (image.format() != QImage::Format_RGBA8888) {
-				//the image's format could have changed due to the rescaling
-				image = image.convertToFormat(QImage::Format_RGBA8888);
-			}
-		}
+static void MakeTextures(CGraphic *g, const bool grayscale, const stratagus::player_color *player_color, const stratagus::time_of_day *time_of_day)
+{
+	const CColor *color_modification = nullptr;
+	if (time_of_day && time_of_day->HasColorModification()) {
+		color_modification = &time_of_day->ColorModification;
 	}
 
-	for (int j = 0; j < th; ++j) {
-		for (int i = 0; i < tw; ++i) {
-			MakeTextures2(g, image, textures[j * tw + i], GLMaxTextureSize * i, GLMaxTextureSize * j, time_of_day);
-		}
-	}
+	const stratagus::player_color *applied_player_color = g->has_player_color() ? player_color : nullptr;
+	const QImage image = CreateTextureImage(g->get_image(), g->get_size(), g->get_original_frame_size(), grayscale, applied_player_color, color_modification);
+
+	MakeTexturesFromImage(g, grayscale, player_color, color_modification, image);
 }
 
 /**
@@ -1263,6 +1238,201 @@ void MakePlayerColorTexture(CPlayerColorGraphic *g, const stratagus::player_colo
 	MakeTextures(g, false, player_color, time_of_day);
 }
 
+/**
+**	@brief	A texture image which has been prepared in the background, and which is waiting for its textures to be made on the main thread
+*/
+struct PreparedTextureImage
+{
+	CGraphic *graphic = nullptr;
+	QSize size; //the size of the graphic when the image was prepared, so that images prepared before the graphic was resized are discarded
+	const stratagus::player_color *player_color = nullptr;
+	CColor color_modification;
+	QImage image;
+};
+
+//the maximum (uncompressed) memory size of texture variants beyond which no further variants are prepared in the background
+static constexpr size_t MaxPreparedTextureVariantMemorySize = 1024 * 1024 * 1024;
+
+static std::mutex PreparedTextureImageMutex;
+static std::vector<PreparedTextureImage> PreparedTextureImages;
+static size_t PendingTextureImageCount = 0;
+static std::set<const CGraphic *> DiscardedTextureImageGraphics; //graphics which have been freed while their texture images were being prepared
+
+/**
+**	@brief	Get the uncompressed memory size of one set of textures of a graphic, i.e. of a single variant of it
+*/
+static size_t GetTextureSetMemorySize(const CGraphic *g)
+{
+	size_t memory_size = 0;
+
+	for (int oh = 0; oh < g->get_height(); oh += GLMaxTextureSize) {
+		for (int ow = 0; ow < g->get_width(); ow += GLMaxTextureSize) {
+			const int w = PowerOf2(std::min<int>(g->get_width() - ow, GLMaxTextureSize));
+			const int h = PowerOf2(std::min<int>(g->get_height() - oh, GLMaxTextureSize));
+			memory_size += static_cast<size_t>(w) * h * 4;
+		}
+	}
+
+	return memory_size;
+}
+
+/**
+**	@brief	Get the uncompressed memory size of the texture variants of all graphics
+**
+**	Texture variants are the textures made for a player color or color modification, in addition to a graphic's base and grayscale textures.
+**
+**	@return	The memory size, in bytes
+*/
+size_t GetTextureVariantMemorySize()
+{
+	size_t memory_size = 0;
+
+	for (const CGraphic *graphic : CGraphic::graphics) {
+		size_t variant_count = graphic->texture_color_modifications.size();
+
+		const CPlayerColorGraphic *cg = dynamic_cast<const CPlayerColorGraphic *>(graphic);
+		if (cg != nullptr) {
+			variant_count += cg->player_color_textures.size();
+
+			for (const auto &kv_pair : cg->player_color_texture_color_modifications) {
+				variant_count += kv_pair.second.size();
+			}
+		}
+
+		if (variant_count > 0) {
+			memory_size += variant_count * GetTextureSetMemorySize(graphic);
+		}
+	}
+
+	return memory_size;
+}
+
+/**
+**	@brief	Prepare the texture images of a time of day's color modification in the background, so that its textures do not have to be made when they are first drawn
+**
+**	Variants are only prepared for graphics which have already been drawn, and for the player colors they have been drawn with, as those are the ones likely to be drawn with the time of day.
+**
+**	@param	time_of_day	The time of day
+*/
+void PrepareTimeOfDayTextures(const stratagus::time_of_day *time_of_day)
+{
+	if (time_of_day == nullptr || !time_of_day->HasColorModification()) {
+		return;
+	}
+
+	if (GetTextureVariantMemorySize() >= MaxPreparedTextureVariantMemorySize) {
+		return;
+	}
+
+	const CColor color_modification = time_of_day->ColorModification;
+
+	for (CGraphic *graphic : CGraphic::graphics) {
+		if (graphic->textures == nullptr) {
+			continue;
+		}
+
+		std::vector<const stratagus::player_color *> player_colors;
+
+		if (graphic->get_textures(color_modification) == nullptr) {
+			player_colors.push_back(nullptr);
+		}
+
+		const CPlayerColorGraphic *cg = dynamic_cast<const CPlayerColorGraphic *>(graphic);
+		if (cg != nullptr && cg->has_player_color()) {
+			for (const auto &kv_pair : cg->player_color_textures) {
+				if (cg->get_textures(kv_pair.first, color_modification) == nullptr) {
+					player_colors.push_back(kv_pair.first);
+				}
+			}
+		}
+
+		for (const stratagus::player_color *player_color : player_colors) {
+			//copy the graphic's data, so that the task does not access the graphic itself
+			const QImage source_image = graphic->get_image();
+			const QSize size = graphic->get_size();
+			const QSize original_frame_size = graphic->get_original_frame_size();
+
+			{
+				std::lock_guard<std::mutex> lock(PreparedTextureImageMutex);
+				++PendingTextureImageCount;
+			}
+
+			stratagus::thread_pool::get()->post([graphic, source_image, size, original_frame_size, player_color, color_modification]() {
+				QImage image;
+
+				try {
+					image = CreateTextureImage(source_image, size, original_frame_size, false, player_color, &color_modification);
+				} catch (const std::exception &exception) {
+					stratagus::exception::report(exception);
+				}
+
+				std::lock_guard<std::mutex> lock(PreparedTextureImageMutex);
+				--PendingTextureImageCount;
+
+				if (!image.isNull() && DiscardedTextureImageGraphics.find(graphic) == DiscardedTextureImageGraphics.end()) {
+					PreparedTextureImages.push_back({graphic, size, player_color, color_modification, std::move(image)});
+				}
+
+				if (PendingTextureImageCount == 0) {
+					DiscardedTextureImageGraphics.clear();
+				}
+			});
+		}
+	}
+}
+
+/**
+**	@brief	Make the textures for the texture images which have been prepared in the background
+**
+**	This has to be called from the main thread, as it uses OpenGL.
+*/
+void MakePreparedTextures()
+{
+	std::vector<PreparedTextureImage> prepared_images;
+
+	{
+		std::lock_guard<std::mutex> lock(PreparedTextureImageMutex);
+		prepared_images.swap(PreparedTextureImages);
+	}
+
+	for (const PreparedTextureImage &prepared_image : prepared_images) {
+		CGraphic *graphic = prepared_image.graphic;
+
+		if (graphic->get_size() != prepared_image.size) {
+			continue;
+		}
+
+		CPlayerColorGraphic *cg = dynamic_cast<CPlayerColorGraphic *>(graphic);
+		if (prepared_image.player_color != nullptr && cg != nullptr) {
+			if (cg->get_textures(prepared_image.player_color, prepared_image.color_modification) != nullptr) {
+				continue; //already made on demand while the image was being prepared
+			}
+		} else if (graphic->get_textures(prepared_image.color_modification) != nullptr) {
+			continue;
+		}
+
+		MakeTexturesFromImage(graphic, false, prepared_image.player_color, &prepared_image.color_modification, prepared_image.image);
+	}
+}
+
+/**
+**	@brief	Discard the texture images being prepared for a graphic, as it is being freed
+**
+**	@param	graphic	The graphic
+*/
+static void DiscardPreparedTextureImages(const CGraphic *graphic)
+{
+	std::lock_guard<std::mutex> lock(PreparedTextureImageMutex);
+
+	PreparedTextureImages.erase(std::remove_if(PreparedTextureImages.begin(), PreparedTextureImages.end(), [graphic](const PreparedTextureImage &prepared_image) {
+		return prepared_image.graphic == graphic;
+	}), PreparedTextureImages.end());
+
+	if (PendingTextureImageCount > 0) {
+		DiscardedTextureImageGraphics.insert(graphic);
+	}
+}
+
 #endif
 
 /**
@@ -0,0 +1,109 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+/**@name test_binary_stream.cpp - The test file for binary_stream.h. */
+//
+//      (c) Copyright 2020 by Andrettin
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+//
+
+#include <UnitTest++.h>
+
+#include "stratagus.h"
+#include "util/binary_stream.h"
+
+namespace {
+
+enum class test_enum : uint16_t {
+	first = 1,
+	last = 0xABCD
+};
+
+}
+
+TEST(BINARY_STREAM_LITTLE_ENDIAN)
+{
+	std::string buffer;
+	stratagus::binary_writer writer(buffer);
+	writer.write<uint32_t>(0x12345678);
+
+	CHECK_EQUAL(4u, buffer.size());
+	CHECK_EQUAL(0x78, static_cast<unsigned char>(buffer[0]));
+	CHECK_EQUAL(0x56, static_cast<unsigned char>(buffer[1]));
+	CHECK_EQUAL(0x34, static_cast<unsigned char>(buffer[2]));
+	CHECK_EQUAL(0x12, static_cast<unsigned char>(buffer[3]));
+}
+
+TEST(BINARY_STREAM_ROUND_TRIP)
+{
+	std::string buffer;
+	stratagus::binary_writer writer(buffer);
+	writer.write<uint8_t>(255);
+	writer.write<int16_t>(-12345);
+	writer.write<int32_t>(INT32_MIN);
+	writer.write<uint64_t>(0x0123456789ABCDEFull);
+	writer.write<test_enum>(test_enum::last);
+	writer.write_string("wyrmgus");
+	writer.write_string(std::string());
+	writer.write_bytes("xyz", 3);
+
+	CHECK_EQUAL(buffer.size(), writer.get_size());
+
+	stratagus::binary_reader reader(buffer);
+	CHECK_EQUAL(255, reader.read<uint8_t>());
+	CHECK_EQUAL(-12345, reader.read<int16_t>());
+	CHECK_EQUAL(INT32_MIN, reader.read<int32_t>());
+	CHECK(reader.read<uint64_t>() == 0x0123456789ABCDEFull);
+	CHECK(reader.read<test_enum>() == test_enum::last);
+	CHECK_EQUAL("wyrmgus", reader.read_string());
+	CHECK_EQUAL("", reader.read_string());
+	CHECK(reader.read_bytes(3) == "xyz");
+	CHECK(reader.is_at_end());
+	CHECK_EQUAL(0u, reader.get_remaining_size());
+}
+
+TEST(BINARY_STREAM_READ_PAST_END)
+{
+	std::string buffer;
+	stratagus::binary_writer writer(buffer);
+	writer.write<uint16_t>(1);
+
+	stratagus::binary_reader reader(buffer);
+	CHECK_THROW(reader.read<uint32_t>(), std::runtime_error);
+
+	//a failed read doesn't advance the position
+	CHECK_EQUAL(0u, reader.get_position());
+	CHECK_EQUAL(1, reader.read<uint16_t>());
+	CHECK_THROW(reader.read<uint8_t>(), std::runtime_error);
+}
+
+TEST(BINARY_STREAM_TRUNCATED_STRING)
+{
+	std::string buffer;
+	stratagus::binary_writer writer(buffer);
+	writer.write_string("truncated");
+	buffer.resize(buffer.size() - 1);
+
+	stratagus::binary_reader reader(buffer);
+	CHECK_THROW(reader.read_string(), std::runtime_error);
+}
@@ -0,0 +1,193 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+/**@name test_geoshape_util.cpp - The test file for geoshape_util.cpp. */
+//
+//      (c) Copyright 2020 by Andrettin
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+//
+
+#include <UnitTest++.h>
+
+#include "stratagus.h"
+#include "util/georectangle_util.h"
+#include "util/geoshape_util.h"
+#include "util/point_util.h"
+
+#include <QGeoPolygon>
+#include <QGeoRectangle>
+#include <QImage>
+
+namespace {
+
+//an image covering 10 by 10 degrees with 20 by 20 pixels, so that pixels are sampled every half degree
+const QGeoRectangle test_georectangle(QGeoCoordinate(10, 0), QGeoCoordinate(0, 10));
+const QSize test_image_size(20, 20);
+const QColor test_color(255, 0, 0);
+
+QImage create_test_image()
+{
+	QImage image(test_image_size, QImage::Format_RGBA8888);
+	image.fill(Qt::transparent);
+	return image;
+}
+
+//write a geoshape by testing each pixel for containment, as write_to_image did for all shapes before rasterizing polygons and rectangles from their edges
+QImage write_contained_pixels(const QGeoShape &geoshape)
+{
+	QImage image = create_test_image();
+	const QRectF unsigned_georectangle = stratagus::georectangle::to_unsigned_georectangle(test_georectangle);
+
+	for (int y = 0; y < image.height(); ++y) {
+		for (int x = 0; x < image.width(); ++x) {
+			if (geoshape.contains(stratagus::point::to_geocoordinate(QPoint(x, y), image.size(), unsigned_georectangle))) {
+				image.setPixelColor(x, y, test_color);
+			}
+		}
+	}
+
+	return image;
+}
+
+int get_written_pixel_count(const QImage &image)
+{
+	int count = 0;
+
+	for (int y = 0; y < image.height(); ++y) {
+		for (int x = 0; x < image.width(); ++x) {
+			if (image.pixelColor(x, y).alpha() != 0) {
+				++count;
+			}
+		}
+	}
+
+	return count;
+}
+
+//get whether a pixel of an image is next to one whose written state differs from its own
+bool is_on_written_boundary(const QImage &image, const int x, const int y)
+{
+	const bool written = image.pixelColor(x, y).alpha() != 0;
+
+	for (const QPoint &offset : { QPoint(-1, 0), QPoint(1, 0), QPoint(0, -1), QPoint(0, 1) }) {
+		const QPoint adjacent_pos = QPoint(x, y) + offset;
+		if (!image.rect().contains(adjacent_pos)) {
+			continue;
+		}
+
+		if ((image.pixelColor(adjacent_pos).alpha() != 0) != written) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+}
+
+//the edges of the test shapes are parallels and meridians between the sampled positions, so that containment does not depend on the projection used to test it
+TEST(GEOSHAPE_WRITE_POLYGON_MATCHES_CONTAINED_PIXELS)
+{
+	//a U shape open to the north, with a hole in its southern part
+	QGeoPolygon geopolygon(QList<QGeoCoordinate>{
+		QGeoCoordinate(8.2, 1.2),
+		QGeoCoordinate(8.2, 3.7),
+		QGeoCoordinate(4.2, 3.7),
+		QGeoCoordinate(4.2, 6.2),
+		QGeoCoordinate(8.2, 6.2),
+		QGeoCoordinate(8.2, 8.7),
+		QGeoCoordinate(1.7, 8.7),
+		QGeoCoordinate(1.7, 1.2)
+	});
+	geopolygon.addHole(QList<QGeoCoordinate>{
+		QGeoCoordinate(3.2, 4.1),
+		QGeoCoordinate(3.2, 5.9),
+		QGeoCoordinate(2.7, 5.9),
+		QGeoCoordinate(2.7, 4.1)
+	});
+
+	QImage image = create_test_image();
+	stratagus::geoshape::write_to_image(geopolygon, image, test_color, test_georectangle);
+
+	const QImage expected_image = write_contained_pixels(geopolygon);
+	CHECK(get_written_pixel_count(expected_image) > 0);
+	CHECK(image == expected_image);
+}
+
+//the rasterizer treats edges as straight lines in latitude and longitude, while QGeoPolygon::contains uses a Mercator projection, so for diagonal edges the two may only disagree about pixels at the shape's boundary
+TEST(GEOSHAPE_WRITE_DIAGONAL_POLYGON_MATCHES_CONTAINED_PIXELS_WITHIN_BOUNDARY)
+{
+	//an arrowhead pointing east, with a notch in its western side
+	const QGeoPolygon geopolygon(QList<QGeoCoordinate>{
+		QGeoCoordinate(9.1, 0.8),
+		QGeoCoordinate(5.3, 9.4),
+		QGeoCoordinate(0.9, 1.3),
+		QGeoCoordinate(4.6, 3.9)
+	});
+
+	QImage image = create_test_image();
+	stratagus::geoshape::write_to_image(geopolygon, image, test_color, test_georectangle);
+
+	const QImage expected_image = write_contained_pixels(geopolygon);
+	CHECK(get_written_pixel_count(expected_image) > 0);
+
+	int mismatch_count = 0;
+	for (int y = 0; y < image.height(); ++y) {
+		for (int x = 0; x < image.width(); ++x) {
+			if (image.pixelColor(x, y) == expected_image.pixelColor(x, y)) {
+				continue;
+			}
+
+			++mismatch_count;
+			CHECK(is_on_written_boundary(expected_image, x, y) || is_on_written_boundary(image, x, y));
+		}
+	}
+
+	//at these latitudes the projections differ by far less than a pixel, so any disagreement is limited to isolated pixels along the edges
+	CHECK(mismatch_count < image.height());
+}
+
+TEST(GEOSHAPE_WRITE_RECTANGLE_MATCHES_CONTAINED_PIXELS)
+{
+	const QGeoRectangle georectangle(QGeoCoordinate(7.3, 2.1), QGeoCoordinate(2.6, 6.8));
+
+	QImage image = create_test_image();
+	stratagus::geoshape::write_to_image(georectangle, image, test_color, test_georectangle);
+
+	const QImage expected_image = write_contained_pixels(georectangle);
+	CHECK(get_written_pixel_count(expected_image) > 0);
+	CHECK(image == expected_image);
+}
+
+TEST(GEOSHAPE_WRITE_KEEPS_WRITTEN_PIXELS)
+{
+	const QGeoRectangle georectangle(QGeoCoordinate(7.3, 2.1), QGeoCoordinate(2.6, 6.8));
+	const QColor other_color(0, 0, 255);
+
+	QImage image = create_test_image();
+	image.setPixelColor(8, 8, other_color);
+	stratagus::geoshape::write_to_image(georectangle, image, test_color, test_georectangle);
+
+	CHECK(image.pixelColor(8, 8) == other_color);
+	CHECK(image.pixelColor(9, 8) == test_color);
+}
@@ -0,0 +1,75 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+/**@name test_image_util.cpp - The test file for image_util.cpp. */
+//
+//      (c) Copyright 2020 by Andrettin
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+//
+
+#include <UnitTest++.h>
+
+#include "stratagus.h"
+#include "util/image_util.h"
+
+#include <QImage>
+
+TEST(HAS_ANY_RGB)
+{
+	QImage image(4, 2, QImage::Format_RGBA8888);
+	image.fill(QColor(0, 0, 255));
+	image.setPixelColor(3, 1, QColor(255, 0, 0, 128));
+
+	//the alpha of the pixels is not taken into account
+	CHECK(stratagus::image::has_any_rgb(image, { QColor(0, 255, 0), QColor(255, 0, 0) }));
+	CHECK(!stratagus::image::has_any_rgb(image, { QColor(0, 255, 0), QColor(255, 0, 1) }));
+	CHECK(!stratagus::image::has_any_rgb(image, {}));
+}
+
+TEST(GET_RGB_COUNTS)
+{
+	QImage image(4, 2, QImage::Format_RGBA8888);
+	image.fill(QColor(0, 0, 255));
+	image.setPixelColor(1, 0, QColor(255, 0, 0));
+	image.setPixelColor(2, 0, QColor(255, 0, 0));
+	image.setPixelColor(3, 1, QColor(0, 255, 0));
+
+	const std::map<QRgb, int> rgb_counts = stratagus::image::get_rgb_counts(image);
+
+	CHECK_EQUAL(3, static_cast<int>(rgb_counts.size()));
+	CHECK_EQUAL(5, rgb_counts.at(qRgba(0, 0, 255, 255)));
+	CHECK_EQUAL(2, rgb_counts.at(qRgba(255, 0, 0, 255)));
+	CHECK_EQUAL(1, rgb_counts.at(qRgba(0, 255, 0, 255)));
+
+	//the counts of an indexed image are those of the colors of its pixels' indices
+	QImage indexed_image(4, 2, QImage::Format_Indexed8);
+	indexed_image.setColorTable({ qRgba(0, 0, 255, 255), qRgba(255, 0, 0, 255), qRgba(0, 255, 0, 255), qRgba(0, 0, 0, 0) });
+	for (int y = 0; y < image.height(); ++y) {
+		for (int x = 0; x < image.width(); ++x) {
+			const QRgb rgb = image.pixel(x, y);
+			indexed_image.setPixel(x, y, rgb == qRgba(255, 0, 0, 255) ? 1 : (rgb == qRgba(0, 255, 0, 255) ? 2 : 0));
+		}
+	}
+
+	CHECK(stratagus::image::get_rgb_counts(indexed_image) == rgb_counts);
+}
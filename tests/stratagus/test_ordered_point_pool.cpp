@@ -0,0 +1,115 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+/**@name test_ordered_point_pool.cpp - The test file for ordered_point_pool.h. */
+//
+//      (c) Copyright 2020 by Andrettin
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+//
+
+#include <UnitTest++.h>
+
+#include "stratagus.h"
+#include "util/ordered_point_pool.h"
+#include "util/point_util.h"
+#include "util/vector_util.h"
+
+namespace {
+
+//a fixed sequence of pseudo-random numbers, so that the same indexes are taken from the pool and the vector
+class index_sequence final
+{
+public:
+	size_t next(const size_t max)
+	{
+		this->seed = this->seed * 1103515245 + 12345;
+		return (this->seed / 65536) % max;
+	}
+
+private:
+	uint32_t seed = 42;
+};
+
+}
+
+TEST(ORDERED_POINT_POOL_TAKE_REMOVES_ALL_COPIES)
+{
+	stratagus::ordered_point_pool pool(QRect(QPoint(0, 0), QPoint(3, 3)));
+	pool.push_back(QPoint(1, 1));
+	pool.push_back(QPoint(2, 1));
+	pool.push_back(QPoint(1, 1));
+	pool.push_back(QPoint(0, 3));
+
+	CHECK_EQUAL(4u, pool.size());
+	CHECK(pool.contains(QPoint(1, 1)));
+	CHECK(!pool.contains(QPoint(3, 3)));
+
+	CHECK(pool.take(2) == QPoint(1, 1));
+	CHECK_EQUAL(2u, pool.size());
+	CHECK(!pool.contains(QPoint(1, 1)));
+
+	CHECK(pool.take(0) == QPoint(2, 1));
+	CHECK(pool.take(0) == QPoint(0, 3));
+	CHECK(pool.empty());
+}
+
+TEST(ORDERED_POINT_POOL_TAKE_ORDER_MATCHES_VECTOR)
+{
+	const QRect rect(QPoint(2, 3), QPoint(17, 12));
+	stratagus::ordered_point_pool pool(rect);
+	std::vector<QPoint> points;
+
+	for (int x = rect.left(); x <= rect.right(); x += 3) {
+		for (int y = rect.top(); y <= rect.bottom(); y += 2) {
+			pool.push_back(QPoint(x, y));
+			points.push_back(QPoint(x, y));
+		}
+	}
+
+	//take points at random indexes as the map generation does, adding the neighbors of each taken point which weren't taken before, including ones already in the list, as a territory expansion would
+	std::vector<bool> taken_points(rect.width() * rect.height(), false);
+	index_sequence indexes;
+	while (!points.empty()) {
+		CHECK_EQUAL(points.size(), pool.size());
+
+		const size_t index = indexes.next(points.size());
+		const QPoint point = points[index];
+		stratagus::vector::remove(points, point);
+		taken_points[stratagus::point::to_index(point - rect.topLeft(), rect.width())] = true;
+
+		CHECK(pool.take(index) == point);
+		CHECK(!pool.contains(point));
+
+		for (const QPoint &offset : { QPoint(1, 0), QPoint(0, 1), QPoint(-1, 0), QPoint(0, -1) }) {
+			const QPoint neighbor = point + offset;
+			if (!rect.contains(neighbor) || taken_points[stratagus::point::to_index(neighbor - rect.topLeft(), rect.width())]) {
+				continue;
+			}
+
+			pool.push_back(neighbor);
+			points.push_back(neighbor);
+		}
+	}
+
+	CHECK(pool.empty());
+}
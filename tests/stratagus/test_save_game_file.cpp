@@ -0,0 +1,216 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+/**@name test_save_game_file.cpp - The test file for save_game_file.cpp. */
+//
+//      (c) Copyright 2020 by Andrettin
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+//
+
+#include <UnitTest++.h>
+
+#include "stratagus.h"
+#include "game/save_game_file.h"
+#include "iolib.h"
+#include "map/tile.h"
+#include "map/tileset.h"
+
+namespace {
+
+//write a save game with the given sections to a string
+std::string write_save_game(const std::function<void(stratagus::save_game_writer &)> &function)
+{
+	CFile file;
+	file.open_memory();
+	stratagus::save_game_writer writer(file);
+	function(writer);
+	return file.get_memory_buffer();
+}
+
+std::string write_test_save_game()
+{
+	return write_save_game([](stratagus::save_game_writer &writer) {
+		writer.write_lua_section("players", [](CFile &file) {
+			file.printf("SetThisPlayer(0)\n");
+		});
+		writer.write_binary_section(static_cast<stratagus::save_game_section_type>(99), "unknown", [](stratagus::binary_writer &binary_writer) {
+			binary_writer.write<uint32_t>(42);
+		});
+		writer.write_binary_section(stratagus::save_game_section_type::map_tiles, "map", [](stratagus::binary_writer &binary_writer) {
+			binary_writer.write_string("tiles");
+		});
+		writer.finish();
+	});
+}
+
+}
+
+TEST(SAVE_GAME_SECTIONS_ROUND_TRIP)
+{
+	const std::string data = write_test_save_game();
+	CHECK(stratagus::save_game_reader::is_save_game_data(data));
+
+	stratagus::save_game_reader reader(data);
+
+	std::optional<stratagus::save_game_reader::section> section = reader.read_section();
+	CHECK(section.has_value());
+	CHECK(section->type == stratagus::save_game_section_type::lua_script);
+	CHECK_EQUAL("players", section->name);
+	CHECK(section->data == "SetThisPlayer(0)\n");
+
+	//a section of an unknown type is returned as it is, so that the caller can skip it and go on with the next one
+	section = reader.read_section();
+	CHECK(section.has_value());
+	CHECK(section->type == static_cast<stratagus::save_game_section_type>(99));
+	CHECK_EQUAL("unknown", section->name);
+	stratagus::binary_reader unknown_reader(section->data);
+	CHECK_EQUAL(42u, unknown_reader.read<uint32_t>());
+	CHECK(unknown_reader.is_at_end());
+
+	section = reader.read_section();
+	CHECK(section.has_value());
+	CHECK(section->type == stratagus::save_game_section_type::map_tiles);
+	CHECK_EQUAL("map", section->name);
+	stratagus::binary_reader map_reader(section->data);
+	CHECK_EQUAL("tiles", map_reader.read_string());
+
+	CHECK(!reader.read_section().has_value());
+}
+
+TEST(SAVE_GAME_NOT_SAVE_GAME_DATA)
+{
+	const std::string data = "SavedGameInfo({})\n";
+	CHECK(!stratagus::save_game_reader::is_save_game_data(data));
+	CHECK_THROW(stratagus::save_game_reader reader(data), std::runtime_error);
+}
+
+TEST(SAVE_GAME_NEWER_FORMAT_VERSION)
+{
+	std::string data = write_save_game([](stratagus::save_game_writer &writer) {
+		writer.finish();
+	});
+
+	//the format version follows the 8-byte magic string
+	data[8] = static_cast<char>(0xFF);
+	CHECK_THROW(stratagus::save_game_reader reader(data), std::runtime_error);
+}
+
+TEST(SAVE_GAME_TRUNCATED_SECTION)
+{
+	const std::string data = write_test_save_game();
+
+	//cut off the last byte of the map section's data, and its end marker
+	const size_t end_marker_size = sizeof(uint16_t) + sizeof(uint32_t) + sizeof(uint64_t);
+	const std::string truncated_data = data.substr(0, data.size() - end_marker_size - 1);
+
+	stratagus::save_game_reader reader(truncated_data);
+	CHECK(reader.read_section().has_value());
+	CHECK(reader.read_section().has_value());
+	CHECK_THROW(reader.read_section(), std::runtime_error);
+}
+
+TEST(SAVE_GAME_MISSING_END_MARKER)
+{
+	const std::string data = write_test_save_game();
+	const size_t end_marker_size = sizeof(uint16_t) + sizeof(uint32_t) + sizeof(uint64_t);
+	const std::string truncated_data = data.substr(0, data.size() - end_marker_size);
+
+	stratagus::save_game_reader reader(truncated_data);
+	CHECK(reader.read_section().has_value());
+	CHECK(reader.read_section().has_value());
+	CHECK(reader.read_section().has_value());
+	CHECK_THROW(reader.read_section(), std::runtime_error);
+}
+
+TEST(TILE_PLANES_ROUND_TRIP)
+{
+	static constexpr unsigned int field_count = 6;
+
+	std::vector<CMapField> fields(field_count);
+	for (unsigned int i = 0; i < field_count; ++i) {
+		CMapField &mf = fields[i];
+		mf.SolidTile = static_cast<short>(i * 3);
+		mf.OverlaySolidTile = static_cast<short>(-static_cast<int>(i));
+		mf.playerInfo.SeenSolidTile = static_cast<short>(i + 100);
+		mf.playerInfo.SeenOverlaySolidTile = static_cast<short>(i + 200);
+		mf.Value = static_cast<short>(1000 - i);
+		mf.Landmass = static_cast<int>(i % 2 + 1);
+		mf.Flags = MapFieldLandAllowed | MapFieldSpeedMask | (i % 2 == 0 ? MapFieldWall : 0);
+		mf.playerInfo.ExploredPlayers = 1u << i;
+	}
+
+	std::string data;
+	stratagus::binary_writer writer(data);
+	CMapField::save_tile_planes(fields.data(), field_count, writer);
+
+	std::vector<CMapField> loaded_fields(field_count);
+	stratagus::binary_reader reader(data);
+	CMapField::load_tile_planes(loaded_fields.data(), field_count, reader);
+	CHECK(reader.is_at_end());
+
+	for (unsigned int i = 0; i < field_count; ++i) {
+		const CMapField &mf = fields[i];
+		const CMapField &loaded_mf = loaded_fields[i];
+		CHECK(loaded_mf.Terrain == nullptr);
+		CHECK(loaded_mf.OverlayTerrain == nullptr);
+		CHECK_EQUAL(mf.SolidTile, loaded_mf.SolidTile);
+		CHECK_EQUAL(mf.OverlaySolidTile, loaded_mf.OverlaySolidTile);
+		CHECK_EQUAL(mf.playerInfo.SeenSolidTile, loaded_mf.playerInfo.SeenSolidTile);
+		CHECK_EQUAL(mf.playerInfo.SeenOverlaySolidTile, loaded_mf.playerInfo.SeenOverlaySolidTile);
+		CHECK_EQUAL(mf.Value, loaded_mf.Value);
+		CHECK_EQUAL(mf.getCost(), loaded_mf.getCost());
+		CHECK_EQUAL(mf.Landmass, loaded_mf.Landmass);
+		CHECK_EQUAL(mf.playerInfo.ExploredPlayers, loaded_mf.playerInfo.ExploredPlayers);
+		CHECK(loaded_mf.TransitionTiles.empty());
+
+		//the speed mask is not saved
+		CHECK_EQUAL(mf.Flags & ~static_cast<unsigned long>(MapFieldSpeedMask), loaded_mf.Flags);
+	}
+}
+
+TEST(TILE_PLANES_FIELD_COUNT_MISMATCH)
+{
+	std::vector<CMapField> fields(4);
+
+	std::string data;
+	stratagus::binary_writer writer(data);
+	CMapField::save_tile_planes(fields.data(), static_cast<unsigned int>(fields.size()), writer);
+
+	std::vector<CMapField> loaded_fields(5);
+	stratagus::binary_reader reader(data);
+	CHECK_THROW(CMapField::load_tile_planes(loaded_fields.data(), static_cast<unsigned int>(loaded_fields.size()), reader), std::runtime_error);
+}
+
+TEST(TILE_PLANES_TRUNCATED)
+{
+	std::vector<CMapField> fields(4);
+
+	std::string data;
+	stratagus::binary_writer writer(data);
+	CMapField::save_tile_planes(fields.data(), static_cast<unsigned int>(fields.size()), writer);
+	data.resize(data.size() - 1);
+
+	std::vector<CMapField> loaded_fields(fields.size());
+	stratagus::binary_reader reader(data);
+	CHECK_THROW(CMapField::load_tile_planes(loaded_fields.data(), static_cast<unsigned int>(loaded_fields.size()), reader), std::runtime_error);
+}